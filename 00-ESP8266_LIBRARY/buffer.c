@@ -25,10 +25,21 @@
  */
 #include "buffer.h"
 
+#if BUFFER_SPSC
+#define BUFFER_POS(b, idx)      ((idx) & ((b)->Size - 1))	/* Get memory position from free-running index */
+#else
+#define BUFFER_POS(b, idx)      (idx)
+#endif /* BUFFER_SPSC */
+
 uint8_t BUFFER_Init(BUFFER_t* Buffer, uint32_t Size, void* BufferPtr) {
 	if (Buffer == NULL) {									/* Check buffer structure */
 		return 1;
 	}
+#if BUFFER_SPSC
+	if (Size == 0 || (Size & (Size - 1))) {					/* Size must be power of 2 for index masking */
+		return 1;
+	}
+#endif /* BUFFER_SPSC */
 	memset(Buffer, 0, sizeof(BUFFER_t));        			/* Set buffer values to all zeros */
     
 	Buffer->Size = Size;                        			/* Set default values */
@@ -61,6 +72,33 @@ void BUFFER_Free(BUFFER_t* Buffer) {
 }
 
 uint32_t BUFFER_Write(BUFFER_t* Buffer, const void* Data, uint32_t count) {
+#if BUFFER_SPSC
+	uint32_t in, out, pos, tocopy;
+    const uint8_t* d = (const uint8_t *)Data;
+
+	if (Buffer == NULL || count == 0) {						/* Check buffer structure */
+		return 0;
+	}
+	in = Buffer->In;										/* Input index is owned by producer */
+	BUFFER_LOAD_ACQUIRE(out, Buffer->Out);					/* Get output index, memory before it is free */
+	if (Buffer->Size - (in - out) < count) {				/* Check available memory */
+		count = Buffer->Size - (in - out);					/* Set values for write */
+		if (count == 0) {									/* If no memory, stop execution */
+			return 0;
+		}
+	}
+	pos = BUFFER_POS(Buffer, in);							/* Get memory position */
+	tocopy = Buffer->Size - pos;							/* Calculate number of elements we can put at the end of buffer */
+	if (tocopy > count) {									/* Check for copy count */
+		tocopy = count;
+	}
+	memcpy(&Buffer->Buffer[pos], d, tocopy);				/* Copy content to buffer */
+	if (count > tocopy) {									/* Check if anything to write */
+		memcpy(Buffer->Buffer, &d[tocopy], count - tocopy);	/* Copy content to beginning */
+	}
+	BUFFER_STORE_RELEASE(Buffer->In, in + count);			/* Publish written data to consumer */
+	return count;											/* Return number of elements written */
+#else
 	uint32_t i = 0;
 	uint32_t free;
     const uint8_t* d = (const uint8_t *)Data;
@@ -110,6 +148,7 @@ uint32_t BUFFER_Write(BUFFER_t* Buffer, const void* Data, uint32_t count) {
 	}
 	return i;												/* Return number of elements written */
 #endif
+#endif /* BUFFER_SPSC */
 }
 
 uint32_t BUFFER_WriteToTop(BUFFER_t* Buffer, const void* Data, uint32_t count) {
@@ -120,12 +159,14 @@ uint32_t BUFFER_WriteToTop(BUFFER_t* Buffer, const void* Data, uint32_t count) {
 	if (Buffer == NULL || count == 0) {						/* Check buffer structure */
 		return 0;
 	}
+#if !BUFFER_SPSC
 	if (Buffer->In >= Buffer->Size) {						/* Check input pointer */
 		Buffer->In = 0;
 	}
 	if (Buffer->Out >= Buffer->Size) {						/* Check output pointer */
 		Buffer->Out = 0;
 	}
+#endif /* !BUFFER_SPSC */
 	free = BUFFER_GetFree(Buffer);							/* Get free memory */
 	if (free < count) {										/* Check available memory */
 		if (free == 0) {									/* If no memory, stop execution */
@@ -134,6 +175,13 @@ uint32_t BUFFER_WriteToTop(BUFFER_t* Buffer, const void* Data, uint32_t count) {
 		count = free;										/* Set values for write */
 	}
 	d += count - 1;										    /* Start on bottom */
+#if BUFFER_SPSC
+	while (count--) {										/* Go through all elements */
+		Buffer->Out--;										/* Free-running index, wraps itself */
+		Buffer->Buffer[BUFFER_POS(Buffer, Buffer->Out)] = *d--;	/* Add to buffer */
+		i++;												/* Increase pointers */
+	}
+#else
 	while (count--) {										/* Go through all elements */
 		if (Buffer->Out == 0) {								/* Check output pointer */
 			Buffer->Out = Buffer->Size - 1;
@@ -143,10 +191,38 @@ uint32_t BUFFER_WriteToTop(BUFFER_t* Buffer, const void* Data, uint32_t count) {
 		Buffer->Buffer[Buffer->Out] = *d--;				    /* Add to buffer */
 		i++;												/* Increase pointers */
 	}
+#endif /* BUFFER_SPSC */
 	return i;												/* Return number of elements written */
 }
 
 uint32_t BUFFER_Read(BUFFER_t* Buffer, void* Data, uint32_t count) {
+#if BUFFER_SPSC
+	uint32_t in, out, pos, tocopy;
+    uint8_t *d = (uint8_t *)Data;
+	
+	if (Buffer == NULL || count == 0) {						/* Check buffer structure */
+		return 0;
+	}
+	out = Buffer->Out;										/* Output index is owned by consumer */
+	BUFFER_LOAD_ACQUIRE(in, Buffer->In);					/* Get input index, memory before it is valid */
+	if (in - out < count) {									/* Check available data */
+		count = in - out;									/* Set values for read */
+		if (count == 0) {									/* If no data, stop execution */
+			return 0;
+		}
+	}
+	pos = BUFFER_POS(Buffer, out);							/* Get memory position */
+	tocopy = Buffer->Size - pos;							/* Calculate number of elements we can read from end of buffer */
+	if (tocopy > count) {									/* Check for copy count */
+		tocopy = count;
+	}
+	memcpy(d, &Buffer->Buffer[pos], tocopy);				/* Copy content from buffer */
+	if (count > tocopy) {									/* Check if anything to read */
+		memcpy(&d[tocopy], Buffer->Buffer, count - tocopy);	/* Copy content from beginning */
+	}
+	BUFFER_STORE_RELEASE(Buffer->Out, out + count);			/* Release read memory to producer */
+	return count;											/* Return number of elements read */
+#else
 	uint32_t i = 0, full;
     uint8_t *d = (uint8_t *)Data;
 #if BUFFER_FAST
@@ -193,6 +269,7 @@ uint32_t BUFFER_Read(BUFFER_t* Buffer, void* Data, uint32_t count) {
 	}
 	return i;												/* Return number of elements stored in memory */
 #endif
+#endif /* BUFFER_SPSC */
 }
 
 uint32_t BUFFER_GetFree(BUFFER_t* Buffer) {
@@ -201,6 +278,12 @@ uint32_t BUFFER_GetFree(BUFFER_t* Buffer) {
 	if (Buffer == NULL) {									/* Check buffer structure */
 		return 0;
 	}
+#if BUFFER_SPSC
+	BUFFER_LOAD_ACQUIRE(in, Buffer->In);					/* Save values */
+	BUFFER_LOAD_ACQUIRE(out, Buffer->Out);
+	size = Buffer->Size - (in - out);						/* All elements can be used */
+	return size;											/* Return free memory */
+#else
 	in = Buffer->In;										/* Save values */
 	out = Buffer->Out;
 	if (in == out) {										/* Check if the same */
@@ -211,6 +294,7 @@ uint32_t BUFFER_GetFree(BUFFER_t* Buffer) {
 		size = Buffer->Size - (in - out);
 	}
 	return size - 1;										/* Return free memory */
+#endif /* BUFFER_SPSC */
 }
 
 uint32_t BUFFER_GetFull(BUFFER_t* Buffer) {
@@ -219,6 +303,11 @@ uint32_t BUFFER_GetFull(BUFFER_t* Buffer) {
 	if (Buffer == NULL) {									/* Check buffer structure */
 		return 0;
 	}
+#if BUFFER_SPSC
+	BUFFER_LOAD_ACQUIRE(in, Buffer->In);					/* Save values */
+	BUFFER_LOAD_ACQUIRE(out, Buffer->Out);
+	size = in - out;										/* Free-running indexes, difference is always valid */
+#else
 	in = Buffer->In;										/* Save values */
 	out = Buffer->Out;
 	if (in == out) {										/* Pointer are same? */
@@ -228,6 +317,7 @@ uint32_t BUFFER_GetFull(BUFFER_t* Buffer) {
 	} else {												/* Buffer is in overflow mode */
 		size = Buffer->Size - (out - in);
 	}
+#endif /* BUFFER_SPSC */
 	return size;											/* Return number of elements in buffer */
 }
 
@@ -237,78 +327,133 @@ uint32_t BUFFER_GetFullFast(BUFFER_t* Buffer) {
 	if (Buffer == NULL) {									/* Check buffer structure */
 		return 0;
 	}
+#if BUFFER_SPSC
+	BUFFER_LOAD_ACQUIRE(in, Buffer->In);					/* Save values */
+	BUFFER_LOAD_ACQUIRE(out, Buffer->Out);
+	return in - out;
+#else
 	in = Buffer->In;										/* Save values */
 	out = Buffer->Out;
 	return (Buffer->Size + in - out) % Buffer->Size;
+#endif /* BUFFER_SPSC */
 }
 
 void BUFFER_Reset(BUFFER_t* Buffer) {
 	if (Buffer == NULL) {									/* Check buffer structure */
 		return;
 	}
+#if BUFFER_SPSC
+	BUFFER_STORE_RELEASE(Buffer->Out, *(volatile uint32_t *)&Buffer->In);	/* Drop all data from consumer side, input is owned by producer */
+#else
 	Buffer->In = 0;											/* Reset values */
 	Buffer->Out = 0;
+#endif /* BUFFER_SPSC */
 }
 
 int32_t BUFFER_FindElement(BUFFER_t* Buffer, uint8_t Element) {
-	uint32_t Num, Out, retval = 0;
+	uint32_t Num, Out, len;
+	const uint8_t* p;
 	
 	if (Buffer == NULL) {									/* Check buffer structure */
 		return -1;
 	}
 	
 	Num = BUFFER_GetFull(Buffer);							/* Create temporary variables */
-	Out = Buffer->Out;
-	while (Num > 0) {										/* Go through input elements */
-		if (Out >= Buffer->Size) {							/* Check output overflow */
-			Out = 0;
-		}
-		if ((uint8_t)Buffer->Buffer[Out] == (uint8_t)Element) {	/* Check for element */
-			return retval;									/* Element found, return position in buffer */
+	Out = BUFFER_POS(Buffer, Buffer->Out);
+	if (Out >= Buffer->Size) {								/* Check output overflow */
+		Out = 0;
+	}
+	len = Buffer->Size - Out;								/* Elements to the end of memory */
+	if (len > Num) {
+		len = Num;
+	}
+	p = memchr(&Buffer->Buffer[Out], Element, len);			/* Search first part, till end of memory */
+	if (p != NULL) {
+		return (int32_t)(p - &Buffer->Buffer[Out]);			/* Element found, return position in buffer */
+	}
+	if (Num > len) {										/* Data wraps to beginning of memory */
+		p = memchr(Buffer->Buffer, Element, Num - len);		/* Search second part */
+		if (p != NULL) {
+			return (int32_t)(len + (p - Buffer->Buffer));	/* Element found, return position in buffer */
 		}
-		Out++;												/* Set new variables */
-		Num--;
-		retval++;
 	}
 	return -1;												/* Element is not in buffer */
 }
 
 int32_t BUFFER_Find(BUFFER_t* Buffer, const void* Data, uint32_t Size) {
-	uint32_t Num, Out, i, retval = 0;
-	uint8_t found = 0;
-    uint8_t* d = (uint8_t *)Data;
+	uint32_t Num, Out, len, part, i, j = 0, pos = 0;
+	const uint8_t* d = (const uint8_t *)Data;
+	const uint8_t* mem;
+	const uint8_t* p;
+	uint16_t table[BUFFER_FIND_TABLE_SIZE];					/* Longest proper prefix which is also suffix, for each pattern length */
+	uint8_t useTable;
 
-	if (Buffer == NULL || (Num = BUFFER_GetFull(Buffer)) < Size) {	/* Check buffer structure and number of elements in buffer */
+	if (Buffer == NULL || Size == 0 || (Num = BUFFER_GetFull(Buffer)) < Size) {	/* Check buffer structure and number of elements in buffer */
 		return -1;
 	}
-	Out = Buffer->Out;										/* Create temporary variables */
-	while (Num > 0) {										/* Go through input elements in buffer */
-		if (Out >= Buffer->Size) {							/* Check output overflow */
-			Out = 0;
+	if (Size == 1) {										/* Single element search */
+		return BUFFER_FindElement(Buffer, d[0]);
+	}
+	useTable = Size <= BUFFER_FIND_TABLE_SIZE;
+	if (useTable) {											/* Prepare table for linear time search */
+		table[0] = 0;
+		for (i = 1; i < Size; i++) {
+			while (j > 0 && d[i] != d[j]) {
+				j = table[j - 1];
+			}
+			if (d[i] == d[j]) {
+				j++;
+			}
+			table[i] = (uint16_t)j;
 		}
-		if ((uint8_t)Buffer->Buffer[Out] == d[0]) {	        /* Check if current element in buffer matches first element in data array */
-			found = 1;
+		j = 0;
+	}
+	
+	Out = BUFFER_POS(Buffer, Buffer->Out);					/* Create temporary variables */
+	if (Out >= Buffer->Size) {								/* Check output overflow */
+		Out = 0;
+	}
+	len = Buffer->Size - Out;								/* Elements in first part, till end of memory */
+	if (len > Num) {
+		len = Num;
+	}
+	for (part = 0; part < 2; part++) {						/* Search first part and then wrapped part at beginning of memory */
+		mem = part ? Buffer->Buffer : &Buffer->Buffer[Out];
+		if (part) {
+			len = Num - len;
 		}
-		
-		Out++;												/* Set new variables */
-		Num--;
-		retval++;
-		if (found) {										/* We have found first element */
-			i = 1;											/* First character found */
-			while (i < Size && Num > 0) {					/* Check others */	
-				if (Out >= Buffer->Size) {					/* Check output overflow */
-					Out = 0;
-				}
-				if ((uint8_t)Buffer->Buffer[Out] != d[i]) {	/* Check if current character in buffer matches character in string */
-					retval += i - 1;
+		for (i = 0; i < len; i++) {							/* Go through elements in current part */
+			if (j == 0) {									/* Nothing matched yet, skip to first pattern element */
+				p = memchr(&mem[i], d[0], len - i);
+				if (p == NULL) {
+					pos += len - i;
 					break;
 				}
-				Out++;										/* Set new variables */
-				Num--;
-				i++;
+				pos += p - &mem[i];
+				i = p - mem;
 			}
-			if (i == Size) {								/* We have found data sequence in buffer */
-				return retval - 1;
+			if (useTable) {
+				while (j > 0 && mem[i] != d[j]) {			/* Fall back to longest matching prefix */
+					j = table[j - 1];
+				}
+				if (mem[i] == d[j]) {
+					j++;
+				}
+				pos++;
+				if (j == Size) {							/* We have found data sequence in buffer */
+					return (int32_t)(pos - Size);
+				}
+			} else {										/* Pattern too long for table, compare candidate directly */
+				for (j = 1; j < Size && pos + j < Num; j++) {
+					if (Buffer->Buffer[(Out + pos + j) % Buffer->Size] != d[j]) {
+						break;
+					}
+				}
+				if (j == Size) {							/* We have found data sequence in buffer */
+					return (int32_t)pos;
+				}
+				j = 0;
+				pos++;
 			}
 		}
 	}
@@ -320,58 +465,182 @@ uint32_t BUFFER_WriteString(BUFFER_t* Buffer, const char* buff) {
 }
 
 uint32_t BUFFER_ReadString(BUFFER_t* Buffer, char* buff, uint32_t buffsize) {
-	uint32_t i = 0, freeMem, fullMem;
-	uint8_t ch;
-	if (Buffer == NULL) {
+	uint32_t i, freeMem, fullMem;
+	int32_t pos;
+	if (Buffer == NULL || buffsize == 0) {
 		return 0;											/* Check value buffer */
 	}
 	
 	freeMem = BUFFER_GetFree(Buffer);						/* Get free memory */
 	fullMem = BUFFER_GetFull(Buffer);						/* Get full memory */
+	pos = BUFFER_FindElement(Buffer, Buffer->StringDelimiter);	/* Find string delimiter */
 	if (													/* Check for any data in buffer */
 		fullMem == 0 ||                                 	/* Buffer empty */
 		(
-			BUFFER_FindElement(Buffer, Buffer->StringDelimiter) < 0 && 	/* String delimiter is not in buffer */
-			freeMem != 0 &&                                            	/* Buffer is not full */
-			fullMem < buffsize                                         	/* User buffer size is larger than number of elements in buffer */
+			pos < 0 && 										/* String delimiter is not in buffer */
+			freeMem != 0 &&                                 /* Buffer is not full */
+			fullMem < buffsize                              /* User buffer size is larger than number of elements in buffer */
 		)
 	) {
 		return 0;											/* Return with no elements read */
 	}
-	while (i < (buffsize - 1)) {							/* If available buffer size is more than 0 characters */
-		BUFFER_Read(Buffer, &ch, 1);						/* We have available data */
-		buff[i] = (char)ch;									/* Save character */
-		if ((char)buff[i] == (char)Buffer->StringDelimiter) {	/* Check for end of string */
-			break;											/* Done */
-		}
-		i++;												/* Increase */
-	}
-	if (i == (buffsize - 1)) {								/* Add zero to the end of string */
-		buff[i] = 0;
-	} else {
-		buff[++i] = 0;
+	i = pos >= 0 ? (uint32_t)pos + 1 : fullMem;				/* Read string including delimiter or everything available */
+	if (i > (buffsize - 1)) {								/* Limit to user buffer size */
+		i = buffsize - 1;
 	}
+	i = BUFFER_Read(Buffer, buff, i);						/* Read string at once */
+	buff[i] = 0;											/* Add zero to the end of string */
 	return i;												/* Return number of characters in buffer */
 }
 
 int8_t BUFFER_CheckElement(BUFFER_t* Buffer, uint32_t pos, uint8_t* element) {
-	uint32_t In, Out, i = 0;
+	uint32_t Out;
 	if (Buffer == NULL) {									/* Check value buffer */
 		return 0;
 	}
 	
-	In = Buffer->In;										/* Read current values */
-	Out = Buffer->Out;
-	while (i < pos && (In != Out)) {						/* Set pointers to right location */
-		Out++;												/* Increase output pointer */
-		i++;
-		if (Out >= Buffer->Size) {							/* Check overflow */
-			Out = 0;
+	if (pos >= BUFFER_GetFull(Buffer)) {					/* Check if position is inside data */
+		return 0;
+	}
+	Out = BUFFER_POS(Buffer, Buffer->Out);					/* Read current values */
+	if (Out >= Buffer->Size) {								/* Check output overflow */
+		Out = 0;
+	}
+	Out += pos;												/* Set pointer to right location */
+	if (Out >= Buffer->Size) {								/* Check overflow */
+		Out -= Buffer->Size;
+	}
+	*element = Buffer->Buffer[Out];							/* Save element */	
+	return 1;												/* Return OK */
+}
+
+void* BUFFER_GetLinearBlockReadAddress(BUFFER_t* Buffer) {
+	if (Buffer == NULL) {									/* Check buffer structure */
+		return NULL;
+	}
+#if !BUFFER_SPSC
+	if (Buffer->Out >= Buffer->Size) {						/* Check output pointer */
+		Buffer->Out = 0;
+	}
+#endif /* !BUFFER_SPSC */
+	return &Buffer->Buffer[BUFFER_POS(Buffer, Buffer->Out)];	/* Return address of first element to read */
+}
+
+uint32_t BUFFER_GetLinearBlockReadLength(BUFFER_t* Buffer) {
+	uint32_t in, out, len;
+	
+	if (Buffer == NULL) {									/* Check buffer structure */
+		return 0;
+	}
+#if BUFFER_SPSC
+	BUFFER_LOAD_ACQUIRE(in, Buffer->In);					/* Save values */
+	out = Buffer->Out;
+	len = Buffer->Size - BUFFER_POS(Buffer, out);			/* Elements to the end of memory */
+	if (len > in - out) {									/* Limit to elements in buffer */
+		len = in - out;
+	}
+#else
+	in = Buffer->In;										/* Save values */
+	out = Buffer->Out;
+	if (out >= Buffer->Size) {								/* Check output pointer */
+		out = 0;
+	}
+	if (in >= out) {										/* Buffer is not in overflow mode */
+		len = in - out;
+	} else {												/* Read to the end of memory, rest is at the beginning */
+		len = Buffer->Size - out;
+	}
+#endif /* BUFFER_SPSC */
+	return len;												/* Return number of elements in linear block */
+}
+
+uint32_t BUFFER_Skip(BUFFER_t* Buffer, uint32_t count) {
+	uint32_t full;
+	
+	if (Buffer == NULL || count == 0) {						/* Check buffer structure */
+		return 0;
+	}
+	full = BUFFER_GetFull(Buffer);							/* Get number of elements in buffer */
+	if (count > full) {										/* Check available data */
+		count = full;
+	}
+#if BUFFER_SPSC
+	BUFFER_STORE_RELEASE(Buffer->Out, Buffer->Out + count);	/* Release memory to producer */
+#else
+	if (Buffer->Out >= Buffer->Size) {						/* Check output pointer */
+		Buffer->Out = 0;
+	}
+	Buffer->Out += count;									/* Increase output pointer */
+	if (Buffer->Out >= Buffer->Size) {						/* Check output overflow */
+		Buffer->Out -= Buffer->Size;
+	}
+#endif /* BUFFER_SPSC */
+	return count;											/* Return number of elements removed */
+}
+
+void* BUFFER_GetLinearBlockWriteAddress(BUFFER_t* Buffer) {
+	if (Buffer == NULL) {									/* Check buffer structure */
+		return NULL;
+	}
+#if !BUFFER_SPSC
+	if (Buffer->In >= Buffer->Size) {						/* Check input pointer */
+		Buffer->In = 0;
+	}
+#endif /* !BUFFER_SPSC */
+	return &Buffer->Buffer[BUFFER_POS(Buffer, Buffer->In)];	/* Return address of first free element */
+}
+
+uint32_t BUFFER_GetLinearBlockWriteLength(BUFFER_t* Buffer) {
+	uint32_t in, out, len;
+	
+	if (Buffer == NULL) {									/* Check buffer structure */
+		return 0;
+	}
+#if BUFFER_SPSC
+	in = Buffer->In;										/* Save values */
+	BUFFER_LOAD_ACQUIRE(out, Buffer->Out);
+	len = Buffer->Size - BUFFER_POS(Buffer, in);			/* Elements to the end of memory */
+	if (len > Buffer->Size - (in - out)) {					/* Limit to free memory */
+		len = Buffer->Size - (in - out);
+	}
+#else
+	in = Buffer->In;										/* Save values */
+	out = Buffer->Out;
+	if (in >= Buffer->Size) {								/* Check input pointer */
+		in = 0;
+	}
+	if (in >= out) {										/* Write to the end of memory */
+		len = Buffer->Size - in;
+		if (out == 0) {										/* One element must stay free */
+			len--;
 		}
+	} else {												/* Write up to output pointer */
+		len = out - in - 1;
+	}
+#endif /* BUFFER_SPSC */
+	return len;												/* Return number of elements in linear block */
+}
+
+uint32_t BUFFER_Advance(BUFFER_t* Buffer, uint32_t count) {
+	uint32_t free;
+	
+	if (Buffer == NULL || count == 0) {						/* Check buffer structure */
+		return 0;
 	}
-	if (i == pos) {											/* If positions match */	
-		*element = Buffer->Buffer[Out];						/* Save element */	
-		return 1;											/* Return OK */
+	free = BUFFER_GetFree(Buffer);							/* Get free memory */
+	if (count > free) {										/* Check available memory */
+		count = free;
+	}
+#if BUFFER_SPSC
+	BUFFER_STORE_RELEASE(Buffer->In, Buffer->In + count);	/* Publish written data to consumer */
+#else
+	if (Buffer->In >= Buffer->Size) {						/* Check input pointer */
+		Buffer->In = 0;
+	}
+	Buffer->In += count;									/* Increase input pointer */
+	if (Buffer->In >= Buffer->Size) {						/* Check input overflow */
+		Buffer->In -= Buffer->Size;
 	}
-	return 0;												/* Return zero */
+#endif /* BUFFER_SPSC */
+	return count;											/* Return number of elements added */
 }
@@ -32,7 +32,7 @@
 \endverbatim
  */
 #ifndef BUFFER_H
-#define BUFFER_H 110
+#define BUFFER_H 120
 
 /* C++ detection */
 #ifdef __cplusplus
@@ -97,6 +97,43 @@ extern "C" {
 #define BUFFER_FAST            1
 #endif
 
+/* Maximal sequence length for linear time search in \ref BUFFER_Find, longer sequences are compared on each candidate */
+#ifndef BUFFER_FIND_TABLE_SIZE
+#define BUFFER_FIND_TABLE_SIZE 32
+#endif
+
+/**
+ * \brief  Enables (1) or disables (0) lock-free single-producer single-consumer mode
+ *
+ *         In this mode, \ref BUFFER_t.In and \ref BUFFER_t.Out are free-running indexes, masked with buffer size on memory access.
+ *         Buffer size must be power of 2 and all its elements can be used for data.
+ *         One producer (interrupt or thread) can write to buffer while one consumer reads from it without disabling interrupts.
+ *
+ * \note   Producer may only use write functions and consumer everything else. \ref BUFFER_Reset drops data from consumer side.
+ * \note   Must be set globally (compiler defines) to have the same value in all files
+ */
+#ifndef BUFFER_SPSC
+#define BUFFER_SPSC            0
+#endif
+
+/* Memory barrier between index and data memory accesses, also used by other single-producer single-consumer queues */
+#ifndef BUFFER_MEMORY_BARRIER
+#if defined(__CC_ARM)
+#define BUFFER_MEMORY_BARRIER()         __dmb(0xF)
+#elif defined(__GNUC__)
+#define BUFFER_MEMORY_BARRIER()         __atomic_thread_fence(__ATOMIC_ACQ_REL)
+#elif BUFFER_SPSC
+#error "BUFFER_MEMORY_BARRIER() must be defined for your compiler when BUFFER_SPSC is enabled"
+#else
+#define BUFFER_MEMORY_BARRIER()         (void)0
+#endif
+#endif
+
+/* Reads index modified by other side, data after it may be accessed after this */
+#define BUFFER_LOAD_ACQUIRE(dst, idx)   do { (dst) = *(volatile uint32_t *)&(idx); BUFFER_MEMORY_BARRIER(); } while (0)
+/* Publishes new index to other side, after data before it have been accessed */
+#define BUFFER_STORE_RELEASE(idx, val)  do { BUFFER_MEMORY_BARRIER(); *(volatile uint32_t *)&(idx) = (val); } while (0)
+
 /**
  * \}
  */
@@ -139,6 +176,7 @@ typedef struct _BUFFER_t {
  * \retval Buffer initialization status:
  *            - 0: Buffer initialized OK
  *            - > 0: Buffer initialization error. Malloc has failed with allocation
+ *                   or size is not power of 2 when \ref BUFFER_SPSC is enabled
  */
 uint8_t BUFFER_Init(BUFFER_t* Buffer, uint32_t Size, void* BufferPtr);
 
@@ -195,6 +233,7 @@ uint32_t BUFFER_GetFullFast(BUFFER_t* Buffer);
 
 /**
  * \brief  Resets (clears) buffer pointers
+ * \note   When \ref BUFFER_SPSC is enabled, only output pointer is modified and all data currently in buffer are dropped
  * \param  *Buffer: Pointer to \ref BUFFER_t structure
  * \retval None
  */
@@ -247,6 +286,57 @@ uint32_t BUFFER_WriteString(BUFFER_t* Buffer, const char* buff);
  */
 uint32_t BUFFER_ReadString(BUFFER_t* Buffer, char* buff, uint32_t buffsize);
 
+/**
+ * \brief  Gets address of linear block of data ready to be read from buffer
+ * \note   Memory at returned address can be processed directly (without copy) and released with \ref BUFFER_Skip
+ * \param  *Buffer: Pointer to \ref BUFFER_t structure
+ * \retval Pointer to first element to read from buffer
+ */
+void* BUFFER_GetLinearBlockReadAddress(BUFFER_t* Buffer);
+
+/**
+ * \brief  Gets number of elements in linear block ready to be read from buffer
+ * \note   This is number of elements at address returned by \ref BUFFER_GetLinearBlockReadAddress
+ *         and may be less than \ref BUFFER_GetFull returns when data wraps around end of memory
+ * \param  *Buffer: Pointer to \ref BUFFER_t structure
+ * \retval Number of elements in linear block
+ */
+uint32_t BUFFER_GetLinearBlockReadLength(BUFFER_t* Buffer);
+
+/**
+ * \brief  Removes elements from buffer without reading them
+ * \note   Use it after data from linear read block have been processed
+ * \param  *Buffer: Pointer to \ref BUFFER_t structure
+ * \param  count: Number of elements to remove
+ * \retval Number of elements removed from buffer
+ */
+uint32_t BUFFER_Skip(BUFFER_t* Buffer, uint32_t count);
+
+/**
+ * \brief  Gets address of linear block of free memory in buffer
+ * \note   Memory at returned address can be written directly (for example by DMA) and added to buffer with \ref BUFFER_Advance
+ * \param  *Buffer: Pointer to \ref BUFFER_t structure
+ * \retval Pointer to first free element in buffer
+ */
+void* BUFFER_GetLinearBlockWriteAddress(BUFFER_t* Buffer);
+
+/**
+ * \brief  Gets number of elements in linear block of free memory in buffer
+ * \note   This is number of elements at address returned by \ref BUFFER_GetLinearBlockWriteAddress
+ *         and may be less than \ref BUFFER_GetFree returns when free memory wraps around end of memory
+ * \param  *Buffer: Pointer to \ref BUFFER_t structure
+ * \retval Number of elements in linear block
+ */
+uint32_t BUFFER_GetLinearBlockWriteLength(BUFFER_t* Buffer);
+
+/**
+ * \brief  Adds elements written directly to linear write block to buffer
+ * \param  *Buffer: Pointer to \ref BUFFER_t structure
+ * \param  count: Number of elements written to linear block
+ * \retval Number of elements added to buffer
+ */
+uint32_t BUFFER_Advance(BUFFER_t* Buffer, uint32_t count);
+
 /**
  * \brief  Checks if character exists in location in buffer
  * \param  *Buffer: Pointer to \ref BUFFER_t structure
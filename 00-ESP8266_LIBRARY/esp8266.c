@@ -31,23 +31,15 @@
 /******************************************************************************/
 /******************************************************************************/
 typedef struct {
-    uint8_t Length;
-    uint8_t Data[128];
-} Received_t;
-#define RECEIVED_ADD(c)                     do { Received.Data[Received.Length++] = (c); Received.Data[Received.Length] = 0; } while (0)
-#define RECEIVED_RESET()                    do { Received.Length = 0; Received.Data[0] = 0; } while (0)
-#define RECEIVED_SHIFT()                    do { uint16_t i = 0; for (i = 0; i < Received.Length; i++) { Received.Data[i] = Received.Data[i + 1]; } Received.Data[i] = 0; if (Received.Length) { Received.Length--; } } while (0);
-#define RECEIVED_LENGTH()                   Received.Length
-
-typedef struct {
-    evol const void* CPtr1;
-    evol const void* CPtr2;
-    evol const void* CPtr3;
-    evol void* Ptr1;
-    evol void* Ptr2;
-    evol void** PPtr1;
-    evol uint32_t UI;
-} Pointers_t;
+    uint16_t Cmd;                                           /* Active command response belongs to */
+    const char* Prefix;                                     /* Response prefix */
+    uint8_t Length;                                         /* Length of prefix */
+    void (*Handler)(evol ESP_t* ESP, const char* str);      /* Response handler function */
+} ResponseHandler_t;
+#define RECEIVED_ADD(c)                     do { if (ESP->Received.Length < sizeof(ESP->Received.Data) - 1) { ESP->Received.Data[ESP->Received.Length++] = (c); ESP->Received.Data[ESP->Received.Length] = 0; } } while (0)
+#define RECEIVED_RESET()                    do { ESP->Received.Length = 0; ESP->Received.Data[0] = 0; } while (0)
+#define RECEIVED_SHIFT()                    do { uint16_t i = 0; for (i = 0; i < ESP->Received.Length; i++) { ESP->Received.Data[i] = ESP->Received.Data[i + 1]; } ESP->Received.Data[i] = 0; if (ESP->Received.Length) { ESP->Received.Length--; } } while (0);
+#define RECEIVED_LENGTH()                   ESP->Received.Length
 
 /******************************************************************************/
 /******************************************************************************/
@@ -60,18 +52,50 @@ typedef struct {
 #define CHARHEXTONUM(x)                     (((x) >= '0' && (x) <= '9') ? ((x) - '0') : (((x) >= 'a' && (x) <= 'f') ? ((x) - 'a' + 10) : (((x) >= 'A' && (x) <= 'F') ? ((x) - 'A' + 10) : 0)))
 #define ISVALIDASCII(x)                     (((x) >= 32 && (x) <= 126) || (x) == '\r' || (x) == '\n')
 #define FROMMEM(x)                          ((const char *)(x))
+#define RESP_IS(str, len, resp)             ((len) == sizeof(resp) - 1 && memcmp((str), (resp), sizeof(resp) - 1) == 0)
+#define RESP_ENDS(str, len, resp)           ((len) >= sizeof(resp) - 1 && memcmp((str) + (len) - (sizeof(resp) - 1), (resp), sizeof(resp) - 1) == 0)
 
 /* LL drivers */
-#define UART_SEND_STR(str)                  do { Send.Data = (const uint8_t *)(str); Send.Count = strlen((const char *)(str)); ESP_LL_Callback(ESP_LL_Control_Send, &Send, &Send.Result); } while (0)
-#define UART_SEND(str, len)                 do { Send.Data = (const uint8_t *)(str); Send.Count = (len); ESP_LL_Callback(ESP_LL_Control_Send, &Send, &Send.Result); } while (0)
-#define UART_SEND_CH(ch)                    do { Send.Data = (const uint8_t *)(ch); Send.Count = 1; ESP_LL_Callback(ESP_LL_Control_Send, &Send, &Send.Result); } while (0)
-
-#define RESP_OK                             FROMMEM("OK\r\n")
-#define RESP_ERROR                          FROMMEM("ERROR\r\n")
-#define RESP_BUSY                           FROMMEM("busy p...\r\n")
-#define RESP_READY                          FROMMEM("ready\r\n")
+#define UART_SEND_STR(str)                  StageCommand(ESP, (const uint8_t *)(str), strlen((const char *)(str)))
+#define UART_SEND(str, len)                 do { FlushCommand(ESP); ESP->Send.Data = (const uint8_t *)(str); ESP->Send.Count = (len); ESP->Send.LL = (ESP_LL_t *)&ESP->LL; ESP_LL_Callback(ESP_LL_Control_Send, (void *)&ESP->Send, (void *)&ESP->Send.Result); __STATS_ADD(ESP, UARTBytesOut, ESP->Send.Count); } while (0)
+#define UART_SEND_CH(ch)                    StageCommand(ESP, (const uint8_t *)(ch), 1)
+#define UART_FLUSH()                        FlushCommand(ESP)
+
+#define RESP_OK                             "OK\r\n"
+#define RESP_ERROR                          "ERROR\r\n"
+#define RESP_BUSY                           "busy p...\r\n"
+#define RESP_READY                          "ready\r\n"
 #define _CRLF                               FROMMEM("\r\n")
 
+/* List of response identifiers from classifier */
+#define RESP_ID_NONE                        ((uint8_t)0x00)
+#define RESP_ID_OK                          ((uint8_t)0x01)
+#define RESP_ID_ERROR                       ((uint8_t)0x02)
+#define RESP_ID_BUSY                        ((uint8_t)0x03)
+#define RESP_ID_READY                       ((uint8_t)0x04)
+#define RESP_ID_FAIL                        ((uint8_t)0x05)
+#define RESP_ID_IPD                         ((uint8_t)0x06)
+#define RESP_ID_DATA                        ((uint8_t)0x07)
+#define RESP_ID_WIFI_CONNECTED              ((uint8_t)0x08)
+#define RESP_ID_WIFI_DISCONNECT             ((uint8_t)0x09)
+#define RESP_ID_WIFI_GOT_IP                 ((uint8_t)0x0A)
+#define RESP_ID_CONNECT                     ((uint8_t)0x0B)
+#define RESP_ID_CLOSED                      ((uint8_t)0x0C)
+#define RESP_ID_SEND_OK                     ((uint8_t)0x0D)
+#define RESP_ID_SEND_FAIL                   ((uint8_t)0x0E)
+#define RESP_ID_SEGMENT_OK                  ((uint8_t)0x0F)
+#define RESP_ID_SEGMENT_FAIL                ((uint8_t)0x10)
+#define RESP_ID_RECV                        ((uint8_t)0x11)
+
+/* Streamed responses and kinds of their fields */
+#define TOKEN_TYPE_CWLAP                    ((uint8_t)0x01)
+#define TOKEN_TYPE_CWJAP                    ((uint8_t)0x02)
+#define TOKEN_TYPE_SNTPCFG                  ((uint8_t)0x03)
+#define TOKEN_SKIP                          ((uint8_t)0x00)
+#define TOKEN_NUM                           ((uint8_t)0x01)
+#define TOKEN_STR                           ((uint8_t)0x02)
+#define TOKEN_MAC                           ((uint8_t)0x03)
+
 /* List of commands */
 #define CMD_IDLE                            ((uint16_t)0x0000)
 
@@ -133,8 +157,8 @@ typedef struct {
 #define CMD_WIFI_SETCWSAP                   ((uint16_t)0x210A)
 #define CMD_WIFI_SETSTAIP                   ((uint16_t)0x210B)
 #define CMD_WIFI_SETAPIP                    ((uint16_t)0x210C)
-#define CMD_WIFI_SETHOSTNAME                ((uint16_t)0x200D)
-#define CMD_WIFI_GETHOSTNAME                ((uint16_t)0x200E)
+#define CMD_WIFI_SETHOSTNAME                ((uint16_t)0x210D)
+#define CMD_WIFI_GETHOSTNAME                ((uint16_t)0x210E)
 #define CMD_IS_ACTIVE_WIFI(p)               ((p)->ActiveCmd >= 0x2000 && (p)->ActiveCmd < 0x3000)
 
 #define CMD_TCPIP                           ((uint16_t)0x3000)
@@ -173,6 +197,7 @@ typedef struct {
 #define CMD_IS_ACTIVE_TCPIP(p)              ((p)->ActiveCmd >= 0x3000 && (p)->ActiveCmd < 0x4000)
  
 #define ESP_DEFAULT_BAUDRATE                115200              /* Default ESP8266 baudrate */
+#define ESP_INIT_CACHE_MAGIC                (0x45534900UL | (sizeof(ESP_InitCache_t) & 0xFF))   /* Valid cache marker, changes with cache layout */
 #define ESP_TIMEOUT                         30000               /* Timeout value in milliseconds */
 
 /* In case ESP_RTOS_YIELD hasn't been defined */
@@ -180,13 +205,28 @@ typedef struct {
 #define ESP_RTOS_YIELD()
 #endif
 
+/* In case critical section macros haven't been defined */
+#ifndef ESP_RTOS_CRITICAL_ENTER
+#define ESP_RTOS_CRITICAL_ENTER()
+#define ESP_RTOS_CRITICAL_EXIT()
+#endif
+
 
 /* Debug */
 #define __DEBUG(fmt, ...)                   printf(fmt, ##__VA_ARGS__)
 
+/* Wait for and signal stack events */
+#if ESP_RTOS
+#define __SYS_WAIT(p, e, t)                 SysWait(p, e, t)
+#define __SYS_SIGNAL(p, e)                  SysSignal(p, e)
+#else
+#define __SYS_WAIT(p, e, t)                 0
+#define __SYS_SIGNAL(p, e)                  (void)0
+#endif                                                      /* ESP_RTOS */
+
 /* Delay milliseconds */
 #if ESP_RTOS
-#define __DELAYMS(ESP, x)                   do { volatile uint32_t t = (ESP)->Time; while (((ESP)->Time - t) < (x)) { ESP_RTOS_YIELD(); } } while (0)
+#define __DELAYMS(ESP, x)                   do { volatile uint32_t t = (ESP)->Time; while (((ESP)->Time - t) < (x)) { if (!__SYS_WAIT(ESP, ESP_SYS_EVENT_DELAY, (x) - ((ESP)->Time - t))) { ESP_RTOS_YIELD(); } } } while (0)
 #else
 #define __DELAYMS(ESP, x)                   do { volatile uint32_t t = (ESP)->Time; while (((ESP)->Time - t) < (x)); } while (0)
 #endif
@@ -194,6 +234,9 @@ typedef struct {
 /* Constants */
 #define ESP_MAX_RFPWR                       82
 #define ESP_MAX_SEND_DATA_LEN               2048
+#define ESP_TRANSFER_PACKET_LEN             2048
+#define ESP_TRANSFER_PACKET_TIME            20
+#define ESP_TRANSFER_CLOSED                 "CLOSED\r\n"
 
 #if ESP_RTOS
 #define __IS_BUSY(p)                        ((p)->ActiveCmd != CMD_IDLE || (p)->Flags.F.Call_Idle != 0)
@@ -202,10 +245,46 @@ typedef struct {
 #endif
 #define __IS_READY(p)                       (!__IS_BUSY(p))
 #define __CHECK_BUSY(p)                     do { if (__IS_BUSY(p)) { __RETURN(ESP, espBUSY); } } while (0)
+#define __START_CMD(p, cmd, b)              do { if (CommandCreate(p, cmd, b) != espOK) { __RETURN(p, espBUSY); } } while (0)
 #define __CHECK_INPUTS(c)                   do { if (!(c)) { __RETURN(ESP, espPARERROR); } } while (0)
+#define __IS_BLOCKING(b)                    ((b) == 1)      /* Other non-zero values are request numbers */
+#define __REQUEST_ID(i)                     ((i) + 2)       /* Request number from index in registered requests */
+
+/* Event and command queue indexes run over twice the queue size to tell full queue from empty one */
+#define __QUEUE_NEXT(i, size)               (((i) + 1) % (2 * (size)))
+#define __QUEUE_COUNT(in, out, size)        (((in) + 2 * (size) - (out)) % (2 * (size)))
+
+/* Stack changed module settings kept in initialization cache, next initialization must read them again */
+#define __CACHE_INVALIDATE(p)               do { if ((p)->InitCache) { (p)->InitCache->Magic = 0; } } while (0)
 
 #define __CONN_RESET(c)                     do { uint8_t number = (c)->Number; memset((void *)(c), 0x00, sizeof(ESP_CONN_t)); (c)->Number = number; } while (0)
 #define __CONN_UPDATE_TIME(e, c)            (c)->PollTime = (e)->Time
+#define __CONN_SEGMENTS(c)                  ((c)->SendSegment - (c)->SendSegmentAck)
+
+/* Check if network data are waiting in buffer because connection receive ring is full */
+#if ESP_CONN_RX_SIZE
+#define __RX_STALLED(p)                     ((p)->IPD.InIPD && (p)->IPD.BytesRemaining && !BUFFER_GetFree((BUFFER_t *)&(p)->ConnRx[(p)->IPD.Conn->Number]))
+#elif ESP_IPD_POOL_BLOCKS
+#define __RX_STALLED(p)                     ((p)->IPD.InIPD && (p)->IPD.BytesRemaining && !(p)->PoolFree && __PBUF_NEED_BLOCK(p))
+#else
+#define __RX_STALLED(p)                     0
+#endif                                                      /* ESP_CONN_RX_SIZE */
+
+/* Check if next received byte needs new pool block, each packet starts in new block */
+#define __PBUF_NEED_BLOCK(p)                (!(p)->IPD.BytesRead || !(p)->ConnPbuf[(p)->IPD.Conn->Number].Last || \
+                                                (p)->ConnPbuf[(p)->IPD.Conn->Number].Last->Len == ESP_IPD_POOL_BLOCK_SIZE)
+
+#if ESP_STATS
+#define __STATS_INC(p, field)               (p)->Stats.field++
+#define __STATS_ADD(p, field, v)            (p)->Stats.field += (v)
+#define __STATS_CMD_DONE(p, err)            StatsCommandDone(p, err)
+#define __STATS_RX(p, cnt, written)         StatsReceived(p, cnt, written)
+#else
+#define __STATS_INC(p, field)
+#define __STATS_ADD(p, field, v)
+#define __STATS_CMD_DONE(p, err)
+#define __STATS_RX(p, cnt, written)
+#endif                                                      /* ESP_STATS */
 
 #if ESP_RTOS
 #define __IDLE(p)                           do {\
@@ -213,21 +292,24 @@ typedef struct {
     if (ESP_LL_Callback(ESP_LL_Control_SYS_Release, (void *)&(p)->Sync, &result) || result) {   \
                                                 \
     }                                           \
+    RequestFinished(p);                         \
     (p)->ActiveCmd = CMD_IDLE;                  \
     __RESET_THREADS(p);                         \
     if (!(p)->Flags.F.IsBlocking) {             \
         (p)->Flags.F.Call_Idle = 1;             \
     }                                           \
-    memset((void *)&Pointers, 0x00, sizeof(Pointers));  \
+    memset((void *)&(p)->Pointers, 0x00, sizeof((p)->Pointers));    \
+    __SYS_SIGNAL(p, ESP_SYS_EVENT_READY);       \
 } while (0)
 #else
 #define __IDLE(p)                           do {\
+    RequestFinished(p);                         \
     (p)->ActiveCmd = CMD_IDLE;                  \
     __RESET_THREADS(p);                         \
     if (!(p)->Flags.F.IsBlocking) {             \
         (p)->Flags.F.Call_Idle = 1;             \
     }                                           \
-    memset((void *)&Pointers, 0x00, sizeof(Pointers));  \
+    memset((void *)&(p)->Pointers, 0x00, sizeof((p)->Pointers));    \
 } while (0)
 #endif
 
@@ -249,14 +331,22 @@ typedef struct {
     }                                           \
     (p)->ActiveCmd = (cmd);                     \
 } while (0)
-#endif /* ESP_RTOS */
+#endif                                                      /* ESP_RTOS */
 
 #define __CMD_SAVE(p)                       (p)->ActiveCmdSaved = (p)->ActiveCmd
 #define __CMD_RESTORE(p)                    (p)->ActiveCmd = (p)->ActiveCmdSaved
 
-#define __RETURN(p, v)                      do { (p)->RetVal = (v); return (v); } while (0)
+#define __RETURN(p, v)                      do { ESP_Result_t res = (v); (p)->RetVal = res; return res; } while (0)
 #define __RETURN_BLOCKING(p, b, mt)         return __return_blocking(p, b, mt);
 
+/* Wait in thread for specific time, deadline is reported with ESP_GetNextDeadline */
+#define __THREAD_DELAY(p, pt, ms)           do {\
+    (p)->ThreadTime = (p)->Time;                \
+    (p)->ThreadDelay = (ms);                    \
+    PT_WAIT_UNTIL(pt, (p)->Time - (p)->ThreadTime > (p)->ThreadDelay);  \
+    (p)->ThreadDelay = 0;                       \
+} while (0)
+
 #define __RST_EVENTS_RESP(p)                do { (p)->Events.Value = 0; (p)->ActiveCmdStart = (p)->Time; } while (0)
 
 #define ESP_CALL_CALLBACK(p, e)             (p)->Callback(e, (ESP_EventParams_t *)&(p)->CallbackParams);
@@ -264,9 +354,12 @@ typedef struct {
 
 #if ESP_USE_CTS
 #define ESP_SET_RTS(p, s)                   do {\
-    if (RTSStatus != (s) && !(p)->Flags.F.RTSForced) {  \
-        RTSStatus = (s);                        \
-        ESP_LL_SetRTS((ESP_LL_t *)&(p)->LL, (s));   \
+    if ((p)->RTSStatus != (s) && !(p)->Flags.F.RTSForced) {  \
+        (p)->RTSStatus = (s);                   \
+        ESP_LL_Pin_t pin;                       \
+        pin.State = (s);                        \
+        pin.LL = (ESP_LL_t *)&(p)->LL;          \
+        ESP_LL_Callback(ESP_LL_Control_SetRTS, &pin, NULL); \
     }                                           \
 } while (0)
 #else
@@ -288,28 +381,11 @@ typedef struct {
 /***                            Private variables                            **/
 /******************************************************************************/
 /******************************************************************************/
-#if ESP_USE_CTS
-static 
-uint8_t RTSStatus;                                          /* RTS pin status */
-#endif /* ESP_USE_CTS */
-
-/* Buffers */
-static BUFFER_t Buffer;                                     /* Buffer structure */
-static uint8_t Buffer_Data[ESP_BUFFER_SIZE + 1];            /* Buffer data array */
-static Received_t Received;                                 /* Received data structure */
-static Pointers_t Pointers;                                 /* Pointers object */
-#if ESP_CONN_SINGLEBUFFER
-static uint8_t IPD_Data[ESP_CONNBUFFER_SIZE + 1];           /* Data buffer for incoming connection */
-#endif /* ESP_CONN_SINGLEBUFFER */
-
-static
-struct pt pt_BASIC, pt_WIFI, pt_TCPIP;                      /* Protothread setup */
-
-static
-ESP_LL_Send_t Send;                                         /* Send data setup */
+static evol
+ESP_t* _ESP;                                                /* Default ESP instance for functions without instance parameter */
 
 #define __RESET_THREADS(ESP)                  do {          \
-PT_INIT(&pt_BASIC); PT_INIT(&pt_WIFI); PT_INIT(&pt_TCPIP);  \
+PT_INIT(&(ESP)->PT_BASIC); PT_INIT(&(ESP)->PT_WIFI); PT_INIT(&(ESP)->PT_TCPIP);  \
 } while (0);
 
 /******************************************************************************/
@@ -317,15 +393,50 @@ PT_INIT(&pt_BASIC); PT_INIT(&pt_WIFI); PT_INIT(&pt_TCPIP);  \
 /***                            Private functions                            **/
 /******************************************************************************/
 /******************************************************************************/
+#if ESP_RTOS
+/* Waits for stack event, returns 0 when low-level does not support waiting */
+estatic
+uint8_t SysWait(evol ESP_t* ESP, uint8_t event, uint32_t timeout) {
+    ESP_LL_SysEvent_t evt;
+    uint8_t result = 1;
+    
+    evt.Event = event;
+    evt.Timeout = timeout;
+    evt.LL = (ESP_LL_t *)&ESP->LL;
+    return ESP_LL_Callback(ESP_LL_Control_SYS_Wait, &evt, &result);
+}
+
+/* Signals stack event to waiting thread, may be called from interrupt */
+estatic
+void SysSignal(evol ESP_t* ESP, uint8_t event) {
+    ESP_LL_SysEvent_t evt;
+    uint8_t result = 1;
+    
+    evt.Event = event;
+    evt.Timeout = 0;
+    evt.LL = (ESP_LL_t *)&ESP->LL;
+    ESP_LL_Callback(ESP_LL_Control_SYS_Signal, &evt, &result);
+}
+#endif                                                      /* ESP_RTOS */
+
 /* Blocking return */
 ESP_Result_t __return_blocking(evol ESP_t* p, uint32_t b, uint32_t mt) {
     ESP_Result_t res;
+#if ESP_CMD_QUEUE_SIZE
+    if ((p)->Params != &(p)->Pointers) {                    /* Command was added to queue */
+        (p)->Queue[(p)->QueueIn % ESP_CMD_QUEUE_SIZE].Timeout = mt;
+        (p)->Params = &(p)->Pointers;
+        BUFFER_STORE_RELEASE((p)->QueueIn, __QUEUE_NEXT((p)->QueueIn, ESP_CMD_QUEUE_SIZE)); /* Command is ready for execution */
+        __SYS_SIGNAL(p, ESP_SYS_EVENT_UPDATE);              /* Wake up update thread to start command */
+        __RETURN(p, espOK);
+    }
+#endif                                                      /* ESP_CMD_QUEUE_SIZE */
     (p)->ActiveCmdTimeout = mt;
-    if (!(b)) {
-        (p)->Flags.F.IsBlocking = 0;
+    (p)->Flags.F.IsBlocking = __IS_BLOCKING(b);
+    __SYS_SIGNAL(p, ESP_SYS_EVENT_UPDATE);                  /* Wake up update thread to start command */
+    if (!__IS_BLOCKING(b)) {
         __RETURN(p, espOK);
     }
-    (p)->Flags.F.IsBlocking = 1;
     res = ESP_WaitReady(p, mt);
     if (res == espTIMEOUT) {
         return espTIMEOUT;
@@ -335,6 +446,288 @@ ESP_Result_t __return_blocking(evol ESP_t* p, uint32_t b, uint32_t mt) {
     return res;
 }
 
+/* Writes event to queue, returns 0 when queue is full */
+estatic
+uint8_t EventPut(evol ESP_t* ESP, uint8_t evt, uint8_t conn, uint32_t value) {
+    evol ESP_EventEntry_t* e;
+    uint32_t out;
+    
+    BUFFER_LOAD_ACQUIRE(out, ESP->EventOut);                /* Entries before output index are free */
+    if (__QUEUE_COUNT(ESP->EventIn, out, ESP_EVENT_QUEUE_SIZE) >= ESP_EVENT_QUEUE_SIZE) {   /* Check for free memory */
+        return 0;
+    }
+    e = &ESP->EventQueue[ESP->EventIn % ESP_EVENT_QUEUE_SIZE];
+    e->Event = evt;
+    e->Conn = conn;
+    e->Time = ESP->Time;
+    e->Value = value;
+    BUFFER_STORE_RELEASE(ESP->EventIn, __QUEUE_NEXT(ESP->EventIn, ESP_EVENT_QUEUE_SIZE));   /* Event is ready for processing */
+    return 1;
+}
+
+/* Moves data events which did not fit to queue before to queue */
+estatic
+void EventFlushData(evol ESP_t* ESP) {
+    uint8_t i;
+    
+    for (i = 0; ESP->EventDataPending && i < ESP_MAX_CONNECTIONS; i++) {
+        if (ESP->EventDataPending & (1 << i)) {
+            if (!EventPut(ESP, espEventDataReceived, i, ESP->EventDataValue[i])) {
+                return;                                     /* Still no memory */
+            }
+            ESP->EventDataPending &= ~(1 << i);
+            ESP->EventDataValue[i] = 0;
+        }
+    }
+}
+
+/* Adds event to queue for callback processing, connection is NULL for global events */
+estatic
+void EventAdd(evol ESP_t* ESP, ESP_Event_t evt, ESP_CONN_t* conn, uint32_t value) {
+    if (ESP->EventDataPending) {                            /* Keep waiting data events before new ones */
+        EventFlushData(ESP);
+    }
+    if (evt == espEventDataReceived && conn) {              /* Data event must never be lost, stack waits for it */
+        if ((ESP->EventDataPending & (1 << conn->Number)) || !EventPut(ESP, evt, conn->Number, value)) {
+            ESP->EventDataPending |= 1 << conn->Number;     /* Merge with event waiting for free memory */
+            ESP->EventDataValue[conn->Number] += value;
+        }
+        return;
+    }
+    if (!EventPut(ESP, evt, conn ? conn->Number : ESP_EVENT_NO_CONN, value)) {
+        ESP->EventOverflow++;                               /* Event is lost */
+    }
+}
+
+/* Moves request of finished command to queue of requests waiting for notification */
+estatic
+void RequestFinished(evol ESP_t* ESP) {
+    ESP_Request_t* req = ESP->ActiveRequest;
+    
+    if (!req) {                                             /* No request for this command */
+        return;
+    }
+    ESP->ActiveRequest = NULL;
+    req->Result = ESP->ActiveResult;                        /* Save result of command */
+    ESP->DoneQueue[ESP->DoneIn % ESP_REQUEST_COUNT] = req->Id;  /* Each request waits at most once, queue is never full */
+    BUFFER_STORE_RELEASE(ESP->DoneIn, __QUEUE_NEXT(ESP->DoneIn, ESP_REQUEST_COUNT));
+}
+
+#if ESP_SINGLE_CONN
+/* Processes span of data received in transparent mode, returns number of processed bytes */
+estatic
+uint32_t TransparentReceived(evol ESP_t* ESP, const uint8_t* data, uint32_t len) {
+    uint32_t i = 0;
+    uint8_t closed = 0;
+    
+    while (i < len && !closed) {                            /* Find connection close marker */
+        if (data[i++] == ESP_TRANSFER_CLOSED[ESP->TransferCloseMatch]) {
+            if (++ESP->TransferCloseMatch == sizeof(ESP_TRANSFER_CLOSED) - 1) {
+                closed = 1;
+            }
+        } else {                                            /* Marker does not repeat any of its prefixes */
+            ESP->TransferCloseMatch = data[i - 1] == ESP_TRANSFER_CLOSED[0];
+        }
+    }
+    
+    __STATS_ADD(ESP, Conn[0].BytesReceived, i);
+    if (ESP->ActiveCmd == CMD_IDLE) {                       /* Notify user about entire span */
+        ESP->CallbackParams.CP1 = (const void *)&ESP->Conn[0];
+        ESP->CallbackParams.CP2 = (const void *)data;
+        ESP->CallbackParams.UI = i;
+        ESP->CallbackParams.Time = ESP->Time;
+        ESP_CALL_CALLBACK(ESP, espEventTransparentReceived);
+    }
+    if (closed) {
+        ESP->TransferCloseMatch = 0;
+        ESP->Flags.F.InTransparentMode = 0;                 /* Not in transparent mode anymore */
+        __CONN_RESET(&ESP->Conn[0]);                        /* Reset connection */
+        EventAdd(ESP, espEventConnClosed, (ESP_CONN_t *)&ESP->Conn[0], 0);
+    }
+    return i;
+}
+#endif                                                      /* ESP_SINGLE_CONN */
+
+#if ESP_CONN_RX_SIZE
+/* Copies network data to connection receive ring, returns number of copied bytes or 0 when ring is full */
+estatic
+uint32_t ConnReceived(evol ESP_t* ESP, const uint8_t* data, uint32_t len) {
+    BUFFER_t* ring = (BUFFER_t *)&ESP->ConnRx[ESP->IPD.Conn->Number];
+    uint32_t count;
+    
+    if (len > ESP->IPD.BytesRemaining) {                    /* Do not read more than remaining in IPD packet */
+        len = ESP->IPD.BytesRemaining;
+    }
+    count = BUFFER_Write(ring, data, len);                  /* Copy as much as fits to ring */
+    if (count) {
+        ESP->IPD.BytesRead += count;                        /* Increase number of bytes read since last event */
+        ESP->IPD.BytesRemaining -= count;                   /* Decrease number of bytes remaining to read in entire IPD packet */
+        __CONN_UPDATE_TIME(ESP, ESP->IPD.Conn);             /* Update connection access time */
+    }
+    if (!ESP->IPD.BytesRemaining) {                         /* We read all the data? */
+        ESP->IPD.InIPD = 0;
+    }
+    if (ESP->IPD.BytesRead && (!ESP->IPD.BytesRemaining || !BUFFER_GetFree(ring))) {    /* Packet finished or ring is full */
+        EventAdd(ESP, espEventDataReceived, ESP->IPD.Conn, ESP->IPD.BytesRead);
+        ESP->IPD.BytesRead = 0;
+    }
+    return count;
+}
+#elif ESP_IPD_POOL_BLOCKS
+/* Copies network data to blocks from IPD pool, returns number of copied bytes or 0 when pool is empty */
+estatic
+uint32_t ConnReceived(evol ESP_t* ESP, const uint8_t* data, uint32_t len) {
+    ESP_PBUF_Queue_t* q = (ESP_PBUF_Queue_t *)&ESP->ConnPbuf[ESP->IPD.Conn->Number];
+    ESP_PBUF_t* p;
+    uint32_t count;
+    
+    ESP_RTOS_CRITICAL_ENTER();                              /* Free list and chain are modified by user threads too */
+    p = q->Last;
+    if (__PBUF_NEED_BLOCK(ESP)) {
+        p = ESP->PoolFree;                                  /* Take first free block */
+        if (!p) {                                           /* Pool is empty, keep data in buffer until user frees blocks */
+            ESP_RTOS_CRITICAL_EXIT();
+            return 0;
+        }
+        ESP->PoolFree = p->Next;
+        p->Next = NULL;
+        p->Len = 0;
+        if (++ESP->PoolUsed > ESP->PoolMaxUsed) {           /* Save high-water mark */
+            ESP->PoolMaxUsed = ESP->PoolUsed;
+        }
+        if (q->Last) {                                      /* Add block to end of connection chain */
+            q->Last->Next = p;
+        } else {
+            q->First = p;
+        }
+        q->Last = p;
+    }
+    ESP_RTOS_CRITICAL_EXIT();                               /* Block is not reported yet, only stack writes to it */
+    count = ESP_IPD_POOL_BLOCK_SIZE - p->Len;               /* Get free memory in block */
+    if (count > len) {
+        count = len;
+    }
+    if (count > ESP->IPD.BytesRemaining) {                  /* Do not read more than remaining in IPD packet */
+        count = ESP->IPD.BytesRemaining;
+    }
+    memcpy(&p->Data[p->Len], data, count);                  /* Copy data to block */
+    p->Len += count;
+    ESP->IPD.BytesRead += count;                            /* Increase number of bytes read since last event */
+    ESP->IPD.BytesRemaining -= count;                       /* Decrease number of bytes remaining to read in entire IPD packet */
+    __CONN_UPDATE_TIME(ESP, ESP->IPD.Conn);                 /* Update connection access time */
+    if (!ESP->IPD.BytesRemaining) {                         /* We read all the data? */
+        ESP->IPD.InIPD = 0;
+    }
+    if (!ESP->IPD.BytesRemaining || (!ESP->PoolFree && p->Len == ESP_IPD_POOL_BLOCK_SIZE)) {    /* Packet finished or pool is empty */
+        ESP_RTOS_CRITICAL_ENTER();
+        q->Ready = p;                                       /* Blocks up to this one are passed to user */
+        ESP_RTOS_CRITICAL_EXIT();
+        EventAdd(ESP, espEventDataReceived, ESP->IPD.Conn, ESP->IPD.BytesRead);
+        ESP->IPD.BytesRead = 0;
+    }
+    return count;
+}
+
+/* Removes reported blocks from connection chain, returns first block or NULL when all were already passed to user */
+estatic
+ESP_PBUF_t* PbufTake(evol ESP_t* ESP, uint8_t num, uint32_t* len) {
+    ESP_PBUF_Queue_t* q = (ESP_PBUF_Queue_t *)&ESP->ConnPbuf[num];
+    ESP_PBUF_t* first, *p;
+    
+    ESP_RTOS_CRITICAL_ENTER();                              /* Chain is extended by update thread */
+    first = q->First;
+    if (!q->Ready) {                                        /* Data of this event were passed with previous one */
+        ESP_RTOS_CRITICAL_EXIT();
+        return NULL;
+    }
+    q->First = q->Ready->Next;                              /* Keep blocks of packet being received */
+    if (!q->First) {
+        q->Last = NULL;
+    }
+    q->Ready->Next = NULL;
+    q->Ready = NULL;
+    ESP_RTOS_CRITICAL_EXIT();
+    for (*len = 0, p = first; p; p = p->Next) {             /* Count bytes in chain */
+        *len += p->Len;
+    }
+    return first;
+}
+#endif                                                      /* ESP_CONN_RX_SIZE */
+
+/* Sets new active command from API call or prepares it in command queue when stack is busy */
+estatic
+ESP_Result_t CommandCreate(evol ESP_t* ESP, uint16_t cmd, uint32_t blocking) {
+    ESP_Request_t* req = NULL;
+#if ESP_CMD_QUEUE_SIZE
+    uint32_t out, count;
+#endif                                                      /* ESP_CMD_QUEUE_SIZE */
+    
+    if (blocking >= __REQUEST_ID(0)) {                      /* Command is started with request */
+        if (blocking >= __REQUEST_ID(ESP_REQUEST_COUNT) || !ESP->Requests[blocking - __REQUEST_ID(0)]) {
+            return espPARERROR;
+        }
+        req = ESP->Requests[blocking - __REQUEST_ID(0)];
+        if (!req->Done) {                                   /* Previous command of request did not finish yet */
+            return espBUSY;
+        }
+        blocking = 0;
+    }
+#if ESP_CMD_QUEUE_SIZE
+    BUFFER_LOAD_ACQUIRE(out, ESP->QueueOut);                /* Check queue before stack, only queued commands are started by update thread */
+    count = __QUEUE_COUNT(ESP->QueueIn, out, ESP_CMD_QUEUE_SIZE);
+    if (count || __IS_BUSY(ESP)) {                          /* Command must wait for previous ones */
+        evol ESP_Command_t* c;
+        if (blocking || count >= ESP_CMD_QUEUE_SIZE) {      /* Blocking calls are never queued */
+            return espBUSY;
+        }
+        c = &ESP->Queue[ESP->QueueIn % ESP_CMD_QUEUE_SIZE];
+        memset((void *)c, 0x00, sizeof(ESP_Command_t));
+        c->Cmd = cmd;
+        c->Request = req;
+        if (req) {
+            req->Done = 0;
+        }
+        ESP->Params = &c->Pointers;                         /* API call saves parameters to queue entry */
+        return espOK;
+    }
+#else
+    if (__IS_BUSY(ESP)) {
+        return espBUSY;
+    }
+#endif                                                      /* ESP_CMD_QUEUE_SIZE */
+    if (req) {
+        req->Done = 0;
+    }
+    __ACTIVE_CMD(ESP, cmd);                                 /* Set active command */
+    ESP->ActiveRequest = req;
+    ESP->Params = &ESP->Pointers;                           /* API call saves parameters directly */
+    return espOK;
+}
+
+#if ESP_CMD_QUEUE_SIZE
+/* Starts next command from queue when stack is idle, returns 1 when command started */
+estatic
+uint8_t CommandQueueDispatch(evol ESP_t* ESP) {
+    evol ESP_Command_t* c;
+    uint32_t in;
+    
+    BUFFER_LOAD_ACQUIRE(in, ESP->QueueIn);                  /* Entries before input index are complete */
+    if (ESP->ActiveCmd != CMD_IDLE || in == ESP->QueueOut) {/* Nothing to start */
+        return 0;
+    }
+    c = &ESP->Queue[ESP->QueueOut % ESP_CMD_QUEUE_SIZE];
+    __ACTIVE_CMD(ESP, c->Cmd);                              /* Set active command */
+    memcpy((void *)&ESP->Pointers, (const void *)&c->Pointers, sizeof(ESP->Pointers));  /* Copy command parameters */
+    ESP->ActiveCmdStart = ESP->Time;
+    ESP->ActiveCmdTimeout = c->Timeout;
+    ESP->ActiveResult = espOK;
+    ESP->ActiveRequest = c->Request;
+    ESP->Flags.F.IsBlocking = 0;                            /* Queued commands are always non-blocking */
+    BUFFER_STORE_RELEASE(ESP->QueueOut, __QUEUE_NEXT(ESP->QueueOut, ESP_CMD_QUEUE_SIZE));   /* Entry may be reused by API call */
+    return 1;
+}
+#endif                                                      /* ESP_CMD_QUEUE_SIZE */
+
 /* Default callback for events */
 estatic
 int ESP_CallbackDefault(ESP_Event_t evt, ESP_EventParams_t* params) {
@@ -382,6 +775,22 @@ int32_t ParseNumber(const char* ptr, uint8_t* cnt) {
     return sum;                                       		/* Return number */
 }
 
+/* Parses comma separated list of numbers, returns number of parsed values */
+estatic
+uint8_t ParseNumbers(const char* str, uint32_t* nums, uint8_t max) {
+    uint8_t cnt, n = 0;
+    
+    while (n < max && CHARISNUM(*str)) {
+        nums[n++] = (uint32_t)ParseNumber(str, &cnt);
+        str += cnt;
+        if (*str != ',') {                                  /* End of list */
+            break;
+        }
+        str++;
+    }
+    return n;
+}
+
 /* Parses and returns HEX number from string */
 estatic
 uint32_t ParseHexNumber(const char* ptr, uint8_t* cnt) {
@@ -440,83 +849,6 @@ void ParseIP(evol ESP_t* ESP, const char* str, uint8_t* ip, uint8_t* cnt) {
     }
 }
 
-/* Parse +CWLAP statement */
-estatic
-void ParseCWLAP(evol ESP_t* ESP, const char* str, ESP_AP_t* AP) {
-    uint8_t cnt;
-    
-    (void)ESP;                                              /* Process unused */
-    
-    if (*str == '(') {                                      /* Remove opening bracket */
-        str++;
-    }
-    
-    memset((void *)AP, 0x00, sizeof(ESP_AP_t));             /* Reset structure first */
-    
-    AP->Ecn = (ESP_Ecn_t)ParseNumber(str, &cnt);            /* Parse ECN value */
-    str += cnt + 1;
-    
-    if (*str == '"') {                                      /* Remove opening " */
-        str++;
-    }
-    
-    cnt = 0;                                                /* Parse SSID */
-    while (*str) {
-        if (*str == '"' && *(str + 1) == ',') {
-            break;
-        }
-        if (cnt < sizeof(AP->SSID) - 1) {
-            AP->SSID[cnt] = *str;
-        }
-        
-        cnt++;
-        str++;
-    }
-    
-    str += 2;                                               /* Parse RSSI */
-    AP->RSSI = ParseNumber(str, &cnt);
-    
-    str += cnt + 1;
-    if (*str == '"') {
-        str++;
-    }
-    ParseMAC(ESP, str, AP->MAC, NULL);                      /* Parse MAC */
-    str += 19;                                              /* Ignore mac, " and comma */
-    AP->Channel = ParseNumber(str, &cnt);                   /* Parse channel for wifi */
-    str += cnt + 1;
-    AP->Offset = ParseNumber(str, &cnt);                    /* Parse offset */
-    str += cnt + 1;
-    AP->Calibration = ParseNumber(str, &cnt);               /* Parse calibration number */
-    str += cnt + 1;
-}
-
-/* Parse +CWJAP statement */
-estatic
-void ParseCWJAP(evol ESP_t* ESP, const char* ptr, ESP_ConnectedAP_t* AP) {
-    uint8_t i, cnt;
-    
-    (void)ESP;                                              /* Process unused */
-    
-    while (*ptr && *ptr != '"') {                    		/* Find first " character */
-        ptr++;
-    }
-    if (!*ptr) {                                    		/* Check if zero detected */
-        return;
-    }
-    ptr++;                                            		/* Remove first " for SSID */
-    i = 0;                                            		/* Parse SSID part */
-    while (*ptr && (*ptr != '"' || *(ptr + 1) != ',' || *(ptr + 2) != '"')) {
-        AP->SSID[i++] = *ptr++;
-    }
-    AP->SSID[i++] = 0;
-    ptr += 3;                                        		/* Increase pointer by 3, ignore "," part */
-    ParseMAC(ESP, ptr, AP->MAC, NULL);    	                /* Get MAC */
-    ptr += 19;                                    		    /* Increase counter by elements in MAC address and ", part */
-    AP->Channel = ParseNumber(ptr, &cnt);	                /* Get channel */
-    ptr += cnt + 1;                                    		/* Increase position */
-    AP->RSSI = ParseNumber(ptr, &cnt);    /* Get RSSI */
-}
-
 /* Parse CWLIF statement with IP and MAC */
 estatic
 void ParseCWLIF(evol ESP_t* ESP, const char* str, ESP_ConnectedStation_t* station) {
@@ -539,7 +871,7 @@ void ParseIPD(evol ESP_t* ESP, const char* str, ESP_IPD_t* IPD) {
     str += cnt + 1;
 #else
     IPD->Conn = (ESP_CONN_t *)&ESP->Conn[0];                /* Get connection */
-#endif /* !ESP_SINGLE_CONN */
+#endif                                                      /* !ESP_SINGLE_CONN */
     __CONN_UPDATE_TIME(ESP, IPD->Conn);                     /* Update connection access time */
     IPD->BytesRemaining = ParseNumber(str, &cnt);           /* Set bytes remaining to read */
 }
@@ -583,7 +915,7 @@ void ParseCIPSTATUS(evol ESP_t* ESP, uint8_t* value, const char* str) {
     
 #if !ESP_SINGLE_CONN
     connNumber = CHARTONUM(*str);                           /* Get connection number */
-#endif /* !ESP_SINGLE_CONN */
+#endif                                                      /* !ESP_SINGLE_CONN */
     *value |= 1 << connNumber;                              /* Set bit according to active connection */
     
     /* Parse connection parameters */
@@ -720,46 +1052,6 @@ void ParseSNTPTime(evol ESP_t* ESP, const char* str, ESP_DateTime_t* dt) {
     dt->Year = ParseNumber(str, &cnt);                      /* Get year */
 }
 
-/* Parse SNTP config */
-estatic
-void ParseSNTPConfig(evol ESP_t* ESP, const char* str, ESP_SNTP_t* conf) {
-    uint8_t cnt, i;
-    char *dst;
-    
-    (void)ESP;                                              /* Process unused */
-    
-    conf->Enable = ParseNumber(str, &cnt);                  /* Get enabled status */
-    str += cnt + 1;
-    
-    conf->Timezone = (int8_t)ParseNumber(str, &cnt);        /* Get timezone */
-    str += cnt + 1;
-    
-    /* Parse server addresses */
-    for (i = 0; i < sizeof(conf->Addr) / sizeof(conf->Addr[0]); i++) {
-        if (!conf->Addr[i]) {                               /* Check if memory is set */
-            break;
-        }
-        dst = conf->Addr[i];                                /* Set destination pointer */
-        if (*str == '"') {
-            str++;
-        }
-        while (*str) {                                      /* Process entire string */
-            if (*str == '"') {                              /* Check if end of server received */
-                if (*(str + 1) == ',') {                    /* If comma is next */
-                    str += 2;                               /* Ignore this char and next one */
-                    break;                                  /* Stop parsing this server and go to next one */
-                } else if (*(str + 1) == '\r') {            /* If new line received */
-                    return;                                 /* Stop function execution */
-                }
-            }
-            *dst = *str;
-            str++;
-            dst++;
-        }
-        *dst = 0;
-    }
-}
-
 /* Parse SYSIOGETCFG value */
 estatic
 void ParseSysIOGetCfg(evol ESP_t* ESP, const char* str, ESP_GPIO_t* conf) {
@@ -789,262 +1081,864 @@ void ParseCIPDNS(evol ESP_t* ESP, const char* str, ESP_DNS_t* dns) {
     if (*str == '"') {
         str++;
     }
-    for (i = 0; i < 4; i++) {
-        dns->Addr[dns->_ptr][i] = ParseNumber(str, &cnt);   /* Parse IP number */
-        str += cnt + 1;                                     /* Go to next number */
+    for (i = 0; i < 4; i++) {
+        dns->Addr[dns->_ptr][i] = ParseNumber(str, &cnt);   /* Parse IP number */
+        str += cnt + 1;                                     /* Go to next number */
+    }
+    dns->_ptr++;                                            /* Increase DNS pointer by 1 */
+}
+
+/* Parses [n,]segment,SEND OK or [n,]segment,SEND FAIL response */
+estatic
+void ParseSegmentSent(evol ESP_t* ESP, const char* str, uint8_t ok) {
+    uint32_t nums[2];
+    uint8_t n;
+    ESP_CONN_t* conn;
+    
+    n = ParseNumbers(str, nums, 2);
+    conn = (ESP_CONN_t *)&ESP->Conn[n > 1 ? nums[0] % ESP_MAX_CONNECTIONS : 0]; /* Connection number is only in multiple connections mode */
+    if ((int32_t)(nums[n - 1] - conn->SendSegmentAck) > 0) {    /* Segments are sent in order */
+        conn->SendSegmentAck = nums[n - 1];
+    }
+    EventAdd(ESP, ok ? espEventDataSegmentSent : espEventDataSegmentSentError, conn, nums[n - 1]);
+}
+
+/* Parses numeric responses of AT+CIPSENDBUF, AT+CIPBUFSTATUS and AT+CIPCHECKSEQ commands */
+estatic
+void ParseSendBufStatus(evol ESP_t* ESP, const char* str) {
+    ESP_CONN_t* conn = (ESP_CONN_t *)ESP->Pointers.Ptr1;
+    uint32_t nums[6], ack = 0;
+    uint8_t n;
+    
+    n = ParseNumbers(str, nums, 6);
+    if (ESP->ActiveCmd == CMD_TCPIP_CIPSENDBUF && n == 2) { /* <segment>,<sent segment> */
+        conn->SendSegment = nums[0];
+        ack = nums[1];
+    } else if (ESP->ActiveCmd == CMD_TCPIP_CIPBUFSTATUS && n >= 5) {    /* [n,]<next segment>,<sent segment>,<acked segment>,<free size>,<queue number> */
+        conn->SendSegment = nums[n - 5] - 1;
+        conn->SendBufferFree = nums[n - 2];
+        ack = nums[n - 3];
+    } else if (ESP->ActiveCmd == CMD_TCPIP_CIPCHECKSEQ && n >= 2) { /* [n,]<segment>,<status> */
+        if (ESP->Pointers.Ptr2) {
+            *(uint8_t *)ESP->Pointers.Ptr2 = nums[n - 1] == 1;
+        }
+        return;
+    } else {
+        return;
+    }
+    if ((int32_t)(ack - conn->SendSegmentAck) > 0) {        /* Do not go back with acknowledged segment */
+        conn->SendSegmentAck = ack;
+    }
+}
+
+/* Gets kind of current field in streamed response */
+estatic
+uint8_t TokenizerFieldKind(evol ESP_t* ESP) {
+    static const uint8_t FieldsCWLAP[] = {TOKEN_NUM, TOKEN_STR, TOKEN_NUM, TOKEN_MAC, TOKEN_NUM, TOKEN_NUM, TOKEN_NUM};
+    static const uint8_t FieldsCWJAP[] = {TOKEN_STR, TOKEN_MAC, TOKEN_NUM, TOKEN_NUM};
+    uint8_t field = ESP->Tokenizer.Field;
+    
+    switch (ESP->Tokenizer.Type) {
+        case TOKEN_TYPE_CWLAP:
+            return field < sizeof(FieldsCWLAP) ? FieldsCWLAP[field] : TOKEN_SKIP;
+        case TOKEN_TYPE_CWJAP:
+            return field < sizeof(FieldsCWJAP) ? FieldsCWJAP[field] : TOKEN_SKIP;
+        case TOKEN_TYPE_SNTPCFG:
+            return field < 2 ? TOKEN_NUM : TOKEN_STR;
+        default:
+            return TOKEN_SKIP;
+    }
+}
+
+/* Gets memory for current string field in streamed response */
+estatic
+char* TokenizerString(evol ESP_t* ESP, uint8_t* size) {
+    uint8_t field = ESP->Tokenizer.Field;
+    
+    switch (ESP->Tokenizer.Type) {
+        case TOKEN_TYPE_CWLAP:
+            *size = sizeof(((ESP_AP_t *)0)->SSID);
+            return ((ESP_AP_t *)ESP->Pointers.Ptr1)->SSID;
+        case TOKEN_TYPE_CWJAP:
+            *size = sizeof(((ESP_ConnectedAP_t *)0)->SSID);
+            return ((ESP_ConnectedAP_t *)ESP->Pointers.Ptr1)->SSID;
+        case TOKEN_TYPE_SNTPCFG: {
+            ESP_SNTP_t* conf = (ESP_SNTP_t *)ESP->Pointers.Ptr1;
+            uint8_t i;
+            
+            field -= 2;                                     /* Servers start at field 2 */
+            if (field >= sizeof(conf->Addr) / sizeof(conf->Addr[0])) {
+                return NULL;
+            }
+            for (i = 0; i <= field; i++) {                  /* Stop at first server without memory */
+                if (!conf->Addr[i]) {
+                    return NULL;
+                }
+            }
+            *size = conf->AddrSize ? conf->AddrSize : ESP_SNTP_ADDR_SIZE;   /* Size of user memory */
+            return conf->Addr[field];
+        }
+        default:
+            return NULL;
+    }
+}
+
+/* Gets memory for current MAC field in streamed response */
+estatic
+uint8_t* TokenizerMAC(evol ESP_t* ESP) {
+    switch (ESP->Tokenizer.Type) {
+        case TOKEN_TYPE_CWLAP:
+            return ((ESP_AP_t *)ESP->Pointers.Ptr1)->MAC;
+        case TOKEN_TYPE_CWJAP:
+            return ((ESP_ConnectedAP_t *)ESP->Pointers.Ptr1)->MAC;
+        default:
+            return NULL;
+    }
+}
+
+/* Saves value of current number field in streamed response */
+estatic
+void TokenizerNumber(evol ESP_t* ESP, int32_t num) {
+    switch (ESP->Tokenizer.Type) {
+        case TOKEN_TYPE_CWLAP: {
+            ESP_AP_t* AP = (ESP_AP_t *)ESP->Pointers.Ptr1;
+            switch (ESP->Tokenizer.Field) {
+                case 0: AP->Ecn = (ESP_Ecn_t)num; break;
+                case 2: AP->RSSI = (int16_t)num; break;
+                case 4: AP->Channel = (uint8_t)num; break;
+                case 5: AP->Offset = (int8_t)num; break;
+                case 6: AP->Calibration = (uint8_t)num; break;
+                default: break;
+            }
+            break;
+        }
+        case TOKEN_TYPE_CWJAP: {
+            ESP_ConnectedAP_t* AP = (ESP_ConnectedAP_t *)ESP->Pointers.Ptr1;
+            switch (ESP->Tokenizer.Field) {
+                case 2: AP->Channel = (uint8_t)num; break;
+                case 3: AP->RSSI = (int16_t)num; break;
+                default: break;
+            }
+            break;
+        }
+        case TOKEN_TYPE_SNTPCFG: {
+            ESP_SNTP_t* conf = (ESP_SNTP_t *)ESP->Pointers.Ptr1;
+            switch (ESP->Tokenizer.Field) {
+                case 0: conf->Enable = (uint8_t)num; break;
+                case 1: conf->Timezone = (int8_t)num; break;
+                default: break;
+            }
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+/* Processes character of current field in streamed response */
+estatic
+void TokenizerChar(evol ESP_t* ESP, char ch) {
+    evol ESP_Tokenizer_t* t = &ESP->Tokenizer;
+    
+    switch (TokenizerFieldKind(ESP)) {
+        case TOKEN_NUM:
+            if (ch == '-') {
+                t->Flags.F.Negative = 1;
+            } else if (CHARISNUM(ch)) {
+                t->Number = t->Number * 10 + CHARTONUM(ch);
+            }
+            break;
+        case TOKEN_MAC:
+            if (ch == ':') {                                /* End of MAC part */
+                uint8_t* mac = TokenizerMAC(ESP);
+                if (t->Part < 6) {
+                    mac[t->Part++] = (uint8_t)t->Number;
+                }
+                t->Number = 0;
+            } else if (CHARISHEXNUM(ch)) {
+                t->Number = (t->Number << 4) | CHARHEXTONUM(ch);
+            }
+            break;
+        case TOKEN_STR: {
+            uint8_t size;
+            char* str = TokenizerString(ESP, &size);
+            if (str && t->Length < size - 1) {              /* Save character when memory available */
+                str[t->Length++] = ch;
+                str[t->Length] = 0;
+            }
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+/* Ends current field in streamed response */
+estatic
+void TokenizerFieldEnd(evol ESP_t* ESP) {
+    evol ESP_Tokenizer_t* t = &ESP->Tokenizer;
+    
+    switch (TokenizerFieldKind(ESP)) {
+        case TOKEN_NUM:
+            TokenizerNumber(ESP, t->Flags.F.Negative ? -t->Number : t->Number);
+            break;
+        case TOKEN_MAC:
+            if (t->Part < 6) {                              /* Save last part of MAC */
+                TokenizerMAC(ESP)[t->Part] = (uint8_t)t->Number;
+            }
+            break;
+        default:
+            break;
+    }
+    t->Field++;                                             /* Go to next field */
+    t->Length = 0;
+    t->Part = 0;
+    t->Number = 0;
+    t->Flags.F.Negative = 0;
+}
+
+/* Starts streamed response after prefix was received, returns 1 when tokenizer took over the line */
+estatic
+uint8_t TokenizerStart(evol ESP_t* ESP, const char* str, uint8_t len) {
+    uint8_t type = 0;
+    
+    if (ESP->ActiveCmd == CMD_WIFI_CWLAP && RESP_IS(str, len, "+CWLAP:")) {
+        if (*(uint16_t *)ESP->Pointers.Ptr2 < ESP->Pointers.UI) {   /* Check if memory still available */
+            memset((void *)ESP->Pointers.Ptr1, 0x00, sizeof(ESP_AP_t)); /* Reset structure first */
+            type = TOKEN_TYPE_CWLAP;
+        }
+    } else if (ESP->ActiveCmd == CMD_WIFI_CWJAP && RESP_IS(str, len, "+CWJAP_CUR:")) {
+        if (ESP->Pointers.Ptr1) {
+            type = TOKEN_TYPE_CWJAP;
+        }
+    } else if (ESP->ActiveCmd == CMD_TCPIP_SNTPGETCFG && RESP_IS(str, len, "+CIPSNTPCFG:")) {
+        type = TOKEN_TYPE_SNTPCFG;
+    }
+    if (type) {
+        memset((void *)&ESP->Tokenizer, 0x00, sizeof(ESP->Tokenizer));  /* Reset tokenizer */
+        ESP->Tokenizer.Type = type;
+    }
+    return type != 0;
+}
+
+/* Processes received character of streamed response */
+estatic
+void TokenizerProcess(evol ESP_t* ESP, char ch) {
+    evol ESP_Tokenizer_t* t = &ESP->Tokenizer;
+    
+    if (t->Flags.F.QuoteEnd) {                              /* Quote was received inside string */
+        t->Flags.F.QuoteEnd = 0;
+        if (ch == ',' || ch == ')' || ch == '\r') {         /* It was closing quote */
+            t->Flags.F.Quoted = 0;
+        } else {
+            TokenizerChar(ESP, '"');                        /* Quote is part of string */
+        }
+    }
+    if (t->Flags.F.Quoted) {                                /* Inside quoted string */
+        if (ch == '"') {
+            t->Flags.F.QuoteEnd = 1;                        /* Check next character first */
+        } else {
+            TokenizerChar(ESP, ch);
+        }
+        return;
+    }
+    if (t->Flags.F.Done) {                                  /* Ignore everything after last field */
+        return;
+    }
+    switch (ch) {
+        case '"':                                           /* Start of quoted string */
+            t->Flags.F.Quoted = 1;
+            break;
+        case '(':                                           /* Opening bracket of fields */
+            break;
+        case ',':                                           /* End of field */
+            TokenizerFieldEnd(ESP);
+            break;
+        case ')':                                           /* End of all fields */
+        case '\r':
+            TokenizerFieldEnd(ESP);
+            t->Flags.F.Done = 1;
+            break;
+        default:
+            TokenizerChar(ESP, ch);
+            break;
+    }
+}
+
+/* Ends streamed response on line end */
+estatic
+void TokenizerEnd(evol ESP_t* ESP) {
+    if (!ESP->Tokenizer.Flags.F.Done) {                     /* Line ended without CR */
+        TokenizerFieldEnd(ESP);
+    }
+    if (ESP->Tokenizer.Type == TOKEN_TYPE_CWLAP) {          /* Go to next access point */
+        ESP->Pointers.Ptr1 = ((ESP_AP_t *)ESP->Pointers.Ptr1) + 1;
+        *(uint16_t *)ESP->Pointers.Ptr2 = (*(uint16_t *)ESP->Pointers.Ptr2) + 1;  /* Increase number of parsed elements */
+    }
+    ESP->Tokenizer.Type = 0;                                /* Tokenizer is not active anymore */
+}
+
+/* Sends staged command to low-level layer with single call */
+estatic
+void FlushCommand(evol ESP_t* ESP) {
+    if (ESP->TXLength) {                                    /* Check if anything to send */
+        ESP->Send.Data = (const uint8_t *)ESP->TXData;
+        ESP->Send.Count = ESP->TXLength;
+        ESP->Send.LL = (ESP_LL_t *)&ESP->LL;
+        ESP_LL_Callback(ESP_LL_Control_Send, (void *)&ESP->Send, (void *)&ESP->Send.Result);    /* Send data at once */
+        __STATS_ADD(ESP, UARTBytesOut, ESP->TXLength);
+        ESP->TXLength = 0;
+    }
+}
+
+/* Adds command part to staging buffer, flushes when buffer is full */
+estatic
+void StageCommand(evol ESP_t* ESP, const uint8_t* data, uint32_t count) {
+    uint32_t len;
+    
+    while (count) {
+        len = ESP_TX_BUFFER_SIZE - ESP->TXLength;           /* Get free memory in buffer */
+        if (len > count) {
+            len = count;
+        }
+        memcpy((void *)&ESP->TXData[ESP->TXLength], data, len); /* Copy data to staging buffer */
+        ESP->TXLength += len;
+        data += len;
+        count -= len;
+        if (ESP->TXLength == ESP_TX_BUFFER_SIZE) {          /* Buffer is full, flush it */
+            FlushCommand(ESP);
+        }
+    }
+}
+
+/* Sets new baudrate to low-level layer and drops data received with previous one */
+estatic
+void SetBaudrate(evol ESP_t* ESP, uint32_t baudrate) {
+    uint8_t result;
+    
+    BUFFER_Reset((BUFFER_t *)&ESP->Buffer);                 /* Reset buffer */
+    ESP->LL.Baudrate = baudrate;
+    ESP_LL_Callback(ESP_LL_Control_Init, (void *)&ESP->LL, &result);    /* Init low-level layer again */
+}
+
+/* Sends packet of len bytes from send vector at current position, or only moves position when skip is set */
+estatic
+void SendVector(evol ESP_t* ESP, uint32_t len, uint8_t skip) {
+    const ESP_SendVec_t* v = (const ESP_SendVec_t *)ESP->Pointers.CPtr2;
+    const uint8_t* d = (const uint8_t *)ESP->Pointers.CPtr1;
+    uint32_t count;
+    
+    while (len) {
+        count = v->Len - (uint32_t)(d - (const uint8_t *)v->Data);  /* Get bytes left in current buffer */
+        if (!count) {                                       /* Go to next buffer */
+            v++;
+            d = (const uint8_t *)v->Data;
+            continue;
+        }
+        if (count > len) {
+            count = len;
+        }
+        if (!skip) {
+            UART_SEND(d, count);                            /* Send part of packet directly from user memory */
+        }
+        d += count;
+        len -= count;
+    }
+    if (skip) {
+        ESP->Pointers.CPtr2 = v;                            /* Save new position */
+        ESP->Pointers.CPtr1 = d;
+    }
+}
+
+#if ESP_SINGLE_CONN && ESP_TRANSFER_TX_SIZE
+/* Sends data from transparent mode transmit ring, in full packets or when packet time expired */
+estatic
+void TransferFlush(evol ESP_t* ESP, uint8_t force) {
+    BUFFER_t* Buff = (BUFFER_t *)&ESP->TransferTx;
+    uint32_t full, len;
+    
+    full = BUFFER_GetFull(Buff);
+    if (!force && full < ESP_TRANSFER_PACKET_LEN && ESP->Time - ESP->TransferTxTime < ESP_TRANSFER_PACKET_TIME) {
+        return;                                             /* Wait for more data to fill packet */
+    }
+    if (!force && full > ESP_TRANSFER_PACKET_LEN) {
+        full = ESP_TRANSFER_PACKET_LEN;                     /* Send single packet at a time */
+    }
+    while (full && (len = BUFFER_GetLinearBlockReadLength(Buff)) > 0) {
+        if (len > full) {
+            len = full;
+        }
+        UART_SEND((uint8_t *)BUFFER_GetLinearBlockReadAddress(Buff), len);  /* Send data directly from ring memory */
+        __STATS_ADD(ESP, Conn[0].BytesSent, len);
+        BUFFER_Skip(Buff, len);
+        full -= len;
+    }
+    ESP->TransferTxTime = ESP->Time;                        /* Remaining data start new packet */
+}
+#endif                                                      /* ESP_SINGLE_CONN && ESP_TRANSFER_TX_SIZE */
+
+#if ESP_STATS
+/* Saves latency of command waiting for response to its histogram */
+estatic
+void StatsCommandDone(evol ESP_t* ESP, uint8_t error) {
+    ESP_CmdStats_t* s = NULL;
+    uint32_t t = ESP->Time - ESP->StatsCmdStart, i;
+    uint8_t bin = 0;
+    
+    if (ESP->StatsCmd == CMD_IDLE) {                        /* Latency already saved */
+        return;
+    }
+    for (i = 0; i < ESP_STATS_CMDS; i++) {                  /* Find entry of command or first unused entry */
+        if (ESP->Stats.Cmd[i].Cmd == ESP->StatsCmd || ESP->Stats.Cmd[i].Cmd == CMD_IDLE) {
+            s = (ESP_CmdStats_t *)&ESP->Stats.Cmd[i];
+            break;
+        }
+    }
+    if (s == NULL) {
+        ESP->Stats.CmdLost++;                               /* All entries are used */
+    } else {
+        s->Cmd = ESP->StatsCmd;
+        s->Count++;
+        s->Total += t;
+        if (t > s->Max) {
+            s->Max = t;
+        }
+        if (error) {
+            s->Errors++;
+        }
+        while (t && bin < ESP_STATS_BINS - 1) {             /* Find logarithmic bin of latency */
+            t >>= 1;
+            bin++;
+        }
+        if (s->Bins[bin] != 0xFFFF) {                       /* Stop counting when bin is full */
+            s->Bins[bin]++;
+        }
+    }
+    ESP->StatsCmd = CMD_IDLE;
+}
+
+/* Counts bytes written to USART input buffer and buffer usage */
+estatic
+void StatsReceived(evol ESP_t* ESP, uint32_t count, uint32_t written) {
+    uint32_t full = BUFFER_GetFull((BUFFER_t *)&ESP->Buffer);
+    
+    ESP->Stats.UARTBytesIn += written;
+    ESP->Stats.RxOverflow += count - written;               /* Bytes which did not fit to buffer */
+    if (full > ESP->Stats.RxBufferMax) {
+        ESP->Stats.RxBufferMax = full;
+    }
+}
+#endif                                                      /* ESP_STATS */
+
+/* Starts command and sets pointer for return statement */
+estatic 
+ESP_Result_t StartCommand(evol ESP_t* ESP, uint16_t cmd, const char* cmdResp) {
+    FlushCommand(ESP);                                      /* Send assembled command to device */
+    
+    ESP->ActiveCmd = cmd;
+    ESP->ActiveCmdResp = (char *)cmdResp;
+    ESP->ActiveCmdStart = ESP->Time;
+    ESP->ActiveResult = espOK;
+#if ESP_STATS
+    ESP->StatsCmd = cmd;                                    /* Save latency when response is received */
+    ESP->StatsCmdStart = ESP->Time;
+#endif                                                      /* ESP_STATS */
+    
+    if (cmd == CMD_TCPIP_CIPSTATUS) {                       /* On CIPSTATUS command */
+        ESP->ActiveConnsResp = 0;                           /* Reset active connections status */
+    }
+    
+    return espOK;
+}
+
+/* Converts number to string */
+estatic
+void NumberToString(char* str, uint32_t number) {
+    sprintf(str, "%lu", (unsigned long)number);
+}
+
+/* Converts number to hex for MAC */
+estatic
+void HexNumberToString(char* str, uint8_t number) {
+    sprintf(str, "%02X", (unsigned)number);
+}
+
+/* Escapes string and sends directly to output stream */
+estatic
+void EscapeStringAndSend(evol ESP_t* ESP, const char* str) {
+    char special = '\\';
+    
+    while (*str) {                                    		/* Go through string */
+        if (*str == ',' || *str == '"' || *str == '\\') {	/* Check for special character */    
+            UART_SEND_CH(&special);                         /* Send special character */
+        }
+        UART_SEND_CH(str++);                                /* Send character */
+    }
+}
+
+/* Handles +CWSAP response */
+estatic
+void HandleCWSAP(evol ESP_t* ESP, const char* str) {
+    ParseCWSAP(ESP, str + 12, (void *)&ESP->APConf);        /* Parse config from AP */
+}
+
+/* Handles ping time response */
+estatic
+void HandlePing(evol ESP_t* ESP, const char* str) {
+    if (CHARISNUM(str[1])) {
+        *(uint32_t *)ESP->Pointers.Ptr1 = ParseNumber(str + 1, NULL);   /* Parse response time */
+    }
+}
+
+/* Handles +SYSRAM and +SYSADC responses */
+estatic
+void HandleSysValue(evol ESP_t* ESP, const char* str) {
+    *(uint32_t *)ESP->Pointers.Ptr1 = ParseNumber(str + 8, NULL);   /* Parse value */
+}
+
+/* Handles +SYSGPIOREAD response */
+estatic
+void HandleSysGPIORead(evol ESP_t* ESP, const char* str) {
+    ParseSysGPIORead(ESP, str + 13, (void *)ESP->Pointers.Ptr1, (void *)ESP->Pointers.Ptr2);
+}
+
+/* Handles +SYSIOGETCFG response */
+estatic
+void HandleSysIOGetCfg(evol ESP_t* ESP, const char* str) {
+    ParseSysIOGetCfg(ESP, str + 13, (void *)ESP->Pointers.Ptr1);
+}
+
+/* Handles +CIPAP_CUR response */
+estatic
+void HandleCIPAP(evol ESP_t* ESP, const char* str) {
+    if (str[11] == 'i') {                                   /* +CIPAP_CUR:ip received */
+        ParseIP(ESP, str + 15, (void *)&ESP->APIP, NULL);   /* Parse IP string */
+        if (ESP->Pointers.Ptr1) {
+            memcpy((void *)ESP->Pointers.Ptr1, (void *)&ESP->APIP, 4);
+        }
+    } else if (str[11] == 'g') {
+        ParseIP(ESP, str + 20, (void *)&ESP->APGateway, NULL);  /* Parse IP string */
+    } else if (str[11] == 'n') {
+        ParseIP(ESP, str + 20, (void *)&ESP->APNetmask, NULL);  /* Parse IP string */
+    }
+}
+
+/* Handles +CIPSTA_CUR response */
+estatic
+void HandleCIPSTA(evol ESP_t* ESP, const char* str) {
+    if (str[12] == 'i') {                                   /* +CIPSTA_CUR:ip received */
+        ParseIP(ESP, str + 16, (void *)&ESP->STAIP, NULL);  /* Parse IP string */
+        if (ESP->Pointers.Ptr1) {
+            memcpy((void *)ESP->Pointers.Ptr1, (void *)&ESP->STAIP, 4);
+        }
+    } else if (str[12] == 'g') {
+        ParseIP(ESP, str + 21, (void *)&ESP->STAGateway, NULL); /* Parse IP string */
+    } else if (str[12] == 'n') {
+        ParseIP(ESP, str + 21, (void *)&ESP->STANetmask, NULL); /* Parse IP string */
+    }
+}
+
+/* Handles +CIPSTAMAC_CUR response */
+estatic
+void HandleCIPSTAMAC(evol ESP_t* ESP, const char* str) {
+    ParseMAC(ESP, str + 16, (void *)&ESP->STAMAC, NULL);    /* Parse MAC */
+    if (ESP->Pointers.Ptr1) {
+        memcpy((void *)ESP->Pointers.Ptr1, (void *)&ESP->STAMAC, 6);
     }
-    dns->_ptr++;                                            /* Increase DNS pointer by 1 */
 }
 
-/* Starts command and sets pointer for return statement */
-estatic 
-ESP_Result_t StartCommand(evol ESP_t* ESP, uint16_t cmd, const char* cmdResp) {
-    ESP->ActiveCmd = cmd;
-    ESP->ActiveCmdResp = (char *)cmdResp;
-    ESP->ActiveCmdStart = ESP->Time;
-    ESP->ActiveResult = espOK;
-    
-    if (cmd == CMD_TCPIP_CIPSTATUS) {                       /* On CIPSTATUS command */
-        ESP->ActiveConnsResp = 0;                           /* Reset active connections status */
+/* Handles +CIPAPMAC_CUR response */
+estatic
+void HandleCIPAPMAC(evol ESP_t* ESP, const char* str) {
+    ParseMAC(ESP, str + 15, (void *)&ESP->APMAC, NULL);     /* Parse MAC */
+    if (ESP->Pointers.Ptr1) {
+        memcpy((void *)ESP->Pointers.Ptr1, (void *)&ESP->APMAC, 6);
     }
-    
-    return espOK;
 }
 
-/* Converts number to string */
+/* Handles +CWHOSTNAME response */
 estatic
-void NumberToString(char* str, uint32_t number) {
-    sprintf(str, "%lu", (unsigned long)number);
+void HandleHostName(evol ESP_t* ESP, const char* str) {
+    ParseHostName(ESP, str + 12, (void *)ESP->Pointers.Ptr1);   /* Parse IP and save it to user location */
 }
 
-/* Converts number to hex for MAC */
+/* Handles +CIPSNTPTIME response */
 estatic
-void HexNumberToString(char* str, uint8_t number) {
-    sprintf(str, "%02X", (unsigned)number);
+void HandleSNTPTime(evol ESP_t* ESP, const char* str) {
+    ParseSNTPTime(ESP, str + 13, (void *)ESP->Pointers.Ptr1);   /* Parse received time */
 }
 
-/* Escapes string and sends directly to output stream */
+/* Handles +CIPDOMAIN response */
 estatic
-void EscapeStringAndSend(const char* str) {
-    char special = '\\';
-    
-    while (*str) {                                    		/* Go through string */
-        if (*str == ',' || *str == '"' || *str == '\\') {	/* Check for special character */    
-            UART_SEND_CH(&special);                         /* Send special character */
-        }
-        UART_SEND_CH(str++);                                /* Send character */
+void HandleCIPDOMAIN(evol ESP_t* ESP, const char* str) {
+    ParseIP(ESP, str + 11, (void *)ESP->Pointers.Ptr1, NULL);   /* Parse IP and save it to user location */
+}
+
+/* Handles +CIPDNS_CUR response */
+estatic
+void HandleCIPDNS(evol ESP_t* ESP, const char* str) {
+    ParseCIPDNS(ESP, str + 12, (void *)ESP->Pointers.Ptr1); /* Parse DNS server */
+}
+
+/* Handles +CIPSTATUS response */
+estatic
+void HandleCIPSTATUS(evol ESP_t* ESP, const char* str) {
+    ParseCIPSTATUS(ESP, (void *)&ESP->ActiveConnsResp, str + 11);   /* Parse CIPSTATUS response */
+}
+
+/* List of command specific "+" responses, only entry for active command is checked */
+static const
+ResponseHandler_t ResponseHandlers[] = {
+    {CMD_WIFI_CWSAP,            FROMMEM("+CWSAP"),          6,  HandleCWSAP},
+    {CMD_TCPIP_PING,            FROMMEM("+"),               1,  HandlePing},
+    {CMD_BASIC_GETSYSRAM,       FROMMEM("+SYSRAM"),         7,  HandleSysValue},
+    {CMD_BASIC_GETSYSADC,       FROMMEM("+SYSADC"),         7,  HandleSysValue},
+    {CMD_BASIC_SYSGPIOREAD,     FROMMEM("+SYSGPIOREAD"),    12, HandleSysGPIORead},
+    {CMD_BASIC_SYSIOGETCFG,     FROMMEM("+SYSIOGETCFG"),    12, HandleSysIOGetCfg},
+    {CMD_WIFI_CIPAP,            FROMMEM("+CIPAP_"),         7,  HandleCIPAP},
+    {CMD_WIFI_CIPSTA,           FROMMEM("+CIPSTA_"),        8,  HandleCIPSTA},
+    {CMD_WIFI_CIPSTAMAC,        FROMMEM("+CIPSTAMAC"),      10, HandleCIPSTAMAC},
+    {CMD_WIFI_CIPAPMAC,         FROMMEM("+CIPAPMAC"),       9,  HandleCIPAPMAC},
+    {CMD_WIFI_GETHOSTNAME,      FROMMEM("+CWHOSTNAME"),     11, HandleHostName},
+    {CMD_TCPIP_CIPSNTPTIME,     FROMMEM("+CIPSNTPTIME"),    12, HandleSNTPTime},
+    {CMD_TCPIP_CIPDOMAIN,       FROMMEM("+CIPDOMAIN"),      10, HandleCIPDOMAIN},
+    {CMD_TCPIP_CIPGETDNS,       FROMMEM("+CIPDNS_"),        8,  HandleCIPDNS},
+    {CMD_TCPIP_CIPSTATUS,       FROMMEM("+CIPSTATUS"),      10, HandleCIPSTATUS},
+};
+
+/* Classifies received line by first characters, returns response ID */
+estatic
+uint8_t ClassifyResponse(const char* str, uint8_t len) {
+    switch (str[0]) {
+        case 'O':
+            return RESP_IS(str, len, RESP_OK) ? RESP_ID_OK : RESP_ID_NONE;
+        case 'E':
+            return RESP_IS(str, len, RESP_ERROR) ? RESP_ID_ERROR : RESP_ID_NONE;
+        case 'b':
+            return RESP_IS(str, len, RESP_BUSY) ? RESP_ID_BUSY : RESP_ID_NONE;
+        case 'r':
+            return RESP_IS(str, len, RESP_READY) ? RESP_ID_READY : RESP_ID_NONE;
+        case 'F':
+            return RESP_IS(str, len, "FAIL\r\n") ? RESP_ID_FAIL : RESP_ID_NONE;
+        case '+':
+            if (str[1] == 'I' && strncmp(str, FROMMEM("+IPD"), 4) == 0) {
+                return RESP_ID_IPD;
+            }
+            return RESP_ID_DATA;                            /* Command specific data */
+        case 'W':                                           /* WIFI CONNECTED, WIFI DISCONNECT, WIFI GOT IP */
+            if (len > 5 && strncmp(str, FROMMEM("WIFI "), 5) == 0) {
+                if (str[5] == 'C' && RESP_IS(str, len, "WIFI CONNECTED\r\n")) {
+                    return RESP_ID_WIFI_CONNECTED;
+                } else if (str[5] == 'D' && RESP_IS(str, len, "WIFI DISCONNECT\r\n")) {
+                    return RESP_ID_WIFI_DISCONNECT;
+                } else if (str[5] == 'G' && RESP_IS(str, len, "WIFI GOT IP\r\n")) {
+                    return RESP_ID_WIFI_GOT_IP;
+                }
+            }
+            return RESP_ID_NONE;
+        case 'S':                                           /* SEND OK, SEND FAIL */
+            if (strncmp(str, FROMMEM("SEND "), 5) == 0) {
+                if (strncmp(&str[5], FROMMEM("OK"), 2) == 0) {
+                    return RESP_ID_SEND_OK;
+                } else if (strncmp(&str[5], FROMMEM("FAIL"), 4) == 0) {
+                    return RESP_ID_SEND_FAIL;
+                }
+            }
+            return RESP_ID_NONE;
+#if ESP_SINGLE_CONN
+        case 'C':                                           /* CONNECT, CLOSED */
+            if (strncmp(str, FROMMEM("CONNECT"), 7) == 0) {
+                return RESP_ID_CONNECT;
+            } else if (strncmp(str, FROMMEM("CLOSED"), 6) == 0) {
+                return RESP_ID_CLOSED;
+            }
+            return RESP_ID_NONE;
+#endif                                                      /* ESP_SINGLE_CONN */
+        case 'R':                                           /* Recv n bytes */
+            return strncmp(str, FROMMEM("Recv "), 5) == 0 ? RESP_ID_RECV : RESP_ID_NONE;
+        default:
+            if (CHARISNUM(str[0])) {
+                if (RESP_ENDS(str, len, ",SEND OK\r\n")) {  /* [n,]segment,SEND OK */
+                    return RESP_ID_SEGMENT_OK;
+                } else if (RESP_ENDS(str, len, ",SEND FAIL\r\n")) {
+                    return RESP_ID_SEGMENT_FAIL;
+                }
+#if !ESP_SINGLE_CONN
+                if (str[1] == ',') {                        /* n,CONNECT, n,CLOSED */
+                    if (strncmp(&str[1], FROMMEM(",CONNECT"), 8) == 0) {
+                        return RESP_ID_CONNECT;
+                    } else if (strncmp(&str[1], FROMMEM(",CLOSED"), 7) == 0) {
+                        return RESP_ID_CLOSED;
+                    }
+                }
+#endif                                                      /* !ESP_SINGLE_CONN */
+            }
+            return RESP_ID_NONE;
     }
 }
 
 /* Process received character */
 estatic 
-void ParseReceived(evol ESP_t* ESP, Received_t* Received_p) {
+void ParseReceived(evol ESP_t* ESP, ESP_Received_t* Received_p) {
     char* str = (char *)Received_p->Data;
     
-    uint8_t is_ok = 0, is_error = 0, len;
+    uint8_t is_ok = 0, is_error = 0, len, i;
     len = Received_p->Length;                               /* String length */
     
     if (*str == '\r' && *(str + 1) == '\n') {               /* Check empty line */
         return;
     }
-
-    is_ok = strcmp(str, RESP_OK) == 0;                      /* Check if OK received */
-    if (!is_ok) {
-        is_error = strcmp(str, RESP_ERROR) == 0;            /* Check if error received */
-        if (!is_error) {
-            is_error = strcmp(str, RESP_BUSY) == 0;         /* Check if busy */
-        }
-    }
-    
-    if (!is_ok && !is_error) {
-        if (strcmp(str, RESP_READY) == 0) {
-            ESP->Events.F.RespReady = 1;                    /* Device is ready flag */
-        }
-    }
     
     /* Device info */
     if (ESP->ActiveCmd == CMD_BASIC_GMR) {
-        if ((str[0] == 'A' || str[0] == 'a') && Pointers.CPtr1 && len > 13) {   /* "AT version:" received */
-            strncpy((char *)Pointers.CPtr1, &str[11], len - 13);    /* Save AT version */
-            ((char *)Pointers.CPtr1)[len - 13] = 0;
+        if ((str[0] == 'A' || str[0] == 'a') && ESP->Pointers.CPtr1 && len > 13) {  /* "AT version:" received */
+            strncpy((char *)ESP->Pointers.CPtr1, &str[11], len - 13);   /* Save AT version */
+            ((char *)ESP->Pointers.CPtr1)[len - 13] = 0;
         }
-        if ((str[0] == 'S' || str[0] == 's') && Pointers.CPtr2) {   /* "SDK version:" received */
-            strncpy((char *)Pointers.CPtr2, &str[12], len - 14);    /* Save SDK version */
-            ((char *)Pointers.CPtr2)[len - 14] = 0;         /* End of strings */
+        if ((str[0] == 'S' || str[0] == 's') && ESP->Pointers.CPtr2) {  /* "SDK version:" received */
+            strncpy((char *)ESP->Pointers.CPtr2, &str[12], len - 14);   /* Save SDK version */
+            ((char *)ESP->Pointers.CPtr2)[len - 14] = 0;    /* End of strings */
         }
-        if ((str[0] == 'C' || str[0] == 'c') && Pointers.CPtr3) {   /* "compile time:" received */
-            strncpy((char *)Pointers.CPtr3, &str[13], len - 15);    /* Save compile time version */
-            ((char *)Pointers.CPtr3)[len - 15] = 0;         /* End of strings */
+        if ((str[0] == 'C' || str[0] == 'c') && ESP->Pointers.CPtr3) {  /* "compile time:" received */
+            strncpy((char *)ESP->Pointers.CPtr3, &str[13], len - 15);   /* Save compile time version */
+            ((char *)ESP->Pointers.CPtr3)[len - 15] = 0;    /* End of strings */
         }
     }
     
     if (ESP->ActiveCmd == CMD_WIFI_CWLIF && CHARISNUM(str[0])) {    /* IP of device connected to AP received */
-        if (*(uint16_t *)Pointers.Ptr2 < Pointers.UI) {     /* Check if memory still available */
-            ParseCWLIF(ESP, str, (void *)Pointers.Ptr1);    /* Parse CWLIF statement */
-            Pointers.Ptr1 = ((ESP_ConnectedStation_t *)Pointers.Ptr1) + 1;
-            *(uint16_t *)Pointers.Ptr2 = (*(uint16_t *)Pointers.Ptr2) + 1;  /* Increase number of parsed elements */
+        if (*(uint16_t *)ESP->Pointers.Ptr2 < ESP->Pointers.UI) {   /* Check if memory still available */
+            ParseCWLIF(ESP, str, (void *)ESP->Pointers.Ptr1);   /* Parse CWLIF statement */
+            ESP->Pointers.Ptr1 = ((ESP_ConnectedStation_t *)ESP->Pointers.Ptr1) + 1;
+            *(uint16_t *)ESP->Pointers.Ptr2 = (*(uint16_t *)ESP->Pointers.Ptr2) + 1;  /* Increase number of parsed elements */
         }
     }
     
-    /* We received string starting with + sign = some useful data! */
-    if (*str == '+') {
-        if (strncmp(str, FROMMEM("+IPD"), 4) == 0) {        /* Check for incoming data */
+    switch (ClassifyResponse(str, len)) {                   /* Process response by its ID */
+        case RESP_ID_OK:
+            is_ok = 1;
+            if (ESP->ActiveCmd == CMD_TCPIP_CIPSTATUS) {    /* Check and merge all connections from ESP */
+                for (i = 0; i < ESP_MAX_CONNECTIONS; i++) {
+                    ESP->Conn[i].Flags.F.Active = (ESP->ActiveConnsResp & (1 << i)) == (1 << i);
+                }
+                ESP->ActiveConns = ESP->ActiveConnsResp;    /* Copy current value */
+            }
+            break;
+        case RESP_ID_ERROR:
+        case RESP_ID_BUSY:
+            is_error = 1;
+            break;
+        case RESP_ID_READY:
+            ESP->Events.F.RespReady = 1;                    /* Device is ready flag */
+            break;
+        case RESP_ID_FAIL:
+            if (ESP->ActiveCmd == CMD_WIFI_CWJAP) {         /* Fail received when connecting to AP */
+                is_error = 1;
+            }
+            break;
+        case RESP_ID_IPD:                                   /* Incoming data */
             ParseIPD(ESP, str + 5, (void *)&ESP->IPD);      /* Parse incoming data string */
             ESP->IPD.InIPD = 1;                             /* Start with data reading */
             if (!ESP->IPD.Conn->TotalBytesReceived) {
                 ESP->IPD.Conn->DataStartTime = (uint32_t)ESP->Time; /* Set time when first IPD received on connection */
             }
             ESP->IPD.Conn->TotalBytesReceived += ESP->IPD.BytesRemaining;   /* Increase total bytes received so far */
-        } else if (ESP->ActiveCmd == CMD_WIFI_CWLAP && strncmp(str, FROMMEM("+CWLAP"), 6) == 0) {  /* When active command is listing wifi stations */
-            if (*(uint16_t *)Pointers.Ptr2 < Pointers.UI) { /* Check if memory still available */
-                ParseCWLAP(ESP, str + 7, (void *)Pointers.Ptr1);    /* Parse CWLAP statement */
-                Pointers.Ptr1 = ((ESP_AP_t *)Pointers.Ptr1) + 1;
-                *(uint32_t *)Pointers.Ptr2 = (*(uint16_t *)Pointers.Ptr2) + 1;  /* Increase number of parsed elements */
-            }
-        } else if (ESP->ActiveCmd == CMD_WIFI_CWSAP && strncmp(str, FROMMEM("+CWSAP"), 6) == 0) {   /* Check CWSAP response */
-            ParseCWSAP(ESP, str + 12, (void *)&ESP->APConf);    /* Parse config from AP */             
-        } else if (ESP->ActiveCmd == CMD_TCPIP_PING && CHARISNUM(str[1])) {
-            *(uint32_t *)Pointers.Ptr1 = ParseNumber(str + 1, NULL);    /* Parse response time */
-        } else if (ESP->ActiveCmd == CMD_BASIC_GETSYSRAM && strncmp(str, FROMMEM("+SYSRAM"), 7) == 0) {
-            *(uint32_t *)Pointers.Ptr1 = ParseNumber(str + 8, NULL);    /* Parse RAM value */
-        } else if (ESP->ActiveCmd == CMD_BASIC_GETSYSADC && strncmp(str, FROMMEM("+SYSADC"), 7) == 0) {
-            *(uint32_t *)Pointers.Ptr1 = ParseNumber(str + 8, NULL);    /* Parse ADC value */
-        } else if (ESP->ActiveCmd == CMD_BASIC_SYSGPIOREAD && strncmp(str, FROMMEM("+SYSGPIOREAD"), 12) == 0) {
-            ParseSysGPIORead(ESP, str + 13, (void *)Pointers.Ptr1, (void *)Pointers.Ptr2);
-        } else if (ESP->ActiveCmd == CMD_BASIC_SYSIOGETCFG && strncmp(str, FROMMEM("+SYSIOGETCFG"), 12) == 0) {
-            ParseSysIOGetCfg(ESP, str + 13, (void *)Pointers.Ptr1);
-        } else if (ESP->ActiveCmd == CMD_WIFI_CIPAP && strncmp(str, FROMMEM("+CIPAP_"), 7) == 0) {  /* +CIPAP received */
-            if (str[11] == 'i') {                           /* +CIPAP_CUR:ip received */
-                ParseIP(ESP, str + 15, (void *)&ESP->APIP, NULL);    /* Parse IP string */
-                if (Pointers.Ptr1) {
-                    memcpy((void *)Pointers.Ptr1, (void *)&ESP->APIP, 4);
+            __STATS_ADD(ESP, Conn[ESP->IPD.Conn->Number].BytesReceived, ESP->IPD.BytesRemaining);
+            break;
+        case RESP_ID_DATA:                                  /* Command specific data */
+            for (i = 0; i < sizeof(ResponseHandlers) / sizeof(ResponseHandlers[0]); i++) {
+                if (ResponseHandlers[i].Cmd == ESP->ActiveCmd) {
+                    if (strncmp(str, ResponseHandlers[i].Prefix, ResponseHandlers[i].Length) == 0) {
+                        ResponseHandlers[i].Handler(ESP, str);  /* Call handler for active command */
+                    }
+                    break;
                 }
-            } else if (str[11] == 'g') {
-                ParseIP(ESP, str + 20, (void *)&ESP->APGateway, NULL);  /* Parse IP string */
-            } else if (str[11] == 'n') {
-                ParseIP(ESP, str + 20, (void *)&ESP->APNetmask, NULL);  /* Parse IP string */
             }
-        } else  if (ESP->ActiveCmd == CMD_WIFI_CIPSTA && strncmp(str, FROMMEM("+CIPSTA_"), 8) == 0) {   /* +CIPSTA received */
-            if (str[12] == 'i') {                               /* +CIPSTA_CUR:ip received */
-                ParseIP(ESP, str + 16, (void *)&ESP->STAIP, NULL);  /* Parse IP string */
-                if (Pointers.Ptr1) {
-                    memcpy((void *)Pointers.Ptr1, (void *)&ESP->STAIP, 4);
-                }
-            } else if (str[12] == 'g') {
-                ParseIP(ESP, str + 21, (void *)&ESP->STAGateway, NULL); /* Parse IP string */
-            } else if (str[12] == 'n') {
-                ParseIP(ESP, str + 21, (void *)&ESP->STANetmask, NULL); /* Parse IP string */
+            break;
+        case RESP_ID_WIFI_CONNECTED:                        /* Just connected */
+            if (ESP->ActiveCmd == CMD_WIFI_CWJAP) {         /* If trying to join AP */
+                ESP->Events.F.RespWifiConnected = 1;
             }
-        } else if (ESP->ActiveCmd == CMD_WIFI_CIPSTAMAC && strncmp(str, FROMMEM("+CIPSTAMAC"), 10) == 0) {  /* On CIPSTAMAC active command */
-            ParseMAC(ESP, str + 16, (void *)&ESP->STAMAC, NULL);    /* Parse MAC */
-            if (Pointers.Ptr1) {
-                memcpy((void *)Pointers.Ptr1, (void *)&ESP->STAMAC, 6);
+            EventAdd(ESP, espEventWifiConnected, NULL, 0);
+            break;
+        case RESP_ID_WIFI_DISCONNECT:                       /* Just disconnected */
+            if (ESP->ActiveCmd == CMD_WIFI_CWJAP) {         /* If trying to join AP */
+                ESP->Events.F.RespWifiDisconnected = 1;
             }
-        } else if (ESP->ActiveCmd == CMD_WIFI_CIPAPMAC && strncmp(str, FROMMEM("+CIPAPMAC"), 9) == 0) { /* On CIPAPMAC active command */
-            ParseMAC(ESP, str + 15, (void *)&ESP->APMAC, NULL); /* Parse MAC */
-            if (Pointers.Ptr1) {
-                memcpy((void *)Pointers.Ptr1, (void *)&ESP->APMAC, 6);
+            EventAdd(ESP, espEventWifiDisconnected, NULL, 0);
+            break;
+        case RESP_ID_WIFI_GOT_IP:                           /* ESP got assigned IP address from DHCP */
+            if (ESP->ActiveCmd == CMD_WIFI_CWJAP) {         /* If trying to join AP */
+                ESP->Events.F.RespWifiGotIp = 1;
             }
-        } else if (ESP->ActiveCmd == CMD_WIFI_GETHOSTNAME && strncmp(str, FROMMEM("+CWHOSTNAME"), 11) == 0) {
-            ParseHostName(ESP, str + 12, (void *)Pointers.Ptr1);    /* Parse IP and save it to user location */
-        } else if (ESP->ActiveCmd == CMD_TCPIP_CIPSNTPTIME && strncmp(str, FROMMEM("+CIPSNTPTIME"), 12) == 0) {
-            ParseSNTPTime(ESP, str + 13, (void *)Pointers.Ptr1);    /* Parse received time */
-        } else if (ESP->ActiveCmd == CMD_TCPIP_SNTPGETCFG && strncmp(str, FROMMEM("+CIPSNTPCFG"), 11) == 0) {
-            ParseSNTPConfig(ESP, str + 12, (void *)Pointers.Ptr1);  /* Parse received time */
-        } else if (ESP->ActiveCmd == CMD_TCPIP_CIPDOMAIN && strncmp(str, FROMMEM("+CIPDOMAIN"), 10) == 0) {
-            ParseIP(ESP, str + 11, (void *)Pointers.Ptr1, NULL);    /* Parse IP and save it to user location */
-        } else if (ESP->ActiveCmd == CMD_TCPIP_CIPGETDNS && strncmp(str, FROMMEM("+CIPDNS_"), 8) == 0) {
-            ParseCIPDNS(ESP, str + 12, (void *)Pointers.Ptr1);  /* Parse DNS server */
-        }
-    }
-    
-    /* Connecting to AP */
-    if (ESP->ActiveCmd == CMD_WIFI_CWJAP) {                 /* Trying to connect to wifi network */
-        if (strcmp(str, FROMMEM("FAIL\r\n")) == 0) {        /* Fail received */
-            is_error = 1;
-        } else if (strncmp(str, FROMMEM("+CWJAP_CUR"), 10) == 0) {  /* Received currently connected AP info */
-            ParseCWJAP(ESP, str + 10, (void *)Pointers.Ptr1);   /* Parse and save */
-        }
-    }
-    
-    /* Wifi management informations */
-    if (strcmp(str, FROMMEM("WIFI CONNECTED\r\n")) == 0) {  /* Just connected */
-        if (ESP->ActiveCmd == CMD_WIFI_CWJAP) {             /* If trying to join AP */
-            ESP->Events.F.RespWifiConnected = 1;
-        }
-        ESP->CallbackFlags.F.WifiConnected = 1;
-    } else if (strcmp(str, FROMMEM("WIFI DISCONNECT\r\n")) == 0) {  /* Just disconnected */
-        if (ESP->ActiveCmd == CMD_WIFI_CWJAP) {             /* If trying to join AP */
-            ESP->Events.F.RespWifiDisconnected = 1;
-        }
-        ESP->CallbackFlags.F.WifiDisconnected = 1;
-    } else if (strcmp(str, FROMMEM("WIFI GOT IP\r\n")) == 0) {  /* ESP got assigned IP address from DHCP */
-        if (ESP->ActiveCmd == CMD_WIFI_CWJAP) {             /* If trying to join AP */
-            ESP->Events.F.RespWifiGotIp = 1;
-        }
-        ESP->CallbackFlags.F.WifiGotIP = 1;
-    }
-    
-    /* Connection management */
+            EventAdd(ESP, espEventWifiGotIP, NULL, 0);
+            break;
+        case RESP_ID_CONNECT: {                             /* Connection active */
 #if !ESP_SINGLE_CONN
-    if (strncmp(&str[1], FROMMEM(",CONNECT"), 8) == 0) {
-        ESP_CONN_t* conn = (void *)&ESP->Conn[CHARTONUM(str[0])];   /* Get connection from number */
-        conn->Number = CHARTONUM(str[0]);                   /* Set connection number */
-        conn->Flags.F.Active = 1;                           /* Connection is active */
-        conn->Callback.F.Connect = 1;
-        __CONN_UPDATE_TIME(ESP, conn);                      /* Update connection access time */
-    } else if (strncmp(&str[1], FROMMEM(",CLOSED"), 7) == 0) {
-        ESP_CONN_t* conn = (void *)&ESP->Conn[CHARTONUM(str[0])];   /* Get connection from number */
-        ESP_EventCallback_t cb = conn->Cb;
-        __CONN_RESET(conn);                                 /* Reset connection */
-        conn->Callback.F.Closed = 1;
-        conn->Cb = cb;
-    }
+            ESP_CONN_t* conn = (void *)&ESP->Conn[CHARTONUM(str[0])];   /* Get connection from number */
+            conn->Number = CHARTONUM(str[0]);               /* Set connection number */
 #else
-    if (strncmp(str, FROMMEM("CONNECT"), 7) == 0) {
-        ESP_CONN_t* conn = (void *)&ESP->Conn[0];           /* Get connection from number */
-        conn->Number = 0;                                   /* Set connection number */
-        conn->Flags.F.Active = 1;                           /* Connection is active */
-        conn->Callback.F.Connect = 1;
-        __CONN_UPDATE_TIME(ESP, conn);                      /* Update connection access time */
-    } else if (strncmp(str, FROMMEM("CLOSED"), 6) == 0) {
-        ESP_CONN_t* conn = (void *)&ESP->Conn[0];           /* Get connection from number */
-        ESP_EventCallback_t cb = conn->Cb;
-        __CONN_RESET(conn);                                 /* Reset connection */
-        conn->Callback.F.Closed = 1;
-        conn->Cb = cb;
-    }
-#endif /* !ESP_SINGLE_CONN */
-    
-    /* Manage connection status */
-    if (ESP->ActiveCmd == CMD_TCPIP_CIPSTATUS) {
-        if (strncmp(str, FROMMEM("+CIPSTATUS"), 10) == 0) { /* +CIPSTATUS received */
-            ParseCIPSTATUS(ESP, (void *)&ESP->ActiveConnsResp, str + 11);   /* Parse CIPSTATUS response */
-        } else if (is_ok) {                                 /* OK received */
-            /* Check and merge all connections from ESP */
-            uint8_t i = 0;
-            for (i = 0; i < ESP_MAX_CONNECTIONS; i++) {
-                ESP->Conn[i].Flags.F.Active = (ESP->ActiveConnsResp & (1 << i)) == (1 << i);
-            }
-            ESP->ActiveConns = ESP->ActiveConnsResp;        /* Copy current value */
+            ESP_CONN_t* conn = (void *)&ESP->Conn[0];       /* Get connection from number */
+            conn->Number = 0;                               /* Set connection number */
+#endif                                                      /* !ESP_SINGLE_CONN */
+            conn->Flags.F.Active = 1;                       /* Connection is active */
+#if ESP_CONN_RX_SIZE
+            BUFFER_Reset((BUFFER_t *)&ESP->ConnRx[conn->Number]);   /* Drop data from previous connection */
+#endif                                                      /* ESP_CONN_RX_SIZE */
+            EventAdd(ESP, espEventConnActive, conn, 0);
+            __CONN_UPDATE_TIME(ESP, conn);                  /* Update connection access time */
+            break;
         }
-    }
-    
-    /* Manage send data */
-    if (ESP->ActiveCmd == CMD_TCPIP_CIPSEND) {
-        if (strncmp(str, FROMMEM("SEND OK"), 7) == 0) {     /* Data successfully sent */
-            ESP->Events.F.RespSendOk = 1;
-        } else if (strncmp(str, FROMMEM("SEND FAIL"), 9) == 0) {    /* Data sent error */
-            ESP->Events.F.RespSendFail = 1;
+        case RESP_ID_CLOSED: {                              /* Connection closed */
+#if !ESP_SINGLE_CONN
+            ESP_CONN_t* conn = (void *)&ESP->Conn[CHARTONUM(str[0])];   /* Get connection from number */
+#else
+            ESP_CONN_t* conn = (void *)&ESP->Conn[0];       /* Get connection from number */
+#endif                                                      /* !ESP_SINGLE_CONN */
+            ESP_EventCallback_t cb = conn->Cb;
+            __CONN_RESET(conn);                             /* Reset connection */
+            EventAdd(ESP, espEventConnClosed, conn, 0);
+            conn->Cb = cb;
+            break;
         }
+        case RESP_ID_SEND_OK:                               /* Data successfully sent */
+            if (ESP->ActiveCmd == CMD_TCPIP_CIPSEND || ESP->ActiveCmd == CMD_TCPIP_CIPSENDEX) {
+                ESP->Events.F.RespSendOk = 1;
+            }
+            break;
+        case RESP_ID_SEND_FAIL:                             /* Data sent error */
+            __STATS_INC(ESP, SendFail);
+            if (ESP->ActiveCmd == CMD_TCPIP_CIPSEND || ESP->ActiveCmd == CMD_TCPIP_CIPSENDEX) {
+                ESP->Events.F.RespSendFail = 1;
+            }
+            break;
+        case RESP_ID_RECV:                                  /* Data received to module send buffer */
+            if (ESP->ActiveCmd == CMD_TCPIP_CIPSENDBUF) {
+                ESP->Events.F.RespRecv = 1;
+            }
+            break;
+        case RESP_ID_SEGMENT_OK:                            /* Segment from module send buffer sent */
+            ParseSegmentSent(ESP, str, 1);
+            break;
+        case RESP_ID_SEGMENT_FAIL:                          /* Segment from module send buffer failed */
+            ParseSegmentSent(ESP, str, 0);
+            break;
+        case RESP_ID_NONE:
+            if (CHARISNUM(str[0])) {                        /* Numeric response of buffered send commands */
+                ParseSendBufStatus(ESP, str);
+            }
+            break;
+        default:
+            break;
     }
     
     if (is_ok) {
         ESP->Events.F.RespOk = 1;
+        __STATS_CMD_DONE(ESP, 0);
         ESP->Events.F.RespError = 0;
     } else if (is_error) {
         ESP->Events.F.RespOk = 0;
         ESP->Events.F.RespError = 1;
+        __STATS_CMD_DONE(ESP, 1);
     }
 }
 
@@ -1055,8 +1949,7 @@ void ParseReceived(evol ESP_t* ESP, Received_t* Received_p) {
 /******************************************************************************/
 estatic
 PT_THREAD(PT_Thread_BASIC(struct pt* pt, evol ESP_t* ESP)) {
-    static volatile uint32_t time;
-    static uint8_t rst;
+    ESP_LL_Pin_t rst;
     char str[8];
     PT_BEGIN(pt);
     
@@ -1074,7 +1967,7 @@ PT_THREAD(PT_Thread_BASIC(struct pt* pt, evol ESP_t* ESP)) {
         
         __IDLE(ESP);                                        /* Go IDLE mode */
     } else if (ESP->ActiveCmd == CMD_BASIC_ATE) {           /* Set echo */
-        NumberToString(str, Pointers.UI);                   /* Get echo parameter as string */
+        NumberToString(str, ESP->Pointers.UI);              /* Get echo parameter as string */
 
         __RST_EVENTS_RESP(ESP);                             /* Reset all events */
 
@@ -1094,11 +1987,12 @@ PT_THREAD(PT_Thread_BASIC(struct pt* pt, evol ESP_t* ESP)) {
         
         /***** Hardware reset *****/
         __RST_EVENTS_RESP(ESP);                             /* Reset all events */
-        rst = ESP_RESET_SET;
+        rst.State = ESP_RESET_SET;
+        rst.LL = (ESP_LL_t *)&ESP->LL;
         ESP_LL_Callback(ESP_LL_Control_SetReset, &rst, 0);  /* Process callback with reset set */
-        time = ESP->Time;
-        PT_WAIT_UNTIL(pt, ESP->Time - time > 2);            /* Wait reset time */
-        rst = ESP_RESET_CLR;
+        __THREAD_DELAY(ESP, pt, 2);                         /* Wait reset time */
+        rst.State = ESP_RESET_CLR;
+        rst.LL = (ESP_LL_t *)&ESP->LL;
         ESP_LL_Callback(ESP_LL_Control_SetReset, &rst, 0);  /* Process callback with reset clear */
         
         PT_WAIT_UNTIL(pt, ESP->Events.F.RespReady ||
@@ -1133,12 +2027,12 @@ PT_THREAD(PT_Thread_BASIC(struct pt* pt, evol ESP_t* ESP)) {
         
         __IDLE(ESP);                                        /* Go IDLE mode */
     } else if (ESP->ActiveCmd == CMD_BASIC_UART) {          /* Set UART */
-        NumberToString(str, Pointers.UI);                   /* Get baudrate as string */
+        NumberToString(str, ESP->Pointers.UI);              /* Get baudrate as string */
         
         /* Send UART command */
         __RST_EVENTS_RESP(ESP);                             /* Reset all events */
         UART_SEND_STR(FROMMEM("AT+UART_"));                 /* Send data */
-        UART_SEND_STR(FROMMEM(Pointers.CPtr1));
+        UART_SEND_STR(FROMMEM(ESP->Pointers.CPtr1));
         UART_SEND_STR(FROMMEM("="));
         UART_SEND_STR(FROMMEM(str));
 #if ESP_USE_CTS
@@ -1154,29 +2048,23 @@ PT_THREAD(PT_Thread_BASIC(struct pt* pt, evol ESP_t* ESP)) {
         
         ESP->ActiveResult = ESP->Events.F.RespOk ? espOK : espERROR;    /* Check response */
         if (ESP->ActiveResult == espOK) {
-            uint8_t result;
-            BUFFER_Reset(&Buffer);                          /* Reset buffer */
-            
-            /* Reinit low-level with new baudrate */
-            ESP->LL.Baudrate = Pointers.UI;
-            ESP_LL_Callback(ESP_LL_Control_Init, (void *)&ESP->LL, &result);    /* Init low-level layer again */
+            SetBaudrate(ESP, ESP->Pointers.UI);             /* Reinit low-level with new baudrate */
         }
         
         /* Now let's read default baudrate for reinit purpose */
-        time = ESP->Time;
-        PT_WAIT_UNTIL(pt, ESP->Time - time > 2);            /* Wait reset time */
+        __THREAD_DELAY(ESP, pt, 2);                         /* Wait reset time */
         
         __RST_EVENTS_RESP(ESP);                             /* Reset all events */
         UART_SEND_STR(FROMMEM("AT+UART_DEF?"));             /* Send data */
-        StartCommand(ESP, CMD_BASIC_UART, NULL);            /* Start command */
         UART_SEND_STR(_CRLF);
+        StartCommand(ESP, CMD_BASIC_UART, NULL);            /* Start command */
         
         PT_WAIT_UNTIL(pt, ESP->Events.F.RespOk ||
                             ESP->Events.F.RespError);       /* Wait for response */
         
         __IDLE(ESP);                                        /* Go IDLE mode */
     } else if (ESP->ActiveCmd == CMD_BASIC_RFPOWER) {       /* Set RF power */
-        NumberToString(str, Pointers.UI);                   /* Convert mode to string */
+        NumberToString(str, ESP->Pointers.UI);              /* Convert mode to string */
         __RST_EVENTS_RESP(ESP);                             /* Reset all events */
         UART_SEND_STR(FROMMEM("AT+RFPOWER="));              /* Send data */
         UART_SEND_STR(FROMMEM(str));
@@ -1200,6 +2088,7 @@ PT_THREAD(PT_Thread_BASIC(struct pt* pt, evol ESP_t* ESP)) {
                             ESP->Events.F.RespError);       /* Wait for response */
         
         ESP->ActiveResult = ESP->Events.F.RespOk ? espOK : espERROR;    /* Check response */
+        __CACHE_INVALIDATE(ESP);                            /* Settings may be restored even on error */
         
         PT_WAIT_UNTIL(pt, ESP->Events.F.RespReady || 
                             ESP->Events.F.RespError);       /* Wait for response */
@@ -1219,7 +2108,7 @@ PT_THREAD(PT_Thread_BASIC(struct pt* pt, evol ESP_t* ESP)) {
         PT_WAIT_UNTIL(pt, ESP->Events.F.RespOk || 
                             ESP->Events.F.RespError);       /* Wait for response */
         
-        ESP->ActiveResult = ESP->Events.F.RespReady ? espOK : espERROR;    /* Check response */
+        ESP->ActiveResult = ESP->Events.F.RespOk ? espOK : espERROR;    /* Check response */
         
         __IDLE(ESP);                                        /* Go IDLE mode */
     } else if (ESP->ActiveCmd == CMD_BASIC_GETSYSADC) {     /* Read ADC channel */
@@ -1232,20 +2121,20 @@ PT_THREAD(PT_Thread_BASIC(struct pt* pt, evol ESP_t* ESP)) {
         PT_WAIT_UNTIL(pt, ESP->Events.F.RespOk || 
                             ESP->Events.F.RespError);       /* Wait for response */
         
-        ESP->ActiveResult = ESP->Events.F.RespReady ? espOK : espERROR;    /* Check response */
+        ESP->ActiveResult = ESP->Events.F.RespOk ? espOK : espERROR;    /* Check response */
         
         __IDLE(ESP);                                        /* Go IDLE mode */
     } else if (ESP->ActiveCmd == CMD_BASIC_SYSIOSETCFG) {   /* Set GPIO config */
         __RST_EVENTS_RESP(ESP);                             /* Reset all events */
         
         UART_SEND_STR(FROMMEM("AT+SYSIOSETCFG="));          /* Send data */
-        NumberToString(str, Pointers.UI);                   /* Convert pin number to string */
+        NumberToString(str, ESP->Pointers.UI);              /* Convert pin number to string */
         UART_SEND_STR(FROMMEM(str));
         UART_SEND_STR(FROMMEM(","));
-        NumberToString(str, ((ESP_GPIO_t *)Pointers.CPtr1)->Mode);  /* Convert pin mode to string */
+        NumberToString(str, ((ESP_GPIO_t *)ESP->Pointers.CPtr1)->Mode); /* Convert pin mode to string */
         UART_SEND_STR(FROMMEM(str));
         UART_SEND_STR(FROMMEM(","));
-        NumberToString(str, ((ESP_GPIO_t *)Pointers.CPtr1)->Pull);  /* Convert pin pull to string */
+        NumberToString(str, ((ESP_GPIO_t *)ESP->Pointers.CPtr1)->Pull); /* Convert pin pull to string */
         UART_SEND_STR(FROMMEM(str));
         UART_SEND_STR(_CRLF);
         StartCommand(ESP, CMD_BASIC_SYSIOSETCFG, NULL);     /* Start command */
@@ -1260,7 +2149,7 @@ PT_THREAD(PT_Thread_BASIC(struct pt* pt, evol ESP_t* ESP)) {
         __RST_EVENTS_RESP(ESP);                             /* Reset all events */
         
         UART_SEND_STR(FROMMEM("AT+SYSIOGETCFG="));          /* Send data */
-        NumberToString(str, Pointers.UI);                   /* Convert pin number to string */
+        NumberToString(str, ESP->Pointers.UI);              /* Convert pin number to string */
         UART_SEND_STR(FROMMEM(str));
         UART_SEND_STR(_CRLF);
         StartCommand(ESP, CMD_BASIC_SYSIOGETCFG, NULL);     /* Start command */
@@ -1275,10 +2164,10 @@ PT_THREAD(PT_Thread_BASIC(struct pt* pt, evol ESP_t* ESP)) {
         __RST_EVENTS_RESP(ESP);                             /* Reset all events */
         
         UART_SEND_STR(FROMMEM("AT+SYSGPIODIR="));           /* Send data */
-        NumberToString(str, Pointers.UI);                   /* Convert pin number to string */
+        NumberToString(str, ESP->Pointers.UI);              /* Convert pin number to string */
         UART_SEND_STR(FROMMEM(str));
         UART_SEND_STR(FROMMEM(","));
-        NumberToString(str, ((ESP_GPIO_t *)Pointers.CPtr1)->Dir);   /* Convert pin direction to string */
+        NumberToString(str, ((ESP_GPIO_t *)ESP->Pointers.CPtr1)->Dir);  /* Convert pin direction to string */
         UART_SEND_STR(FROMMEM(str));
         UART_SEND_STR(_CRLF);
         StartCommand(ESP, CMD_BASIC_SYSGPIOSETDIR, NULL);   /* Start command */
@@ -1293,7 +2182,7 @@ PT_THREAD(PT_Thread_BASIC(struct pt* pt, evol ESP_t* ESP)) {
         __RST_EVENTS_RESP(ESP);                             /* Reset all events */
         
         UART_SEND_STR(FROMMEM("AT+SYSGPIOREAD="));          /* Send data */
-        NumberToString(str, Pointers.UI);                   /* Convert pin number to string */
+        NumberToString(str, ESP->Pointers.UI);              /* Convert pin number to string */
         UART_SEND_STR(FROMMEM(str));
         UART_SEND_STR(_CRLF);
         StartCommand(ESP, CMD_BASIC_SYSGPIOREAD, NULL);   /* Start command */
@@ -1308,10 +2197,10 @@ PT_THREAD(PT_Thread_BASIC(struct pt* pt, evol ESP_t* ESP)) {
         __RST_EVENTS_RESP(ESP);                             /* Reset all events */
         
         UART_SEND_STR(FROMMEM("AT+SYSGPIOWRITE="));         /* Send data */
-        NumberToString(str, (Pointers.UI) & 0xFF);          /* Convert pin number to string */
+        NumberToString(str, (ESP->Pointers.UI) & 0xFF);     /* Convert pin number to string */
         UART_SEND_STR(FROMMEM(str));
         UART_SEND_STR(FROMMEM(","));
-        NumberToString(str, (Pointers.UI >> 8) & 0xFF);     /* Convert pin value to string */
+        NumberToString(str, (ESP->Pointers.UI >> 8) & 0xFF);    /* Convert pin value to string */
         UART_SEND_STR(FROMMEM(str));
         UART_SEND_STR(_CRLF);
         StartCommand(ESP, CMD_BASIC_SYSGPIOREAD, NULL);     /* Start command */
@@ -1333,10 +2222,10 @@ PT_THREAD(PT_Thread_WIFI(struct pt* pt, evol ESP_t* ESP)) {
     PT_BEGIN(pt);
     
     if (ESP->ActiveCmd == CMD_WIFI_CWMODE) {                /* Set device mode */
-        NumberToString(str, Pointers.UI);                   /* Convert mode to string */
+        NumberToString(str, ESP->Pointers.UI);              /* Convert mode to string */
         __RST_EVENTS_RESP(ESP);                             /* Reset all events */
         UART_SEND_STR(FROMMEM("AT+CWMODE_"));               /* Send data */
-        UART_SEND_STR(FROMMEM(Pointers.CPtr1));
+        UART_SEND_STR(FROMMEM(ESP->Pointers.CPtr1));
         UART_SEND_STR(FROMMEM("="));
         UART_SEND_STR(FROMMEM(str));
         UART_SEND_STR(_CRLF);
@@ -1397,11 +2286,11 @@ PT_THREAD(PT_Thread_WIFI(struct pt* pt, evol ESP_t* ESP)) {
         
         __IDLE(ESP);                                        /* Go IDLE mode */
     } else if (ESP->ActiveCmd == CMD_WIFI_SETSTAMAC) {      /* Get AP IP address */
-        ptr = (uint8_t *) Pointers.CPtr2;
+        ptr = (uint8_t *) ESP->Pointers.CPtr2;
         
         __RST_EVENTS_RESP(ESP);                             /* Reset all events */
         UART_SEND_STR(FROMMEM("AT+CIPSTAMAC_"));            /* Send data */
-        UART_SEND_STR(FROMMEM(Pointers.CPtr1));             /* Default or current */
+        UART_SEND_STR(FROMMEM(ESP->Pointers.CPtr1));        /* Default or current */
         UART_SEND_STR(FROMMEM("=\""));
         i = 6; ch = ':';
         while (i--) {
@@ -1420,16 +2309,17 @@ PT_THREAD(PT_Thread_WIFI(struct pt* pt, evol ESP_t* ESP)) {
         
         ESP->ActiveResult = ESP->Events.F.RespOk ? espOK : espERROR;    /* Check response */
         if (ESP->ActiveResult == espOK) {                   /* Copy data as new MAC address */
-            memcpy((void *)&ESP->APMAC, (void *)Pointers.CPtr2, 6); /* Copy new MAC */
+            memcpy((void *)&ESP->STAMAC, (void *)ESP->Pointers.CPtr2, 6);   /* Copy new MAC */
+            __CACHE_INVALIDATE(ESP);
         }
             
         __IDLE(ESP);                                        /* Go IDLE mode */
     } else if (ESP->ActiveCmd == CMD_WIFI_SETAPMAC) {       /* Get AP IP address */
-        ptr = (uint8_t *) Pointers.CPtr2;
+        ptr = (uint8_t *) ESP->Pointers.CPtr2;
         
         __RST_EVENTS_RESP(ESP);                             /* Reset all events */
         UART_SEND_STR(FROMMEM("AT+CIPAPMAC_"));             /* Send data */
-        UART_SEND_STR(FROMMEM(Pointers.CPtr1));             /* Default or current */
+        UART_SEND_STR(FROMMEM(ESP->Pointers.CPtr1));        /* Default or current */
         UART_SEND_STR(FROMMEM("=\""));
         i = 6; ch = ':';
         while (i--) {
@@ -1448,16 +2338,17 @@ PT_THREAD(PT_Thread_WIFI(struct pt* pt, evol ESP_t* ESP)) {
         
         ESP->ActiveResult = ESP->Events.F.RespOk ? espOK : espERROR;    /* Check response */
         if (ESP->ActiveResult == espOK) {                   /* Copy data as new MAC address */
-            memcpy((void *)&ESP->APMAC, (void *)Pointers.CPtr2, 6); /* Copy new MAC */
+            memcpy((void *)&ESP->APMAC, (void *)ESP->Pointers.CPtr2, 6);    /* Copy new MAC */
+            __CACHE_INVALIDATE(ESP);
         }
         
         __IDLE(ESP);                                        /* Go IDLE mode */
     } else if (ESP->ActiveCmd == CMD_WIFI_SETSTAIP) {       /* Set AP IP address */
-        ptr = (uint8_t *) Pointers.CPtr2;
+        ptr = (uint8_t *) ESP->Pointers.CPtr2;
         
         __RST_EVENTS_RESP(ESP);                             /* Reset all events */
         UART_SEND_STR(FROMMEM("AT+CIPSTA_"));               /* Send data */
-        UART_SEND_STR(FROMMEM(Pointers.CPtr1));             /* Default or current */
+        UART_SEND_STR(FROMMEM(ESP->Pointers.CPtr1));        /* Default or current */
         UART_SEND_STR(FROMMEM("=\""));
         i = 4; ch = '.';
         while (i--) {
@@ -1468,8 +2359,8 @@ PT_THREAD(PT_Thread_WIFI(struct pt* pt, evol ESP_t* ESP)) {
             }
         }
         UART_SEND_STR(FROMMEM("\""));
-        if (Pointers.CPtr3 != NULL) {                       /* Check for gateway and netmask addresses */
-            ptr = (uint8_t *) Pointers.CPtr3;
+        if (ESP->Pointers.CPtr3 != NULL) {                  /* Check for gateway and netmask addresses */
+            ptr = (uint8_t *) ESP->Pointers.CPtr3;
             UART_SEND_STR(FROMMEM(",\""));
             i = 4;
             while (i--) {                                   /* Send gateway address */
@@ -1498,20 +2389,20 @@ PT_THREAD(PT_Thread_WIFI(struct pt* pt, evol ESP_t* ESP)) {
         
         ESP->ActiveResult = ESP->Events.F.RespOk ? espOK : espERROR;    /* Check response */
         if (ESP->ActiveResult == espOK) {                   /* Copy data as new MAC address */
-            memcpy((void *)&ESP->STAIP, (void *)Pointers.CPtr2, 4);
-            if (Pointers.CPtr3 != NULL) {                   /* Check network mask and gateway */
-                memcpy((void *)&ESP->STAGateway, ((uint8_t *) Pointers.CPtr3), 4);  /* Copy gateway address */
-                memcpy((void *)&ESP->STANetmask, ((uint8_t *) Pointers.CPtr3) + 4, 4);  /* Copy netmas address */
+            memcpy((void *)&ESP->STAIP, (void *)ESP->Pointers.CPtr2, 4);
+            if (ESP->Pointers.CPtr3 != NULL) {              /* Check network mask and gateway */
+                memcpy((void *)&ESP->STAGateway, ((uint8_t *) ESP->Pointers.CPtr3), 4); /* Copy gateway address */
+                memcpy((void *)&ESP->STANetmask, ((uint8_t *) ESP->Pointers.CPtr3) + 4, 4); /* Copy netmas address */
             }
         }
         
         __IDLE(ESP);                                        /* Go IDLE mode */
     } else if (ESP->ActiveCmd == CMD_WIFI_SETAPIP) {        /* Set AP IP address */
-        ptr = (uint8_t *) Pointers.CPtr2;
+        ptr = (uint8_t *) ESP->Pointers.CPtr2;
         
         __RST_EVENTS_RESP(ESP);                             /* Reset all events */
         UART_SEND_STR(FROMMEM("AT+CIPAP_"));                /* Send data */
-        UART_SEND_STR(FROMMEM(Pointers.CPtr1));             /* Default or current */
+        UART_SEND_STR(FROMMEM(ESP->Pointers.CPtr1));        /* Default or current */
         UART_SEND_STR(FROMMEM("=\""));
         i = 4; ch = '.';
         while (i--) {
@@ -1529,8 +2420,9 @@ PT_THREAD(PT_Thread_WIFI(struct pt* pt, evol ESP_t* ESP)) {
                             ESP->Events.F.RespError);       /* Wait for response */
         
         ESP->ActiveResult = ESP->Events.F.RespOk ? espOK : espERROR;    /* Check response */
-        if (ESP->ActiveResult == espOK) {                   /* Copy data as new MAC address */
-            memcpy((void *)&ESP->STAIP, ptr - 4, 4);
+        if (ESP->ActiveResult == espOK) {                   /* Copy data as new IP address */
+            memcpy((void *)&ESP->APIP, ptr - 4, 4);
+            __CACHE_INVALIDATE(ESP);
         }
         
         __IDLE(ESP);                                        /* Go IDLE mode */
@@ -1563,14 +2455,14 @@ PT_THREAD(PT_Thread_WIFI(struct pt* pt, evol ESP_t* ESP)) {
 cmd_wifi_listaccesspoints_clean:
         __IDLE(ESP);                                        /* Go IDLE mode */
     } else if (ESP->ActiveCmd == CMD_WIFI_CWJAP) {          /* Connect to network */
-        ptr = (uint8_t *) Pointers.Ptr1;
+        ptr = (uint8_t *) ESP->Pointers.Ptr1;
         __RST_EVENTS_RESP(ESP);                             /* Reset all events */
         UART_SEND_STR(FROMMEM("AT+CWJAP_"));                /* Send data */
-        UART_SEND_STR(FROMMEM(Pointers.CPtr1));
+        UART_SEND_STR(FROMMEM(ESP->Pointers.CPtr1));
         UART_SEND_STR(FROMMEM("=\""));
-        EscapeStringAndSend(FROMMEM(Pointers.CPtr2));
+        EscapeStringAndSend(ESP, FROMMEM(ESP->Pointers.CPtr2));
         UART_SEND_STR(FROMMEM("\",\""));
-        EscapeStringAndSend(FROMMEM(Pointers.CPtr3));
+        EscapeStringAndSend(ESP, FROMMEM(ESP->Pointers.CPtr3));
         UART_SEND_STR(FROMMEM("\"")); 
         if (ptr) {                                          /* Send MAC address */
             UART_SEND_STR(FROMMEM(",\""));
@@ -1625,7 +2517,7 @@ cmd_wifi_listaccesspoints_clean:
     } else if (ESP->ActiveCmd == CMD_WIFI_CWAUTOCONN) {     /* Set autoconnect status */
         __RST_EVENTS_RESP(ESP);                             /* Reset all events */
         UART_SEND_STR(FROMMEM("AT+CWAUTOCONN="));           /* Send data */
-        UART_SEND_STR(Pointers.UI ? FROMMEM("1") : FROMMEM("0"));
+        UART_SEND_STR(ESP->Pointers.UI ? FROMMEM("1") : FROMMEM("0"));
         UART_SEND_STR(_CRLF);
         StartCommand(ESP, CMD_WIFI_CWAUTOCONN, NULL);       /* Start command */
         
@@ -1664,22 +2556,22 @@ cmd_wifi_listaccesspoints_clean:
         __RST_EVENTS_RESP(ESP);                             /* Reset all events */
         
         UART_SEND_STR(FROMMEM("AT+CWSAP_"));                /* Send data */
-        UART_SEND_STR(FROMMEM(Pointers.CPtr1));             /* Send data */
+        UART_SEND_STR(FROMMEM(ESP->Pointers.CPtr1));        /* Send data */
         UART_SEND_STR(FROMMEM("=\""));
-        EscapeStringAndSend(((ESP_APConfig_t *)Pointers.CPtr2)->SSID);
+        EscapeStringAndSend(ESP, ((ESP_APConfig_t *)ESP->Pointers.CPtr2)->SSID);
         UART_SEND_STR(FROMMEM("\",\""));
-        EscapeStringAndSend(((ESP_APConfig_t *)Pointers.CPtr2)->Pass);
+        EscapeStringAndSend(ESP, ((ESP_APConfig_t *)ESP->Pointers.CPtr2)->Pass);
         UART_SEND_STR(FROMMEM("\","));
-        NumberToString(str, ((ESP_APConfig_t *)Pointers.CPtr2)->Channel);
+        NumberToString(str, ((ESP_APConfig_t *)ESP->Pointers.CPtr2)->Channel);
         UART_SEND_STR(FROMMEM(str));
         UART_SEND_STR(FROMMEM(","));
-        NumberToString(str, ((ESP_APConfig_t *)Pointers.CPtr2)->Ecn);
+        NumberToString(str, ((ESP_APConfig_t *)ESP->Pointers.CPtr2)->Ecn);
         UART_SEND_STR(FROMMEM(str));
         UART_SEND_STR(FROMMEM(","));
-        NumberToString(str, ((ESP_APConfig_t *)Pointers.CPtr2)->MaxConnections);
+        NumberToString(str, ((ESP_APConfig_t *)ESP->Pointers.CPtr2)->MaxConnections);
         UART_SEND_STR(FROMMEM(str));
         UART_SEND_STR(FROMMEM(","));
-        NumberToString(str, ((ESP_APConfig_t *)Pointers.CPtr2)->Hidden);
+        NumberToString(str, ((ESP_APConfig_t *)ESP->Pointers.CPtr2)->Hidden);
         UART_SEND_STR(FROMMEM(str));
         UART_SEND_STR(_CRLF);
         StartCommand(ESP, CMD_WIFI_CWSAP, NULL);            /* Start command */
@@ -1691,13 +2583,14 @@ cmd_wifi_listaccesspoints_clean:
         if (ESP->ActiveResult != espOK) {
             __IDLE(ESP);                                    /* Go IDLE mode */
         } else {
+            __CACHE_INVALIDATE(ESP);                        /* Soft AP settings changed */
             __IDLE(ESP);                                    /* Go IDLE mode */
             __ACTIVE_CMD(ESP, CMD_WIFI_GETCWSAP);           /* Get info and save to structure */
         }
     } else if (ESP->ActiveCmd == CMD_WIFI_WPS) {            /* Set WPS function */
         __RST_EVENTS_RESP(ESP);                             /* Reset all events */
         UART_SEND_STR(FROMMEM("AT+WPS="));                  /* Send data */
-        UART_SEND_STR(Pointers.UI ? FROMMEM("1") : FROMMEM("0"));
+        UART_SEND_STR(ESP->Pointers.UI ? FROMMEM("1") : FROMMEM("0"));
         UART_SEND_STR(_CRLF);
         StartCommand(ESP, CMD_WIFI_WPS, NULL);              /* Start command */
         
@@ -1711,7 +2604,7 @@ cmd_wifi_listaccesspoints_clean:
         __RST_EVENTS_RESP(ESP);                             /* Reset all events */
         
         UART_SEND_STR(FROMMEM("AT+CWHOSTNAME=\""));         /* Send data */
-        EscapeStringAndSend((char *)Pointers.CPtr1);
+        EscapeStringAndSend(ESP, (char *)ESP->Pointers.CPtr1);
         UART_SEND_STR(FROMMEM("\""));
         UART_SEND_STR(_CRLF);
         StartCommand(ESP, CMD_WIFI_SETHOSTNAME, NULL);      /* Start command */
@@ -1743,14 +2636,12 @@ cmd_wifi_listaccesspoints_clean:
 estatic
 PT_THREAD(PT_Thread_TCPIP(struct pt* pt, evol ESP_t* ESP)) {
     char str[7];
-    static uint8_t i;
-    static uint8_t tries;
-    static uint32_t btw = 0;
+    uint8_t i;
     
     PT_BEGIN(pt);
 
     if (ESP->ActiveCmd == CMD_TCPIP_CIPMUX) {               /* Set device mode */
-        NumberToString(str, Pointers.UI);                   /* Convert mode to string */
+        NumberToString(str, ESP->Pointers.UI);              /* Convert mode to string */
         __RST_EVENTS_RESP(ESP);                             /* Reset all events */
         UART_SEND_STR(FROMMEM("AT+CIPMUX="));               /* Send data */
         UART_SEND_STR(FROMMEM(str));
@@ -1776,7 +2667,7 @@ PT_THREAD(PT_Thread_TCPIP(struct pt* pt, evol ESP_t* ESP)) {
         
         __IDLE(ESP);                                        /* Go IDLE mode */
     } else if (ESP->ActiveCmd == CMD_TCPIP_SERVERENABLE) {  /* Enable server mode */
-        NumberToString(str, Pointers.UI);                   /* Convert mode to string */
+        NumberToString(str, ESP->Pointers.UI);              /* Convert mode to string */
         __RST_EVENTS_RESP(ESP);                             /* Reset all events */
         UART_SEND_STR(FROMMEM("AT+CIPSERVER=1,"));          /* Send data */
         UART_SEND_STR(FROMMEM(str));
@@ -1802,7 +2693,7 @@ PT_THREAD(PT_Thread_TCPIP(struct pt* pt, evol ESP_t* ESP)) {
         
         __IDLE(ESP);                                        /* Go IDLE mode */
     } else if (ESP->ActiveCmd == CMD_TCPIP_CIPSTO) {        /* Set server timeout */
-        NumberToString(str, Pointers.UI);                   /* Convert mode to string */
+        NumberToString(str, ESP->Pointers.UI);              /* Convert mode to string */
         __RST_EVENTS_RESP(ESP);                             /* Reset all events */
         UART_SEND_STR(FROMMEM("AT+CIPSTO="));               /* Send data */
         UART_SEND_STR(FROMMEM(str));
@@ -1831,19 +2722,19 @@ PT_THREAD(PT_Thread_TCPIP(struct pt* pt, evol ESP_t* ESP)) {
         for (i = 0; i < ESP_MAX_CONNECTIONS; i++) {
             if (!ESP->Conn[i].Flags.F.Active || (ESP->ActiveConns & (1 << i)) == 0) {
                 ESP->Conn[i].Number = i;
-                *(ESP_CONN_t **)Pointers.PPtr1 = (ESP_CONN_t *)&ESP->Conn[i];
+                *(ESP_CONN_t **)ESP->Pointers.PPtr1 = (ESP_CONN_t *)&ESP->Conn[i];
                 break;
             }
         }
         
         /* Check valid connection */
-        if (!(*(ESP_CONN_t **)Pointers.PPtr1) || i == ESP_MAX_CONNECTIONS) {
+        if (!(*(ESP_CONN_t **)ESP->Pointers.PPtr1) || i == ESP_MAX_CONNECTIONS) {
             ESP->ActiveResult = espERROR;
             goto cmd_tcpip_cipstart_clean;
         }
         
         /* Check if there is an active connection and is SSL */
-        if (((ESP_CONN_Type_t)(Pointers.UI >> 16)) == ESP_CONN_Type_SSL) {
+        if (((ESP_CONN_Type_t)(ESP->Pointers.UI >> 16)) == ESP_CONN_Type_SSL) {
             for (i = 0; i < ESP_MAX_CONNECTIONS; i++) {
                 if (ESP->Conn[i].Flags.F.Active && ESP->Conn[i].Flags.F.SSL) {
                     ESP->ActiveResult = espSSLERROR;
@@ -1852,27 +2743,27 @@ PT_THREAD(PT_Thread_TCPIP(struct pt* pt, evol ESP_t* ESP)) {
             }
         }
 
-        (*(ESP_CONN_t **)Pointers.PPtr1)->Flags.F.Client = 1;   /* Connection made as client */
-        (*(ESP_CONN_t **)Pointers.PPtr1)->Flags.F.SSL = ((ESP_CONN_Type_t)(Pointers.UI >> 16)) == ESP_CONN_Type_SSL;  /* Connection type is SSL */
+        (*(ESP_CONN_t **)ESP->Pointers.PPtr1)->Flags.F.Client = 1;  /* Connection made as client */
+        (*(ESP_CONN_t **)ESP->Pointers.PPtr1)->Flags.F.SSL = ((ESP_CONN_Type_t)(ESP->Pointers.UI >> 16)) == ESP_CONN_Type_SSL;  /* Connection type is SSL */
         
         __RST_EVENTS_RESP(ESP);                             /* Reset all events */
         UART_SEND_STR(FROMMEM("AT+CIPSTART="));             /* Send data */
 #if !ESP_SINGLE_CONN
-        NumberToString(str, (*(ESP_CONN_t **)Pointers.PPtr1)->Number);  /* Convert mode to string */
+        NumberToString(str, (*(ESP_CONN_t **)ESP->Pointers.PPtr1)->Number); /* Convert mode to string */
         UART_SEND_STR(FROMMEM(str));
         UART_SEND_STR(FROMMEM(","));
-#endif /* ESP_SINGLE_CONN */
-        if (((ESP_CONN_Type_t)(Pointers.UI >> 16)) == ESP_CONN_Type_TCP) {
+#endif                                                      /* ESP_SINGLE_CONN */
+        if (((ESP_CONN_Type_t)(ESP->Pointers.UI >> 16)) == ESP_CONN_Type_TCP) {
             UART_SEND_STR(FROMMEM("\"TCP"));
-        } else if (((ESP_CONN_Type_t)(Pointers.UI >> 16)) == ESP_CONN_Type_UDP) {
+        } else if (((ESP_CONN_Type_t)(ESP->Pointers.UI >> 16)) == ESP_CONN_Type_UDP) {
             UART_SEND_STR(FROMMEM("\"UDP"));
-        } else if (((ESP_CONN_Type_t)(Pointers.UI >> 16)) == ESP_CONN_Type_SSL) {
+        } else if (((ESP_CONN_Type_t)(ESP->Pointers.UI >> 16)) == ESP_CONN_Type_SSL) {
             UART_SEND_STR(FROMMEM("\"SSL"));
         }
         UART_SEND_STR(FROMMEM("\",\""));
-        UART_SEND_STR(FROMMEM(Pointers.CPtr1));
+        UART_SEND_STR(FROMMEM(ESP->Pointers.CPtr1));
         UART_SEND_STR(FROMMEM("\","));
-        NumberToString(str, Pointers.UI & 0xFFFF);
+        NumberToString(str, ESP->Pointers.UI & 0xFFFF);
         UART_SEND_STR(FROMMEM(str));
         UART_SEND_STR(_CRLF);
         StartCommand(ESP, CMD_TCPIP_CIPSTART, NULL);        /* Start command */
@@ -1883,7 +2774,7 @@ PT_THREAD(PT_Thread_TCPIP(struct pt* pt, evol ESP_t* ESP)) {
         ESP->ActiveResult = ESP->Events.F.RespOk ? espOK : espERROR;    /* Check response */
         
         if (ESP->ActiveResult != espOK) {                   /* Failed, reset connection */
-            __CONN_RESET((*(ESP_CONN_t **)Pointers.PPtr1));
+            __CONN_RESET((*(ESP_CONN_t **)ESP->Pointers.PPtr1));
             goto cmd_tcpip_cipstart_clean;
         }
         
@@ -1898,12 +2789,12 @@ cmd_tcpip_cipstart_clean:
         
         __RST_EVENTS_RESP(ESP);                             /* Reset all events */
 #if !ESP_SINGLE_CONN
-        NumberToString(str, Pointers.UI);                   /* Close specific connection */
+        NumberToString(str, ESP->Pointers.UI);              /* Close specific connection */
         UART_SEND_STR(FROMMEM("AT+CIPCLOSE="));             /* Send data */
         UART_SEND_STR(FROMMEM(str));
 #else
         UART_SEND_STR(FROMMEM("AT+CIPCLOSE"));              /* Send data */ 
-#endif /* !ESP_SINGLE_CONN */
+#endif                                                      /* !ESP_SINGLE_CONN */
         UART_SEND_STR(_CRLF);
         StartCommand(ESP, CMD_TCPIP_CIPCLOSE, NULL);        /* Start command */
         
@@ -1932,25 +2823,26 @@ cmd_tcpip_cipstart_clean:
             
             ESP->ActiveResult = ESP->Events.F.RespBracket ? espOK : espERROR;
             ESP->Flags.F.InTransparentMode = ESP->ActiveResult == espOK;    /* Transfer mode status */
+            ESP->TransferCloseMatch = 0;                    /* Start looking for close marker */
         } else 
-#endif /* ESP_SINGLE_CONN */
+#endif                                                      /* ESP_SINGLE_CONN */
         {
-            if (Pointers.Ptr2 != NULL) {
-                *(uint32_t *)Pointers.Ptr2 = 0;             /* Set sent bytes to zero first */
+            if (ESP->Pointers.Ptr2 != NULL) {
+                *(uint32_t *)ESP->Pointers.Ptr2 = 0;             /* Set sent bytes to zero first */
             }
             
-            tries = 3;                                      /* Give 3 tries to send each packet */
+            ESP->SendTries = 3;                             /* Give 3 ESP->SendTries to send each packet */
             do {
-                btw = Pointers.UI > ESP_MAX_SEND_DATA_LEN ? ESP_MAX_SEND_DATA_LEN : Pointers.UI;    /* Set length to send */
+                ESP->SendLength = ESP->Pointers.UI > ESP_MAX_SEND_DATA_LEN ? ESP_MAX_SEND_DATA_LEN : ESP->Pointers.UI;  /* Set length to send */
                 
                 __RST_EVENTS_RESP(ESP);                     /* Reset events */
                 UART_SEND_STR(FROMMEM("AT+CIPSEND="));      /* Send number to ESP */
 #if !ESP_SINGLE_CONN
-                NumberToString(str, ((ESP_CONN_t *)Pointers.Ptr1)->Number);
+                NumberToString(str, ((ESP_CONN_t *)ESP->Pointers.Ptr1)->Number);
                 UART_SEND_STR(FROMMEM(str));
                 UART_SEND_STR(FROMMEM(","));
-#endif /* ESP_SINGLE_CONN */
-                NumberToString(str, btw);                   /* Get string from number */
+#endif                                                      /* ESP_SINGLE_CONN */
+                NumberToString(str, ESP->SendLength);       /* Get string from number */
                 UART_SEND_STR(str);
                 UART_SEND_STR(_CRLF);
                 StartCommand(ESP, CMD_TCPIP_CIPSEND, NULL); /* Start command */
@@ -1960,46 +2852,252 @@ cmd_tcpip_cipstart_clean:
                 
                 if (ESP->Events.F.RespBracket) {            /* We received bracket */
                     __RST_EVENTS_RESP(ESP);                 /* Reset events */
-                    UART_SEND((uint8_t *)Pointers.CPtr1, btw);  /* Send data */
+                    if (ESP->Pointers.CPtr2) {              /* Send packet from multiple buffers */
+                        SendVector(ESP, ESP->SendLength, 0);
+                    } else {
+                        UART_SEND((uint8_t *)ESP->Pointers.CPtr1, ESP->SendLength); /* Send data */
+                    }
                     
                     PT_WAIT_UNTIL(pt, ESP->Events.F.RespSendOk ||
                                         ESP->Events.F.RespSendFail ||
                                         ESP->Events.F.RespError);   /* Wait for OK or ERROR */
                     
                     ESP->ActiveResult = ESP->Events.F.RespSendOk ? espOK : espSENDERROR; /* Set result to return */
-                    __CONN_UPDATE_TIME(ESP, (ESP_CONN_t *)Pointers.Ptr1);   /* Update connection access time */
+                    __CONN_UPDATE_TIME(ESP, (ESP_CONN_t *)ESP->Pointers.Ptr1);  /* Update connection access time */
                     
                     if (ESP->ActiveResult == espOK) {
-                        if (Pointers.Ptr2 != NULL) {
-                            *(uint32_t *)Pointers.Ptr2 = *(uint32_t *)Pointers.Ptr2 + btw;  /* Increase number of sent bytes */
+                        if (ESP->Pointers.Ptr2 != NULL) {
+                            *(uint32_t *)ESP->Pointers.Ptr2 = *(uint32_t *)ESP->Pointers.Ptr2 + ESP->SendLength;  /* Increase number of sent bytes */
                         }
+                        __STATS_ADD(ESP, Conn[((ESP_CONN_t *)ESP->Pointers.Ptr1)->Number].BytesSent, ESP->SendLength);
                     }
                 } else if (ESP->Events.F.RespError) {
                     ESP->ActiveResult = espERROR;           /* Process error */
                 }
                 if (ESP->ActiveResult == espOK) {
-                    tries = 3;                              /* Reset number of tries */
+                    ESP->SendTries = 3;                     /* Reset number of ESP->SendTries */
                     
-                    Pointers.UI -= btw;                     /* Decrease number of sent bytes */
-                    Pointers.CPtr1 = (uint8_t *)Pointers.CPtr1 + btw;   /* Set new data memory location to send */
+                    ESP->Pointers.UI -= ESP->SendLength;    /* Decrease number of sent bytes */
+                    if (ESP->Pointers.CPtr2) {
+                        SendVector(ESP, ESP->SendLength, 1);    /* Move to first byte of next packet */
+                    } else {
+                        ESP->Pointers.CPtr1 = (uint8_t *)ESP->Pointers.CPtr1 + ESP->SendLength; /* Set new data memory location to send */
+                    }
                 } else if (ESP->Events.F.RespSendFail) {    /* Send failed */
-                    tries--;                                /* We failed, decrease number of tries and start over */
+                    ESP->SendTries--;                       /* We failed, decrease number of ESP->SendTries and start over */
+                    __STATS_INC(ESP, SendRetries);
                 } else {                                    /* Error was received, link is probably not active */
-                    tries = 0;                              /* Stop execution here */
+                    ESP->SendTries = 0;                     /* Stop execution here */
                 }
-            } while (Pointers.UI && tries);                 /* Until anything to send or max tries reached */
+            } while (ESP->Pointers.UI && ESP->SendTries);   /* Until anything to send or max ESP->SendTries reached */
+            
+            if (ESP->SendTries) {
+                EventAdd(ESP, espEventDataSent, (ESP_CONN_t *)ESP->Pointers.Ptr1, 0);
+            } else {
+                EventAdd(ESP, espEventDataSentError, (ESP_CONN_t *)ESP->Pointers.Ptr1, 0);
+            }
+        }
+        
+        __CMD_RESTORE(ESP);                                 /* Restore command */
+        __IDLE(ESP);                                        /* Go IDLE mode */
+    } else if (ESP->ActiveCmd == CMD_TCPIP_CIPSENDEX) {     /* Send string on connection */
+        __CMD_SAVE(ESP);                                    /* Save command */
+        
+        if (ESP->Pointers.Ptr2 != NULL) {
+            *(uint32_t *)ESP->Pointers.Ptr2 = 0;            /* Set sent bytes to zero first */
+        }
+        
+        ESP->SendTries = 3;                                 /* Give 3 tries to send each packet */
+        do {
+            ESP->Pointers.CPtr2 = memchr((const void *)ESP->Pointers.CPtr1, 0, ESP_MAX_SEND_DATA_LEN);  /* Find end of string in next packet */
+            ESP->SendLength = ESP->Pointers.CPtr2 ? (const char *)ESP->Pointers.CPtr2 - (const char *)ESP->Pointers.CPtr1 : ESP_MAX_SEND_DATA_LEN;
             
-            if (tries) {
-                ((ESP_CONN_t *)Pointers.Ptr1)->Callback.F.DataSent = 1; /* Set flag for callback */
+            __RST_EVENTS_RESP(ESP);                         /* Reset events */
+            UART_SEND_STR(FROMMEM("AT+CIPSENDEX="));        /* Send command with maximal length */
+#if !ESP_SINGLE_CONN
+            NumberToString(str, ((ESP_CONN_t *)ESP->Pointers.Ptr1)->Number);
+            UART_SEND_STR(FROMMEM(str));
+            UART_SEND_STR(FROMMEM(","));
+#endif                                                      /* ESP_SINGLE_CONN */
+            NumberToString(str, ESP_MAX_SEND_DATA_LEN);
+            UART_SEND_STR(str);
+            UART_SEND_STR(_CRLF);
+            StartCommand(ESP, CMD_TCPIP_CIPSENDEX, NULL);   /* Start command */
+            
+            PT_WAIT_UNTIL(pt, ESP->Events.F.RespBracket ||
+                                ESP->Events.F.RespError);   /* Wait for > character and timeout */
+            
+            if (ESP->Events.F.RespBracket) {                /* We received bracket */
+                __RST_EVENTS_RESP(ESP);                     /* Reset events */
+                UART_SEND((uint8_t *)ESP->Pointers.CPtr1, ESP->SendLength); /* Send data */
+                if (ESP->SendLength < ESP_MAX_SEND_DATA_LEN) {
+                    UART_SEND(FROMMEM("\\0"), 2);           /* Terminate packet before maximal length */
+                }
+                
+                PT_WAIT_UNTIL(pt, ESP->Events.F.RespSendOk ||
+                                    ESP->Events.F.RespSendFail ||
+                                    ESP->Events.F.RespError);   /* Wait for OK or ERROR */
+                
+                ESP->ActiveResult = ESP->Events.F.RespSendOk ? espOK : espSENDERROR;    /* Set result to return */
+                __CONN_UPDATE_TIME(ESP, (ESP_CONN_t *)ESP->Pointers.Ptr1);  /* Update connection access time */
             } else {
-                ((ESP_CONN_t *)Pointers.Ptr1)->Callback.F.DataError = 1;/* Set flag for callback */
+                ESP->ActiveResult = espERROR;               /* Process error */
+            }
+            if (ESP->ActiveResult == espOK) {
+                ESP->SendTries = 3;                         /* Reset number of tries */
+                if (ESP->Pointers.Ptr2 != NULL) {
+                    *(uint32_t *)ESP->Pointers.Ptr2 = *(uint32_t *)ESP->Pointers.Ptr2 + ESP->SendLength;  /* Increase number of sent bytes */
+                }
+                __STATS_ADD(ESP, Conn[((ESP_CONN_t *)ESP->Pointers.Ptr1)->Number].BytesSent, ESP->SendLength);
+                ESP->Pointers.CPtr1 = (const char *)ESP->Pointers.CPtr1 + ESP->SendLength;  /* Set new data memory location to send */
+            } else if (ESP->Events.F.RespSendFail) {        /* Send failed */
+                ESP->SendTries--;                           /* We failed, decrease number of tries and start over */
+                __STATS_INC(ESP, SendRetries);
+            } else {                                        /* Error was received, link is probably not active */
+                ESP->SendTries = 0;                         /* Stop execution here */
+            }
+        } while (*(const char *)ESP->Pointers.CPtr1 && ESP->SendTries); /* Until end of string or max tries reached */
+        
+        if (ESP->SendTries) {
+            EventAdd(ESP, espEventDataSent, (ESP_CONN_t *)ESP->Pointers.Ptr1, 0);
+        } else {
+            EventAdd(ESP, espEventDataSentError, (ESP_CONN_t *)ESP->Pointers.Ptr1, 0);
+        }
+        
+        __CMD_RESTORE(ESP);                                 /* Restore command */
+        __IDLE(ESP);                                        /* Go IDLE mode */
+    } else if (ESP->ActiveCmd == CMD_TCPIP_CIPSENDBUF) {    /* Add data to module send buffer */
+        __CMD_SAVE(ESP);                                    /* Save command */
+        
+        if (ESP->Pointers.Ptr2 != NULL) {
+            *(uint32_t *)ESP->Pointers.Ptr2 = 0;            /* Set added bytes to zero first */
+        }
+        
+        ESP->SendTries = 3;                                 /* Give 3 tries when module buffer is full */
+        do {
+            ESP->SendLength = ESP->Pointers.UI > ESP_MAX_SEND_DATA_LEN ? ESP_MAX_SEND_DATA_LEN : ESP->Pointers.UI;  /* Set length to send */
+            
+            __RST_EVENTS_RESP(ESP);                         /* Reset events */
+            PT_WAIT_UNTIL(pt, __CONN_SEGMENTS((ESP_CONN_t *)ESP->Pointers.Ptr1) < ESP_SENDBUF_SEGMENTS ||
+                                !((ESP_CONN_t *)ESP->Pointers.Ptr1)->Flags.F.Active ||
+                                ESP->Events.F.RespError);   /* Wait for free segment in module buffer */
+            
+            ESP->ActiveResult = espERROR;
+            if (!ESP->Events.F.RespError && ((ESP_CONN_t *)ESP->Pointers.Ptr1)->Flags.F.Active) {
+                __RST_EVENTS_RESP(ESP);                     /* Reset events */
+                UART_SEND_STR(FROMMEM("AT+CIPSENDBUF="));   /* Send number to ESP */
+#if !ESP_SINGLE_CONN
+                NumberToString(str, ((ESP_CONN_t *)ESP->Pointers.Ptr1)->Number);
+                UART_SEND_STR(FROMMEM(str));
+                UART_SEND_STR(FROMMEM(","));
+#endif                                                      /* ESP_SINGLE_CONN */
+                NumberToString(str, ESP->SendLength);       /* Get string from number */
+                UART_SEND_STR(str);
+                UART_SEND_STR(_CRLF);
+                StartCommand(ESP, CMD_TCPIP_CIPSENDBUF, NULL);  /* Start command */
+                
+                PT_WAIT_UNTIL(pt, ESP->Events.F.RespBracket ||
+                                    ESP->Events.F.RespError);   /* Wait for > character and timeout */
+                
+                if (ESP->Events.F.RespBracket) {            /* We received bracket */
+                    __RST_EVENTS_RESP(ESP);                 /* Reset events */
+                    UART_SEND((uint8_t *)ESP->Pointers.CPtr1, ESP->SendLength); /* Send data */
+                    
+                    PT_WAIT_UNTIL(pt, ESP->Events.F.RespRecv ||
+                                        ESP->Events.F.RespError);   /* Wait for data to be in module buffer */
+                    
+                    ESP->ActiveResult = ESP->Events.F.RespRecv ? espOK : espSENDERROR;
+                    __CONN_UPDATE_TIME(ESP, (ESP_CONN_t *)ESP->Pointers.Ptr1);  /* Update connection access time */
+                } else {
+                    ESP->ActiveResult = espERROR;           /* Data were not accepted */
+                }
+            }
+            if (ESP->ActiveResult == espOK) {
+                ESP->SendTries = 3;                         /* Reset number of tries */
+                if (ESP->Pointers.Ptr2 != NULL) {
+                    *(uint32_t *)ESP->Pointers.Ptr2 = *(uint32_t *)ESP->Pointers.Ptr2 + ESP->SendLength;  /* Increase number of added bytes */
+                }
+                __STATS_ADD(ESP, Conn[((ESP_CONN_t *)ESP->Pointers.Ptr1)->Number].BytesSent, ESP->SendLength);
+                ESP->Pointers.UI -= ESP->SendLength;        /* Decrease number of bytes to send */
+                ESP->Pointers.CPtr1 = (uint8_t *)ESP->Pointers.CPtr1 + ESP->SendLength; /* Set new data memory location to send */
+            } else if (ESP->ActiveResult == espERROR && ESP->Events.F.RespError &&
+                        __CONN_SEGMENTS((ESP_CONN_t *)ESP->Pointers.Ptr1) &&
+                        ((ESP_CONN_t *)ESP->Pointers.Ptr1)->Flags.F.Active) {   /* Module buffer is probably full */
+                ESP->SendTries--;
+                __STATS_INC(ESP, SendRetries);
+                
+                __RST_EVENTS_RESP(ESP);                     /* Reset events */
+                UART_SEND_STR(FROMMEM("AT+CIPBUFSTATUS"));  /* Check module buffer status */
+#if !ESP_SINGLE_CONN
+                UART_SEND_STR(FROMMEM("="));
+                NumberToString(str, ((ESP_CONN_t *)ESP->Pointers.Ptr1)->Number);
+                UART_SEND_STR(FROMMEM(str));
+#endif                                                      /* ESP_SINGLE_CONN */
+                UART_SEND_STR(_CRLF);
+                StartCommand(ESP, CMD_TCPIP_CIPBUFSTATUS, NULL);    /* Start command */
+                
+                PT_WAIT_UNTIL(pt, ESP->Events.F.RespOk ||
+                                    ESP->Events.F.RespError);   /* Wait for response */
+                
+                if (ESP->Events.F.RespOk && ((ESP_CONN_t *)ESP->Pointers.Ptr1)->SendBufferFree < ESP->SendLength) {
+                    ESP->SendAck = ((ESP_CONN_t *)ESP->Pointers.Ptr1)->SendSegmentAck;  /* Save last sent segment */
+                    
+                    __RST_EVENTS_RESP(ESP);                 /* Reset events */
+                    PT_WAIT_UNTIL(pt, ((ESP_CONN_t *)ESP->Pointers.Ptr1)->SendSegmentAck != ESP->SendAck ||
+                                        !__CONN_SEGMENTS((ESP_CONN_t *)ESP->Pointers.Ptr1) ||
+                                        ESP->Events.F.RespError);   /* Wait for module to send at least one segment */
+                }
+            } else {                                        /* Connection is closed or data were not accepted */
+                ESP->SendTries = 0;                         /* Stop execution here */
             }
+        } while (ESP->Pointers.UI && ESP->SendTries);       /* Until anything to send or max tries reached */
+        
+        if (ESP->Pointers.UI) {                             /* Not all data were added */
+            EventAdd(ESP, espEventDataSentError, (ESP_CONN_t *)ESP->Pointers.Ptr1, 0);
+        } else {
+            EventAdd(ESP, espEventDataSent, (ESP_CONN_t *)ESP->Pointers.Ptr1, 0);
         }
         
         __CMD_RESTORE(ESP);                                 /* Restore command */
+        __IDLE(ESP);                                        /* Go IDLE mode */
+    } else if (ESP->ActiveCmd == CMD_TCPIP_CIPBUFSTATUS) {  /* Check module send buffer status */
+        __RST_EVENTS_RESP(ESP);                             /* Reset all events */
+        UART_SEND_STR(FROMMEM("AT+CIPBUFSTATUS"));          /* Send data */
+#if !ESP_SINGLE_CONN
+        UART_SEND_STR(FROMMEM("="));
+        NumberToString(str, ((ESP_CONN_t *)ESP->Pointers.Ptr1)->Number);
+        UART_SEND_STR(FROMMEM(str));
+#endif                                                      /* ESP_SINGLE_CONN */
+        UART_SEND_STR(_CRLF);
+        StartCommand(ESP, CMD_TCPIP_CIPBUFSTATUS, NULL);    /* Start command */
+        
+        PT_WAIT_UNTIL(pt, ESP->Events.F.RespOk || 
+                            ESP->Events.F.RespError);       /* Wait for response */
+        
+        ESP->ActiveResult = ESP->Events.F.RespOk ? espOK : espERROR;    /* Check response */
+        
+        __IDLE(ESP);                                        /* Go IDLE mode */
+    } else if (ESP->ActiveCmd == CMD_TCPIP_CIPCHECKSEQ) {   /* Check if segment was sent */
+        __RST_EVENTS_RESP(ESP);                             /* Reset all events */
+        UART_SEND_STR(FROMMEM("AT+CIPCHECKSEQ="));          /* Send data */
+#if !ESP_SINGLE_CONN
+        NumberToString(str, ((ESP_CONN_t *)ESP->Pointers.Ptr1)->Number);
+        UART_SEND_STR(FROMMEM(str));
+        UART_SEND_STR(FROMMEM(","));
+#endif                                                      /* ESP_SINGLE_CONN */
+        NumberToString(str, ESP->Pointers.UI);
+        UART_SEND_STR(FROMMEM(str));
+        UART_SEND_STR(_CRLF);
+        StartCommand(ESP, CMD_TCPIP_CIPCHECKSEQ, NULL);     /* Start command */
+        
+        PT_WAIT_UNTIL(pt, ESP->Events.F.RespOk || 
+                            ESP->Events.F.RespError);       /* Wait for response */
+        
+        ESP->ActiveResult = ESP->Events.F.RespOk ? espOK : espERROR;    /* Check response */
+        
         __IDLE(ESP);                                        /* Go IDLE mode */
     } else if (ESP->ActiveCmd == CMD_TCPIP_CIPSSLSIZE) {    /* Set SSL buffer size */
-        NumberToString(str, Pointers.UI);                   /* Close specific connection */
+        NumberToString(str, ESP->Pointers.UI);              /* Close specific connection */
         __RST_EVENTS_RESP(ESP);                             /* Reset all events */
         UART_SEND_STR(FROMMEM("AT+CIPSSLSIZE="));           /* Send data */
         UART_SEND_STR(FROMMEM(str));
@@ -2015,7 +3113,7 @@ cmd_tcpip_cipstart_clean:
     } else if (ESP->ActiveCmd == CMD_TCPIP_PING) {          /* Ping domain or IP */
         __RST_EVENTS_RESP(ESP);                             /* Reset all events */
         UART_SEND_STR(FROMMEM("AT+PING=\""));               /* Send data */
-        UART_SEND_STR(FROMMEM(Pointers.CPtr1));
+        UART_SEND_STR(FROMMEM(ESP->Pointers.CPtr1));
         UART_SEND_STR(FROMMEM("\""));
         UART_SEND_STR(_CRLF);
         StartCommand(ESP, CMD_TCPIP_PING, NULL);            /* Start command */
@@ -2041,7 +3139,7 @@ cmd_tcpip_cipstart_clean:
     }
 #if ESP_SINGLE_CONN
     else if (ESP->ActiveCmd == CMD_TCPIP_CIPMODE) {         /* Set transfer CIP mode */
-        NumberToString(str, Pointers.UI);                   /* Close specific connection */
+        NumberToString(str, ESP->Pointers.UI);              /* Close specific connection */
         __RST_EVENTS_RESP(ESP);                             /* Reset all events */
         UART_SEND_STR(FROMMEM("AT+CIPMODE="));              /* Send data */
         UART_SEND_STR(FROMMEM(str));
@@ -2053,19 +3151,20 @@ cmd_tcpip_cipstart_clean:
         
         ESP->ActiveResult = ESP->Events.F.RespOk ? espOK : espERROR;    /* Check response */
         if (ESP->ActiveResult == espOK) {
-            ESP->TransferMode = (ESP_TransferMode_t) Pointers.UI;
+            ESP->TransferMode = (ESP_TransferMode_t) ESP->Pointers.UI;
         }
         
         __IDLE(ESP);                                        /* Go IDLE mode */
     } else if (ESP->ActiveCmd == CMD_TCPIP_TRANSFER_STOP) {        
+#if ESP_TRANSFER_TX_SIZE
+        TransferFlush(ESP, 1);                              /* Send all data waiting in transmit ring */
+#endif                                                      /* ESP_TRANSFER_TX_SIZE */
         /****** Execute AT check ******/
-        btw = ESP->Time;                                    /* Set start time */
-        PT_WAIT_UNTIL(pt, (ESP->Time - btw) > 100);         /* Wait some time first */
+        __THREAD_DELAY(ESP, pt, 100);                       /* Wait some time first */
         
         UART_SEND((uint8_t *)"+++", 3);                     /* Send data to stop transfer mode */
         
-        btw = ESP->Time;                                    /* Set new start time */
-        PT_WAIT_UNTIL(pt, (ESP->Time - btw) > 1100);        /* Wait at least 1 second for next command */
+        __THREAD_DELAY(ESP, pt, 1100);                      /* Wait at least 1 second for next command */
         
         ESP->Flags.F.InTransparentMode = 0;                 /* Temporarly disable transparent mode */
         RECEIVED_RESET();
@@ -2084,21 +3183,21 @@ cmd_tcpip_cipstart_clean:
         
         __IDLE(ESP);                                        /* Go IDLE mode */
     }
-#endif /* ESP_SINGLE_CONN */
+#endif                                                      /* ESP_SINGLE_CONN */
     else if (ESP->ActiveCmd == CMD_TCPIP_SNTPSETCFG) {      /* Set SNTP configuration */
         __RST_EVENTS_RESP(ESP);                             /* Reset all events */
         
         UART_SEND_STR(FROMMEM("AT+CIPSNTPCFG="));           /* Send data */
-        NumberToString(str, !!((ESP_SNTP_t *)Pointers.CPtr1)->Enable);
+        NumberToString(str, !!((ESP_SNTP_t *)ESP->Pointers.CPtr1)->Enable);
         UART_SEND_STR(FROMMEM(str));
-        if (((ESP_SNTP_t *)Pointers.CPtr1)->Enable) {       /* SNTP is enabled, send other settings */
-            sprintf(str, "%d", (signed)((ESP_SNTP_t *)Pointers.CPtr1)->Timezone);
+        if (((ESP_SNTP_t *)ESP->Pointers.CPtr1)->Enable) {  /* SNTP is enabled, send other settings */
+            sprintf(str, "%d", (signed)((ESP_SNTP_t *)ESP->Pointers.CPtr1)->Timezone);
             UART_SEND_STR(FROMMEM(","));
             UART_SEND_STR(FROMMEM(str));                    /* Send timezone */
-            for (i = 0; i < sizeof(((ESP_SNTP_t *)Pointers.CPtr1)->Addr) / sizeof(((ESP_SNTP_t *)Pointers.CPtr1)->Addr[0]); i++) {  /* Check all servers if exists */
-                if (((ESP_SNTP_t *)Pointers.CPtr1)->Addr[i] && strlen(((ESP_SNTP_t *)Pointers.CPtr1)->Addr[i])) {
+            for (i = 0; i < sizeof(((ESP_SNTP_t *)ESP->Pointers.CPtr1)->Addr) / sizeof(((ESP_SNTP_t *)ESP->Pointers.CPtr1)->Addr[0]); i++) {    /* Check all servers if exists */
+                if (((ESP_SNTP_t *)ESP->Pointers.CPtr1)->Addr[i] && strlen(((ESP_SNTP_t *)ESP->Pointers.CPtr1)->Addr[i])) {
                     UART_SEND_STR(FROMMEM(",\""));
-                    UART_SEND_STR(FROMMEM(((ESP_SNTP_t *)Pointers.CPtr1)->Addr[i]));    /* Send first server address */
+                    UART_SEND_STR(FROMMEM(((ESP_SNTP_t *)ESP->Pointers.CPtr1)->Addr[i]));   /* Send first server address */
                     UART_SEND_STR(FROMMEM("\""));
                 }
             }
@@ -2140,12 +3239,12 @@ cmd_tcpip_cipstart_clean:
         
         __RST_EVENTS_RESP(ESP);                             /* Reset all events */
         UART_SEND_STR(FROMMEM("AT+CIPDNS_"));               /* Send data */
-        UART_SEND_STR(FROMMEM(Pointers.CPtr1));
+        UART_SEND_STR(FROMMEM(ESP->Pointers.CPtr1));
         UART_SEND_STR(FROMMEM("="));
         
         /* Send addresses */
         do {
-            const ESP_DNS_t* dns = (ESP_DNS_t *)Pointers.CPtr2;  
+            const ESP_DNS_t* dns = (ESP_DNS_t *)ESP->Pointers.CPtr2;  
         
             NumberToString(str, !!dns->Enable);
             UART_SEND_STR(FROMMEM(str));      
@@ -2180,7 +3279,7 @@ cmd_tcpip_cipstart_clean:
     } else if (ESP->ActiveCmd == CMD_TCPIP_CIPGETDNS) {     /* Get DNS configuration */
         __RST_EVENTS_RESP(ESP);                             /* Reset all events */
         UART_SEND_STR(FROMMEM("AT+CIPDNS_"));               /* Send data */
-        UART_SEND_STR(FROMMEM(Pointers.CPtr1));
+        UART_SEND_STR(FROMMEM(ESP->Pointers.CPtr1));
         UART_SEND_STR(FROMMEM("?"));
         
         UART_SEND_STR(_CRLF);
@@ -2195,7 +3294,7 @@ cmd_tcpip_cipstart_clean:
     } else if (ESP->ActiveCmd == CMD_TCPIP_CIPDOMAIN) {     /* Get IP address from domain name */
         __RST_EVENTS_RESP(ESP);                             /* Reset all events */
         UART_SEND_STR(FROMMEM("AT+CIPDOMAIN=\""));          /* Send data */
-        UART_SEND_STR(FROMMEM(Pointers.CPtr1));
+        UART_SEND_STR(FROMMEM(ESP->Pointers.CPtr1));
         UART_SEND_STR(FROMMEM("\""));
         UART_SEND_STR(_CRLF);
         StartCommand(ESP, CMD_TCPIP_CIPDOMAIN, NULL);       /* Start command */
@@ -2211,27 +3310,104 @@ cmd_tcpip_cipstart_clean:
     PT_END(pt);
 }
 
-/* Process all thread calls */
-ESP_Result_t ProcessThreads(evol ESP_t* ESP) {
+/* Run threads for active command */
+estatic
+void RunThreads(evol ESP_t* ESP) {
     if (CMD_IS_ACTIVE_BASIC(ESP)) {                         /* General related commands */
-        PT_Thread_BASIC(&pt_BASIC, ESP);                       
+        PT_Thread_BASIC((struct pt *)&ESP->PT_BASIC, ESP);                       
     }
     if (CMD_IS_ACTIVE_WIFI(ESP)) {                          /* General related commands */
-        PT_Thread_WIFI(&pt_WIFI, ESP);                       
+        PT_Thread_WIFI((struct pt *)&ESP->PT_WIFI, ESP);                       
     }
     if (CMD_IS_ACTIVE_TCPIP(ESP)) {                         /* On active PIN related command */
-        PT_Thread_TCPIP(&pt_TCPIP, ESP);
+        PT_Thread_TCPIP((struct pt *)&ESP->PT_TCPIP, ESP);
+    }
+}
+
+/* Process all thread calls */
+ESP_Result_t ProcessThreads(evol ESP_t* ESP) {
+    RunThreads(ESP);                                        /* Process active command */
+#if ESP_CMD_QUEUE_SIZE
+    if (CommandQueueDispatch(ESP)) {                        /* Start next command as soon as previous finished */
+        RunThreads(ESP);
     }
+#endif                                                      /* ESP_CMD_QUEUE_SIZE */
 #if !ESP_RTOS && !ESP_ASYNC
     ESP_ProcessCallbacks(ESP);                              /* Process callbacks when not in RTOS or ASYNC mode */
 #endif
     __RETURN(ESP, espOK);
 }
 
+#if ESP_AUTOBAUD
+/* Checks link at current baudrate with burst of AT commands, fails on missing response or invalid characters */
+static
+ESP_Result_t __CheckBaudrate(evol ESP_t* ESP) {
+    uint32_t garbage = ESP->UARTGarbage;
+    uint8_t i;
+    
+    for (i = 0; i < ESP_AUTOBAUD_CHECKS; i++) {
+        __ACTIVE_CMD(ESP, CMD_BASIC_AT);                    /* Check AT response */
+        ESP_WaitReady(ESP, ESP->ActiveCmdTimeout);
+        __IDLE(ESP);
+        if (ESP->ActiveResult != espOK) {
+            return espERROR;
+        }
+    }
+    return ESP->UARTGarbage - garbage > ESP_AUTOBAUD_GARBAGE ? espERROR : espOK;
+}
+
+/* Raises baudrate through configured list and keeps the highest one which passes link check */
+static
+void __InitBaudrate(evol ESP_t* ESP) {
+    static const uint32_t rates[] = { ESP_AUTOBAUD_LIST };
+    uint32_t good = ESP->LL.Baudrate;
+    uint8_t i;
+    
+    for (i = 0; i < sizeof(rates) / sizeof(rates[0]); i++) {
+        if (rates[i] <= good) {                             /* Only go up */
+            continue;
+        }
+        ESP->Pointers.CPtr1 = FROMMEM("CUR");               /* Do not save baudrate to module flash */
+        ESP->Pointers.UI = rates[i];
+        __ACTIVE_CMD(ESP, CMD_BASIC_UART);                  /* Set new baudrate */
+        ESP_WaitReady(ESP, ESP->ActiveCmdTimeout);
+        __IDLE(ESP);
+        if (ESP->ActiveResult != espOK) {                   /* Baudrate not accepted, module still uses previous one */
+            break;
+        }
+        if (__CheckBaudrate(ESP) == espOK) {
+            good = rates[i];                                /* Link is good, try next one */
+            continue;
+        }
+        
+        /* Link is not reliable, go back to last good baudrate */
+        ESP->Pointers.CPtr1 = FROMMEM("CUR");
+        ESP->Pointers.UI = good;
+        __ACTIVE_CMD(ESP, CMD_BASIC_UART);
+        ESP_WaitReady(ESP, ESP->ActiveCmdTimeout);
+        __IDLE(ESP);
+        SetBaudrate(ESP, good);                             /* Response may be lost, set it anyway */
+        if (__CheckBaudrate(ESP) != espOK) {                /* Module did not get command, reset sets it back to default baudrate */
+            SetBaudrate(ESP, ESP->InitBaudrate);
+            ESP->ActiveCmdTimeout = 5000;
+            __ACTIVE_CMD(ESP, CMD_BASIC_RST);               /* Reset device */
+            ESP_WaitReady(ESP, ESP->ActiveCmdTimeout);
+            __IDLE(ESP);
+            ESP->ActiveCmdTimeout = 100;
+        }
+        break;
+    }
+}
+#endif                                                      /* ESP_AUTOBAUD */
+
 /* Initialize necessary parts */
 static
 ESP_Result_t __Init(evol ESP_t* ESP) {
     size_t i;
+    ESP_InitCache_t* cache = ESP->InitCache;
+    uint8_t cached = cache && cache->Magic == ESP_INIT_CACHE_MAGIC; /* Check if module informations are known from previous session */
+    uint32_t start = ESP->Time, t = ESP->Time;
+    
     /* Reset protothreads */
     __RESET_THREADS(ESP);
     
@@ -2240,6 +3416,11 @@ ESP_Result_t __Init(evol ESP_t* ESP) {
     
     /* Send initialization commands */
     ESP->Flags.F.IsBlocking = 1;                            /* Process blocking calls */
+#if ESP_AUTOBAUD
+    if (ESP->LL.Baudrate != ESP->InitBaudrate) {            /* Module uses initial baudrate again after reset */
+        SetBaudrate(ESP, ESP->InitBaudrate);
+    }
+#endif                                                      /* ESP_AUTOBAUD */
     ESP->ActiveCmdTimeout = 5000;                           /* Set response timeout */
     i = 50;
     while (i) {
@@ -2251,6 +3432,8 @@ ESP_Result_t __Init(evol ESP_t* ESP) {
         }
         i--;
     }
+    ESP->InitTimes.Reset = ESP->Time - t;                   /* Save reset phase time */
+    t = ESP->Time;
     ESP->ActiveCmdTimeout = 100;                            /* Set response timeout */
     while (i) {
         __ACTIVE_CMD(ESP, CMD_BASIC_AT);                    /* Check AT response */
@@ -2261,8 +3444,13 @@ ESP_Result_t __Init(evol ESP_t* ESP) {
         }
         i--;
     }
+#if ESP_AUTOBAUD
+    if (i) {
+        __InitBaudrate(ESP);                                /* Go to highest reliable baudrate */
+    }
+#endif                                                      /* ESP_AUTOBAUD */
     while (i) {
-        Pointers.UI = ESP_ECHO ? 1 : 0;
+        ESP->Pointers.UI = ESP_ECHO ? 1 : 0;
         __ACTIVE_CMD(ESP, CMD_BASIC_ATE);                    /* Check ATE response */
         ESP_WaitReady(ESP, ESP->ActiveCmdTimeout);
         __IDLE(ESP);
@@ -2271,7 +3459,7 @@ ESP_Result_t __Init(evol ESP_t* ESP) {
         }
         i--;
     }
-    while (i) {
+    while (i && !cached) {
         __ACTIVE_CMD(ESP, CMD_BASIC_GMR);                   /* Check AT software */
         ESP_WaitReady(ESP, ESP->ActiveCmdTimeout);
         __IDLE(ESP);
@@ -2282,8 +3470,8 @@ ESP_Result_t __Init(evol ESP_t* ESP) {
     }
 #if ESP_USE_CTS
     while (i) {
-        Pointers.CPtr1 = FROMMEM("CUR");
-        Pointers.UI = baudrate;
+        ESP->Pointers.CPtr1 = FROMMEM("CUR");
+        ESP->Pointers.UI = ESP->LL.Baudrate;                /* Keep baudrate, enable flow control */
         __ACTIVE_CMD(ESP, CMD_BASIC_UART);                  /* Check AT response */
         ESP_WaitReady(ESP, ESP->ActiveCmdTimeout);
         __IDLE(ESP);
@@ -2294,8 +3482,8 @@ ESP_Result_t __Init(evol ESP_t* ESP) {
     }
 #endif /* ESP_USE_CTS */
     while (i) {
-        Pointers.CPtr1 = FROMMEM("CUR");
-        Pointers.UI = 3;
+        ESP->Pointers.CPtr1 = FROMMEM("CUR");
+        ESP->Pointers.UI = 3;
         __ACTIVE_CMD(ESP, CMD_WIFI_CWMODE);                 /* Set device mode */
         ESP_WaitReady(ESP, ESP->ActiveCmdTimeout);
         __IDLE(ESP);
@@ -2305,7 +3493,7 @@ ESP_Result_t __Init(evol ESP_t* ESP) {
         i--;
     }
     while (i) {
-        Pointers.UI = !ESP_SINGLE_CONN && 1;                /* Set up for single connection mode */
+        ESP->Pointers.UI = !ESP_SINGLE_CONN && 1;           /* Set up for single connection mode */
         __ACTIVE_CMD(ESP, CMD_TCPIP_CIPMUX);                /* Set device mux */
         ESP_WaitReady(ESP, ESP->ActiveCmdTimeout);
         __IDLE(ESP);
@@ -2315,7 +3503,7 @@ ESP_Result_t __Init(evol ESP_t* ESP) {
         i--;
     }
     while (i) {
-        Pointers.UI = !ESP_SINGLE_CONN && 1;                /* In single connection mode, we don't need informations on IPD data = CLIENT ONLY */
+        ESP->Pointers.UI = !ESP_SINGLE_CONN && 1;           /* In single connection mode, we don't need informations on IPD data = CLIENT ONLY */
         __ACTIVE_CMD(ESP, CMD_TCPIP_CIPDINFO);              /* Enable informations about connection on +IPD statement */
         ESP_WaitReady(ESP, ESP->ActiveCmdTimeout);
         __IDLE(ESP);
@@ -2324,9 +3512,28 @@ ESP_Result_t __Init(evol ESP_t* ESP) {
         }
         i--;
     }
-    while (i) {
+    while (i) {
+        __ACTIVE_CMD(ESP, CMD_TCPIP_SERVERDISABLE);         /* Disable server */
+        ESP_WaitReady(ESP, ESP->ActiveCmdTimeout);
+        ESP->ActiveResult = espOK;
+        __IDLE(ESP);
+        break;                                              /* Ignore response */
+    }
+    ESP->InitTimes.Setup = ESP->Time - t;                   /* Save setup phase time */
+    t = ESP->Time;
+    
+    /* Read module informations, stable ones are taken from cache when available */
+    if (i && cached) {
+        memcpy((void *)ESP->STAMAC, cache->STAMAC, sizeof(ESP->STAMAC));
+        memcpy((void *)ESP->APMAC, cache->APMAC, sizeof(ESP->APMAC));
+        memcpy((void *)ESP->APIP, cache->APIP, sizeof(ESP->APIP));
+        memcpy((void *)ESP->APGateway, cache->APGateway, sizeof(ESP->APGateway));
+        memcpy((void *)ESP->APNetmask, cache->APNetmask, sizeof(ESP->APNetmask));
+        memcpy((void *)&ESP->APConf, &cache->APConf, sizeof(ESP->APConf));
+    }
+    while (i && !cached) {
         __ACTIVE_CMD(ESP, CMD_WIFI_GETSTAMAC);              /* Get station MAC address */
-        Pointers.UI = 1;
+        ESP->Pointers.UI = 1;
         ESP_WaitReady(ESP, ESP->ActiveCmdTimeout);
         __IDLE(ESP);
         if (ESP->ActiveResult == espOK) {
@@ -2334,9 +3541,9 @@ ESP_Result_t __Init(evol ESP_t* ESP) {
         }
         i--;
     }
-    while (i) {
+    while (i && !cached) {
         __ACTIVE_CMD(ESP, CMD_WIFI_GETAPMAC);               /* Get AP MAC address */
-        Pointers.UI = 1;
+        ESP->Pointers.UI = 1;
         ESP_WaitReady(ESP, ESP->ActiveCmdTimeout);
         __IDLE(ESP);
         if (ESP->ActiveResult == espOK) {
@@ -2346,7 +3553,7 @@ ESP_Result_t __Init(evol ESP_t* ESP) {
     }
     while (i) {
         __ACTIVE_CMD(ESP, CMD_WIFI_GETSTAIP);               /* Get station IP */
-        Pointers.UI = 1;
+        ESP->Pointers.UI = 1;
         ESP_WaitReady(ESP, ESP->ActiveCmdTimeout);
         __IDLE(ESP);
         if (ESP->ActiveResult == espOK) {
@@ -2354,9 +3561,9 @@ ESP_Result_t __Init(evol ESP_t* ESP) {
         }
         i--;
     }
-    while (i) {
+    while (i && !cached) {
         __ACTIVE_CMD(ESP, CMD_WIFI_GETAPIP);                /* Get AP IP */
-        Pointers.UI = 1;
+        ESP->Pointers.UI = 1;
         ESP_WaitReady(ESP, ESP->ActiveCmdTimeout);
         __IDLE(ESP);
         if (ESP->ActiveResult == espOK) {
@@ -2364,7 +3571,7 @@ ESP_Result_t __Init(evol ESP_t* ESP) {
         }
         i--;
     }
-    while (i) {
+    while (i && !cached) {
         __ACTIVE_CMD(ESP, CMD_WIFI_GETCWSAP);               /* Get AP settings */
         ESP_WaitReady(ESP, ESP->ActiveCmdTimeout);
         __IDLE(ESP);
@@ -2373,13 +3580,18 @@ ESP_Result_t __Init(evol ESP_t* ESP) {
         }
         i--;
     }
-    while (i) {
-        __ACTIVE_CMD(ESP, CMD_TCPIP_SERVERDISABLE);         /* Get AP settings */
-        ESP_WaitReady(ESP, ESP->ActiveCmdTimeout);
-        ESP->ActiveResult = espOK;
-        __IDLE(ESP);
-        break;                                              /* Ignore response */
+    if (i && cache && !cached) {                            /* Save informations for next initialization */
+        memcpy(cache->STAMAC, (const void *)ESP->STAMAC, sizeof(cache->STAMAC));
+        memcpy(cache->APMAC, (const void *)ESP->APMAC, sizeof(cache->APMAC));
+        memcpy(cache->APIP, (const void *)ESP->APIP, sizeof(cache->APIP));
+        memcpy(cache->APGateway, (const void *)ESP->APGateway, sizeof(cache->APGateway));
+        memcpy(cache->APNetmask, (const void *)ESP->APNetmask, sizeof(cache->APNetmask));
+        memcpy(&cache->APConf, (const void *)&ESP->APConf, sizeof(cache->APConf));
+        cache->Magic = ESP_INIT_CACHE_MAGIC;
     }
+    ESP->InitTimes.Query = ESP->Time - t;                   /* Save query phase time */
+    ESP->InitTimes.Total = ESP->Time - start;
+    ESP->InitTimes.Cached = cached;
     __IDLE(ESP);                                            /* Process IDLE */
     ESP->Flags.F.IsBlocking = 0;                            /* Reset blocking calls */
     ESP->Flags.F.Call_Idle = 0;
@@ -2393,10 +3605,15 @@ ESP_Result_t __Init(evol ESP_t* ESP) {
 /******************************************************************************/
 /******************************************************************************/
 ESP_Result_t ESP_Init(evol ESP_t* ESP, uint32_t baudrate, ESP_EventCallback_t callback) {
-    BUFFER_t* Buff = &Buffer;
+    return ESP_InitEx(ESP, baudrate, callback, NULL);       /* Initialize without cache */
+}
+
+ESP_Result_t ESP_InitEx(evol ESP_t* ESP, uint32_t baudrate, ESP_EventCallback_t callback, ESP_InitCache_t* cache) {
+    BUFFER_t* Buff = (BUFFER_t *)&ESP->Buffer;
     uint8_t result;
     
     memset((void *)ESP, 0x00, sizeof(ESP_t));               /* Clear structure first */
+    ESP->InitCache = cache;                                 /* Cache is used on each initialization */
     
     ESP->Callback = callback;                               /* Set event callback */
     if (callback == NULL) {
@@ -2407,17 +3624,52 @@ ESP_Result_t ESP_Init(evol ESP_t* ESP, uint32_t baudrate, ESP_EventCallback_t ca
     do {
         uint8_t i = 0;
         for (i = 0; i < ESP_MAX_CONNECTIONS; i++) {
-            ESP->Conn[i].Data = IPD_Data;
+            ESP->Conn[i].Data = (uint8_t *)ESP->IPDData;
         }
     } while (0);
 #endif /*!< ESP_CONN_SINGLEBUFFER */
+#if ESP_IPD_POOL_BLOCKS
+    do {
+        uint16_t i;
+        for (i = 0; i < ESP_IPD_POOL_BLOCKS; i++) {         /* Link all blocks to free list */
+            ESP->Pool[i].Next = i + 1 < ESP_IPD_POOL_BLOCKS ? (ESP_PBUF_t *)&ESP->Pool[i + 1] : NULL;
+        }
+        ESP->PoolFree = (ESP_PBUF_t *)&ESP->Pool[0];
+    } while (0);
+#endif                                                      /* ESP_IPD_POOL_BLOCKS */
+#if ESP_CONN_RX_SIZE
+    do {
+        uint8_t i;
+        for (i = 0; i < ESP_MAX_CONNECTIONS; i++) {         /* Allocate receive rings now, stack can not report failure later */
+            if (BUFFER_Init((BUFFER_t *)&ESP->ConnRx[i], ESP_CONN_RX_SIZE, NULL)) {
+                while (i--) {
+                    BUFFER_Free((BUFFER_t *)&ESP->ConnRx[i]);
+                }
+                __RETURN(ESP, espNOHEAP);
+            }
+        }
+    } while (0);
+#endif                                                      /* ESP_CONN_RX_SIZE */
     
     ESP->Time = 0;                                          /* Reset time start time */
-    BUFFER_Init(Buff, sizeof(Buffer_Data) - 1, Buffer_Data);    /* Init buffer for receive */
+    if (BUFFER_Init(Buff, sizeof(ESP->BufferData) - 1, (uint8_t *)ESP->BufferData)) {   /* Init buffer for receive */
+        __RETURN(ESP, espERROR);
+    }
+#if ESP_SINGLE_CONN && ESP_TRANSFER_TX_SIZE
+    if (BUFFER_Init((BUFFER_t *)&ESP->TransferTx, sizeof(ESP->TransferTxData) - 1, (uint8_t *)ESP->TransferTxData)) {   /* Init transparent mode transmit ring */
+        __RETURN(ESP, espERROR);
+    }
+#endif                                                      /* ESP_SINGLE_CONN && ESP_TRANSFER_TX_SIZE */
+    if (_ESP == NULL) {
+        _ESP = ESP;                                         /* Set first instance as default one */
+    }
     
     /* Low-Level initialization */
     result = 1;                                             /* Set to default value first */
     ESP->LL.Baudrate = baudrate;
+#if ESP_AUTOBAUD
+    ESP->InitBaudrate = baudrate;                           /* Save baudrate module uses after reset */
+#endif                                                      /* ESP_AUTOBAUD */
     if (!ESP_LL_Callback(ESP_LL_Control_Init, (void *)&ESP->LL, &result) || result) {   /* Init low-level */
         __RETURN(ESP, espLLERROR);                          /* Return error */
     }
@@ -2441,182 +3693,279 @@ ESP_Result_t ESP_ReInit(evol ESP_t* ESP) {
 }
 
 ESP_Result_t ESP_DeInit(evol ESP_t* ESP) {
-    BUFFER_Free(&Buffer);                                   /* Clear USART buffer */
+    BUFFER_Free((BUFFER_t *)&ESP->Buffer);                  /* Clear USART buffer */
+    if (_ESP == ESP) {
+        _ESP = NULL;                                        /* Default instance is not valid anymore */
+    }
     
     __RETURN(ESP, espOK);                                   /* Return OK from function */
 }
 
 ESP_Result_t ESP_Update(evol ESP_t* ESP) {
     char ch;
-    static char prev1_ch = 0x00, prev2_ch = 0x00;
-    BUFFER_t* Buff = &Buffer;
+    BUFFER_t* Buff = (BUFFER_t *)&ESP->Buffer;
+    const uint8_t* data;
+    uint32_t len, i, count;
     uint16_t processedCount = 500;
     
+    if (ESP->EventDataPending) {                            /* Data events waiting for free entry in queue */
+        EventFlushData(ESP);
+    }
+    if (__RX_STALLED(ESP)) {                                /* Response may wait behind data user did not read yet */
+        if (ESP->Flags.F.RxStalled) {
+            ESP->ActiveCmdStart += ESP->Time - ESP->RxStallTime;    /* Stall does not count to command timeout */
+        }
+        ESP->Flags.F.RxStalled = 1;
+        ESP->RxStallTime = ESP->Time;
+    } else {
+        ESP->Flags.F.RxStalled = 0;
+    }
     if (ESP->ActiveCmd != CMD_IDLE && ESP->Time - ESP->ActiveCmdStart > ESP->ActiveCmdTimeout) {
         ESP->Events.F.RespError = 1;                        /* Set active error and process */
+#if ESP_STATS
+        if (ESP->StatsCmd != CMD_IDLE) {
+            ESP->Stats.Timeouts++;                          /* Command did not respond */
+            StatsCommandDone(ESP, 1);
+        }
+#endif                                                      /* ESP_STATS */
     }
     
-    while (
-#if !ESP_RTOS && ESP_ASYNC
-        processedCount-- &&
+    while (processedCount && (len = BUFFER_GetLinearBlockReadLength(Buff)) > 0) {   /* Get linear block of received data */
+        data = BUFFER_GetLinearBlockReadAddress(Buff);      /* Process data directly from buffer memory */
+        for (i = 0; i < len; ) {                            /* Process entire linear block */
+            if (ESP->IPD.InIPD && ESP->IPD.BytesRemaining) {/* Read network data */
+#if ESP_CONN_RX_SIZE || ESP_IPD_POOL_BLOCKS
+                count = ConnReceived(ESP, &data[i], len - i);   /* Copy data to connection receive ring or pool blocks */
+                if (!count) {                               /* Ring is full, keep data in buffer until user reads ring */
+                    break;
+                }
+                i += count;
+                ESP->Prev2Ch = count > 1 ? (char)data[i - 2] : ESP->Prev1Ch;    /* Save previous characters */
+                ESP->Prev1Ch = (char)data[i - 1];
 #else
-        processedCount-- &&
-#endif /* !ESP_RTOS && ESP_ASYNC */
-        BUFFER_Read(Buff, (uint8_t *)&ch, 1)                /* Read single character from buffer */
-    ) {
-        ESP_SET_RTS(ESP, ESP_RTS_CLR);                      /* Clear RTS pin */
-        if (ESP->IPD.InIPD && ESP->IPD.BytesRemaining) {    /* Read network data */
-            if (ESP->ActiveCmd == CMD_IDLE) {
-                __ACTIVE_CMD(ESP, CMD_TCPIP_IPD);           /* Set active command! */
-                ESP->Flags.F.IsBlocking = 1;                /* Set as it was blocking call */
-            }
-            ESP->IPD.Conn->Data[ESP->IPD.BytesRead] = ch;   /* Add character to receive buffer */
-            ESP->IPD.BytesRead++;                           /* Increase number of bytes read in this packet */
-            ESP->IPD.BytesRemaining--;                      /* Decrease number of bytes remaining to read in entire IPD packet */
-            __CONN_UPDATE_TIME(ESP, ESP->IPD.Conn);         /* Update connection access time */
-            
-            if (!ESP->IPD.BytesRemaining) {                 /* We read all the data? */
-                ESP->IPD.InIPD = 0;
-                if (ESP->ActiveCmd == CMD_TCPIP_IPD) {      /* If we set as TCPIP then release it */
-                    __IDLE(ESP);                            /* Go to IDLE mode */
+                if (ESP->ActiveCmd == CMD_IDLE) {
+                    __ACTIVE_CMD(ESP, CMD_TCPIP_IPD);       /* Set active command! */
+                    ESP->Flags.F.IsBlocking = 1;            /* Set as it was blocking call */
                 }
-            }
-            if (ESP->IPD.BytesRead >= (ESP_CONNBUFFER_SIZE - 1) || !ESP->IPD.BytesRemaining) { /* Receive buffer full or we read all the data? */
-                ESP->CallbackParams.CP1 = ESP->IPD.Conn;
-                ESP->CallbackParams.CP2 = ESP->IPD.Conn->Data;
-                ESP->IPD.Conn->DataLength = ESP->IPD.BytesRead;
-                ESP->CallbackParams.UI = ESP->IPD.BytesRead;
-                if (ESP->IPD.BytesRemaining
+                if (!ESP->IPD.BytesRead && ESP->IPD.Conn->Callback.F.CallLastPartOfPacketReceived) {    /* Previous packet waits for callback */
+                    ESP->IPD.Conn->Callback.F.CallLastPartOfPacketReceived = 0; /* Queued event is skipped */
+                    ESP->CallbackParams.CP1 = ESP->IPD.Conn;
+                    ESP->CallbackParams.CP2 = ESP->IPD.Conn->Data;
+                    ESP->CallbackParams.UI = ESP->IPD.Conn->DataLength;
+                    ESP->CallbackParams.Time = ESP->Time;
+                    ESP_CALL_CALLBACK(ESP, espEventDataReceived);   /* Report it before data are overwritten */
+                }
+                count = len - i;                            /* Get number of bytes we can copy at a time */
+                if (count > ESP->IPD.BytesRemaining) {      /* Do not read more than remaining in IPD packet */
+                    count = ESP->IPD.BytesRemaining;
+                }
+                if (count > (uint32_t)(ESP_CONNBUFFER_SIZE - 1) - ESP->IPD.BytesRead) { /* Do not read more than we have memory in receive buffer */
+                    count = (uint32_t)(ESP_CONNBUFFER_SIZE - 1) - ESP->IPD.BytesRead;
+                }
+                memcpy((void *)&ESP->IPD.Conn->Data[ESP->IPD.BytesRead], &data[i], count); /* Copy block of data to receive buffer */
+                ESP->IPD.BytesRead += count;                /* Increase number of bytes read in this packet */
+                ESP->IPD.BytesRemaining -= count;           /* Decrease number of bytes remaining to read in entire IPD packet */
+                i += count;
+                ESP->Prev2Ch = count > 1 ? (char)data[i - 2] : ESP->Prev1Ch;    /* Save previous characters */
+                ESP->Prev1Ch = (char)data[i - 1];
+                __CONN_UPDATE_TIME(ESP, ESP->IPD.Conn);     /* Update connection access time */
+                
+                if (!ESP->IPD.BytesRemaining) {             /* We read all the data? */
+                    ESP->IPD.InIPD = 0;
+                    if (ESP->ActiveCmd == CMD_TCPIP_IPD) {  /* If we set as TCPIP then release it */
+                        __IDLE(ESP);                        /* Go to IDLE mode */
+                    }
+                }
+                if (ESP->IPD.BytesRead >= (ESP_CONNBUFFER_SIZE - 1) || !ESP->IPD.BytesRemaining) { /* Receive buffer full or we read all the data? */
+                    ESP->CallbackParams.CP1 = ESP->IPD.Conn;
+                    ESP->CallbackParams.CP2 = ESP->IPD.Conn->Data;
+                    ESP->IPD.Conn->DataLength = ESP->IPD.BytesRead;
+                    ESP->CallbackParams.UI = ESP->IPD.BytesRead;
+                    if (ESP->IPD.BytesRemaining
 #if ESP_CONN_SINGLEBUFFER
-                    || (!ESP->IPD.BytesRemaining && ESP->ActiveCmd == CMD_IDLE) /*!< Do this only if low of RAM (Do not USE RTOS in this mode) */
+                        || (!ESP->IPD.BytesRemaining && ESP->ActiveCmd == CMD_IDLE) /*!< Do this only if low of RAM (Do not USE RTOS in this mode) */
 #endif /* ESP_CONN_SINGLEBUFFER */
-                ) {
-                    ESP_CALL_CALLBACK(ESP, espEventDataReceived);   /* Process callback */
-                    ESP->IPD.Conn->Callback.F.CallLastPartOfPacketReceived = 0;
-                } else {
-                    ESP->IPD.Conn->Callback.F.CallLastPartOfPacketReceived = 1;
+                    ) {
+                        ESP->CallbackParams.Time = ESP->Time;
+                        ESP_CALL_CALLBACK(ESP, espEventDataReceived);   /* Process callback */
+                        ESP->IPD.Conn->Callback.F.CallLastPartOfPacketReceived = 0;
+                    } else {
+                        ESP->IPD.Conn->Callback.F.CallLastPartOfPacketReceived = 1; /* Connection data are kept until callback */
+                        EventAdd(ESP, espEventDataReceived, ESP->IPD.Conn, 0);
+                    }
+                    ESP->IPD.BytesRead = 0;                 /* Reset buffer and prepare for new packet */
                 }
-                ESP->IPD.BytesRead = 0;                     /* Reset buffer and prepare for new packet */
-            }
+#endif                                                      /* ESP_CONN_RX_SIZE || ESP_IPD_POOL_BLOCKS */
 #if ESP_SINGLE_CONN
-        } else if (ESP->TransferMode == ESP_TransferMode_Transparent && ESP->Flags.F.InTransparentMode) {
-            RECEIVED_ADD(ch);                               /* Add character to received data */
-            if (RECEIVED_LENGTH() >= 8) {                   /* If greater than 8 for some reason */
-                while (RECEIVED_LENGTH() > 8) {             /* Shift it up to 8 bytes long */
-                    RECEIVED_SHIFT();
-                }
-                if (Received.Data[0] == 'C' && strncmp((const char *)Received.Data, FROMMEM("CLOSED\r\n"), 8) == 0) {
-                    ESP->Flags.F.InTransparentMode = 0;     /* Not in transparent mode anymore */
-                    __CONN_RESET(&ESP->Conn[0]);            /* Reset connection */
-                    ESP->Conn[0].Callback.F.Closed = 1;     /* Set callback for connection */
+            } else if (ESP->TransferMode == ESP_TransferMode_Transparent && ESP->Flags.F.InTransparentMode) {
+                count = TransparentReceived(ESP, &data[i], len - i);    /* Process span of transparent data at once */
+                i += count;
+                ESP->Prev2Ch = count > 1 ? (char)data[i - 2] : ESP->Prev1Ch;    /* Save previous characters */
+                ESP->Prev1Ch = (char)data[i - 1];
+#endif                                                      /* ESP_SINGLE_CONN */
+            } else {
+                if (!processedCount) {                      /* Limit number of processed characters outside IPD data */
+                    break;
                 }
-            }
-            if (ESP->ActiveCmd == CMD_IDLE) {
-                ESP->CallbackParams.CP1 = (const void *)&ESP->Conn[0];
-                ESP->CallbackParams.CP2 = (const void *)&ch;
-                ESP->CallbackParams.UI = 1;
-                ESP_CALL_CALLBACK(ESP, espEventTransparentReceived);
-            }
-#endif /* ESP_SINGLE_CONN */
-        } else {
-            if (ISVALIDASCII(ch)) { /* Handle transparent mode receive data */
-                switch (ch) {
-                    case '\n':
-                        RECEIVED_ADD(ch);                   /* Add character */
-                        ParseReceived(ESP, &Received);      /* Parse received string */
-                        RECEIVED_RESET();
-                        break;
-                    default: 
-                        if ((ch == ' ' && prev1_ch == '>' && prev2_ch == '\n')
+                processedCount--;
+                ch = (char)data[i++];                       /* Get character from linear block */
+                if (ISVALIDASCII(ch)) {                     /* Handle transparent mode receive data */
+                    switch (ch) {
+                        case '\n':
+                            if (ESP->Tokenizer.Type) {      /* Response was processed while receiving */
+                                TokenizerEnd(ESP);
+                            } else {
+                                RECEIVED_ADD(ch);           /* Add character */
+                                ParseReceived(ESP, (ESP_Received_t *)&ESP->Received);   /* Parse received string */
+                            }
+                            RECEIVED_RESET();
+                            break;
+                        default: 
+                            if ((ch == ' ' && ESP->Prev1Ch == '>' && ESP->Prev2Ch == '\n')
 #if ESP_SINGLE_CONN                        
-                            || (ESP->TransferMode == ESP_TransferMode_Transparent && ch == '>' && prev1_ch == '\n')
-#endif /* ESP_SINGLE_CONN */
-                        ) {   /* Check if bracket received */
-                            ESP->Events.F.RespBracket = 1;  /* We receive bracket on command */
-                        } else {
-                            RECEIVED_ADD(ch);               /* Add character to buffer */
-                            
-                            /*!< Check IPD statement */
-                            if (ch == ':' && RECEIVED_LENGTH() > 4) {   /* Maybe +IPD was received* */
-                                if (Received.Data[0] == '+' && strncmp(FROMMEM(Received.Data), FROMMEM("+IPD"), 4) == 0) {  /* Check for IPD statement */
-                                    ParseReceived(ESP, &Received);  /* Process parsing received data */
-                                    RECEIVED_RESET();       /* Reset received object! */
+                                || (ESP->TransferMode == ESP_TransferMode_Transparent && ch == '>' && ESP->Prev1Ch == '\n')
+#endif                                                      /* ESP_SINGLE_CONN */
+                            ) {   /* Check if bracket received */
+                                ESP->Events.F.RespBracket = 1;  /* We receive bracket on command */
+                            } else if (ESP->Tokenizer.Type) {   /* Response is processed while receiving */
+                                TokenizerProcess(ESP, ch);  /* Process character without line buffer */
+                            } else {
+                                RECEIVED_ADD(ch);           /* Add character to buffer */
+                                
+                                /*!< Check IPD statement */
+                                if (ch == ':' && RECEIVED_LENGTH() > 4 && ESP->Received.Data[0] == '+') {   /* Maybe +IPD or streamed response was received */
+                                    if (strncmp(FROMMEM(ESP->Received.Data), FROMMEM("+IPD"), 4) == 0) {    /* Check for IPD statement */
+                                        ParseReceived(ESP, (ESP_Received_t *)&ESP->Received);   /* Process parsing received data */
+                                        RECEIVED_RESET();   /* Reset received object! */
+                                    } else {
+                                        TokenizerStart(ESP, (const char *)ESP->Received.Data, RECEIVED_LENGTH());   /* Check for response processed while receiving */
+                                    }
                                 }
                             }
-                        }
-                        break;
-                } 
-            } else {
-                RECEIVED_RESET();                           /* Reset invalid received character */
+                            break;
+                    } 
+                } else {
+                    RECEIVED_RESET();                       /* Reset invalid received character */
+                    ESP->Tokenizer.Type = 0;
+                    ESP->UARTGarbage++;                     /* Count invalid characters for link quality check */
+                    __STATS_INC(ESP, Garbage);
+                }
+                ESP->Prev2Ch = ESP->Prev1Ch;                /* Save previous character to prevprev character */
+                ESP->Prev1Ch = ch;                          /* Save current character as previous */
+            }
+            if (ESP->IPD.Conn && ESP->IPD.Conn->Callback.F.CallLastPartOfPacketReceived) {
+                break;
             }
         }
-        prev2_ch = prev1_ch;                                /* Save previous character to prevprev character */
-        prev1_ch = ch;                                      /* Save current character as previous */
-        if (ESP->IPD.Conn && ESP->IPD.Conn->Callback.F.CallLastPartOfPacketReceived) {
+        BUFFER_Skip(Buff, i);                               /* Remove processed data from buffer */
+        if (i) {
+            ESP_SET_RTS(ESP, ESP_RTS_CLR);                  /* Clear RTS pin, there is free memory in buffer */
+        }
+        if (i < len) {                                      /* Processing stopped before end of block? */
             break;
         }
     }
     
+#if ESP_SINGLE_CONN && ESP_TRANSFER_TX_SIZE
+    if (ESP->Flags.F.InTransparentMode && ESP->ActiveCmd == CMD_IDLE) {
+        TransferFlush(ESP, 0);                              /* Send data from transmit ring */
+    }
+#endif                                                      /* ESP_SINGLE_CONN && ESP_TRANSFER_TX_SIZE */
     return ProcessThreads(ESP);                             /* Process stack */
 }
 
+ESP_Result_t ESP_UpdateWait(evol ESP_t* ESP, uint32_t timeout) {
+#if ESP_RTOS
+    if (!BUFFER_GetFull((BUFFER_t *)&ESP->Buffer) || __RX_STALLED(ESP)) {   /* Nothing received yet or waiting for user to read ring */
+        if (!__SYS_WAIT(ESP, ESP_SYS_EVENT_UPDATE, timeout)) {  /* Sleep until data received, command set or timeout */
+            ESP_RTOS_YIELD();                               /* Waiting is not supported by low-level */
+        }
+    }
+#else
+    (void)timeout;                                          /* Prevent compiler warnings */
+#endif                                                      /* ESP_RTOS */
+    return ESP_Update(ESP);                                 /* Process stack */
+}
+
 ESP_Result_t ESP_ProcessCallbacks(evol ESP_t* ESP) {
     uint8_t i = 0;
+    uint32_t in;
+    ESP_Request_t* req;
+    
+    /* Process finished requests */
+    BUFFER_LOAD_ACQUIRE(in, ESP->DoneIn);                   /* Results before input index are valid */
+    while (ESP->DoneOut != in) {
+        req = ESP->Requests[ESP->DoneQueue[ESP->DoneOut % ESP_REQUEST_COUNT] - __REQUEST_ID(0)];
+        BUFFER_STORE_RELEASE(ESP->DoneOut, __QUEUE_NEXT(ESP->DoneOut, ESP_REQUEST_COUNT));  /* Remove request from queue */
+        req->Done = 1;                                      /* Request may be used again from now on */
+        if (req->Cb) {
+            req->Cb(req);                                   /* Notify user about finished command */
+        }
+    }
+    
     /* Process callbacks */
     if (ESP->ActiveCmd == CMD_IDLE && ESP->Flags.F.Call_Idle) { /* Process IDLE call */
         ESP->Flags.F.Call_Idle = 0;
+        ESP->CallbackParams.Time = ESP->Time;
         ESP_CALL_CALLBACK(ESP, espEventIdle);
     }
-    if (ESP->ActiveCmd == CMD_IDLE && ESP->CallbackFlags.F.WifiConnected) { /* Wifi just connected */
-        ESP->CallbackFlags.F.WifiConnected = 0;
-        ESP_CALL_CALLBACK(ESP, espEventWifiConnected);
-    }
-    if (ESP->ActiveCmd == CMD_IDLE && ESP->CallbackFlags.F.WifiDisconnected) {  /* Wifi just connected */
-        ESP->CallbackFlags.F.WifiDisconnected = 0;
-        ESP_CALL_CALLBACK(ESP, espEventWifiDisconnected);
+    while (__IS_READY(ESP)) {                               /* Process events in order they happened */
+        ESP_EventEntry_t ev, *e = &ev;
+        
+        BUFFER_LOAD_ACQUIRE(in, ESP->EventIn);              /* Entries before input index are valid */
+        if (in == ESP->EventOut) {                          /* No more events */
+            break;
+        }
+        memcpy(e, (const void *)&ESP->EventQueue[ESP->EventOut % ESP_EVENT_QUEUE_SIZE], sizeof(ev));    /* Entry may be reused after output index moves */
+        memset((void *)&ESP->CallbackParams, 0x00, sizeof(ESP->CallbackParams));
+        ESP->CallbackParams.Time = e->Time;
+        if (e->Conn == ESP_EVENT_NO_CONN) {                 /* Global event */
+            BUFFER_STORE_RELEASE(ESP->EventOut, __QUEUE_NEXT(ESP->EventOut, ESP_EVENT_QUEUE_SIZE));
+            ESP_CALL_CALLBACK(ESP, (ESP_Event_t)e->Event);
+        } else {
+            ESP_CONN_t* c = (ESP_CONN_t *)&ESP->Conn[e->Conn];
+            
+            if (!c->Cb) {
+                c->Cb = ESP->Callback;                      /* Check if callback is set */
+            }
+            ESP->CallbackParams.CP1 = c;
+            ESP->CallbackParams.UI = e->Value;
+#if ESP_IPD_POOL_BLOCKS
+            if (e->Event == espEventDataReceived) {         /* Pass received blocks to user */
+                ESP->CallbackParams.CP2 = PbufTake(ESP, c->Number, (uint32_t *)&ESP->CallbackParams.UI);
+            }
+#elif !ESP_CONN_RX_SIZE
+            if (e->Event == espEventDataReceived) {         /* Notify user about last packet */
+                ESP->CallbackParams.CP2 = c->Data;
+                ESP->CallbackParams.UI = c->Callback.F.CallLastPartOfPacketReceived ? c->DataLength : 0;
+                c->Callback.F.CallLastPartOfPacketReceived = 0;
+            }
+#endif                                                      /* ESP_IPD_POOL_BLOCKS */
+            BUFFER_STORE_RELEASE(ESP->EventOut, __QUEUE_NEXT(ESP->EventOut, ESP_EVENT_QUEUE_SIZE));
+#if ESP_IPD_POOL_BLOCKS
+            if (e->Event == espEventDataReceived && !ESP->CallbackParams.CP2) {
+                continue;                                   /* Data were already passed with previous event */
+            }
+#elif !ESP_CONN_RX_SIZE
+            if (e->Event == espEventDataReceived && !ESP->CallbackParams.UI) {
+                continue;                                   /* Data were already passed when next packet arrived */
+            }
+#endif                                                      /* ESP_IPD_POOL_BLOCKS */
+            ESP_CALL_CONN_CALLBACK(ESP, c, (ESP_Event_t)e->Event);
+        }
     }
-    if (ESP->ActiveCmd == CMD_IDLE && ESP->CallbackFlags.F.WifiGotIP) { /* Wifi just connected */
-        ESP->CallbackFlags.F.WifiGotIP = 0;
-        ESP_CALL_CALLBACK(ESP, espEventWifiGotIP);
+    if (ESP->EventDataPending) {                            /* Data event waits for entries we freed */
+        __SYS_SIGNAL(ESP, ESP_SYS_EVENT_UPDATE);
     }
     
+    /* Poll active connections */
     for (i = 0; i < sizeof(ESP->Conn) / sizeof(ESP->Conn[0]); i++) {
         ESP_CONN_t* c = (ESP_CONN_t *)&ESP->Conn[i];
         
-        if (!c->Cb) {
-            c->Cb = ESP->Callback;                          /* Check if callback is set */
-        }
-        
-        /* Maybe move this part directly to __IDLE() command */
-        /* More test required first to see usability of this */
-        if (__IS_READY(ESP) && c->Callback.F.CallLastPartOfPacketReceived) {    /* Notify user about last packet */
-            c->Callback.F.CallLastPartOfPacketReceived = 0;
-            ESP->CallbackParams.CP1 = c;
-            ESP->CallbackParams.CP2 = c->Data;
-            ESP->CallbackParams.UI = c->DataLength;
-            ESP_CALL_CONN_CALLBACK(ESP, c, espEventDataReceived);
-        }
-        if (__IS_READY(ESP) && c->Callback.F.DataSent) {    /* Data sent ok */
-            c->Callback.F.DataSent = 0;
-            ESP->CallbackParams.CP1 = c;
-            ESP_CALL_CONN_CALLBACK(ESP, c, espEventDataSent);
-        }
-        if (__IS_READY(ESP) && c->Callback.F.DataError) {   /* Data sent error */
-            c->Callback.F.DataError = 0;
-            ESP->CallbackParams.CP1 = c;
-            ESP_CALL_CONN_CALLBACK(ESP, c, espEventDataSentError);
-        }
-        if (__IS_READY(ESP) && c->Callback.F.Connect) {     /* Connection just active */
-            c->Callback.F.Connect = 0;
-            ESP->CallbackParams.CP1 = c;
-            ESP_CALL_CONN_CALLBACK(ESP, c, espEventConnActive); 
-        }
-        if (__IS_READY(ESP) && c->Callback.F.Closed) {      /* Connection just closed */
-            c->Callback.F.Closed = 0;
-            ESP->CallbackParams.CP1 = c;
-            ESP_CALL_CONN_CALLBACK(ESP, c, espEventConnClosed); 
-        }
         if (__IS_READY(ESP) && c->Flags.F.Active) {
+            if (!c->Cb) {
+                c->Cb = ESP->Callback;                      /* Check if callback is set */
+            }
             if (c->PollTime == 0 || c->PollTimeInterval == 0) {
                 c->PollTimeInterval = 1000;
                 c->PollTime = ESP->Time + c->PollTimeInterval;
@@ -2624,6 +3973,7 @@ ESP_Result_t ESP_ProcessCallbacks(evol ESP_t* ESP) {
             if (ESP->Time > c->PollTime) {
                 c->PollTime += c->PollTimeInterval;
                 ESP->CallbackParams.CP1 = c;
+                ESP->CallbackParams.Time = ESP->Time;
                 ESP_CALL_CONN_CALLBACK(ESP, c, espEventConnPoll); 
             }
         }
@@ -2635,6 +3985,108 @@ void ESP_UpdateTime(evol ESP_t* ESP, uint32_t time_increase) {
     ESP->Time += time_increase;                             /* Increase time */
 }
 
+void ESP_SetTime(evol ESP_t* ESP, uint32_t time) {
+    if (ESP->Flags.F.TimeBaseSet) {                         /* Previous timestamp is known */
+        ESP->Time += time - ESP->TimeBase;                  /* Increase time by elapsed time */
+    }
+    ESP->TimeBase = time;
+    ESP->Flags.F.TimeBaseSet = 1;
+}
+
+uint32_t ESP_GetEventOverflow(evol ESP_t* ESP) {
+    return ESP->EventOverflow;
+}
+
+#if ESP_STATS
+ESP_Result_t ESP_GetStats(evol ESP_t* ESP, ESP_Stats_t* stats) {
+    __CHECK_INPUTS(stats);                                  /* Check inputs */
+    memcpy(stats, (const void *)&ESP->Stats, sizeof(*stats));   /* Copy all counters at once */
+    stats->Time = ESP->Time;
+    return espOK;
+}
+
+ESP_Result_t ESP_ResetStats(evol ESP_t* ESP) {
+    memset((void *)&ESP->Stats, 0x00, sizeof(ESP->Stats));
+    return espOK;
+}
+#endif                                                      /* ESP_STATS */
+
+ESP_Result_t ESP_GetInitTimes(evol ESP_t* ESP, ESP_InitTimes_t* times) {
+    __CHECK_INPUTS(times);                                  /* Check inputs */
+    memcpy(times, (const void *)&ESP->InitTimes, sizeof(*times));   /* Copy times of last initialization */
+    return espOK;
+}
+
+uint32_t ESP_GetNextDeadline(evol ESP_t* ESP) {
+    uint32_t next = ESP_DEADLINE_NONE, d;
+    uint8_t i;
+    
+    if ((BUFFER_GetFull((BUFFER_t *)&ESP->Buffer) && !__RX_STALLED(ESP)) || /* Received data waiting for processing */
+        ESP->Flags.F.Call_Idle || ESP->EventIn != ESP->EventOut || ESP->EventDataPending || ESP->DoneIn != ESP->DoneOut /* Callbacks waiting */
+#if ESP_CMD_QUEUE_SIZE
+        || (ESP->ActiveCmd == CMD_IDLE && ESP->QueueIn != ESP->QueueOut)    /* Queued command waiting to start */
+#endif                                                      /* ESP_CMD_QUEUE_SIZE */
+        ) {
+        return 0;
+    }
+    
+    /* Active command timeout */
+    if (ESP->ActiveCmd != CMD_IDLE) {
+        d = ESP->ActiveCmdStart + ESP->ActiveCmdTimeout + 1;
+        next = (int32_t)(d - ESP->Time) > 0 ? d - ESP->Time : 0;
+        
+        /* Time guard inside command, for example before transparent mode escape sequence */
+        if (ESP->ThreadDelay) {
+            d = ESP->ThreadTime + ESP->ThreadDelay + 1;
+            d = (int32_t)(d - ESP->Time) > 0 ? d - ESP->Time : 0;
+            if (d < next) {
+                next = d;
+            }
+        }
+    }
+    
+#if ESP_SINGLE_CONN && ESP_TRANSFER_TX_SIZE
+    /* Partial packet waiting in transparent mode transmit ring */
+    if (ESP->Flags.F.InTransparentMode && BUFFER_GetFull((BUFFER_t *)&ESP->TransferTx)) {
+        d = ESP->TransferTxTime + ESP_TRANSFER_PACKET_TIME;
+        d = (int32_t)(d - ESP->Time) > 0 ? d - ESP->Time : 0;
+        if (d < next) {
+            next = d;
+        }
+    }
+#endif                                                      /* ESP_SINGLE_CONN && ESP_TRANSFER_TX_SIZE */
+    
+    /* Connection callbacks and polls */
+    for (i = 0; i < sizeof(ESP->Conn) / sizeof(ESP->Conn[0]); i++) {
+        ESP_CONN_t* c = (ESP_CONN_t *)&ESP->Conn[i];
+        
+        if (c->Flags.F.Active && c->PollTime && c->PollTimeInterval) {
+            d = c->PollTime + 1;
+            d = (int32_t)(d - ESP->Time) > 0 ? d - ESP->Time : 0;
+            if (d < next) {
+                next = d;
+            }
+        }
+    }
+    return next;
+}
+
+ESP_Result_t ESP_RequestInit(evol ESP_t* ESP, ESP_Request_t* req) {
+    uint8_t i;
+    
+    __CHECK_INPUTS(req);                                    /* Check inputs */
+    for (i = 0; i < ESP_REQUEST_COUNT; i++) {
+        if (!ESP->Requests[i] || ESP->Requests[i] == req) { /* Find free entry or entry of this request */
+            req->Result = espOK;
+            req->Done = 1;                                  /* Request may be used */
+            req->Id = __REQUEST_ID(i);
+            ESP->Requests[i] = req;
+            __RETURN(ESP, espOK);
+        }
+    }
+    __RETURN(ESP, espNOHEAP);
+}
+
 ESP_Result_t ESP_GetLastReturnStatus(evol ESP_t* ESP) {
     ESP_Result_t tmp = ESP->ActiveResult;
     ESP->ActiveResult = espOK;
@@ -2643,13 +4095,55 @@ ESP_Result_t ESP_GetLastReturnStatus(evol ESP_t* ESP) {
 }
 
 uint16_t ESP_DataReceived(uint8_t* ch, uint16_t count) {
+    if (_ESP == NULL) {                                     /* Check if stack is initialized */
+        return 0;
+    }
+    return ESP_DataReceivedEx(_ESP, ch, count);             /* Write to default instance */
+}
+
+uint16_t ESP_DataReceivedEx(evol ESP_t* ESP, uint8_t* ch, uint16_t count) {
+    uint16_t r;
+    r = BUFFER_Write((BUFFER_t *)&ESP->Buffer, ch, count);  /* Writes data to USART buffer */
+    __STATS_RX(ESP, count, r);
+#if ESP_USE_CTS
+    if (BUFFER_GetFree((BUFFER_t *)&ESP->Buffer) <= 3) {
+        ESP_SET_RTS(ESP, ESP_RTS_SET);                      /* Set RTS pin */
+    }
+#endif /* ESP_USE_CTS */
+    __SYS_SIGNAL(ESP, ESP_SYS_EVENT_UPDATE);                /* Wake up update thread */
+    return r;
+}
+
+uint16_t ESP_DataReceivedGetBlock(uint8_t** data) {
+    if (_ESP == NULL) {                                     /* Check if stack is initialized */
+        *data = NULL;
+        return 0;
+    }
+    return ESP_DataReceivedGetBlockEx(_ESP, data);          /* Get block from default instance */
+}
+
+uint16_t ESP_DataReceivedGetBlockEx(evol ESP_t* ESP, uint8_t** data) {
+    *data = BUFFER_GetLinearBlockWriteAddress((BUFFER_t *)&ESP->Buffer);  /* Get address of free memory in USART buffer */
+    return (uint16_t)BUFFER_GetLinearBlockWriteLength((BUFFER_t *)&ESP->Buffer);    /* Return number of bytes which can be written directly */
+}
+
+uint16_t ESP_DataReceivedAdvance(uint16_t count) {
+    if (_ESP == NULL) {                                     /* Check if stack is initialized */
+        return 0;
+    }
+    return ESP_DataReceivedAdvanceEx(_ESP, count);          /* Advance default instance */
+}
+
+uint16_t ESP_DataReceivedAdvanceEx(evol ESP_t* ESP, uint16_t count) {
     uint16_t r;
-    r = BUFFER_Write(&Buffer, ch, count);                   /* Writes data to USART buffer */
+    r = BUFFER_Advance((BUFFER_t *)&ESP->Buffer, count);    /* Add directly written data to USART buffer */
+    __STATS_RX(ESP, count, r);
 #if ESP_USE_CTS
-    if (BUFFER_GetFree(&Buffer) <= 3) {
-        ESP_SET_RTS(_ESP, ESP_RTS_SET);                     /* Set RTS pin */
+    if (BUFFER_GetFree((BUFFER_t *)&ESP->Buffer) <= 3) {
+        ESP_SET_RTS(ESP, ESP_RTS_SET);                      /* Set RTS pin */
     }
 #endif /* ESP_USE_CTS */
+    __SYS_SIGNAL(ESP, ESP_SYS_EVENT_UPDATE);                /* Wake up update thread */
     return r;
 }
 
@@ -2663,7 +4157,9 @@ ESP_Result_t ESP_WaitReady(evol ESP_t* ESP, uint32_t timeout) {
         ESP_Update(ESP);                                    /* Update stack if we are in synchronous mode */
 #else
         ESP_ProcessCallbacks(ESP);                          /* Process callbacks when not in synchronous mode */
-        ESP_RTOS_YIELD();
+        if (__IS_BUSY(ESP) && !__SYS_WAIT(ESP, ESP_SYS_EVENT_READY, ESP->ActiveCmdTimeout)) {   /* Sleep until command finishes */
+            ESP_RTOS_YIELD();                               /* Waiting is not supported by low-level */
+        }
 #endif /* !ESP_RTOS && !ESP_ASYNC */
     } while (__IS_BUSY(ESP));
     __RETURN(ESP, ESP->ActiveResult);                       /* Return active result from command */
@@ -2675,7 +4171,9 @@ ESP_Result_t ESP_Delay(evol ESP_t* ESP, uint32_t timeout) {
 #if !ESP_RTOS && !ESP_ASYNC
         ESP_Update(ESP);
 #else
-        ESP_RTOS_YIELD();
+        if (!__SYS_WAIT(ESP, ESP_SYS_EVENT_DELAY, timeout - (ESP->Time - start))) { /* Sleep for remaining time */
+            ESP_RTOS_YIELD();                               /* Waiting is not supported by low-level */
+        }
 #endif /* !ESP_RTOS && !ESP_ASYNC */
     } while (ESP->Time - start < timeout);
     __RETURN(ESP, espOK);
@@ -2689,59 +4187,53 @@ ESP_Result_t ESP_IsReady(evol ESP_t* ESP) {
 /***                              Device settings                            **/
 /******************************************************************************/
 ESP_Result_t ESP_RestoreDefault(evol ESP_t* ESP, uint32_t blocking) {
-    __CHECK_BUSY(ESP);                                      /* Check busy status */
-    __ACTIVE_CMD(ESP, CMD_BASIC_RESTORE);                   /* Set active command */
+    __START_CMD(ESP, CMD_BASIC_RESTORE, blocking);          /* Set active command or add it to queue */
     
     __RETURN_BLOCKING(ESP, blocking, 2000);                 /* Return with blocking support */
 }
 
 ESP_Result_t ESP_SetUART(evol ESP_t* ESP, uint32_t baudrate, uint32_t def, uint32_t blocking) {
     __CHECK_INPUTS(baudrate >= 110 && baudrate <= (40 * 115200));   /* Check inputs */
-    __CHECK_BUSY(ESP);                                      /* Check busy status */
-    __ACTIVE_CMD(ESP, CMD_BASIC_UART);                      /* Set active command */
+    __START_CMD(ESP, CMD_BASIC_UART, blocking);             /* Set active command or add it to queue */
     
-    Pointers.CPtr1 = def ? FROMMEM("DEF") : FROMMEM("CUR");
-    Pointers.UI = baudrate;
+    ESP->Params->CPtr1 = def ? FROMMEM("DEF") : FROMMEM("CUR");
+    ESP->Params->UI = baudrate;
     
     __RETURN_BLOCKING(ESP, blocking, 1000);                 /* Return with blocking support */
 }
 
 ESP_Result_t ESP_SetRFPower(evol ESP_t* ESP, float pwr, uint32_t blocking) {
     __CHECK_INPUTS(pwr > 0 && (pwr / 0.25f) <= ESP_MAX_RFPWR);  /* Check inputs */
-    __CHECK_BUSY(ESP);                                      /* Check busy status */
-    __ACTIVE_CMD(ESP, CMD_BASIC_RFPOWER);                   /* Set active command */
+    __START_CMD(ESP, CMD_BASIC_RFPOWER, blocking);          /* Set active command or add it to queue */
     
-    Pointers.UI = (uint8_t)(pwr / 0.25f);
+    ESP->Params->UI = (uint8_t)(pwr / 0.25f);
     
     __RETURN_BLOCKING(ESP, blocking, 1000);                 /* Return with blocking support */
 }
 
 ESP_Result_t ESP_FirmwareUpdate(evol ESP_t* ESP, uint32_t blocking) {
-    __CHECK_BUSY(ESP);                                      /* Check busy status */
-    __ACTIVE_CMD(ESP, CMD_TCPIP_CIUPDATE);                  /* Set active command */
+    __START_CMD(ESP, CMD_TCPIP_CIUPDATE, blocking);         /* Set active command or add it to queue */
     
     __RETURN_BLOCKING(ESP, blocking, 180000);               /* Return with blocking support */
 }
 
 ESP_Result_t ESP_GetSoftwareInfo(evol ESP_t* ESP, char* atv, char* sdkv, char* cmpt, uint32_t blocking) {
     __CHECK_INPUTS(atv || sdkv || cmpt);                    /* Check inputs, at least one must be valid to start with this command */
-    __CHECK_BUSY(ESP);                                      /* Check busy status */
-    __ACTIVE_CMD(ESP, CMD_BASIC_GMR);                       /* Set active command */
+    __START_CMD(ESP, CMD_BASIC_GMR, blocking);              /* Set active command or add it to queue */
     
     /* Use const pointers because of missing structure data and to prevent RAM usage */
-    Pointers.CPtr1 = (const void *)atv;
-    Pointers.CPtr2 = (const void *)sdkv;
-    Pointers.CPtr3 = (const void *)cmpt;
+    ESP->Params->CPtr1 = (const void *)atv;
+    ESP->Params->CPtr2 = (const void *)sdkv;
+    ESP->Params->CPtr3 = (const void *)cmpt;
     
     __RETURN_BLOCKING(ESP, blocking, 180000);               /* Return with blocking support */
 }
 
 ESP_Result_t ESP_SetMode(evol ESP_t* ESP, ESP_Mode_t mode, uint32_t def, uint32_t blocking) {
-    __CHECK_BUSY(ESP);                                      /* Check busy status */
-    __ACTIVE_CMD(ESP, CMD_WIFI_CWMODE);                     /* Set active command */
+    __START_CMD(ESP, CMD_WIFI_CWMODE, blocking);            /* Set active command or add it to queue */
 
-    Pointers.CPtr1 = def ? FROMMEM("DEF") : FROMMEM("CUR");
-    Pointers.UI = (uint8_t)mode;
+    ESP->Params->CPtr1 = def ? FROMMEM("DEF") : FROMMEM("CUR");
+    ESP->Params->UI = (uint8_t)mode;
 
     __RETURN_BLOCKING(ESP, blocking, 1000);                 /* Return with blocking support */
 }
@@ -2750,98 +4242,88 @@ ESP_Result_t ESP_SetMode(evol ESP_t* ESP, ESP_Mode_t mode, uint32_t def, uint32_
 /***                         STATION AND AP settings                         **/
 /******************************************************************************/
 ESP_Result_t ESP_STA_GetIP(evol ESP_t* ESP, uint8_t* ip, uint32_t blocking) {
-    __CHECK_BUSY(ESP);                                      /* Check busy status */
-    __ACTIVE_CMD(ESP, CMD_WIFI_GETSTAIP);                   /* Set active command */
+    __START_CMD(ESP, CMD_WIFI_GETSTAIP, blocking);          /* Set active command or add it to queue */
     
-    Pointers.Ptr1 = ip;                                     /* Save pointer to save IP to */
+    ESP->Params->Ptr1 = ip;                                 /* Save pointer to save IP to */
     
     __RETURN_BLOCKING(ESP, blocking, 1000);                 /* Return with blocking support */
 }
 
 ESP_Result_t ESP_STA_SetIP(evol ESP_t* ESP, const uint8_t* ip, const uint8_t* gw_msk, uint8_t def, uint32_t blocking) {
-    __CHECK_BUSY(ESP);                                      /* Check busy status */
-    __ACTIVE_CMD(ESP, CMD_WIFI_SETSTAIP);                   /* Set active command */
+    __START_CMD(ESP, CMD_WIFI_SETSTAIP, blocking);          /* Set active command or add it to queue */
     
-    Pointers.CPtr1 = def ? FROMMEM("DEF") : FROMMEM("CUR");
-    Pointers.CPtr2 = ip;
-    Pointers.CPtr3 = gw_msk;
+    ESP->Params->CPtr1 = def ? FROMMEM("DEF") : FROMMEM("CUR");
+    ESP->Params->CPtr2 = ip;
+    ESP->Params->CPtr3 = gw_msk;
     
     __RETURN_BLOCKING(ESP, blocking, 1000);                 /* Return with blocking support */
 }
 
 ESP_Result_t ESP_STA_GetMAC(evol ESP_t* ESP, uint8_t* mac, uint32_t blocking) {
-    __CHECK_BUSY(ESP);                                      /* Check busy status */
-    __ACTIVE_CMD(ESP, CMD_WIFI_GETSTAMAC);                  /* Set active command */
+    __START_CMD(ESP, CMD_WIFI_GETSTAMAC, blocking);         /* Set active command or add it to queue */
     
-    Pointers.Ptr1 = mac;                                    /* Save pointer to save MAC to */
+    ESP->Params->Ptr1 = mac;                                /* Save pointer to save MAC to */
     
     __RETURN_BLOCKING(ESP, blocking, 1000);                 /* Return with blocking support */
 }
 
 ESP_Result_t ESP_STA_SetMAC(evol ESP_t* ESP, const uint8_t* mac, uint32_t def, uint32_t blocking) {
     __CHECK_INPUTS(mac && (*mac & 0x01) == 0);              /* Check inputs, bit 0 of first byte cannot be set to 1 on station */
-    __CHECK_BUSY(ESP);                                      /* Check busy status */
-    __ACTIVE_CMD(ESP, CMD_WIFI_SETSTAMAC);                  /* Set active command */
+    __START_CMD(ESP, CMD_WIFI_SETSTAMAC, blocking);         /* Set active command or add it to queue */
     
-    Pointers.CPtr1 = def ? FROMMEM("DEF") : FROMMEM("CUR");
-    Pointers.CPtr2 = mac;
+    ESP->Params->CPtr1 = def ? FROMMEM("DEF") : FROMMEM("CUR");
+    ESP->Params->CPtr2 = mac;
     
     __RETURN_BLOCKING(ESP, blocking, 1000);                 /* Return with blocking support */
 }
 
 ESP_Result_t ESP_AP_GetIP(evol ESP_t* ESP, uint8_t* ip, uint32_t blocking) {
-    __CHECK_BUSY(ESP);                                      /* Check busy status */
-    __ACTIVE_CMD(ESP, CMD_WIFI_GETAPIP);                    /* Set active command */
+    __START_CMD(ESP, CMD_WIFI_GETAPIP, blocking);           /* Set active command or add it to queue */
     
-    Pointers.Ptr1 = ip;                                     /* Save pointer to save IP to */
+    ESP->Params->Ptr1 = ip;                                 /* Save pointer to save IP to */
     
     __RETURN_BLOCKING(ESP, blocking, 1000);                 /* Return with blocking support */
 }
 
 ESP_Result_t ESP_AP_SetIP(evol ESP_t* ESP, const uint8_t* ip, uint8_t def, uint32_t blocking) {
-    __CHECK_BUSY(ESP);                                      /* Check busy status */
-    __ACTIVE_CMD(ESP, CMD_WIFI_SETAPIP);                    /* Set active command */
+    __START_CMD(ESP, CMD_WIFI_SETAPIP, blocking);           /* Set active command or add it to queue */
     
-    Pointers.CPtr1 = def ? FROMMEM("DEF") : FROMMEM("CUR");
-    Pointers.CPtr2 = ip;
+    ESP->Params->CPtr1 = def ? FROMMEM("DEF") : FROMMEM("CUR");
+    ESP->Params->CPtr2 = ip;
     
     __RETURN_BLOCKING(ESP, blocking, 1000);                 /* Return with blocking support */
 }
 
 ESP_Result_t ESP_AP_GetMAC(evol ESP_t* ESP, uint8_t* mac, uint32_t blocking) {
-    __CHECK_BUSY(ESP);                                      /* Check busy status */
-    __ACTIVE_CMD(ESP, CMD_WIFI_GETAPMAC);                   /* Set active command */
+    __START_CMD(ESP, CMD_WIFI_GETAPMAC, blocking);          /* Set active command or add it to queue */
     
-    Pointers.Ptr1 = mac;                                    /* Save pointer to save MAC to */
+    ESP->Params->Ptr1 = mac;                                /* Save pointer to save MAC to */
     
     __RETURN_BLOCKING(ESP, blocking, 1000);                 /* Return with blocking support */
 }
 
 ESP_Result_t ESP_AP_SetMAC(evol ESP_t* ESP, const uint8_t* mac, uint32_t def, uint32_t blocking) {
     __CHECK_INPUTS(mac);                                    /* Check inputs */
-    __CHECK_BUSY(ESP);                                      /* Check busy status */
-    __ACTIVE_CMD(ESP, CMD_WIFI_SETAPMAC);                   /* Set active command */
+    __START_CMD(ESP, CMD_WIFI_SETAPMAC, blocking);          /* Set active command or add it to queue */
     
-    Pointers.CPtr1 = def ? FROMMEM("DEF") : FROMMEM("CUR");
-    Pointers.CPtr2 = mac;
+    ESP->Params->CPtr1 = def ? FROMMEM("DEF") : FROMMEM("CUR");
+    ESP->Params->CPtr2 = mac;
     
     __RETURN_BLOCKING(ESP, blocking, 1000);                 /* Return with blocking support */
 }
 
 ESP_Result_t ESP_AP_GetConfig(evol ESP_t* ESP, uint32_t blocking) {
-    __CHECK_BUSY(ESP);                                      /* Check busy status */
-    __ACTIVE_CMD(ESP, CMD_WIFI_GETCWSAP);                   /* Set active command */
+    __START_CMD(ESP, CMD_WIFI_GETCWSAP, blocking);          /* Set active command or add it to queue */
     
     __RETURN_BLOCKING(ESP, blocking, 1000);                 /* Return with blocking support */
 }
 
 ESP_Result_t ESP_AP_SetConfig(evol ESP_t* ESP, ESP_APConfig_t* conf, uint8_t def, uint32_t blocking) {
     __CHECK_INPUTS(conf);                                   /* Check inputs */
-    __CHECK_BUSY(ESP);                                      /* Check busy status */
-    __ACTIVE_CMD(ESP, CMD_WIFI_SETCWSAP);                   /* Set active command */
+    __START_CMD(ESP, CMD_WIFI_SETCWSAP, blocking);          /* Set active command or add it to queue */
     
-    Pointers.CPtr1 = def ? FROMMEM("DEF") : FROMMEM("CUR");
-    Pointers.CPtr2 = conf;
+    ESP->Params->CPtr1 = def ? FROMMEM("DEF") : FROMMEM("CUR");
+    ESP->Params->CPtr2 = conf;
     
     __RETURN_BLOCKING(ESP, blocking, 1000);                 /* Return with blocking support */
 }
@@ -2851,74 +4333,67 @@ ESP_Result_t ESP_AP_SetConfig(evol ESP_t* ESP, ESP_APConfig_t* conf, uint8_t def
 /******************************************************************************/
 ESP_Result_t ESP_SYS_GetAvailableRAM(evol ESP_t* ESP, uint32_t* ram, uint32_t blocking) {
     __CHECK_INPUTS(ram);                                    /* Check inputs */
-    __CHECK_BUSY(ESP);                                      /* Check busy status */
-    __ACTIVE_CMD(ESP, CMD_BASIC_GETSYSRAM);                 /* Set active command */
+    __START_CMD(ESP, CMD_BASIC_GETSYSRAM, blocking);        /* Set active command or add it to queue */
     
-    Pointers.Ptr1 = ram;
+    ESP->Params->Ptr1 = ram;
     
     __RETURN_BLOCKING(ESP, blocking, 1000);                 /* Return with blocking support */
 }
 
 ESP_Result_t ESP_SYS_ReadADC(evol ESP_t* ESP, uint32_t* adc, uint32_t blocking) {
     __CHECK_INPUTS(adc);                                    /* Check inputs */
-    __CHECK_BUSY(ESP);                                      /* Check busy status */
-    __ACTIVE_CMD(ESP, CMD_BASIC_GETSYSADC);                 /* Set active command */
+    __START_CMD(ESP, CMD_BASIC_GETSYSADC, blocking);        /* Set active command or add it to queue */
     
-    Pointers.Ptr1 = adc;
+    ESP->Params->Ptr1 = adc;
     
     __RETURN_BLOCKING(ESP, blocking, 1000);                 /* Return with blocking support */
 }
 
 ESP_Result_t ESP_SYS_GPIO_Read(evol ESP_t* ESP, uint8_t gpionum, uint8_t* level, ESP_GPIO_Dir_t* dir, uint32_t blocking) {
     __CHECK_INPUTS(level);                                  /* Check inputs */
-    __CHECK_BUSY(ESP);                                      /* Check busy status */
-    __ACTIVE_CMD(ESP, CMD_BASIC_SYSGPIOREAD);               /* Set active command */
+    __START_CMD(ESP, CMD_BASIC_SYSGPIOREAD, blocking);      /* Set active command or add it to queue */
     
-    Pointers.Ptr1 = level;
-    Pointers.Ptr2 = dir;
-    Pointers.UI = gpionum;
+    ESP->Params->Ptr1 = level;
+    ESP->Params->Ptr2 = dir;
+    ESP->Params->UI = gpionum;
     
     __RETURN_BLOCKING(ESP, blocking, 1000);                 /* Return with blocking support */
 }
 
 ESP_Result_t ESP_SYS_GPIO_Write(evol ESP_t* ESP, uint8_t gpionum, uint8_t val, uint32_t blocking) {
-    __CHECK_BUSY(ESP);                                      /* Check busy status */
-    __ACTIVE_CMD(ESP, CMD_BASIC_SYSGPIOWRITE);              /* Set active command */
+    __START_CMD(ESP, CMD_BASIC_SYSGPIOWRITE, blocking);     /* Set active command or add it to queue */
     
-    Pointers.UI = (!!val) << 8 | gpionum;                   /* Save values for gpio number and value to write */
+    ESP->Params->UI = (!!val) << 8 | gpionum;               /* Save values for gpio number and value to write */
     
     __RETURN_BLOCKING(ESP, blocking, 1000);                 /* Return with blocking support */
 }
 
 ESP_Result_t ESP_SYS_GPIO_SetConfig(evol ESP_t* ESP, uint8_t gpionum, const ESP_GPIO_t* conf, uint32_t blocking) {
     __CHECK_INPUTS(conf);                                   /* Check inputs */
-    __CHECK_BUSY(ESP);                                      /* Check busy status */
-    __ACTIVE_CMD(ESP, CMD_BASIC_SYSIOSETCFG);               /* Set active command */
+    __START_CMD(ESP, CMD_BASIC_SYSIOSETCFG, blocking);      /* Set active command or add it to queue */
     
-    Pointers.CPtr1 = conf;
-    Pointers.UI = gpionum;
+    ESP->Params->CPtr1 = conf;
+    ESP->Params->UI = gpionum;
     
     __RETURN_BLOCKING(ESP, blocking, 1000);                 /* Return with blocking support */
 }
 
 ESP_Result_t ESP_SYS_GPIO_GetConfig(evol ESP_t* ESP, uint8_t gpionum, ESP_GPIO_t* conf, uint32_t blocking) {
     __CHECK_INPUTS(conf);                                   /* Check inputs */
-    __CHECK_BUSY(ESP);                                      /* Check busy status */
-    __ACTIVE_CMD(ESP, CMD_BASIC_SYSIOGETCFG);               /* Set active command */
+    __START_CMD(ESP, CMD_BASIC_SYSIOGETCFG, blocking);      /* Set active command or add it to queue */
     
-    Pointers.Ptr1 = conf;
-    Pointers.UI = gpionum;
+    ESP->Params->Ptr1 = conf;
+    ESP->Params->UI = gpionum;
     
     __RETURN_BLOCKING(ESP, blocking, 1000);                 /* Return with blocking support */
 }
 
 ESP_Result_t ESP_SYS_GPIO_SetDir(evol ESP_t* ESP, uint8_t gpionum, const ESP_GPIO_t* conf, uint32_t blocking) {
     __CHECK_INPUTS(conf);                                   /* Check inputs */
-    __CHECK_BUSY(ESP);                                      /* Check busy status */
-    __ACTIVE_CMD(ESP, CMD_BASIC_SYSGPIOSETDIR);             /* Set active command */
+    __START_CMD(ESP, CMD_BASIC_SYSGPIOSETDIR, blocking);    /* Set active command or add it to queue */
     
-    Pointers.CPtr1 = conf;
-    Pointers.UI = gpionum;
+    ESP->Params->CPtr1 = conf;
+    ESP->Params->UI = gpionum;
     
     __RETURN_BLOCKING(ESP, blocking, 1000);                 /* Return with blocking support */
 }
@@ -2929,56 +4404,51 @@ ESP_Result_t ESP_SYS_GPIO_SetDir(evol ESP_t* ESP, uint8_t gpionum, const ESP_GPI
 /******************************************************************************/
 ESP_Result_t ESP_SERVER_Enable(evol ESP_t* ESP, uint16_t port, uint32_t blocking) {
     __CHECK_INPUTS(port > 0);                               /* Check inputs */
-    __CHECK_BUSY(ESP);                                      /* Check busy status */
-    __ACTIVE_CMD(ESP, CMD_TCPIP_SERVERENABLE);              /* Set active command */
+    __START_CMD(ESP, CMD_TCPIP_SERVERENABLE, blocking);     /* Set active command or add it to queue */
     
-    Pointers.UI = port;                                     /* port number */
+    ESP->Params->UI = port;                                 /* port number */
     
     __RETURN_BLOCKING(ESP, blocking, 1000);                 /* Return with blocking support */
 }
 
 ESP_Result_t ESP_SERVER_Disable(evol ESP_t* ESP, uint32_t blocking) {
-    __CHECK_BUSY(ESP);                                      /* Check busy status */
-    __ACTIVE_CMD(ESP, CMD_TCPIP_SERVERDISABLE);             /* Set active command */
+    __START_CMD(ESP, CMD_TCPIP_SERVERDISABLE, blocking);    /* Set active command or add it to queue */
     
     __RETURN_BLOCKING(ESP, blocking, 1000);                 /* Return with blocking support */
 }
 
 ESP_Result_t ESP_SERVER_SetTimeout(evol ESP_t* ESP, uint16_t timeout, uint32_t blocking) {
-    __CHECK_BUSY(ESP);                                      /* Check busy status */
-    __ACTIVE_CMD(ESP, CMD_TCPIP_CIPSTO);                    /* Set active command */
+    __START_CMD(ESP, CMD_TCPIP_CIPSTO, blocking);           /* Set active command or add it to queue */
     
-    Pointers.UI = timeout;                                  /* Save timeout value */
+    ESP->Params->UI = timeout;                              /* Save timeout value */
     
     __RETURN_BLOCKING(ESP, blocking, 1000);                 /* Return with blocking support */
 }
-#endif /* ESP_SINGLE_CONN */
+#endif                                                      /* ESP_SINGLE_CONN */
 
 /******************************************************************************/
 /***                            List wifi stations                           **/
 /******************************************************************************/
 ESP_Result_t ESP_STA_ListAccessPoints(evol ESP_t* ESP, ESP_AP_t* APs, uint16_t atr, uint16_t* ar, uint32_t blocking) {
     __CHECK_INPUTS(APs && atr && ar);                       /* Check inputs */
-    __CHECK_BUSY(ESP);                                      /* Check busy status */
-    __ACTIVE_CMD(ESP, CMD_WIFI_LISTACCESSPOINTS);           /* Set active command */
+    __START_CMD(ESP, CMD_WIFI_LISTACCESSPOINTS, blocking);  /* Set active command or add it to queue */
     
     *ar = 0;
-    Pointers.Ptr1 = APs;
-    Pointers.Ptr2 = ar;
-    Pointers.UI = atr;
+    ESP->Params->Ptr1 = APs;
+    ESP->Params->Ptr2 = ar;
+    ESP->Params->UI = atr;
     
     __RETURN_BLOCKING(ESP, blocking, 10000);                /* Return with blocking support */
 }
 
 ESP_Result_t ESP_AP_ListConnectedStations(evol ESP_t* ESP, ESP_ConnectedStation_t* stations, uint16_t size, uint16_t* sr, uint32_t blocking) {
     __CHECK_INPUTS(stations && size && sr);                 /* Check inputs */
-    __CHECK_BUSY(ESP);                                      /* Check busy status */
-    __ACTIVE_CMD(ESP, CMD_WIFI_CWLIF);                      /* Set active command */
+    __START_CMD(ESP, CMD_WIFI_CWLIF, blocking);             /* Set active command or add it to queue */
     
     *sr = 0;
-    Pointers.Ptr1 = stations;
-    Pointers.Ptr2 = sr;
-    Pointers.UI = size;
+    ESP->Params->Ptr1 = stations;
+    ESP->Params->Ptr2 = sr;
+    ESP->Params->UI = size;
     
     __RETURN_BLOCKING(ESP, blocking, 10000);                /* Return with blocking support */
 }
@@ -2988,38 +4458,34 @@ ESP_Result_t ESP_AP_ListConnectedStations(evol ESP_t* ESP, ESP_ConnectedStation_
 /******************************************************************************/
 ESP_Result_t ESP_STA_Connect(evol ESP_t* ESP, const char* ssid, const char* pass, const uint8_t* mac, uint32_t def, uint32_t blocking) {
     __CHECK_INPUTS(ssid && pass);                           /* Check inputs */
-    __CHECK_BUSY(ESP);                                      /* Check busy status */
-    __ACTIVE_CMD(ESP, CMD_WIFI_CWJAP);                      /* Set active command */
+    __START_CMD(ESP, CMD_WIFI_CWJAP, blocking);             /* Set active command or add it to queue */
     
-    Pointers.CPtr1 = def ? FROMMEM("DEF") : FROMMEM("CUR");
-    Pointers.CPtr2 = ssid;
-    Pointers.CPtr3 = pass;
-    Pointers.Ptr1 = (void *)mac;
+    ESP->Params->CPtr1 = def ? FROMMEM("DEF") : FROMMEM("CUR");
+    ESP->Params->CPtr2 = ssid;
+    ESP->Params->CPtr3 = pass;
+    ESP->Params->Ptr1 = (void *)mac;
     
     __RETURN_BLOCKING(ESP, blocking, 30000);                /* Return with blocking support */
 }
 
 ESP_Result_t ESP_STA_GetConnected(evol ESP_t* ESP, ESP_ConnectedAP_t* AP, uint32_t blocking) {
-    __CHECK_BUSY(ESP);                                      /* Check busy status */
-    __ACTIVE_CMD(ESP, CMD_WIFI_GETCWJAP);                   /* Set active command */
+    __START_CMD(ESP, CMD_WIFI_GETCWJAP, blocking);          /* Set active command or add it to queue */
     
-    Pointers.Ptr1 = AP;
+    ESP->Params->Ptr1 = AP;
     
     __RETURN_BLOCKING(ESP, blocking, 10000);                /* Return with blocking support */
 }
 
 ESP_Result_t ESP_STA_Disconnect(evol ESP_t* ESP, uint32_t blocking) {
-    __CHECK_BUSY(ESP);                                      /* Check busy status */
-    __ACTIVE_CMD(ESP, CMD_WIFI_CWQAP);                      /* Set active command */
+    __START_CMD(ESP, CMD_WIFI_CWQAP, blocking);             /* Set active command or add it to queue */
     
     __RETURN_BLOCKING(ESP, blocking, 10000);                /* Return with blocking support */
 }
 
 ESP_Result_t ESP_STA_SetAutoConnect(evol ESP_t* ESP, uint8_t autoconn, uint32_t blocking) {
-    __CHECK_BUSY(ESP);                                      /* Check busy status */
-    __ACTIVE_CMD(ESP, CMD_WIFI_CWAUTOCONN);                 /* Set active command */
+    __START_CMD(ESP, CMD_WIFI_CWAUTOCONN, blocking);        /* Set active command or add it to queue */
     
-    Pointers.UI = autoconn ? 1 : 0;
+    ESP->Params->UI = autoconn ? 1 : 0;
     
     __RETURN_BLOCKING(ESP, blocking, 10000);                /* Return with blocking support */
 }
@@ -3029,44 +4495,102 @@ ESP_Result_t ESP_STA_SetAutoConnect(evol ESP_t* ESP, uint8_t autoconn, uint32_t
 /******************************************************************************/
 ESP_Result_t ESP_CONN_Start(evol ESP_t* ESP, ESP_CONN_t** conn, ESP_CONN_Type_t type, const char* domain, uint16_t port, uint32_t blocking) {
     __CHECK_INPUTS(conn && domain && port);                 /* Check inputs */
-    __CHECK_BUSY(ESP);                                      /* Check busy status */
-    __ACTIVE_CMD(ESP, CMD_TCPIP_CIPSTART);                  /* Set active command */
+    __START_CMD(ESP, CMD_TCPIP_CIPSTART, blocking);         /* Set active command or add it to queue */
     
-    Pointers.PPtr1 = (evol void **)conn;
-    Pointers.CPtr1 = domain;
-    Pointers.UI = type << 16 | port;
+    ESP->Params->PPtr1 = (evol void **)conn;
+    ESP->Params->CPtr1 = domain;
+    ESP->Params->UI = type << 16 | port;
     
     __RETURN_BLOCKING(ESP, blocking, 180000);               /* Return with blocking support */
 }
 
 ESP_Result_t ESP_CONN_Send(evol ESP_t* ESP, ESP_CONN_t* conn, const uint8_t* data, uint32_t btw, uint32_t* bw, uint32_t blocking) {
     __CHECK_INPUTS(conn && data && btw);                    /* Check inputs */
-    __CHECK_BUSY(ESP);                                      /* Check busy status */
-    __ACTIVE_CMD(ESP, CMD_TCPIP_CIPSEND);                   /* Set active command */
+    __START_CMD(ESP, CMD_TCPIP_CIPSEND, blocking);          /* Set active command or add it to queue */
+    
+    ESP->Params->Ptr1 = conn;
+    ESP->Params->Ptr2 = bw;
+    ESP->Params->CPtr1 = data;
+    ESP->Params->CPtr2 = NULL;                              /* Data are in single buffer */
+    ESP->Params->UI = btw;
+    
+    __RETURN_BLOCKING(ESP, blocking, 10000);                /* Return with blocking support */
+}
+
+ESP_Result_t ESP_CONN_SendVector(evol ESP_t* ESP, ESP_CONN_t* conn, const ESP_SendVec_t* vec, uint32_t cnt, uint32_t* bw, uint32_t blocking) {
+    uint32_t i, btw = 0;
+    
+    for (i = 0; vec && i < cnt; i++) {                      /* Get number of bytes in all buffers */
+        btw += vec[i].Len;
+    }
+    __CHECK_INPUTS(conn && vec && btw);                     /* Check inputs */
+    __START_CMD(ESP, CMD_TCPIP_CIPSEND, blocking);          /* Set active command or add it to queue */
+    
+    ESP->Params->Ptr1 = conn;
+    ESP->Params->Ptr2 = bw;
+    ESP->Params->CPtr1 = vec->Data;                         /* Start with first byte of first buffer */
+    ESP->Params->CPtr2 = vec;
+    ESP->Params->UI = btw;
+    
+    __RETURN_BLOCKING(ESP, blocking, 10000);                /* Return with blocking support */
+}
+
+ESP_Result_t ESP_CONN_SendEx(evol ESP_t* ESP, ESP_CONN_t* conn, const char* str, uint32_t* bw, uint32_t blocking) {
+    __CHECK_INPUTS(conn && str && *str);                    /* Check inputs */
+    __START_CMD(ESP, CMD_TCPIP_CIPSENDEX, blocking);        /* Set active command or add it to queue */
+    
+    ESP->Params->Ptr1 = conn;
+    ESP->Params->Ptr2 = bw;
+    ESP->Params->CPtr1 = str;
+    
+    __RETURN_BLOCKING(ESP, blocking, 10000);                /* Return with blocking support */
+}
+
+ESP_Result_t ESP_CONN_SendBuf(evol ESP_t* ESP, ESP_CONN_t* conn, const uint8_t* data, uint32_t btw, uint32_t* bw, uint32_t blocking) {
+    __CHECK_INPUTS(conn && data && btw);                    /* Check inputs */
+    __START_CMD(ESP, CMD_TCPIP_CIPSENDBUF, blocking);       /* Set active command or add it to queue */
     
-    Pointers.Ptr1 = conn;
-    Pointers.Ptr2 = bw;
-    Pointers.CPtr1 = data;
-    Pointers.UI = btw;
+    ESP->Params->Ptr1 = conn;
+    ESP->Params->Ptr2 = bw;
+    ESP->Params->CPtr1 = data;
+    ESP->Params->UI = btw;
     
     __RETURN_BLOCKING(ESP, blocking, 10000);                /* Return with blocking support */
 }
 
+ESP_Result_t ESP_CONN_GetBufferStatus(evol ESP_t* ESP, ESP_CONN_t* conn, uint32_t blocking) {
+    __CHECK_INPUTS(conn);                                   /* Check inputs */
+    __START_CMD(ESP, CMD_TCPIP_CIPBUFSTATUS, blocking);     /* Set active command or add it to queue */
+    
+    ESP->Params->Ptr1 = conn;
+    
+    __RETURN_BLOCKING(ESP, blocking, 1000);                 /* Return with blocking support */
+}
+
+ESP_Result_t ESP_CONN_CheckSegment(evol ESP_t* ESP, ESP_CONN_t* conn, uint32_t segment, uint8_t* sent, uint32_t blocking) {
+    __CHECK_INPUTS(conn && sent);                           /* Check inputs */
+    __START_CMD(ESP, CMD_TCPIP_CIPCHECKSEQ, blocking);      /* Set active command or add it to queue */
+    
+    ESP->Params->Ptr1 = conn;
+    ESP->Params->Ptr2 = sent;
+    ESP->Params->UI = segment;
+    
+    __RETURN_BLOCKING(ESP, blocking, 1000);                 /* Return with blocking support */
+}
+
 ESP_Result_t ESP_CONN_Close(evol ESP_t* ESP, ESP_CONN_t* conn, uint32_t blocking) {
     __CHECK_INPUTS(conn);                                   /* Check inputs */
-    __CHECK_BUSY(ESP);                                      /* Check busy status */
-    __ACTIVE_CMD(ESP, CMD_TCPIP_CIPCLOSE);                  /* Set active command */
+    __START_CMD(ESP, CMD_TCPIP_CIPCLOSE, blocking);         /* Set active command or add it to queue */
  
-    Pointers.UI = conn->Number;
+    ESP->Params->UI = conn->Number;
     
     __RETURN_BLOCKING(ESP, blocking, 10000);                /* Return with blocking support */
 }
 
 ESP_Result_t ESP_CONN_CloseAll(evol ESP_t* ESP, uint32_t blocking) {
-    __CHECK_BUSY(ESP);                                      /* Check busy status */
-    __ACTIVE_CMD(ESP, CMD_TCPIP_CIPCLOSE);                  /* Set active command */
+    __START_CMD(ESP, CMD_TCPIP_CIPCLOSE, blocking);         /* Set active command or add it to queue */
 
-    Pointers.UI = ESP_MAX_CONNECTIONS;                      /* Close all connections */
+    ESP->Params->UI = ESP_MAX_CONNECTIONS;                  /* Close all connections */
     
     __RETURN_BLOCKING(ESP, blocking, 5000);                 /* Return with blocking support */
 }
@@ -3087,12 +4611,78 @@ ESP_Result_t ESP_CONN_SetCallback(evol ESP_t* ESP, ESP_CONN_t* conn, ESP_EventCa
     return espOK;
 }
 
+#if ESP_CONN_RX_SIZE
+ESP_Result_t ESP_CONN_SetReceiveBuffer(evol ESP_t* ESP, uint8_t num, void* mem, uint32_t size) {
+    BUFFER_t ring;
+    
+    __CHECK_INPUTS(num < ESP_MAX_CONNECTIONS && size > 1);  /* Check inputs */
+    if (ESP->Conn[num].Flags.F.Active) {                    /* Ring can not be changed while in use */
+        return espERROR;
+    }
+    if (BUFFER_Init(&ring, size, mem)) {                    /* Prepare new ring memory, keep old ring on failure */
+        return mem ? espERROR : espNOHEAP;
+    }
+    BUFFER_Free((BUFFER_t *)&ESP->ConnRx[num]);             /* Free previously allocated memory */
+    memcpy((void *)&ESP->ConnRx[num], &ring, sizeof(ring));
+    return espOK;
+}
+
+uint32_t ESP_CONN_Available(evol ESP_t* ESP, ESP_CONN_t* conn) {
+    if (!conn) {
+        return 0;
+    }
+    return BUFFER_GetFull((BUFFER_t *)&ESP->ConnRx[conn->Number]);
+}
+
+uint32_t ESP_CONN_Read(evol ESP_t* ESP, ESP_CONN_t* conn, void* data, uint32_t btr) {
+    uint32_t br;
+    
+    if (!conn || !data) {
+        return 0;
+    }
+    br = BUFFER_Read((BUFFER_t *)&ESP->ConnRx[conn->Number], data, btr);    /* Read data from ring */
+    if (br) {
+        __SYS_SIGNAL(ESP, ESP_SYS_EVENT_UPDATE);            /* Wake up stack if receive was waiting for free memory */
+    }
+    return br;
+}
+#endif                                                      /* ESP_CONN_RX_SIZE */
+
+#if ESP_IPD_POOL_BLOCKS
+uint32_t ESP_PBUF_Free(evol ESP_t* ESP, ESP_PBUF_t* p) {
+    ESP_PBUF_t* last = p;
+    uint32_t cnt = 1;
+    
+    if (!p) {
+        return 0;
+    }
+    while (last->Next) {                                    /* Find last block in chain */
+        last = last->Next;
+        cnt++;
+    }
+    ESP_RTOS_CRITICAL_ENTER();                              /* Free list is used by update thread too */
+    last->Next = ESP->PoolFree;                             /* Return entire chain to free list */
+    ESP->PoolFree = p;
+    ESP->PoolUsed -= cnt;
+    ESP_RTOS_CRITICAL_EXIT();
+    __SYS_SIGNAL(ESP, ESP_SYS_EVENT_UPDATE);                /* Wake up stack if receive was waiting for free block */
+    return cnt;
+}
+
+uint32_t ESP_PBUF_GetMaxUsed(evol ESP_t* ESP) {
+    return ESP->PoolMaxUsed;
+}
+
+uint32_t ESP_PBUF_GetUsed(evol ESP_t* ESP) {
+    return ESP->PoolUsed;
+}
+#endif                                                      /* ESP_IPD_POOL_BLOCKS */
+
 ESP_Result_t ESP_SetSSLBufferSize(evol ESP_t* ESP, uint32_t size, uint32_t blocking) {
     __CHECK_INPUTS(size >= 2048 && size <= 4096);           /* Check inputs */
-    __CHECK_BUSY(ESP);                                      /* Check busy status */
-    __ACTIVE_CMD(ESP, CMD_TCPIP_CIPSSLSIZE);                /* Set active command */
+    __START_CMD(ESP, CMD_TCPIP_CIPSSLSIZE, blocking);       /* Set active command or add it to queue */
 
-    Pointers.UI = size;                                     /* Close all connections */
+    ESP->Params->UI = size;                                 /* Close all connections */
     
     __RETURN_BLOCKING(ESP, blocking, 1000);                 /* Return with blocking support */
 }
@@ -3102,10 +4692,9 @@ ESP_Result_t ESP_SetSSLBufferSize(evol ESP_t* ESP, uint32_t size, uint32_t block
 /***                           Transparent transfer                          **/
 /******************************************************************************/
 ESP_Result_t ESP_TRANSFER_SetMode(evol ESP_t* ESP, ESP_TransferMode_t Mode, uint32_t blocking) {
-    __CHECK_BUSY(ESP);                                      /* Check busy status */
-    __ACTIVE_CMD(ESP, CMD_TCPIP_CIPMODE);                   /* Set active command */
+    __START_CMD(ESP, CMD_TCPIP_CIPMODE, blocking);          /* Set active command or add it to queue */
 
-    Pointers.UI = (uint8_t)Mode;                            /* Close all connections */
+    ESP->Params->UI = (uint8_t)Mode;                        /* Close all connections */
     
     __RETURN_BLOCKING(ESP, blocking, 1000);                 /* Return with blocking support */
 }
@@ -3118,12 +4707,29 @@ ESP_Result_t ESP_TRANSFER_Start(evol ESP_t* ESP, uint32_t blocking) {
     __ACTIVE_CMD(ESP, CMD_TCPIP_CIPSEND);                   /* Set active command */
     
     /* Set up send without parameters, execute only AT+CIPSEND command to start transparent mode */
-    memset((void *)&Pointers, 0x00, sizeof(Pointers));
+    memset((void *)&ESP->Pointers, 0x00, sizeof(ESP->Pointers));
     
     __RETURN_BLOCKING(ESP, blocking, 10000);                /* Return with blocking support */
 }
 
 ESP_Result_t ESP_TRANSFER_Send(evol ESP_t* ESP, const void* data, uint32_t length, uint32_t blocking) {
+#if ESP_TRANSFER_TX_SIZE
+    __CHECK_INPUTS(data && length <= ESP_TRANSFER_TX_SIZE); /* Check inputs */
+    while (ESP->Flags.F.InTransparentMode && BUFFER_GetFree((BUFFER_t *)&ESP->TransferTx) < length) {
+        if (!__IS_BLOCKING(blocking)) {
+            __RETURN(ESP, espBUSY);                         /* Not enough memory in transmit ring */
+        }
+        ESP_Delay(ESP, 1);                                  /* Wait for stack to send data from ring */
+    }
+    if (!ESP->Flags.F.InTransparentMode) {
+        __RETURN(ESP, espERROR);
+    }
+    if (!BUFFER_GetFull((BUFFER_t *)&ESP->TransferTx)) {
+        ESP->TransferTxTime = ESP->Time;                    /* First byte of new packet */
+    }
+    BUFFER_Write((BUFFER_t *)&ESP->TransferTx, data, length);   /* Copy data to transmit ring */
+    __RETURN(ESP, espOK);
+#else
     __CHECK_BUSY(ESP);                                      /* Check busy status */
     if (!ESP->Flags.F.InTransparentMode) {
         return espERROR;
@@ -3131,10 +4737,12 @@ ESP_Result_t ESP_TRANSFER_Send(evol ESP_t* ESP, const void* data, uint32_t lengt
     __ACTIVE_CMD(ESP, CMD_TCPIP_TRANSFER_SEND);             /* Set active command */
     
     UART_SEND((uint8_t *)data, length);                     /* Send data to wifi directly */
+    __STATS_ADD(ESP, Conn[0].BytesSent, length);
     
     ESP->ActiveResult = espOK;                              /* Return OK */
     __IDLE(ESP);
     __RETURN_BLOCKING(ESP, blocking, 1000);                 /* Return with blocking support */
+#endif                                                      /* ESP_TRANSFER_TX_SIZE */
 }
 
 ESP_Result_t ESP_TRANSFER_Stop(evol ESP_t* ESP, uint32_t blocking) {
@@ -3145,37 +4753,34 @@ ESP_Result_t ESP_TRANSFER_Stop(evol ESP_t* ESP, uint32_t blocking) {
     
     __RETURN_BLOCKING(ESP, blocking, 5000);                 /* Return with blocking support */
 }
-#endif /* ESP_SINGLE_CONN */
+#endif                                                      /* ESP_SINGLE_CONN */
 
 /******************************************************************************/
 /***                              SNTP API                                   **/
 /******************************************************************************/
 ESP_Result_t ESP_SNTP_SetConfig(evol ESP_t* ESP, const ESP_SNTP_t* sntp, uint32_t blocking) {
     __CHECK_INPUTS(sntp && (!sntp->Enable || (sntp->Enable && sntp->Timezone >= -11 && sntp->Timezone <= 13))); /* Check input parameters */
-    __CHECK_BUSY(ESP);                                      /* Check busy status */
-    __ACTIVE_CMD(ESP, CMD_TCPIP_SNTPSETCFG);                /* Set active command */
+    __START_CMD(ESP, CMD_TCPIP_SNTPSETCFG, blocking);       /* Set active command or add it to queue */
     
-    Pointers.CPtr1 = sntp;
+    ESP->Params->CPtr1 = sntp;
     
     __RETURN_BLOCKING(ESP, blocking, 1000);                 /* Return with blocking support */
 }
 
 ESP_Result_t ESP_SNTP_GetConfig(evol ESP_t* ESP, ESP_SNTP_t* sntp, uint32_t blocking) {
     __CHECK_INPUTS(sntp);                                   /* Check input parameters */
-    __CHECK_BUSY(ESP);                                      /* Check busy status */
-    __ACTIVE_CMD(ESP, CMD_TCPIP_SNTPGETCFG);                /* Set active command */
+    __START_CMD(ESP, CMD_TCPIP_SNTPGETCFG, blocking);       /* Set active command or add it to queue */
     
-    Pointers.Ptr1 = sntp;
+    ESP->Params->Ptr1 = sntp;
     
     __RETURN_BLOCKING(ESP, blocking, 1000);                 /* Return with blocking support */
 }
 
 ESP_Result_t ESP_SNTP_GetDateTime(evol ESP_t* ESP, ESP_DateTime_t* dt, uint32_t blocking) {
     __CHECK_INPUTS(dt);                                     /* Check input parameters */
-    __CHECK_BUSY(ESP);                                      /* Check busy status */
-    __ACTIVE_CMD(ESP, CMD_TCPIP_CIPSNTPTIME);               /* Set active command */
+    __START_CMD(ESP, CMD_TCPIP_CIPSNTPTIME, blocking);      /* Set active command or add it to queue */
     
-    Pointers.Ptr1 = dt;
+    ESP->Params->Ptr1 = dt;
     
     __RETURN_BLOCKING(ESP, blocking, 1000);                 /* Return with blocking support */
 }
@@ -3185,22 +4790,20 @@ ESP_Result_t ESP_SNTP_GetDateTime(evol ESP_t* ESP, ESP_DateTime_t* dt, uint32_t
 /******************************************************************************/
 ESP_Result_t ESP_DNS_SetConfig(evol ESP_t* ESP, const ESP_DNS_t* dns, uint8_t def, uint32_t blocking) {    
     __CHECK_INPUTS(dns);                                    /* Check inputs */
-    __CHECK_BUSY(ESP);                                      /* Check busy status */
-    __ACTIVE_CMD(ESP, CMD_TCPIP_CIPSETDNS);                 /* Set active command */
+    __START_CMD(ESP, CMD_TCPIP_CIPSETDNS, blocking);        /* Set active command or add it to queue */
 
-    Pointers.CPtr1 = def ? FROMMEM("DEF") : FROMMEM("CUR");
-    Pointers.CPtr2 = dns;
+    ESP->Params->CPtr1 = def ? FROMMEM("DEF") : FROMMEM("CUR");
+    ESP->Params->CPtr2 = dns;
     
     __RETURN_BLOCKING(ESP, blocking, 1000);                 /* Return with blocking support */
 }
 
 ESP_Result_t ESP_DNS_GetConfig(evol ESP_t* ESP, ESP_DNS_t* dns, uint8_t def, uint32_t blocking) {
     __CHECK_INPUTS(dns);                                    /* Check inputs */
-    __CHECK_BUSY(ESP);                                      /* Check busy status */
-    __ACTIVE_CMD(ESP, CMD_TCPIP_CIPGETDNS);                 /* Set active command */
+    __START_CMD(ESP, CMD_TCPIP_CIPGETDNS, blocking);        /* Set active command or add it to queue */
 
-    Pointers.CPtr1 = def ? FROMMEM("DEF") : FROMMEM("CUR");
-    Pointers.Ptr1 = dns;
+    ESP->Params->CPtr1 = def ? FROMMEM("DEF") : FROMMEM("CUR");
+    ESP->Params->Ptr1 = dns;
     dns->_ptr = 0;
     
     __RETURN_BLOCKING(ESP, blocking, 1000);                 /* Return with blocking support */
@@ -3208,11 +4811,10 @@ ESP_Result_t ESP_DNS_GetConfig(evol ESP_t* ESP, ESP_DNS_t* dns, uint8_t def, uin
 
 ESP_Result_t ESP_DNS_GetIp(evol ESP_t* ESP, const char* domain, uint8_t* ip, uint32_t blocking) {
     __CHECK_INPUTS(ip);                                     /* Check inputs */
-    __CHECK_BUSY(ESP);                                      /* Check busy status */
-    __ACTIVE_CMD(ESP, CMD_TCPIP_CIPDOMAIN);                 /* Set active command */
+    __START_CMD(ESP, CMD_TCPIP_CIPDOMAIN, blocking);        /* Set active command or add it to queue */
 
-    Pointers.CPtr1 = domain;
-    Pointers.Ptr1 = ip;
+    ESP->Params->CPtr1 = domain;
+    ESP->Params->Ptr1 = ip;
     
     __RETURN_BLOCKING(ESP, blocking, 10000);                /* Return with blocking support */
 }
@@ -3222,59 +4824,59 @@ ESP_Result_t ESP_DNS_GetIp(evol ESP_t* ESP, const char* domain, uint8_t* ip, uin
 /******************************************************************************/
 ESP_Result_t ESP_Ping(evol ESP_t* ESP, const char* addr, uint32_t* time, uint32_t blocking) {
     __CHECK_INPUTS(addr && time);                           /* Check inputs */
-    __CHECK_BUSY(ESP);                                      /* Check busy status */
-    __ACTIVE_CMD(ESP, CMD_TCPIP_PING);                      /* Set active command */
+    __START_CMD(ESP, CMD_TCPIP_PING, blocking);             /* Set active command or add it to queue */
 
     *time = 0;
-    Pointers.CPtr1 = addr;
-    Pointers.Ptr1 = time;
+    ESP->Params->CPtr1 = addr;
+    ESP->Params->Ptr1 = time;
     
     __RETURN_BLOCKING(ESP, blocking, 10000);                /* Return with blocking support */
 }
 
 ESP_Result_t ESP_SetWPS(evol ESP_t* ESP, uint8_t wps, uint32_t blocking) {
-    __CHECK_BUSY(ESP);                                      /* Check busy status */
-    __ACTIVE_CMD(ESP, CMD_WIFI_WPS);                        /* Set active command */
+    __START_CMD(ESP, CMD_WIFI_WPS, blocking);               /* Set active command or add it to queue */
 
-    Pointers.UI = wps ? 1 : 0;
+    ESP->Params->UI = wps ? 1 : 0;
     
     __RETURN_BLOCKING(ESP, blocking, 1000);                 /* Return with blocking support */
 }
 
 ESP_Result_t ESP_SetHostName(evol ESP_t* ESP, const char* hostname, uint32_t blocking) {
     __CHECK_INPUTS(hostname);                               /* Check inputs */
-    __CHECK_BUSY(ESP);                                      /* Check busy status */
-    __ACTIVE_CMD(ESP, CMD_WIFI_SETHOSTNAME);                /* Set active command */
+    __START_CMD(ESP, CMD_WIFI_SETHOSTNAME, blocking);       /* Set active command or add it to queue */
 
-    Pointers.CPtr1 = hostname;
+    ESP->Params->CPtr1 = hostname;
     
     __RETURN_BLOCKING(ESP, blocking, 1000);                 /* Return with blocking support */
 }
 
 ESP_Result_t ESP_GetHostName(evol ESP_t* ESP, char* hostname, uint32_t blocking) {
     __CHECK_INPUTS(hostname);                               /* Check inputs */
-    __CHECK_BUSY(ESP);                                      /* Check busy status */
-    __ACTIVE_CMD(ESP, CMD_WIFI_GETHOSTNAME);                /* Set active command */
+    __START_CMD(ESP, CMD_WIFI_GETHOSTNAME, blocking);       /* Set active command or add it to queue */
 
-    Pointers.Ptr1 = hostname;
+    ESP->Params->Ptr1 = hostname;
     
     __RETURN_BLOCKING(ESP, blocking, 1000);                 /* Return with blocking support */
 }
 
 void ESP_AssertRTS(evol ESP_t* ESP) {
-    uint8_t state = ESP_RTS_SET;
+    ESP_LL_Pin_t state;
     uint8_t result = 1;
     
+    state.State = ESP_RTS_SET;
+    state.LL = (ESP_LL_t *)&ESP->LL;
     ESP->Flags.F.RTSForced = 1;
     ESP_LL_Callback(ESP_LL_Control_SetRTS, &state, &result);
 }
 
 void ESP_DesertRTS(evol ESP_t* ESP) {
     if (ESP->Flags.F.RTSForced) {
-        uint8_t state = ESP_RTS_CLR;
+        ESP_LL_Pin_t state;
         uint8_t result = 1;
         
+        state.State = ESP_RTS_CLR;
+        state.LL = (ESP_LL_t *)&ESP->LL;
         ESP_LL_Callback(ESP_LL_Control_SetRTS, &state, &result);
-        ESP->Flags.F.RTSForced = 1;
+        ESP->Flags.F.RTSForced = 0;
     }
 }
@@ -97,7 +97,92 @@ extern "C" {
 #define ESP_ECHO                    0   /*!< Echo mode */
 #endif
 
+/* Check command staging buffer size */
+#if !defined(ESP_TX_BUFFER_SIZE)
+#define ESP_TX_BUFFER_SIZE          128 /*!< Command staging buffer size */
+#endif
+
+/* Check command queue size */
+#if !defined(ESP_CMD_QUEUE_SIZE)
+#define ESP_CMD_QUEUE_SIZE          4   /*!< Number of commands waiting for execution */
+#endif
+
+/* Check number of requests */
+#if !defined(ESP_REQUEST_COUNT)
+#define ESP_REQUEST_COUNT           4   /*!< Number of requests which may be registered */
+#endif
+
+/* Check event queue size */
+#if !defined(ESP_EVENT_QUEUE_SIZE)
+#define ESP_EVENT_QUEUE_SIZE        16  /*!< Number of events waiting for callback */
+#endif
+
+/* Check transparent mode transmit ring size */
+#if !defined(ESP_TRANSFER_TX_SIZE)
+#define ESP_TRANSFER_TX_SIZE        0   /*!< Transparent mode transmit ring size, 0 when disabled */
+#endif
+
+/* Check connection receive ring size */
+#if !defined(ESP_CONN_RX_SIZE)
+#define ESP_CONN_RX_SIZE            0   /*!< Connection receive ring size, 0 when disabled */
+#endif
+
+/* Check IPD block pool size */
+#if !defined(ESP_IPD_POOL_BLOCKS)
+#define ESP_IPD_POOL_BLOCKS         0   /*!< Number of blocks in IPD block pool, 0 when disabled */
+#endif
+#if !defined(ESP_IPD_POOL_BLOCK_SIZE)
+#define ESP_IPD_POOL_BLOCK_SIZE     256 /*!< Size of single block in IPD block pool */
+#endif
+
+#if ESP_CONN_RX_SIZE && ESP_CONN_SINGLEBUFFER
+#error "ESP_CONN_RX_SIZE can not be used together with ESP_CONN_SINGLEBUFFER"
+#endif
+#if ESP_IPD_POOL_BLOCKS && (ESP_CONN_RX_SIZE || ESP_CONN_SINGLEBUFFER)
+#error "ESP_IPD_POOL_BLOCKS can not be used together with ESP_CONN_RX_SIZE or ESP_CONN_SINGLEBUFFER"
+#endif
+#if BUFFER_SPSC && (ESP_BUFFER_SIZE & (ESP_BUFFER_SIZE - 1))
+#error "ESP_BUFFER_SIZE must be power of 2 when BUFFER_SPSC is enabled"
+#endif
+#if BUFFER_SPSC && (ESP_TRANSFER_TX_SIZE & (ESP_TRANSFER_TX_SIZE - 1))
+#error "ESP_TRANSFER_TX_SIZE must be power of 2 when BUFFER_SPSC is enabled"
+#endif
+#if BUFFER_SPSC && (ESP_CONN_RX_SIZE & (ESP_CONN_RX_SIZE - 1))
+#error "ESP_CONN_RX_SIZE must be power of 2 when BUFFER_SPSC is enabled"
+#endif
+
+/* Check baudrate negotiation */
+#if !defined(ESP_AUTOBAUD)
+#define ESP_AUTOBAUD                0   /*!< Baudrate negotiation at initialization, disabled by default */
+#endif
+#if !defined(ESP_AUTOBAUD_LIST)
+#define ESP_AUTOBAUD_LIST           230400, 460800, 921600  /*!< Baudrates to try in ascending order */
+#endif
+#if !defined(ESP_AUTOBAUD_CHECKS)
+#define ESP_AUTOBAUD_CHECKS         10  /*!< Number of AT commands to check link at new baudrate */
+#endif
+#if !defined(ESP_AUTOBAUD_GARBAGE)
+#define ESP_AUTOBAUD_GARBAGE        0   /*!< Maximal number of invalid characters allowed during link check */
+#endif
+
+/* Check statistics */
+#if !defined(ESP_STATS)
+#define ESP_STATS                   0   /*!< Statistics of stack, disabled by default */
+#endif
+#if !defined(ESP_STATS_CMDS)
+#define ESP_STATS_CMDS              16  /*!< Number of commands latency histograms are saved for */
+#endif
+
+/* Check number of segments in module send buffer */
+#if !defined(ESP_SENDBUF_SEGMENTS)
+#define ESP_SENDBUF_SEGMENTS        4   /*!< Number of segments waiting in module send buffer per connection */
+#endif
+
 /* Public defines */
+#define ESP_EVENT_NO_CONN           0xFF                /*!< Event does not belong to connection */
+#define ESP_STATS_BINS              12                  /*!< Number of bins in command latency histogram */
+#define ESP_SNTP_ADDR_SIZE          64                  /*!< Default size of memory for SNTP server address, see \ref ESP_SNTP_t */
+#define ESP_DEADLINE_NONE           (0xFFFFFFFFUL)      /*!< Stack does not need to be processed because of time */
 #define ESP_MIN_BAUDRATE            (110UL)             /*!< Minimum baud for UART communication */
 #define ESP_MAX_BAUDRATE            (4608000UL)         /*!< Maximum baud for UART communication */
 
@@ -196,6 +281,8 @@ typedef enum _ESP_Event_t {
     espEventDataSent,                                   /*!< Data were sent on connection */
     espEventDataSentError,                              /*!< Error trying to sent data on connection */
     espEventTransparentReceived,                        /*!< Byte has been received from transparent connection mode */
+    espEventDataSegmentSent,                            /*!< Segment added with \ref ESP_CONN_SendBuf was sent, segment ID is in UI parameter */
+    espEventDataSegmentSentError,                       /*!< Segment added with \ref ESP_CONN_SendBuf failed to send, segment ID is in UI parameter */
 } ESP_Event_t;
 
 /**
@@ -205,13 +292,72 @@ typedef struct _ESP_EventParams_t {
     const void* CP1;                                    /*!< Constant void pointer number 1 */
     const void* CP2;                                    /*!< Constant void pointer number 2 */
     uint32_t UI;                                        /*!< Unsigned integer value */
+    uint32_t Time;                                      /*!< Time in units of milliseconds when event happened */
 } ESP_EventParams_t;
 
+/**
+ * \brief           Pending event structure
+ * \note            For internal use only
+ */
+typedef struct _ESP_EventEntry_t {
+    uint8_t Event;                                      /*!< Event, member of \ref ESP_Event_t enumeration */
+    uint8_t Conn;                                       /*!< Connection number or \ref ESP_EVENT_NO_CONN for global events */
+    uint32_t Time;                                      /*!< Time when event happened */
+    uint32_t Value;                                     /*!< Event specific value, passed as UI parameter */
+} ESP_EventEntry_t;
+
+/**
+ * \brief           Block of received data from IPD block pool
+ * \note            Blocks of received packet are linked to chain with Next member
+ */
+typedef struct _ESP_PBUF_t {
+    struct _ESP_PBUF_t* Next;                           /*!< Next block in chain or NULL for last block */
+    uint16_t Len;                                       /*!< Number of valid bytes in block */
+    uint8_t Data[ESP_IPD_POOL_BLOCK_SIZE];              /*!< Block data */
+} ESP_PBUF_t;
+
+/**
+ * \brief           Buffer descriptor for \ref ESP_CONN_SendVector function
+ */
+typedef struct _ESP_SendVec_t {
+    const void* Data;                                   /*!< Pointer to data to send */
+    uint32_t Len;                                       /*!< Number of bytes in buffer */
+} ESP_SendVec_t;
+
+/**
+ * \brief           Received blocks of connection waiting for callback
+ * \note            For internal use only
+ */
+typedef struct _ESP_PBUF_Queue_t {
+    ESP_PBUF_t* First;                                  /*!< First received block */
+    ESP_PBUF_t* Last;                                   /*!< Last received block, new data are added to it */
+    ESP_PBUF_t* Ready;                                  /*!< Last block of data already reported with event */
+} ESP_PBUF_Queue_t;
+
 /**
  * \brief           Callback function prototype
  */
 typedef int (*ESP_EventCallback_t)(ESP_Event_t, ESP_EventParams_t *);
 
+/**
+ * \brief           Request structure to track result of single command
+ * \note            Structure is owned by user and must stay valid until stack is initialized again
+ */
+typedef struct _ESP_Request_t {
+    evol ESP_Result_t Result;                           /*!< Result of finished command */
+    evol uint8_t Done;                                  /*!< Set to 1 when command finished and result is valid */
+    void (*Cb)(struct _ESP_Request_t *);                /*!< Function called when command finished. Can be set to NULL */
+    void* Arg;                                          /*!< Custom user argument */
+    uint8_t Id;                                         /*!< Request number passed as blocking parameter. For internal use only */
+} ESP_Request_t;
+
+/**
+ * \brief           Passes request to API function instead of blocking parameter
+ * \note            Command started with request is non-blocking
+ * \param[in]       req: Pointer to \ref ESP_Request_t structure registered with \ref ESP_RequestInit
+ */
+#define ESP_REQUEST(req)            ((uint32_t)(req)->Id)
+
 /**
  * \brief           Connection type
  */
@@ -230,12 +376,16 @@ typedef struct _ESP_CONN_t {
 	uint8_t RemoteIP[4];                                /*!< IP address of device */
     uint16_t LocalPort;                                 /*!< Local PORT number */
 	ESP_CONN_Type_t Type;                               /*!< Connection type. Parameter is valid only if connection is made as client */
-#if ESP_CONN_SINGLEBUFFER
+#if ESP_CONN_RX_SIZE || ESP_IPD_POOL_BLOCKS
+    /* Received data are stored to connection receive ring or block pool in ESP_t structure */
+#elif ESP_CONN_SINGLEBUFFER
     uint8_t* Data;                                      /*!< Pointer to data array */
 #else
     uint8_t Data[ESP_CONNBUFFER_SIZE + 1];              /*!< Received data on connection */
 #endif
+#if !ESP_CONN_RX_SIZE && !ESP_IPD_POOL_BLOCKS
     uint16_t DataLength;                                /*!< Number of bytes received in connection packet */
+#endif /* !ESP_CONN_RX_SIZE && !ESP_IPD_POOL_BLOCKS */
     
     uint32_t TotalBytesReceived;                        /*!< Number of total bytes so far received on connection */
     uint32_t DataStartTime;                             /*!< Current time in units of milliseconds when first data packet was received on connection */
@@ -249,10 +399,6 @@ typedef struct _ESP_CONN_t {
 	} Flags;                                            /*!< Connection flags management */
     union {
         struct {
-            int Connect:1;                              /*!< Connection was just connected, client or server */
-            int Closed:1;                               /*!< Connection was just disconnected, client or server */
-            int DataSent:1;                             /*!< Data were sent successfully */
-            int DataError:1;                            /*!< Error trying to send data */
             int CallLastPartOfPacketReceived:1;         /*!< Data are processed synchronously. When there is last part of packet received and command is not idle, we must save notification for callback */
         } F;
         int Value;
@@ -263,6 +409,10 @@ typedef struct _ESP_CONN_t {
     
     uint32_t PollTimeInterval;                          /*!< Interval for poll callback when connection is active but nothing happens to it */
     uint32_t PollTime;                                  /*!< Internal next poll time */
+    
+    uint32_t SendSegment;                               /*!< ID of last segment added to module send buffer */
+    uint32_t SendSegmentAck;                            /*!< ID of last segment module reported as sent */
+    uint32_t SendBufferFree;                            /*!< Free module send buffer in units of bytes, updated with \ref ESP_CONN_GetBufferStatus */
 } ESP_CONN_t;
 
 /**
@@ -384,6 +534,8 @@ typedef struct _ESP_SNTP_t {
                                                             \note When using structure for reading, 
                                                                     these pointers must be prefilled with valid memory to save data
                                                                     to or set to NULL if entires should be ignored when reading */
+    uint8_t AddrSize;                                   /*!< Size of memory each Addr pointer points to when reading, including string termination.
+                                                            Set to 0 to use \ref ESP_SNTP_ADDR_SIZE bytes. Longer addresses are truncated */
 } ESP_SNTP_t;
 
 /**
@@ -395,11 +547,135 @@ typedef struct _ESP_DNS_t {
     uint8_t Addr[2][4];                                 /*!< Memory for 2 IP addresses for DNS */
 } ESP_DNS_t;
 
+/**
+ * \brief           Received line structure
+ * \note            For internal use only
+ */
+typedef struct _ESP_Received_t {
+    uint8_t Length;                                     /*!< Number of characters in line */
+    uint8_t Data[128];                                  /*!< Line data */
+} ESP_Received_t;
+
+/**
+ * \brief           Streaming response tokenizer structure
+ * \note            For internal use only
+ */
+typedef struct _ESP_Tokenizer_t {
+    uint8_t Type;                                       /*!< Type of response being tokenized, 0 when not active */
+    uint8_t Field;                                      /*!< Index of current field in response */
+    uint8_t Length;                                     /*!< Number of characters written to current string field */
+    uint8_t Part;                                       /*!< Index of current part of MAC address */
+    int32_t Number;                                     /*!< Value of current number field or address part */
+    union {
+        struct {
+            uint8_t Quoted:1;                           /*!< Tokenizer is inside quoted string */
+            uint8_t QuoteEnd:1;                         /*!< Quote received inside quoted string, may be end of string */
+            uint8_t Negative:1;                         /*!< Number in current field is negative */
+            uint8_t Done:1;                             /*!< All fields were processed */
+        } F;
+        uint8_t Value;                                  /*!< Value of entire union */
+    } Flags;                                            /*!< Tokenizer flags */
+} ESP_Tokenizer_t;
+
+/**
+ * \brief           Command parameters structure
+ * \note            For internal use only
+ */
+typedef struct _ESP_Pointers_t {
+    evol const void* CPtr1;                             /*!< Constant pointer parameter */
+    evol const void* CPtr2;                             /*!< Constant pointer parameter */
+    evol const void* CPtr3;                             /*!< Constant pointer parameter */
+    evol void* Ptr1;                                    /*!< Pointer parameter */
+    evol void* Ptr2;                                    /*!< Pointer parameter */
+    evol void** PPtr1;                                  /*!< Pointer to pointer parameter */
+    evol uint32_t UI;                                   /*!< Number parameter */
+} ESP_Pointers_t;
+
+/**
+ * \brief           Queued command structure
+ * \note            For internal use only
+ */
+typedef struct _ESP_Command_t {
+    uint16_t Cmd;                                       /*!< Command to execute */
+    uint32_t Timeout;                                   /*!< Timeout in units of MS for command to finish */
+    ESP_Request_t* Request;                             /*!< Request to notify when command finishes */
+    ESP_Pointers_t Pointers;                            /*!< Parameters of command */
+} ESP_Command_t;
+
+/**
+ * \brief           Module informations kept between sessions for faster initialization
+ * \note            Application stores structure to non-volatile memory and passes it to \ref ESP_InitEx.
+ *                  Stack sets Magic member to 0 when it changes cached settings with API functions, store structure again after that.
+ *                  Set Magic member to 0 to force full initialization, for example after module settings were changed by other means
+ */
+typedef struct _ESP_InitCache_t {
+    uint32_t Magic;                                     /*!< Valid cache marker, set by stack */
+    uint8_t STAMAC[6];                                  /*!< MAC address for station of ESP module */
+    uint8_t APMAC[6];                                   /*!< MAC address for softAP of ESP module */
+    uint8_t APIP[4];                                    /*!< IP address for softAP of ESP module */
+    uint8_t APGateway[4];                               /*!< Gateway address for softAP */
+    uint8_t APNetmask[4];                               /*!< Netmask address for softAP */
+    ESP_APConfig_t APConf;                              /*!< Soft AP configuration */
+} ESP_InitCache_t;
+
+/**
+ * \brief           Duration of initialization phases in units of milliseconds
+ */
+typedef struct _ESP_InitTimes_t {
+    uint32_t Reset;                                     /*!< Module reset until ready message */
+    uint32_t Setup;                                     /*!< Link check and commands which set module mode */
+    uint32_t Query;                                     /*!< Reading of module informations */
+    uint32_t Total;                                     /*!< Entire initialization */
+    uint8_t Cached;                                     /*!< Set to 1 when module informations were taken from cache */
+} ESP_InitTimes_t;
+
+/**
+ * \brief           Latency statistics of single command
+ * \note            Latency is measured from command start to OK or ERROR response.
+ *                  Commands sending data to connection report time until module is ready for data.
+ */
+typedef struct _ESP_CmdStats_t {
+    uint16_t Cmd;                                       /*!< Command identifier, 0x1xxx for basic, 0x2xxx for wifi and 0x3xxx for TCP/IP commands. Set to 0 when entry is not used */
+    uint16_t Errors;                                    /*!< Number of commands finished with ERROR response or timeout */
+    uint32_t Count;                                     /*!< Number of finished commands */
+    uint32_t Total;                                     /*!< Sum of latencies in units of milliseconds */
+    uint32_t Max;                                       /*!< Maximal latency in units of milliseconds */
+    uint16_t Bins[ESP_STATS_BINS];                      /*!< Latency histogram. Bin 0 counts latencies below 1 ms, bin n counts latencies from 2^(n-1) to 2^n - 1 ms and last bin all longer latencies */
+} ESP_CmdStats_t;
+
+/**
+ * \brief           Traffic statistics of single connection
+ * \note            Calculate throughput from difference of two snapshots divided by difference of their Time members
+ */
+typedef struct _ESP_ConnStats_t {
+    uint32_t BytesSent;                                 /*!< Number of bytes successfully sent */
+    uint32_t BytesReceived;                             /*!< Number of bytes received from network */
+} ESP_ConnStats_t;
+
+/**
+ * \brief           Statistics of stack, see \ref ESP_GetStats
+ */
+typedef struct _ESP_Stats_t {
+    uint32_t Time;                                      /*!< Stack time when snapshot was taken */
+    uint32_t UARTBytesIn;                               /*!< Number of bytes received from module and written to USART input buffer */
+    uint32_t UARTBytesOut;                              /*!< Number of bytes sent to module */
+    uint32_t RxBufferMax;                               /*!< Maximal number of bytes waiting in USART input buffer */
+    uint32_t RxOverflow;                                /*!< Number of received bytes lost because USART input buffer was full */
+    uint32_t Garbage;                                   /*!< Number of received characters which are not valid ASCII */
+    uint32_t SendRetries;                               /*!< Number of packets sent again after SEND FAIL or full module buffer */
+    uint32_t SendFail;                                  /*!< Number of SEND FAIL responses */
+    uint32_t Timeouts;                                  /*!< Number of commands without response in timeout */
+    uint32_t CmdLost;                                   /*!< Number of finished commands not saved because all entries were used */
+    ESP_ConnStats_t Conn[ESP_MAX_CONNECTIONS];          /*!< Traffic of each connection */
+    ESP_CmdStats_t Cmd[ESP_STATS_CMDS];                 /*!< Latency of each command in order commands were first used */
+} ESP_Stats_t;
+
 /**
  * \brief           Main ESP8266 working structure
  */
 typedef struct _ESP_t {
     evol uint32_t Time;                                 /*!< Current time in units of milliseconds */
+    uint32_t TimeBase;                                  /*!< Last absolute timestamp set with \ref ESP_SetTime */
     evol ESP_Result_t RetVal;                           /*!< Return value */
     
     /*!< Low-Level management */
@@ -437,6 +713,16 @@ typedef struct _ESP_t {
 	ESP_CONN_t Conn[ESP_MAX_CONNECTIONS];               /*!< Array of connections */
     uint8_t ActiveConns;                                /*!< Bit variable of active connections on ESP8266 from CIPSTATUS response */
     uint8_t ActiveConnsResp;                            /*!< List of active connections */
+#if ESP_CONN_RX_SIZE
+    BUFFER_t ConnRx[ESP_MAX_CONNECTIONS];               /*!< Receive ring for each connection */
+#endif /* ESP_CONN_RX_SIZE */
+#if ESP_IPD_POOL_BLOCKS
+    ESP_PBUF_t Pool[ESP_IPD_POOL_BLOCKS];               /*!< Blocks for received data of all connections */
+    ESP_PBUF_t* PoolFree;                               /*!< List of free blocks */
+    uint16_t PoolUsed;                                  /*!< Number of blocks currently in use */
+    uint16_t PoolMaxUsed;                               /*!< Maximal number of blocks in use at the same time */
+    ESP_PBUF_Queue_t ConnPbuf[ESP_MAX_CONNECTIONS];     /*!< Received blocks for each connection */
+#endif /* ESP_IPD_POOL_BLOCKS */
     
     /*!< Incoming data structure */
     ESP_IPD_t IPD;                                      /*!< IPD network data structure */
@@ -444,6 +730,12 @@ typedef struct _ESP_t {
 #if ESP_SINGLE_CONN
     /*!< Transfer mode */
     ESP_TransferMode_t TransferMode;                    /*!< Data transfer mode in use */
+    uint8_t TransferCloseMatch;                         /*!< Number of matched characters of connection close marker in transparent mode */
+#if ESP_TRANSFER_TX_SIZE
+    BUFFER_t TransferTx;                                /*!< Transparent mode transmit ring */
+    uint8_t TransferTxData[ESP_TRANSFER_TX_SIZE + 1];   /*!< Transparent mode transmit ring data array */
+    uint32_t TransferTxTime;                            /*!< Time when first byte of current packet was added to transmit ring */
+#endif /* ESP_TRANSFER_TX_SIZE */
 #endif
 
 	union {
@@ -452,21 +744,26 @@ typedef struct _ESP_t {
             int Call_Idle:1;                            /*!< Status whether idle status event should be called before we can proceed with another action */
             int InTransparentMode:1;                    /*!< Status whether we are currently in transparent mode and transfer is active */
             int RTSForced:1;                            /*!< Status whether RTS pin was forced by user */
+            int TimeBaseSet:1;                          /*!< Status whether absolute timestamp was set with \ref ESP_SetTime */
+            int RxStalled:1;                            /*!< Status whether receive waits for user to read data, command timeout is suspended */
 		} F;
 		int Value;
 	} Flags;                                            /*!< Flags for library purpose */
     
     /*!< Callback management */
-    union {
-        struct {
-            int WifiConnected:1;                        /*!< Wifi just got connected */
-            int WifiDisconnected:1;                     /*!< Wifi just got disconnected */
-            int WifiGotIP:1;                            /*!< Wifi station just got IP address */
-        } F;
-        int Value;
-    } CallbackFlags;                                    /*!< List of global flags for callback events */
+    ESP_EventEntry_t EventQueue[ESP_EVENT_QUEUE_SIZE];  /*!< Events waiting for callback in order they happened */
+    uint32_t EventIn;                                   /*!< Index of next free entry in event queue, modified by \ref ESP_Update only */
+    uint32_t EventOut;                                  /*!< Index of next event to process, modified by \ref ESP_ProcessCallbacks only */
+    uint8_t EventDataPending;                           /*!< Bit mask of connections with data event waiting for free entry in event queue */
+    uint32_t EventDataValue[ESP_MAX_CONNECTIONS];       /*!< Value of data events waiting for free entry in event queue */
+    evol uint32_t EventOverflow;                        /*!< Number of events lost because queue was full */
     ESP_EventCallback_t Callback;                       /*!< Pointer to callback function */
     ESP_EventParams_t CallbackParams;                   /*!< Callback parameters */
+    ESP_Request_t* Requests[ESP_REQUEST_COUNT];         /*!< Requests registered with \ref ESP_RequestInit */
+    ESP_Request_t* ActiveRequest;                       /*!< Request of active command */
+    uint8_t DoneQueue[ESP_REQUEST_COUNT];               /*!< Numbers of finished requests waiting for notification */
+    uint32_t DoneIn;                                    /*!< Index of next free entry in finished requests, modified by \ref ESP_Update only */
+    uint32_t DoneOut;                                   /*!< Index of next finished request, modified by \ref ESP_ProcessCallbacks only */
     
     /*!< Events management with receive interaction */
     union {
@@ -482,6 +779,7 @@ typedef struct _ESP_t {
             int RespCloseOk:1;                          /*!< n, CLOSE OK was returned from device */
             int RespSendOk:1;                           /*!< n, SEND OK was returned from device */
             int RespSendFail:1;                         /*!< n, SEND FAIL was returned from device */
+            int RespRecv:1;                             /*!< Recv n bytes was returned from device */
             
             int RespWifiConnected:1;
             int RespWifiDisconnected:1;
@@ -489,6 +787,52 @@ typedef struct _ESP_t {
         } F;
         int Value;                                      /*!< Value containing all the flags in single memory */
     } Events;                                           /*!< Union holding all the required events for library internal processing */
+    
+    /*!< Processing state, for internal use only */
+    BUFFER_t Buffer;                                    /*!< Receive buffer structure */
+    uint8_t BufferData[ESP_BUFFER_SIZE + 1];            /*!< Receive buffer data array */
+    ESP_Received_t Received;                            /*!< Received line structure */
+    ESP_Tokenizer_t Tokenizer;                          /*!< Tokenizer for responses processed while receiving */
+    ESP_Pointers_t Pointers;                            /*!< Parameters of active command */
+    evol ESP_Pointers_t* Params;                        /*!< Parameters of command being set by API call */
+#if ESP_CMD_QUEUE_SIZE
+    ESP_Command_t Queue[ESP_CMD_QUEUE_SIZE];            /*!< Commands waiting for execution */
+    uint32_t QueueIn;                                   /*!< Index of next free entry in queue, modified by API calls only */
+    uint32_t QueueOut;                                  /*!< Index of next command to execute, modified by \ref ESP_Update only */
+#endif /* ESP_CMD_QUEUE_SIZE */
+#if ESP_CONN_SINGLEBUFFER
+    uint8_t IPDData[ESP_CONNBUFFER_SIZE + 1];           /*!< Data buffer for incoming connection */
+#endif /* ESP_CONN_SINGLEBUFFER */
+    char Prev1Ch;                                       /*!< Last processed character from receive buffer */
+    char Prev2Ch;                                       /*!< Character processed before last one */
+    
+    struct pt PT_BASIC;                                 /*!< Basic commands protothread */
+    struct pt PT_WIFI;                                  /*!< Wifi commands protothread */
+    struct pt PT_TCPIP;                                 /*!< TCPIP commands protothread */
+    uint32_t ThreadTime;                                /*!< Start time of delay in protothread */
+    uint32_t ThreadDelay;                               /*!< Duration of delay in protothread, 0 when not waiting */
+    uint32_t RxStallTime;                               /*!< Time of last update while receive was stalled */
+    uint32_t SendLength;                                /*!< Number of bytes in current CIPSEND packet */
+    uint8_t SendTries;                                  /*!< Number of tries left to send current packet */
+    uint32_t SendAck;                                   /*!< Last sent segment ID when module send buffer was full */
+    
+    ESP_LL_Send_t Send;                                 /*!< Send data setup */
+    uint8_t TXData[ESP_TX_BUFFER_SIZE];                 /*!< Command staging buffer */
+    uint16_t TXLength;                                  /*!< Number of bytes waiting in staging buffer */
+    uint32_t UARTGarbage;                               /*!< Number of received characters which are not valid ASCII */
+    ESP_InitCache_t* InitCache;                         /*!< Cache of module informations used on initialization */
+    ESP_InitTimes_t InitTimes;                          /*!< Duration of last initialization phases */
+#if ESP_STATS
+    ESP_Stats_t Stats;                                  /*!< Statistics of stack */
+    uint16_t StatsCmd;                                  /*!< Command waiting for response to save its latency */
+    uint32_t StatsCmdStart;                             /*!< Time when command waiting for response started */
+#endif /* ESP_STATS */
+#if ESP_AUTOBAUD
+    uint32_t InitBaudrate;                              /*!< Baudrate module uses after reset */
+#endif /* ESP_AUTOBAUD */
+#if ESP_USE_CTS
+    uint8_t RTSStatus;                                  /*!< RTS pin status */
+#endif /* ESP_USE_CTS */
 } ESP_t;
 
 /**
@@ -503,13 +847,30 @@ typedef struct _ESP_t {
 
 /**
  * \brief           Initializes ESP stack and prepares device to working state
+ * \note            When \ref ESP_AUTOBAUD is enabled, baudrate is raised to the highest reliable value from \ref ESP_AUTOBAUD_LIST.
+ *                  Module returns to initial baudrate after reset, call \ref ESP_ReInit after reset to negotiate it again
  * \param[in,out]   *ESP: Pointer to working \ref ESP_t structure
- * \param[in]       baudrate: Baudrate for UART to communicate with ESP8266 module
+ * \param[in]       baudrate: Baudrate module uses after reset for UART to communicate with ESP8266 module
  * \param[in]       callback: Pointer to callback function stack will use to notify user about updates
- * \retval          Member of \ref ESP_Result_t enumeration
+ * \retval          Member of \ref ESP_Result_t enumeration, \ref espNOHEAP when connection receive rings can not be allocated
  */
 ESP_Result_t ESP_Init(evol ESP_t* ESP, uint32_t baudrate, ESP_EventCallback_t callback);
 
+/**
+ * \brief           Initializes ESP stack with cache of module informations from previous session
+ *
+ *                  When cache is valid, queries of AT version, MAC addresses and soft AP settings are skipped
+ *                  and only commands which set module mode are sent. Otherwise full initialization is done
+ *                  and cache is filled, so application can store it for next start.
+ * \note            Cache is used also by \ref ESP_ReInit and must stay valid while stack is initialized
+ * \param[in,out]   *ESP: Pointer to working \ref ESP_t structure
+ * \param[in]       baudrate: Baudrate module uses after reset for UART to communicate with ESP8266 module
+ * \param[in]       callback: Pointer to callback function stack will use to notify user about updates
+ * \param[in,out]   *cache: Pointer to \ref ESP_InitCache_t structure with cache or NULL to not use cache
+ * \retval          Member of \ref ESP_Result_t enumeration
+ */
+ESP_Result_t ESP_InitEx(evol ESP_t* ESP, uint32_t baudrate, ESP_EventCallback_t callback, ESP_InitCache_t* cache);
+
 /**
  * \brief           Deinitializes ESP stack
  * \param[in,out]   *ESP: Pointer to working \ref ESP_t structure
@@ -549,6 +910,18 @@ ESP_Result_t ESP_IsReady(evol ESP_t* ESP);
  */
 ESP_Result_t ESP_Update(evol ESP_t* ESP);
 
+/**
+ * \brief           Waits for new received data or new command and updates ESP stack
+ * \note            When RTOS is used, use this function in update thread instead of calling \ref ESP_Update in a loop.
+ *                  Thread sleeps until \ref ESP_DataReceived is called, command is started or timeout expires.
+ *                  Low-level must implement \ref ESP_LL_Control_SYS_Wait and \ref ESP_LL_Control_SYS_Signal controls
+ * \note            When RTOS is not used, function only calls \ref ESP_Update
+ * \param[in,out]   *ESP: Pointer to working \ref ESP_t structure
+ * \param[in]       timeout: Maximal time in units of milliseconds to wait before stack is updated anyway
+ * \retval          Member of \ref ESP_Result_t enumeration
+ */
+ESP_Result_t ESP_UpdateWait(evol ESP_t* ESP, uint32_t timeout);
+
 /**
  * \brief           Process callback calls
  * \note            \li When in RTOS or ASYNC mode, user should use separate thread than one used for \ref ESP_Update
@@ -558,6 +931,42 @@ ESP_Result_t ESP_Update(evol ESP_t* ESP);
  */
 ESP_Result_t ESP_ProcessCallbacks(evol ESP_t* ESP);
 
+/**
+ * \brief           Get number of events lost because event queue was full
+ * \note            Increase \ref ESP_EVENT_QUEUE_SIZE or process callbacks more often when value is not 0
+ * \note            \ref espEventDataReceived events are not counted, they are delivered later when queue is full
+ * \param[in,out]   *ESP: Pointer to working \ref ESP_t structure
+ * \retval          Number of lost events since stack initialization
+ */
+uint32_t ESP_GetEventOverflow(evol ESP_t* ESP);
+
+/**
+ * \brief           Get duration of each phase of last initialization
+ * \param[in,out]   *ESP: Pointer to working \ref ESP_t structure
+ * \param[out]      *times: Pointer to \ref ESP_InitTimes_t structure to save times to
+ * \retval          Member of \ref ESP_Result_t enumeration
+ */
+ESP_Result_t ESP_GetInitTimes(evol ESP_t* ESP, ESP_InitTimes_t* times);
+
+#if ESP_STATS
+/**
+ * \brief           Get snapshot of stack statistics
+ * \note            Counters are copied without stopping stack, so snapshot taken while
+ *                  data are received may not be consistent between members
+ * \param[in,out]   *ESP: Pointer to working \ref ESP_t structure
+ * \param[out]      *stats: Pointer to \ref ESP_Stats_t structure to save statistics to
+ * \retval          Member of \ref ESP_Result_t enumeration
+ */
+ESP_Result_t ESP_GetStats(evol ESP_t* ESP, ESP_Stats_t* stats);
+
+/**
+ * \brief           Clear all stack statistics
+ * \param[in,out]   *ESP: Pointer to working \ref ESP_t structure
+ * \retval          Member of \ref ESP_Result_t enumeration
+ */
+ESP_Result_t ESP_ResetStats(evol ESP_t* ESP);
+#endif /* ESP_STATS */
+
 /**
  * \brief           Update time for stack from timer IRQ or any other time source
  * \param[in,out]   *ESP: Pointer to working \ref ESP_t structure
@@ -566,15 +975,79 @@ ESP_Result_t ESP_ProcessCallbacks(evol ESP_t* ESP);
  */
 void ESP_UpdateTime(evol ESP_t* ESP, uint32_t time_increase);
 
+/**
+ * \brief           Set current time for stack from absolute monotonic time source
+ * \note            Use this function instead of \ref ESP_UpdateTime when time source is free running counter,
+ *                  for example RTOS tick count. Stack calculates elapsed time since previous call itself
+ * \param[in,out]   *ESP: Pointer to working \ref ESP_t structure
+ * \param[in]       time: Current timestamp in units of milliseconds. Overflow of value is allowed
+ */
+void ESP_SetTime(evol ESP_t* ESP, uint32_t time);
+
+/**
+ * \brief           Get time until stack needs to be processed again
+ * \note            Use returned value as sleep time for tickless operation, for example as timeout
+ *                  for \ref ESP_UpdateWait. Received data and new commands wake stack up on their own
+ * \note            Deadlines include active command timeout, time guards inside commands and connection polls
+ * \param[in,out]   *ESP: Pointer to working \ref ESP_t structure
+ * \retval          Number of milliseconds until stack must be processed, 0 when it must be processed now,
+ *                  or \ref ESP_DEADLINE_NONE when nothing is waiting for time
+ */
+uint32_t ESP_GetNextDeadline(evol ESP_t* ESP);
+
 /**
  * \brief           Add new data to ESP receive buffer
- * \note            Must be called from UART RXNE interrupt or any other input source of data from ESP
+ * \note            Must be called from UART RXNE interrupt or any other input source of data from ESP.
+ *                  Whole blocks (for example DMA half-buffers) can be passed at once
+ * \note            Data are added to first initialized ESP instance
  * \param[in]       *ch: Pointer to byte or array of bytes to add to stack's input buffer
  * \param[in]       count: Number of bytes to write to stack's input buffer
  * \retval          Number of bytes written to internal ESP buffer
  */
 uint16_t ESP_DataReceived(uint8_t* ch, uint16_t count);
 
+/**
+ * \brief           Add new data to receive buffer of specific ESP instance
+ * \note            Use this function instead of \ref ESP_DataReceived when more than one ESP module is used
+ * \param[in,out]   *ESP: Pointer to working \ref ESP_t structure
+ * \param[in]       *ch: Pointer to byte or array of bytes to add to stack's input buffer
+ * \param[in]       count: Number of bytes to write to stack's input buffer
+ * \retval          Number of bytes written to internal ESP buffer
+ */
+uint16_t ESP_DataReceivedEx(evol ESP_t* ESP, uint8_t* ch, uint16_t count);
+
+/**
+ * \brief           Gets linear block of free memory in ESP receive buffer
+ * \note            Input source (for example DMA) can write directly to returned memory.
+ *                  Written data must be then added to buffer with \ref ESP_DataReceivedAdvance
+ * \param[out]      **data: Pointer to pointer to save address of free memory to
+ * \retval          Number of bytes which can be written to returned memory
+ */
+uint16_t ESP_DataReceivedGetBlock(uint8_t** data);
+
+/**
+ * \brief           Gets linear block of free memory in receive buffer of specific ESP instance
+ * \param[in,out]   *ESP: Pointer to working \ref ESP_t structure
+ * \param[out]      **data: Pointer to pointer to save address of free memory to
+ * \retval          Number of bytes which can be written to returned memory
+ */
+uint16_t ESP_DataReceivedGetBlockEx(evol ESP_t* ESP, uint8_t** data);
+
+/**
+ * \brief           Adds data written directly to memory from \ref ESP_DataReceivedGetBlock to ESP receive buffer
+ * \param[in]       count: Number of bytes written to memory
+ * \retval          Number of bytes added to internal ESP buffer
+ */
+uint16_t ESP_DataReceivedAdvance(uint16_t count);
+
+/**
+ * \brief           Adds data written directly to memory from \ref ESP_DataReceivedGetBlockEx to receive buffer of specific ESP instance
+ * \param[in,out]   *ESP: Pointer to working \ref ESP_t structure
+ * \param[in]       count: Number of bytes written to memory
+ * \retval          Number of bytes added to internal ESP buffer
+ */
+uint16_t ESP_DataReceivedAdvanceEx(evol ESP_t* ESP, uint16_t count);
+
 /**
  * \brief           Gets last return status from stack
  * \note            Use this function in callback function to detect returned status of last operation
@@ -583,6 +1056,23 @@ uint16_t ESP_DataReceived(uint8_t* ch, uint16_t count);
  */
 ESP_Result_t ESP_GetLastReturnStatus(evol ESP_t* ESP);
 
+/**
+ * \brief           Registers request to track result of commands started by API functions
+ *
+ *                  Pass \ref ESP_REQUEST macro with request as blocking parameter of API function to start command with request.
+ *                  Request is bound to command by API call itself, so different threads may start commands with own requests.
+ *
+ * \note            Register requests after stack initialization, before API functions are used from other threads.
+ *                  When API function does not return \ref espOK or request was not finished yet, request is not used and will not be notified
+ * \note            When command finishes, request result and done status are set and request callback is called
+ *                  from \ref ESP_ProcessCallbacks function. No memory is allocated by stack
+ * \note            Transparent transfer functions do not support requests
+ * \param[in,out]   *ESP: Pointer to working \ref ESP_t structure
+ * \param[in,out]   *req: Pointer to \ref ESP_Request_t structure with callback and argument already set
+ * \retval          Member of \ref ESP_Result_t enumeration, \ref espNOHEAP when \ref ESP_REQUEST_COUNT requests are registered already
+ */
+ESP_Result_t ESP_RequestInit(evol ESP_t* ESP, ESP_Request_t* req);
+
 /**
  * \defgroup        SYS_API System API
  * \brief           System API
@@ -939,6 +1429,83 @@ ESP_Result_t ESP_CONN_Start(evol ESP_t* ESP, ESP_CONN_t** conn, ESP_CONN_Type_t
  */
 ESP_Result_t ESP_CONN_Send(evol ESP_t* ESP, ESP_CONN_t* conn, const uint8_t* data, uint32_t btw, uint32_t* bw, uint32_t blocking);
 
+/**
+ * \brief           Send data from multiple buffers to active connection as one transmission
+ *
+ *                  Buffers are sent one after another in packets of up to 2048 bytes, each packet
+ *                  is filled from as many buffers as fit in it. Data are sent directly from buffers, without copy,
+ *                  so header, dynamic values and body can be kept in separate memories.
+ * \note            Array of buffer descriptors and buffers must be valid until command finishes
+ * \param[in,out]   *ESP: Pointer to working \ref ESP_t structure
+ * \param[in]       *conn: Pointer to \ref ESP_CONN_t structure with active connection
+ * \param[in]       *vec: Pointer to array of \ref ESP_SendVec_t buffer descriptors
+ * \param[in]       cnt: Number of entries in array
+ * \param[out]      *bw: Pointer to variable to store number of bytes actually written to connection and successfully sent
+ * \param[in]       blocking: Status whether this function should be blocking to check for response
+ * \retval          Member of \ref ESP_Result_t enumeration
+ */
+ESP_Result_t ESP_CONN_SendVector(evol ESP_t* ESP, ESP_CONN_t* conn, const ESP_SendVec_t* vec, uint32_t cnt, uint32_t* bw, uint32_t blocking);
+
+/**
+ * \brief           Send string to active connection without knowing its length in advance
+ *
+ *                  String is sent with AT+CIPSENDEX command with maximal packet length.
+ *                  When string ends before maximal length, packet is terminated with "\\0" sequence,
+ *                  so records can be formatted to buffer and sent without length calculation.
+ * \note            String must not contain "\\0" character sequence, module takes it as end of packet
+ * \param[in,out]   *ESP: Pointer to working \ref ESP_t structure
+ * \param[in]       *conn: Pointer to \ref ESP_CONN_t structure with active connection
+ * \param[in]       *str: Pointer to NULL terminated string to send
+ * \param[out]      *bw: Pointer to variable to store number of bytes actually written to connection and successfully sent
+ * \param[in]       blocking: Status whether this function should be blocking to check for response
+ * \retval          Member of \ref ESP_Result_t enumeration
+ */
+ESP_Result_t ESP_CONN_SendEx(evol ESP_t* ESP, ESP_CONN_t* conn, const char* str, uint32_t* bw, uint32_t blocking);
+
+/**
+ * \brief           Add data to module send buffer of active TCP connection
+ *
+ *                  Data are split to segments of up to 2048 bytes and each segment is added to module
+ *                  send buffer with AT+CIPSENDBUF command. Next segment is added without waiting for
+ *                  previous one to be sent, up to \ref ESP_SENDBUF_SEGMENTS segments per connection.
+ *                  When module buffer is full, stack checks buffer status and waits for segments to be sent.
+ *
+ *                  Command finishes when all data are in module buffer. When each segment is sent,
+ *                  \ref espEventDataSegmentSent or \ref espEventDataSegmentSentError event is called with segment ID.
+ * \note            Data memory must be valid until command finishes
+ * \note            Segment events are processed when stack is ready, set \ref ESP_EVENT_QUEUE_SIZE
+ *                  to at least number of segments in single call to not lose them
+ * \param[in,out]   *ESP: Pointer to working \ref ESP_t structure
+ * \param[in]       *conn: Pointer to \ref ESP_CONN_t structure with active TCP connection
+ * \param[in]       *data: Pointer to data to be sent to connection
+ * \param[in]       btw: Number of bytes to send
+ * \param[out]      *bw: Pointer to variable to store number of bytes added to module send buffer
+ * \param[in]       blocking: Status whether this function should be blocking to check for response
+ * \retval          Member of \ref ESP_Result_t enumeration
+ */
+ESP_Result_t ESP_CONN_SendBuf(evol ESP_t* ESP, ESP_CONN_t* conn, const uint8_t* data, uint32_t btw, uint32_t* bw, uint32_t blocking);
+
+/**
+ * \brief           Read module send buffer status of connection
+ * \note            Result is saved to SendSegment, SendSegmentAck and SendBufferFree members of connection
+ * \param[in,out]   *ESP: Pointer to working \ref ESP_t structure
+ * \param[in]       *conn: Pointer to \ref ESP_CONN_t structure with active TCP connection
+ * \param[in]       blocking: Status whether this function should be blocking to check for response
+ * \retval          Member of \ref ESP_Result_t enumeration
+ */
+ESP_Result_t ESP_CONN_GetBufferStatus(evol ESP_t* ESP, ESP_CONN_t* conn, uint32_t blocking);
+
+/**
+ * \brief           Check if segment added with \ref ESP_CONN_SendBuf was sent successfully
+ * \param[in,out]   *ESP: Pointer to working \ref ESP_t structure
+ * \param[in]       *conn: Pointer to \ref ESP_CONN_t structure with active TCP connection
+ * \param[in]       segment: Segment ID to check
+ * \param[out]      *sent: Pointer to variable to save status to. Set to 1 when segment was sent or 0 otherwise
+ * \param[in]       blocking: Status whether this function should be blocking to check for response
+ * \retval          Member of \ref ESP_Result_t enumeration
+ */
+ESP_Result_t ESP_CONN_CheckSegment(evol ESP_t* ESP, ESP_CONN_t* conn, uint32_t segment, uint8_t* sent, uint32_t blocking);
+
 /**
  * \brief           Close active connection
  * \param[in,out]   *ESP: Pointer to working \ref ESP_t structure
@@ -996,6 +1563,68 @@ ESP_Result_t ESP_CONN_CloseAll(evol ESP_t* ESP, uint32_t blocking);
  */
 ESP_Result_t ESP_CONN_SetCallback(evol ESP_t* ESP, ESP_CONN_t* conn, ESP_EventCallback_t cb, uint32_t blocking);
 
+#if ESP_CONN_RX_SIZE
+/**
+ * \brief           Set memory for connection receive ring
+ * \note            By default, ring of \ref ESP_CONN_RX_SIZE bytes is allocated by \ref ESP_Init.
+ *                  Call this function after initialization, before connection is active, to use static memory or different size.
+ *                  On failure, previous ring is kept
+ * \param[in,out]   *ESP: Pointer to working \ref ESP_t structure
+ * \param[in]       num: Connection number
+ * \param[in]       *mem: Pointer to memory for ring or NULL to allocate it
+ * \param[in]       size: Size of ring memory in units of bytes
+ * \retval          Member of \ref ESP_Result_t enumeration
+ */
+ESP_Result_t ESP_CONN_SetReceiveBuffer(evol ESP_t* ESP, uint8_t num, void* mem, uint32_t size);
+
+/**
+ * \brief           Get number of received bytes waiting in connection receive ring
+ * \param[in,out]   *ESP: Pointer to working \ref ESP_t structure
+ * \param[in]       *conn: Pointer to \ref ESP_CONN_t structure with connection
+ * \retval          Number of bytes available for read
+ */
+uint32_t ESP_CONN_Available(evol ESP_t* ESP, ESP_CONN_t* conn);
+
+/**
+ * \brief           Read received data from connection receive ring
+ * \note            When ring was full, stack continues with reading data from module after this call
+ * \param[in,out]   *ESP: Pointer to working \ref ESP_t structure
+ * \param[in]       *conn: Pointer to \ref ESP_CONN_t structure with connection
+ * \param[out]      *data: Pointer to memory to copy data to
+ * \param[in]       btr: Maximal number of bytes to read
+ * \retval          Number of bytes read
+ */
+uint32_t ESP_CONN_Read(evol ESP_t* ESP, ESP_CONN_t* conn, void* data, uint32_t btr);
+#endif /* ESP_CONN_RX_SIZE */
+
+#if ESP_IPD_POOL_BLOCKS
+/**
+ * \brief           Return chain of received blocks to IPD block pool
+ * \note            Chain is passed as CP2 parameter of \ref espEventDataReceived event and must be freed by user,
+ *                  either in callback or later when data are processed.
+ *                  When pool is empty, stack stops reading data from module until blocks are freed.
+ * \param[in,out]   *ESP: Pointer to working \ref ESP_t structure
+ * \param[in]       *p: Pointer to first block in chain
+ * \retval          Number of blocks returned to pool
+ */
+uint32_t ESP_PBUF_Free(evol ESP_t* ESP, ESP_PBUF_t* p);
+
+/**
+ * \brief           Get maximal number of IPD pool blocks in use at the same time since stack initialization
+ * \note            Use it to set \ref ESP_IPD_POOL_BLOCKS for actual application traffic
+ * \param[in,out]   *ESP: Pointer to working \ref ESP_t structure
+ * \retval          High-water mark of used blocks
+ */
+uint32_t ESP_PBUF_GetMaxUsed(evol ESP_t* ESP);
+
+/**
+ * \brief           Get number of IPD pool blocks currently in use
+ * \param[in,out]   *ESP: Pointer to working \ref ESP_t structure
+ * \retval          Number of used blocks
+ */
+uint32_t ESP_PBUF_GetUsed(evol ESP_t* ESP);
+#endif /* ESP_IPD_POOL_BLOCKS */
+
 /**
  * \brief           Set user defined parameter for connection
  * \param[in,out]   *ESP: Pointer to working \ref ESP_t structure
@@ -1160,7 +1789,8 @@ ESP_Result_t ESP_SNTP_SetConfig(evol ESP_t* ESP, const ESP_SNTP_t* sntp, uint32_
 /**
  * \brief           Get SNTP configuration
  * \param[in,out]   *ESP: Pointer to working \ref ESP_t structure
- * \param[in]       *sntp: Pointer to \ref ESP_SNTP_t structure to fill data to. \note To get info about sntp server addresses, Addr member of \ref ESP_SNTP_t structure must point to RAM memory to save data to!
+ * \param[in]       *sntp: Pointer to \ref ESP_SNTP_t structure to fill data to. \note To get info about sntp server addresses, Addr member of \ref ESP_SNTP_t structure must point to RAM memory to save data to
+ *                      and AddrSize member must be set to size of that memory!
  * \param[in]       blocking: Status whether this function should be blocking to check for response
  * \retval          Member of \ref ESP_Result_t enumeration
  */
@@ -1268,6 +1898,9 @@ ESP_Result_t ESP_TRANSFER_Start(evol ESP_t* ESP, uint32_t blocking);
 
 /**
  * \brief           Data to send over ESP device
+ * \note            When \ref ESP_TRANSFER_TX_SIZE is set, data are copied to transmit ring and sent from \ref ESP_Update
+ *                  in packets of up to 2048 bytes. Smaller writes are merged for up to 20 milliseconds, so module sends them in single packet.
+ *                  When there is not enough free memory in ring, function returns \ref espBUSY, or waits for memory when blocking.
  * \param[in,out]   *ESP: Pointer to working \ref ESP_t structure
  * \param[in]       *data: Pointer to data to send
  * \param[in]       btw: Number of bytes to write
@@ -56,9 +56,61 @@
  *          max ESP receive string size.
  *
  * \note    When possible, buffer should be at least 256 bytes.
+ * \note    Must be power of 2 when \ref BUFFER_SPSC lock-free buffer mode is enabled
  */
 #define ESP_BUFFER_SIZE                     256
 
+/**
+ * \brief   Command staging buffer size in units of bytes.
+ *
+ *          Each AT command is assembled in this buffer and sent to low-level
+ *          layer with single \ref ESP_LL_Control_Send call when command starts.
+ *
+ * \note    Commands longer than buffer size are sent in multiple parts.
+ *          Raw connection data are always sent directly, without copy.
+ */
+#define ESP_TX_BUFFER_SIZE                  128
+
+/**
+ * \brief   Number of commands which may wait for execution while stack is busy.
+ *
+ *          Non-blocking API calls made while another command is active are
+ *          added to queue and started immediately when previous one finishes.
+ *          Set to 0 to disable queue and return \ref espBUSY instead.
+ *
+ * \note    Blocking calls are never queued and return \ref espBUSY when stack is busy.
+ *          Memory passed to queued commands must be valid until command finishes.
+ */
+#define ESP_CMD_QUEUE_SIZE                  4
+
+/**
+ * \brief   Number of requests which may be registered with \ref ESP_RequestInit.
+ *
+ *          Each request may track one command at a time, see \ref ESP_REQUEST.
+ */
+#define ESP_REQUEST_COUNT                   4
+
+/**
+ * \brief   Number of events which may wait for callback processing.
+ *
+ *          Events are reported to callback in order they happened, without merging repeated events.
+ *
+ * \note    When queue is full, new events are lost and counted, see \ref ESP_GetEventOverflow.
+ *          Received data events are never lost, they wait and are merged per connection until there is free entry.
+ */
+#define ESP_EVENT_QUEUE_SIZE                16
+
+/**
+ * \brief   Maximal number of segments per connection waiting in module send buffer.
+ *
+ *          Used by \ref ESP_CONN_SendBuf function. New segment is added to module
+ *          only when number of segments not yet sent is lower than this value.
+ *
+ * \note    Each segment has up to 2048 bytes. Larger value gives better throughput
+ *          on links with high latency, but module may run out of buffer memory.
+ */
+#define ESP_SENDBUF_SEGMENTS                4
+
 /**
  * \brief   Enables (1) or disables (0) single connection mode
  *
@@ -80,6 +132,17 @@
  */
 #define ESP_CONNBUFFER_SIZE                 1460
 
+/**
+ * \brief   Transparent mode transmit ring size in units of bytes. Set to 0 to disable ring.
+ *
+ *          When enabled, \ref ESP_TRANSFER_Send copies data to ring and stack sends them
+ *          in packets of up to 2048 bytes. Small writes are merged for up to 20 milliseconds,
+ *          because module starts new network packet after 20 milliseconds of UART silence.
+ *
+ * \note    Used only when \ref ESP_SINGLE_CONN is enabled. Recommended at least 4096 bytes.
+ */
+#define ESP_TRANSFER_TX_SIZE                0
+
 /**
  * \brief   Enables (1) or disables (0) single buffer for all connections together
  *
@@ -91,6 +154,42 @@
  */
 #define ESP_CONN_SINGLEBUFFER               0
 
+/**
+ * \brief   Per connection receive ring size in units of bytes. Set to 0 to disable rings.
+ *
+ *          When enabled, received data are copied to connection ring instead of fixed connection buffer
+ *          and application reads them with \ref ESP_CONN_Read function. \ref espEventDataReceived event
+ *          only reports number of new bytes in ring. When ring is full, stack stops reading module data
+ *          until application reads from ring.
+ *
+ * \note    Ring memory is allocated by \ref ESP_Init or set with \ref ESP_CONN_SetReceiveBuffer function.
+ *          Can not be used together with \ref ESP_CONN_SINGLEBUFFER.
+ * \note    Backpressure is lossless only when \ref ESP_USE_CTS is enabled and RTS pin is wired,
+ *          otherwise USART input buffer may overflow while ring is full.
+ */
+#define ESP_CONN_RX_SIZE                    0
+
+/**
+ * \brief   Number of blocks in shared IPD block pool. Set to 0 to disable pool.
+ *
+ *          When enabled, received data of all connections are stored to blocks of
+ *          \ref ESP_IPD_POOL_BLOCK_SIZE bytes taken from single pool, so memory is used only
+ *          for data not yet processed by application. \ref espEventDataReceived event passes
+ *          chain of \ref ESP_PBUF_t blocks as CP2 parameter, which must be freed with \ref ESP_PBUF_Free.
+ *
+ * \note    When pool is empty, stack stops reading data from module, see \ref ESP_USE_CTS.
+ *          Can not be used together with \ref ESP_CONN_RX_SIZE or \ref ESP_CONN_SINGLEBUFFER.
+ *          Use \ref ESP_PBUF_GetMaxUsed to find number of blocks application needs.
+ */
+#define ESP_IPD_POOL_BLOCKS                 0
+
+/**
+ * \brief   Size of single block in IPD block pool in units of bytes
+ *
+ * \note    Each received packet starts in new block
+ */
+#define ESP_IPD_POOL_BLOCK_SIZE             256
+
 /**
  * \brief   Enables (1) or disables (0) echo from ESP module
  *
@@ -130,6 +229,18 @@
  */
 #define ESP_RTOS_YIELD()                    taskYIELD()
 
+/**
+ * \brief  RTOS specific macros for short critical section
+ *
+ *         Used around few instructions which modify lists shared between update thread
+ *         and user threads, such as free blocks of \ref ESP_IPD_POOL_BLOCKS pool.
+ *
+ * \note   Leave undefined when stack and user code run in single thread.
+ *         When \ref ESP_ASYNC processing is done in interrupt, define them to disable and enable interrupts.
+ */
+#define ESP_RTOS_CRITICAL_ENTER()           taskENTER_CRITICAL()
+#define ESP_RTOS_CRITICAL_EXIT()            taskEXIT_CRITICAL()
+
 /**
  * \brief  Timeout in milliseconds for mutex to access API
  *
@@ -164,6 +275,54 @@
  */
 #define ESP_USE_CTS                         0
 
+/**
+ * \brief   Enables (1) or disables (0) UART baudrate negotiation at initialization
+ *
+ *          Stack sets each baudrate from \ref ESP_AUTOBAUD_LIST with AT+UART_CUR command
+ *          and checks link with \ref ESP_AUTOBAUD_CHECKS AT commands. Baudrate is kept when all commands
+ *          succeed and no more than \ref ESP_AUTOBAUD_GARBAGE invalid characters are received,
+ *          otherwise stack goes back to last good baudrate and stops. When module does not respond
+ *          at last good baudrate anymore, it is reset and initial baudrate is used.
+ *
+ * \note    Low-level must support reinitialization with new baudrate in \ref ESP_LL_Control_Init.
+ *          When \ref ESP_USE_CTS is enabled, hardware flow control is enabled with each baudrate.
+ */
+#define ESP_AUTOBAUD                        0
+
+/**
+ * \brief   List of baudrates to try in ascending order, separated by comma
+ */
+#define ESP_AUTOBAUD_LIST                   230400, 460800, 921600
+
+/**
+ * \brief   Number of AT commands sent to check link at new baudrate
+ */
+#define ESP_AUTOBAUD_CHECKS                 10
+
+/**
+ * \brief   Maximal number of invalid characters allowed during link check
+ */
+#define ESP_AUTOBAUD_GARBAGE                0
+
+/**
+ * \brief   Enables (1) or disables (0) statistics of stack
+ *
+ *          Stack counts UART traffic, USART input buffer usage, invalid characters, send retries
+ *          and bytes sent and received on each connection, and saves latency histogram for each command.
+ *          Use \ref ESP_GetStats to get snapshot of statistics.
+ *
+ * \note    Counting is done with few additions per command or received block,
+ *          so statistics can be enabled in production code.
+ */
+#define ESP_STATS                           0
+
+/**
+ * \brief   Number of different commands latency histograms are saved for
+ *
+ * \note    Commands started when all entries are used are not saved, see \ref ESP_Stats_t
+ */
+#define ESP_STATS_CMDS                      16
+
 
 /**
  * \}
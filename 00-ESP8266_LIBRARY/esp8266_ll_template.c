@@ -33,7 +33,50 @@
 
 
 #if ESP_RTOS
-osMutexId id;
+#include "stddef.h"
+
+#define ESP_LL_INSTANCES        1                   /* Number of ESP instances used by application */
+
+/* System objects of single ESP instance */
+typedef struct {
+    ESP_LL_t* LL;                                   /* Low-level structure of instance, NULL when entry is free */
+    ESP_RTOS_SYNC_t* Sync;                          /* Sync object of instance */
+    osMutexId id;                                   /* Mutex for API access */
+    osSemaphoreId sem[2];                           /* Binary semaphores for update and ready events */
+} ESP_LL_SYS_t;
+
+osSemaphoreDef(ESP_Update_Sem);
+osSemaphoreDef(ESP_Ready_Sem);
+static ESP_LL_SYS_t sys[ESP_LL_INSTANCES];
+
+/* Gets system objects of instance by its low-level structure, takes free entry for new instance when create is set */
+static ESP_LL_SYS_t* GetSysLL(ESP_LL_t* LL, uint8_t create) {
+    uint8_t i;
+    for (i = 0; i < ESP_LL_INSTANCES; i++) {
+        if (sys[i].LL == LL) {
+            return &sys[i];
+        }
+    }
+    for (i = 0; create && i < ESP_LL_INSTANCES; i++) {
+        if (sys[i].LL == NULL) {
+            sys[i].LL = LL;
+            sys[i].Sync = (ESP_RTOS_SYNC_t *)&((ESP_t *)((uint8_t *)LL - offsetof(ESP_t, LL)))->Sync;  /* Sync object of the same instance */
+            return &sys[i];
+        }
+    }
+    return NULL;
+}
+
+/* Gets system objects of instance by its sync object */
+static ESP_LL_SYS_t* GetSysSync(ESP_RTOS_SYNC_t* Sync) {
+    uint8_t i;
+    for (i = 0; i < ESP_LL_INSTANCES; i++) {
+        if (sys[i].LL != NULL && sys[i].Sync == Sync) {
+            return &sys[i];
+        }
+    }
+    return NULL;
+}
 #endif /* ESP_RTOS */
 
 uint8_t ESP_LL_Callback(ESP_LL_Control_t ctrl, void* param, void* result) {
@@ -46,6 +89,21 @@ uint8_t ESP_LL_Callback(ESP_LL_Control_t ctrl, void* param, void* result) {
             /************************************/
 
             
+#if ESP_RTOS
+            do {
+                ESP_LL_SYS_t* s = GetSysLL(LL, 1);  /* Get system objects of this instance */
+                if (s != NULL && s->sem[ESP_SYS_EVENT_UPDATE] == NULL) {    /* Init may be called again with new baudrate */
+                    s->sem[ESP_SYS_EVENT_UPDATE] = osSemaphoreCreate(osSemaphore(ESP_Update_Sem), 1);
+                    s->sem[ESP_SYS_EVENT_READY] = osSemaphoreCreate(osSemaphore(ESP_Ready_Sem), 1);
+                }
+                if (s == NULL || s->sem[ESP_SYS_EVENT_UPDATE] == NULL || s->sem[ESP_SYS_EVENT_READY] == NULL) {
+                    if (result) {
+                        *(uint8_t *)result = 1;     /* Too many instances or no memory */
+                    }
+                    return 1;
+                }
+            } while (0);
+#endif /* ESP_RTOS */
             if (result) {
                 *(uint8_t *)result = 0;             /* Successfully initialized */
             }
@@ -79,34 +137,60 @@ uint8_t ESP_LL_Callback(ESP_LL_Control_t ctrl, void* param, void* result) {
 #if ESP_RTOS
         case ESP_LL_Control_SYS_Create: {           /* Create system synchronization object */
             ESP_RTOS_SYNC_t* Sync = (ESP_RTOS_SYNC_t *)param;   /* Get pointer to sync object */
-            id = osMutexCreate(Sync);               /* Create mutex */
+            ESP_LL_SYS_t* s = GetSysSync(Sync);     /* Instance was initialized before */
+            if (s != NULL) {
+                s->id = osMutexCreate(Sync);        /* Create mutex */
+            }
             
             if (result) {
-                *(uint8_t *)result = id == NULL;    /*!< Set result value */
+                *(uint8_t *)result = s == NULL || s->id == NULL;    /*!< Set result value */
             }
             return 1;                               /* Command processed */
         }
         case ESP_LL_Control_SYS_Delete: {           /* Delete system synchronization object */
             ESP_RTOS_SYNC_t* Sync = (ESP_RTOS_SYNC_t *)param;   /* Get pointer to sync object */
-            osMutexDelete(Sync);                    /* Delete mutex object */
+            ESP_LL_SYS_t* s = GetSysSync(Sync);
+            if (s != NULL && s->id != NULL) {
+                osMutexDelete(s->id);               /* Delete mutex object */
+                s->id = NULL;
+            }
             
             if (result) {
-                *(uint8_t *)result = id == NULL;    /*!< Set result value */
+                *(uint8_t *)result = s == NULL;     /*!< Set result value */
             }
             return 1;                               /* Command processed */
         }
         case ESP_LL_Control_SYS_Request: {          /* Request system synchronization object */
             ESP_RTOS_SYNC_t* Sync = (ESP_RTOS_SYNC_t *)param;   /* Get pointer to sync object */
-            (void)Sync;                             /* Prevent compiler warnings */
+            ESP_LL_SYS_t* s = GetSysSync(Sync);
             
-            *(uint8_t *)result = osMutexWait(id, 1000) == osOK ? 0 : 1; /* Set result according to response */
+            *(uint8_t *)result = s != NULL && osMutexWait(s->id, 1000) == osOK ? 0 : 1; /* Set result according to response */
             return 1;                               /* Command processed */
         }
         case ESP_LL_Control_SYS_Release: {          /* Release system synchronization object */
             ESP_RTOS_SYNC_t* Sync = (ESP_RTOS_SYNC_t *)param;   /* Get pointer to sync object */
-            (void)Sync;                             /* Prevent compiler warnings */
+            ESP_LL_SYS_t* s = GetSysSync(Sync);
+            
+            *(uint8_t *)result = s != NULL && osMutexRelease(s->id) == osOK ? 0 : 1;    /* Set result according to response */
+            return 1;                               /* Command processed */
+        }
+        case ESP_LL_Control_SYS_Wait: {             /* Wait for stack event */
+            ESP_LL_SysEvent_t* evt = (ESP_LL_SysEvent_t *)param;
+            ESP_LL_SYS_t* s = GetSysLL(evt->LL, 0); /* Get semaphores of instance */
+            
+            if (evt->Event == ESP_SYS_EVENT_DELAY || s == NULL) {
+                osDelay(evt->Timeout);              /* Sleep only */
+                *(uint8_t *)result = 1;
+            } else {
+                *(uint8_t *)result = osSemaphoreWait(s->sem[evt->Event], evt->Timeout) == osOK ? 0 : 1;   /* Wrapper returns osOK when semaphore was taken */
+            }
+            return 1;                               /* Command processed */
+        }
+        case ESP_LL_Control_SYS_Signal: {           /* Signal stack event, may be called from interrupt */
+            ESP_LL_SysEvent_t* evt = (ESP_LL_SysEvent_t *)param;
+            ESP_LL_SYS_t* s = GetSysLL(evt->LL, 0); /* Get semaphores of instance */
             
-            *(uint8_t *)result = osMutexRelease(id) == osOK ? 0 : 1;    /* Set result according to response */
+            *(uint8_t *)result = s != NULL && s->sem[evt->Event] != NULL && osSemaphoreRelease(s->sem[evt->Event]) == osOK ? 0 : 1;  /* Semaphore may not be created yet */
             return 1;                               /* Command processed */
         }
 #endif /* ESP_RTOS */
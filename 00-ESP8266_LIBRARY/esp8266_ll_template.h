@@ -131,7 +131,7 @@ typedef enum _ESP_LL_Control_t {
     /**
      * \brief       Called to set software RTS pin when necessary
      *
-     * \param[in]   *param: Pointer to \ref uint8_t variable with RTS info. This parameter can be a value of \ref ESP_RTS_SET or \ref ESP_RTS_CLR macros
+     * \param[in]   *param: Pointer to \ref ESP_LL_Pin_t structure with RTS info. State can be a value of \ref ESP_RTS_SET or \ref ESP_RTS_CLR macros
      * \param[out]  *result: Pointer to \ref uint8_t variable with result. Set to 0 when OK, or non-zero on ERROR.
      */
     ESP_LL_Control_SetRTS,          /*!< Set software RTS control */
@@ -139,7 +139,7 @@ typedef enum _ESP_LL_Control_t {
     /**
      * \brief       Called to set reset pin when necessary
      *
-     * \param[in]   *param: Pointer to \ref uint8_t variable with RESET info. This parameter can be a value of \ref ESP_RESET_SET or \ref ESP_RESET_CLR macros
+     * \param[in]   *param: Pointer to \ref ESP_LL_Pin_t structure with RESET info. State can be a value of \ref ESP_RESET_SET or \ref ESP_RESET_CLR macros
      * \param[out]  *result: Pointer to \ref uint8_t variable with result. Set to 0 when OK, or non-zero on ERROR.
      */
     ESP_LL_Control_SetReset,        /*!< Set reset control */
@@ -175,8 +175,37 @@ typedef enum _ESP_LL_Control_t {
      * \param[out]  *result: Pointer to \ref uint8_t variable with result. Set to 0 when OK, or non-zero on ERROR.
      */
     ESP_LL_Control_SYS_Release,     /*!< Releases grant for specific sync object */
+    
+    /**
+     * \brief       Called to wait for stack event instead of yielding in a loop
+     *
+     * \note        Use binary semaphore or task notification for each event, so waiting thread does not consume CPU.
+     *              When not implemented, stack yields with \ref ESP_RTOS_YIELD instead
+     * \param[in]   *param: Pointer to \ref ESP_LL_SysEvent_t structure with event and timeout
+     * \param[out]  *result: Pointer to \ref uint8_t variable with result. Set to 0 when event was signalled, or non-zero on timeout.
+     */
+    ESP_LL_Control_SYS_Wait,        /*!< Waits for stack event */
+    
+    /**
+     * \brief       Called to signal stack event to waiting thread
+     *
+     * \note        Called from interrupt context when \ref ESP_DataReceived is called from interrupt.
+     *              Such interrupts must run at priority which allows RTOS calls, for FreeRTOS not above configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY
+     * \param[in]   *param: Pointer to \ref ESP_LL_SysEvent_t structure with event
+     * \param[out]  *result: Pointer to \ref uint8_t variable with result. Set to 0 when OK, or non-zero on ERROR.
+     */
+    ESP_LL_Control_SYS_Signal,      /*!< Signals stack event */
 } ESP_LL_Control_t;
 
+/**
+ * \brief   Low level structure for driver
+ * \note    For now it has basic settings only without hardware flow control.
+ * \note    Each ESP instance has its own structure. Use its address to identify module in \ref ESP_LL_Callback
+ */
+typedef struct _ESP_LL_t {
+    uint32_t Baudrate;          /*!< Baudrate to be used for UART */
+} ESP_LL_t;
+
 /**
  * \brief   Structure for sending data to low-level part
  */
@@ -184,15 +213,26 @@ typedef struct _ESP_LL_Send_t {
     const uint8_t* Data;            /*!< Pointer to data to send */
     uint16_t Count;                 /*!< Number of bytes to send */
     uint8_t Result;                 /*!< Result of last send */
+    ESP_LL_t* LL;                   /*!< Low-level structure of instance data are sent for */
 } ESP_LL_Send_t;
 
 /**
- * \brief   Low level structure for driver
- * \note    For now it has basic settings only without hardware flow control.
+ * \brief   Structure for setting pin state in low-level part
+ * \note    State is first member, so parameter can be also read as \ref uint8_t variable
  */
-typedef struct _ESP_LL_t {
-    uint32_t Baudrate;          /*!< Baudrate to be used for UART */
-} ESP_LL_t;
+typedef struct _ESP_LL_Pin_t {
+    uint8_t State;                  /*!< New pin state */
+    ESP_LL_t* LL;                   /*!< Low-level structure of instance pin belongs to */
+} ESP_LL_Pin_t;
+
+/**
+ * \brief   Structure for waiting and signalling stack events on RTOS support
+ */
+typedef struct _ESP_LL_SysEvent_t {
+    uint8_t Event;                  /*!< Event, value of \ref ESP_SYS_EVENT_UPDATE, \ref ESP_SYS_EVENT_READY or \ref ESP_SYS_EVENT_DELAY macros */
+    uint32_t Timeout;               /*!< Maximal time in units of milliseconds to wait for event */
+    ESP_LL_t* LL;                   /*!< Low-level structure of instance event belongs to */
+} ESP_LL_SysEvent_t;
     
 /**
  * \}
@@ -211,6 +251,9 @@ typedef struct _ESP_LL_t {
 #define ESP_RTS_CLR         0   /*!< RTS should be set low */
 #define ESP_RESET_SET       1   /*!< Reset pin should be set */
 #define ESP_RESET_CLR       0   /*!< Reset pin should be cleared */
+#define ESP_SYS_EVENT_UPDATE    0   /*!< New data received or new command set, update thread waits for it */
+#define ESP_SYS_EVENT_READY     1   /*!< Command finished, threads waiting for stack to be ready wait for it */
+#define ESP_SYS_EVENT_DELAY     2   /*!< Event is never signalled, wait for timeout only */
     
 /**
  * \}
@@ -0,0 +1,87 @@
+/**
+ * \brief   Common part of host benchmarks
+ */
+#include "bench.h"
+#include "string.h"
+#include "time.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include "x86intrin.h"
+#define BENCH_CYCLES()          __rdtsc()
+#else
+#define BENCH_CYCLES()          0
+#endif
+
+static uint64_t BENCH_Now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+int BENCH_Quick(int argc, char** argv) {
+    int i;
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--quick") == 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+const char* BENCH_Option(int argc, char** argv, const char* name) {
+    size_t len = strlen(name);
+    int i;
+    for (i = 1; i < argc; i++) {
+        if (strncmp(argv[i], name, len) == 0 && argv[i][len] == '=') {
+            return &argv[i][len + 1];
+        }
+    }
+    return NULL;
+}
+
+void BENCH_Start(BENCH_t* b) {
+    b->StartCycles = BENCH_CYCLES();
+    b->StartNs = BENCH_Now();
+}
+
+void BENCH_Stop(BENCH_t* b) {
+    b->Ns = BENCH_Now() - b->StartNs;
+    b->Cycles = BENCH_CYCLES() - b->StartCycles;
+    if (!b->Ns) {
+        b->Ns = 1;                                          /* Avoid division by zero on coarse clocks */
+    }
+}
+
+/* Prints common fields, line is finished by caller */
+static void BENCH_Print(const char* bench, const char* cse, const char* unit, uint64_t items, const BENCH_t* b) {
+    double s = (double)b->Ns / 1e9;
+
+    printf("{\"bench\":\"%s\",\"case\":\"%s\",\"unit\":\"%s\",\"items\":%llu,\"seconds\":%.6f,\"per_second\":%.6g,\"ns_per_item\":%.6g,",
+        bench, cse, unit, (unsigned long long)items, s, items ? (double)items / s : 0.0, items ? (double)b->Ns / (double)items : 0.0);
+    if (b->Cycles && items) {
+        printf("\"cycles_per_item\":%.6g", (double)b->Cycles / (double)items);
+    } else {
+        printf("\"cycles_per_item\":null");
+    }
+}
+
+void BENCH_Report(const char* bench, const char* cse, const char* unit, uint64_t items, const BENCH_t* b) {
+    BENCH_Print(bench, cse, unit, items, b);
+    printf("}\n");
+    fflush(stdout);
+}
+
+void BENCH_ReportSim(const char* bench, const char* cse, const char* unit, uint64_t items, uint64_t ms, const BENCH_t* b) {
+    BENCH_Print(bench, cse, unit, items, b);
+    printf(",\"sim_ms\":%llu,\"sim_per_second\":%.6g}\n", (unsigned long long)ms, ms ? (double)items * 1000.0 / (double)ms : 0.0);
+    fflush(stdout);
+}
+
+uint32_t BENCH_Random(uint32_t* seed) {
+    uint32_t x = *seed ? *seed : 0x12345678;                /* Xorshift generator */
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *seed = x;
+    return x;
+}
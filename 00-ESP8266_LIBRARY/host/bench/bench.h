@@ -0,0 +1,90 @@
+/**
+ * \brief   Common part of host benchmarks
+ *
+ * Each result is printed as single line JSON object:
+ *
+\verbatim
+{"bench":"buffer","case":"write_read/size=4096/chunk=64","unit":"bytes","items":67108864,
+ "seconds":0.0213,"per_second":3.15e+09,"ns_per_item":0.317,"cycles_per_item":0.95}
+\endverbatim
+ *
+ * cycles_per_item is null when cycle counter is not available on host.
+ * Run benchmark with --quick argument to only check it works.
+ */
+#ifndef BENCH_H
+#define BENCH_H
+
+#include "stdint.h"
+#include "stdio.h"
+
+/**
+ * \brief   Measurement of single benchmark case
+ */
+typedef struct _BENCH_t {
+    uint64_t StartNs;               /*!< Monotonic time when measurement started */
+    uint64_t StartCycles;           /*!< Cycle counter when measurement started */
+    uint64_t Ns;                    /*!< Measured time in nanoseconds */
+    uint64_t Cycles;                /*!< Measured cycles, 0 when not available */
+} BENCH_t;
+
+/**
+ * \brief   Checks arguments for quick mode
+ * \param[in]   argc: Number of arguments from main
+ * \param[in]   argv: Arguments from main
+ * \retval      1: Run quick check only
+ * \retval      0: Run full benchmark
+ */
+int BENCH_Quick(int argc, char** argv);
+
+/**
+ * \brief   Gets value of option in form name=value from arguments
+ * \param[in]   argc: Number of arguments from main
+ * \param[in]   argv: Arguments from main
+ * \param[in]   *name: Option name without = character
+ * \retval      Pointer to value or NULL when option is not set
+ */
+const char* BENCH_Option(int argc, char** argv, const char* name);
+
+/**
+ * \brief   Starts measurement
+ * \param[out]  *b: Pointer to measurement structure
+ */
+void BENCH_Start(BENCH_t* b);
+
+/**
+ * \brief   Stops measurement and saves elapsed time and cycles
+ * \param[in,out]   *b: Pointer to measurement structure
+ */
+void BENCH_Stop(BENCH_t* b);
+
+/**
+ * \brief   Prints result of measurement
+ * \param[in]   *bench: Benchmark name
+ * \param[in]   *cse: Case name with parameters
+ * \param[in]   *unit: Unit of processed items, such as bytes or lines
+ * \param[in]   items: Number of processed items during measurement
+ * \param[in]   *b: Finished measurement
+ */
+void BENCH_Report(const char* bench, const char* cse, const char* unit, uint64_t items, const BENCH_t* b);
+
+/**
+ * \brief   Prints result of measurement on simulated link, with throughput in virtual time
+ *
+ * Line has two more fields: "sim_ms" with virtual time and "sim_per_second" with items per virtual second.
+ * \param[in]   *bench: Benchmark name
+ * \param[in]   *cse: Case name with parameters
+ * \param[in]   *unit: Unit of processed items, such as bytes or lines
+ * \param[in]   items: Number of processed items during measurement
+ * \param[in]   ms: Virtual time of measurement in milliseconds
+ * \param[in]   *b: Finished measurement
+ */
+void BENCH_ReportSim(const char* bench, const char* cse, const char* unit, uint64_t items, uint64_t ms, const BENCH_t* b);
+
+/**
+ * \brief   Gets pseudo random number, sequence is the same on every run
+ * \param[in,out]   *seed: Pointer to generator state
+ * \retval      Random 32-bit number
+ */
+uint32_t BENCH_Random(uint32_t* seed);
+
+#endif
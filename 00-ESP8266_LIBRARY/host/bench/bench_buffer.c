@@ -0,0 +1,159 @@
+/**
+ * \brief   BUFFER_Write, BUFFER_Read and BUFFER_Find throughput
+ *
+ * Built also with BUFFER_SPSC=1 as bench_buffer_spsc, which adds cases with producer
+ * and consumer in separate threads.
+ */
+#include "bench.h"
+#include "buffer.h"
+#include "string.h"
+#include "stdlib.h"
+#if BUFFER_SPSC
+#include "pthread.h"
+#include "sched.h"
+#endif
+
+static uint8_t data[4096];
+
+/* Writes and reads back chunks, buffer indexes go over wrap point all the time */
+static void BenchWriteRead(uint32_t size, uint32_t chunk, uint64_t total) {
+    BUFFER_t b;
+    BENCH_t t;
+    uint64_t done = 0;
+    char cse[64];
+
+    if (BUFFER_Init(&b, size, NULL)) {
+        printf("{\"error\":\"buffer init failed\"}\n");
+        exit(1);
+    }
+    BUFFER_Write(&b, data, size / 3);                       /* Start with partly full buffer */
+    BENCH_Start(&t);
+    while (done < total) {
+        if (BUFFER_Write(&b, data, chunk) != chunk || BUFFER_Read(&b, data, chunk) != chunk) {
+            printf("{\"error\":\"buffer write or read failed\"}\n");
+            exit(1);
+        }
+        done += chunk;
+    }
+    BENCH_Stop(&t);
+    sprintf(cse, "write_read/size=%u/chunk=%u", (unsigned)size, (unsigned)chunk);
+    BENCH_Report("buffer", cse, "bytes", done, &t);
+    BUFFER_Free(&b);
+}
+
+/* Searches pattern at the end of buffer filled with text, data go over wrap point */
+static void BenchFind(uint32_t size, const char* pattern, uint64_t total) {
+    BUFFER_t b;
+    BENCH_t t;
+    uint32_t len = strlen(pattern), fill = size / 2, i;
+    uint64_t done = 0;
+    int32_t pos;
+    char cse[64];
+
+    if (BUFFER_Init(&b, size, NULL)) {
+        printf("{\"error\":\"buffer init failed\"}\n");
+        exit(1);
+    }
+    BUFFER_Write(&b, data, size - fill / 2);                /* Move indexes so data wrap */
+    BUFFER_Read(&b, data, size - fill / 2);
+    for (i = 0; i < fill - len; i++) {
+        uint8_t ch = 'a' + i % 26;
+        BUFFER_Write(&b, &ch, 1);
+    }
+    BUFFER_Write(&b, pattern, len);
+    BENCH_Start(&t);
+    while (done < total) {
+        if (len == 1) {
+            pos = BUFFER_FindElement(&b, (uint8_t)pattern[0]);
+        } else {
+            pos = BUFFER_Find(&b, pattern, len);
+        }
+        if (pos != (int32_t)(fill - len)) {
+            printf("{\"error\":\"pattern not found\"}\n");
+            exit(1);
+        }
+        done += fill;
+    }
+    BENCH_Stop(&t);
+    sprintf(cse, "%s/size=%u/fill=%u", len == 1 ? "find_element" : "find", (unsigned)size, (unsigned)fill);
+    BENCH_Report("buffer", cse, "bytes", done, &t);
+    BUFFER_Free(&b);
+}
+
+#if BUFFER_SPSC
+typedef struct {
+    BUFFER_t Buffer;
+    uint32_t Chunk;
+    uint64_t Total;
+} Threads_t;
+
+static void* Producer(void* arg) {
+    Threads_t* th = (Threads_t *)arg;
+    uint64_t done = 0;
+
+    uint32_t len;
+
+    while (done < th->Total) {
+        if ((len = BUFFER_Write(&th->Buffer, data, th->Chunk)) == 0) {
+            sched_yield();                                  /* Let consumer run when CPUs are shared */
+        }
+        done += len;
+    }
+    return NULL;
+}
+
+/* Producer thread writes chunks while main thread reads them, without any lock */
+static void BenchThreads(uint32_t size, uint32_t chunk, uint64_t total) {
+    static uint8_t out[4096];
+    Threads_t th;
+    pthread_t producer;
+    BENCH_t t;
+    uint64_t done = 0;
+    uint32_t len;
+    char cse[64];
+
+    if (BUFFER_Init(&th.Buffer, size, NULL)) {
+        printf("{\"error\":\"buffer init failed\"}\n");
+        exit(1);
+    }
+    th.Chunk = chunk;
+    th.Total = total;
+    BENCH_Start(&t);
+    if (pthread_create(&producer, NULL, Producer, &th)) {
+        printf("{\"error\":\"thread create failed\"}\n");
+        exit(1);
+    }
+    while (done < total) {
+        if ((len = BUFFER_Read(&th.Buffer, out, chunk)) == 0) {
+            sched_yield();
+        }
+        done += len;
+    }
+    pthread_join(producer, NULL);
+    BENCH_Stop(&t);
+    sprintf(cse, "threads/size=%u/chunk=%u", (unsigned)size, (unsigned)chunk);
+    BENCH_Report("buffer_spsc", cse, "bytes", done, &t);
+    BUFFER_Free(&th.Buffer);
+}
+#endif
+
+int main(int argc, char** argv) {
+    static const uint32_t chunks[] = {1, 16, 64, 512};
+    uint64_t total = BENCH_Quick(argc, argv) ? (1 << 16) : (1 << 26);
+    uint32_t i;
+
+    for (i = 0; i < sizeof(data); i++) {
+        data[i] = (uint8_t)i;
+    }
+    for (i = 0; i < sizeof(chunks) / sizeof(chunks[0]); i++) {
+        BenchWriteRead(4096, chunks[i], chunks[i] == 1 ? total / 8 : total);
+    }
+    BenchFind(4096, "\n", total);
+    BenchFind(4096, "\r\nOK\r\n", total);
+#if BUFFER_SPSC
+    for (i = 0; i < sizeof(chunks) / sizeof(chunks[0]); i++) {
+        BenchThreads(4096, chunks[i], chunks[i] == 1 ? total / 8 : total);
+    }
+#endif
+    return 0;
+}
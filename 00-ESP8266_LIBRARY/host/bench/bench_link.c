@@ -0,0 +1,119 @@
+/**
+ * \brief   End-to-end send and receive throughput against simulated module
+ *
+ * Library runs with host low-level layer, module is simulated with UART baudrate and network latency
+ * from case name. sim_per_second is throughput on simulated link, cycles_per_item is host CPU
+ * cost of stack and simulator for each transferred byte.
+ */
+#include "bench.h"
+#include "esp8266_host.h"
+#include "string.h"
+#include "stdlib.h"
+
+static ESP_t ESP;
+static ATSIM_t sim;
+static uint8_t data[16384];
+static uint64_t received;
+
+static int Callback(ESP_Event_t evt, ESP_EventParams_t* params) {
+    if (evt == espEventDataReceived) {
+        received += params->UI;
+    }
+    return 0;
+}
+
+static void Fail(const char* what) {
+    printf("{\"error\":\"%s\"}\n", what);
+    exit(1);
+}
+
+/* Starts module with joined network and connection to remote side */
+static ESP_CONN_t* Open(uint32_t baudrate, uint32_t latency) {
+    ATSIM_Config_t config = {0};
+    ESP_CONN_t* conn;
+
+    config.Latency = latency;
+    ATSIM_Init(&sim, &config);
+    ESP_HOST_Attach(&ESP, &sim);
+    if (ESP_Init(&ESP, 115200, Callback) != espOK) {
+        Fail("init failed");
+    }
+    if (baudrate != 115200 && ESP_SetUART(&ESP, baudrate, 0, 1) != espOK) {
+        Fail("baudrate change failed");
+    }
+    if (ESP_STA_Connect(&ESP, "Home", "password", NULL, 0, 1) != espOK ||
+        ESP_CONN_Start(&ESP, &conn, ESP_CONN_Type_TCP, "example.com", 80, 1) != espOK) {
+        Fail("connection failed");
+    }
+    received = 0;
+    return conn;
+}
+
+static void Close(void) {
+    ESP_DeInit(&ESP);
+    ESP_HOST_Detach(&ESP);
+    ATSIM_DeInit(&sim);
+}
+
+static void BenchSend(uint32_t baudrate, uint32_t latency, uint64_t total) {
+    ESP_CONN_t* conn = Open(baudrate, latency);
+    uint64_t done = 0, start = sim.Time;
+    uint32_t bw;
+    BENCH_t t;
+    char cse[64];
+
+    BENCH_Start(&t);
+    while (done < total) {
+        if (ESP_CONN_Send(&ESP, conn, data, sizeof(data), &bw, 1) != espOK || bw != sizeof(data)) {
+            Fail("send failed");
+        }
+        done += bw;
+    }
+    BENCH_Stop(&t);
+    if (sim.Conn[conn->Number].BytesSent != done) {
+        Fail("remote side did not receive all data");
+    }
+    sprintf(cse, "send/baud=%u/latency=%u", (unsigned)baudrate, (unsigned)latency);
+    BENCH_ReportSim("link", cse, "bytes", done, sim.Time - start, &t);
+    Close();
+}
+
+static void BenchReceive(uint32_t baudrate, uint32_t latency, uint64_t total) {
+    ESP_CONN_t* conn = Open(baudrate, latency);
+    uint64_t sent, start = sim.Time;
+    BENCH_t t;
+    char cse[64];
+
+    BENCH_Start(&t);
+    for (sent = 0; sent < total; sent += sizeof(data)) {    /* Remote side sends everything at once */
+        ATSIM_RemoteSend(&sim, conn->Number, data, sizeof(data));
+    }
+    while (received < total && sim.Time - start < 600000) {
+        ESP_HOST_Run(1);
+    }
+    BENCH_Stop(&t);
+    if (received != total) {
+        Fail("not all data received");
+    }
+    sprintf(cse, "receive/baud=%u/latency=%u", (unsigned)baudrate, (unsigned)latency);
+    BENCH_ReportSim("link", cse, "bytes", received, sim.Time - start, &t);
+    Close();
+}
+
+int main(int argc, char** argv) {
+    static const uint32_t baudrates[] = {115200, 921600};
+    int quick = BENCH_Quick(argc, argv);
+    uint64_t total;
+    uint32_t i;
+
+    for (i = 0; i < sizeof(data); i++) {
+        data[i] = (uint8_t)i;
+    }
+    for (i = 0; i < sizeof(baudrates) / sizeof(baudrates[0]); i++) {
+        total = quick ? 1 : baudrates[i] / 10 * 20 / sizeof(data);  /* About 20 seconds of virtual time */
+        total *= sizeof(data);
+        BenchSend(baudrates[i], 20, total);
+        BenchReceive(baudrates[i], 20, total);
+    }
+    return 0;
+}
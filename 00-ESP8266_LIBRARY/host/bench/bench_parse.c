@@ -0,0 +1,98 @@
+/**
+ * \brief   ParseReceived lines per second on module response trace
+ *
+ * Library is included directly to reach internal parser.
+ * Trace is text file with one response line per line. Default traces/session.txt follows
+ * typical session: init, CWLAP, join, several TCP connections with IPD traffic, SNTP and errors.
+ * Use trace=<file> argument to run it on capture from real module.
+ *
+ * Lines are parsed while no command is active, same as unsolicited responses,
+ * +IPD lines are cut after ':' as ESP_Update does.
+ */
+#include "esp8266.c"
+#include "bench.h"
+#include "stdlib.h"
+
+#define MAX_LINES           4096
+
+static ESP_t E;
+static ESP_Received_t Lines[MAX_LINES];
+static uint32_t LinesCount;
+
+static int Callback(ESP_Event_t evt, ESP_EventParams_t* params) {
+    return 0;
+}
+
+/* Loads trace, line endings are always converted to CRLF as module sends them */
+static void LoadTrace(const char* path) {
+    char line[256];
+    size_t len;
+    FILE* f = fopen(path, "rb");
+    
+    if (!f) {
+        printf("{\"error\":\"cannot open trace %s\"}\n", path);
+        exit(1);
+    }
+    while (LinesCount < MAX_LINES && fgets(line, sizeof(line) - 2, f)) {
+        ESP_Received_t* r = &Lines[LinesCount];
+        char* ipd;
+        
+        len = strlen(line);
+        while (len && (line[len - 1] == '\n' || line[len - 1] == '\r')) {
+            len--;
+        }
+        if (strncmp(line, "+IPD", 4) == 0 && (ipd = memchr(line, ':', len)) != NULL) {
+            len = ipd - line + 1;                           /* Data follow after colon */
+        } else {
+            line[len++] = '\r';
+            line[len++] = '\n';
+        }
+        if (len >= sizeof(r->Data)) {                       /* Line buffer in library is limited too */
+            len = sizeof(r->Data) - 1;
+        }
+        memcpy(r->Data, line, len);
+        r->Data[len] = 0;
+        r->Length = len;
+        LinesCount++;
+    }
+    fclose(f);
+    if (!LinesCount) {
+        printf("{\"error\":\"trace %s is empty\"}\n", path);
+        exit(1);
+    }
+}
+
+int main(int argc, char** argv) {
+    const char* trace = BENCH_Option(argc, argv, "trace");
+    uint64_t total = BENCH_Quick(argc, argv) ? (1 << 12) : (1 << 23), done = 0, bytes = 0;
+    uint32_t i;
+    BENCH_t t;
+    
+    LoadTrace(trace ? trace : ESP_BENCH_TRACE);
+    for (i = 0; i < LinesCount; i++) {
+        bytes += Lines[i].Length;
+    }
+    
+    BUFFER_Init((BUFFER_t *)&E.Buffer, sizeof(E.BufferData) - 1, (uint8_t *)E.BufferData);
+    for (i = 0; i < ESP_MAX_CONNECTIONS; i++) {
+        E.Conn[i].Number = i;
+    }
+    E.Callback = Callback;
+    _ESP = &E;
+    
+    BENCH_Start(&t);
+    while (done < total) {
+        for (i = 0; i < LinesCount; i++) {
+            memcpy((void *)&E.Received, &Lines[i], Lines[i].Length + 2);   /* Length, characters and terminating zero */
+            ParseReceived(&E, (ESP_Received_t *)&E.Received);
+            E.IPD.InIPD = 0;                                /* Next line is response again */
+        }
+        E.EventOut = E.EventIn;                             /* Drop events, nobody processes them */
+        E.Events.Value = 0;
+        done += LinesCount;
+    }
+    BENCH_Stop(&t);
+    BENCH_Report("parse", "session/lines", "lines", done, &t);
+    BENCH_Report("parse", "session/bytes", "bytes", done / LinesCount * bytes, &t);
+    return 0;
+}
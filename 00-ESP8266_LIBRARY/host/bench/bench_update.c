@@ -0,0 +1,149 @@
+/**
+ * \brief   ESP_Update bytes per second on received streams
+ *
+ * Library is included directly to set up instance without low-level initialization.
+ * Stream is written with ESP_DataReceivedEx and processed with ESP_Update
+ * and ESP_ProcessCallbacks until receive buffer is empty, as application does.
+ *
+ * Cases:
+ *  - ipd: +IPD packets with CIPDINFO header, payload is passed to connection callback
+ *  - cwlap: +CWLAP lines while access point list command is active
+ *
+ * With ESP_BENCH_BASELINE defined, benchmark builds against library before block receive path,
+ * which kept receive buffer and parser state in static variables.
+ */
+#include "esp8266.c"
+#include "bench.h"
+#include "stdlib.h"
+
+#ifdef ESP_BENCH_BASELINE
+#define BENCH_BUFFER            (&Buffer)
+#define BENCH_BUFFER_DATA       Buffer_Data
+#define BENCH_POINTERS          Pointers
+#define BENCH_RECEIVE(d, l)     ESP_DataReceived((uint8_t *)(d), (l))
+#else
+#define BENCH_BUFFER            ((BUFFER_t *)&E.Buffer)
+#define BENCH_BUFFER_DATA       E.BufferData
+#define BENCH_POINTERS          E.Pointers
+#define BENCH_RECEIVE(d, l)     ESP_DataReceivedEx(&E, (uint8_t *)(d), (l))
+#endif
+
+#define STREAM_SIZE         16384
+#define CWLAP_APS           20
+
+static ESP_t E;
+static uint8_t Stream[STREAM_SIZE];
+static uint32_t StreamLength;
+static uint64_t Delivered;
+static ESP_AP_t APs[CWLAP_APS];
+static uint16_t APsCount;
+
+static int Callback(ESP_Event_t evt, ESP_EventParams_t* params) {
+    if (evt == espEventDataReceived) {
+        Delivered += params->UI;                            /* Count payload delivered to application */
+    }
+    return 0;
+}
+
+static void Setup(void) {
+    uint32_t i;
+    
+    memset(&E, 0x00, sizeof(E));
+    BUFFER_Init(BENCH_BUFFER, sizeof(BENCH_BUFFER_DATA) - 1, (uint8_t *)BENCH_BUFFER_DATA);
+    for (i = 0; i < ESP_MAX_CONNECTIONS; i++) {
+        E.Conn[i].Number = i;
+    }
+    E.Callback = Callback;
+    E.ActiveCmdTimeout = 0xFFFFFFFF;
+#ifndef ESP_BENCH_BASELINE
+    _ESP = &E;
+#endif
+}
+
+/* Feeds stream to library and processes it until everything is consumed */
+static void Feed(const uint8_t* data, uint32_t len) {
+    uint32_t n;
+    
+    while (len) {
+        n = BENCH_RECEIVE(data, len);
+        data += n;
+        len -= n;
+        do {
+            ESP_Update(&E);
+            ESP_ProcessCallbacks(&E);
+        } while (BUFFER_GetFull(BENCH_BUFFER) && !n);
+    }
+    while (BUFFER_GetFull(BENCH_BUFFER)) {
+        ESP_Update(&E);
+        ESP_ProcessCallbacks(&E);
+    }
+}
+
+static void BenchIPD(uint32_t size, uint64_t total) {
+    uint32_t payload = 0, seed = 1, i;
+    uint64_t done = 0;
+    BENCH_t t;
+    char cse[32];
+    
+    Setup();
+    StreamLength = 0;
+    while (StreamLength + size + 64 <= sizeof(Stream)) {
+        StreamLength += sprintf((char *)&Stream[StreamLength], "\r\n+IPD,%u,%u,93.184.216.34,80:", (unsigned)(payload % ESP_MAX_CONNECTIONS), (unsigned)size);
+        for (i = 0; i < size; i++) {
+            Stream[StreamLength++] = (uint8_t)BENCH_Random(&seed);
+        }
+        payload += size;
+    }
+    Delivered = 0;
+    BENCH_Start(&t);
+    while (done < total) {
+        Feed(Stream, StreamLength);
+        done += StreamLength;
+    }
+    BENCH_Stop(&t);
+    if (Delivered != done / StreamLength * payload) {
+        printf("{\"error\":\"ipd payload lost, %llu of %llu bytes\"}\n", (unsigned long long)Delivered, (unsigned long long)(done / StreamLength * payload));
+        exit(1);
+    }
+    sprintf(cse, "ipd/size=%u", (unsigned)size);
+    BENCH_Report("update", cse, "bytes", done, &t);
+}
+
+static void BenchCWLAP(uint64_t total) {
+    uint64_t done = 0;
+    uint32_t i;
+    BENCH_t t;
+    
+    Setup();
+    StreamLength = 0;
+    for (i = 0; i < CWLAP_APS; i++) {
+        StreamLength += sprintf((char *)&Stream[StreamLength], "+CWLAP:(%u,\"Network-%02u\",%d,\"18:fe:34:a1:b2:%02x\",%u,%d,0)\r\n",
+            (unsigned)(i % 5), (unsigned)i, -40 - (int)i * 3, (unsigned)i, (unsigned)(i % 13 + 1), -(int)(i % 30));
+    }
+    StreamLength += sprintf((char *)&Stream[StreamLength], "\r\nOK\r\n");
+    E.ActiveCmd = CMD_WIFI_CWLAP;                           /* Lines are parsed only while command is active */
+    BENCH_Start(&t);
+    while (done < total) {
+        BENCH_POINTERS.Ptr1 = APs;
+        BENCH_POINTERS.Ptr2 = &APsCount;
+        BENCH_POINTERS.UI = CWLAP_APS;
+        APsCount = 0;
+        Feed(Stream, StreamLength);
+        if (APsCount != CWLAP_APS) {
+            printf("{\"error\":\"cwlap parsed %u of %u access points\"}\n", (unsigned)APsCount, (unsigned)CWLAP_APS);
+            exit(1);
+        }
+        done += StreamLength;
+    }
+    BENCH_Stop(&t);
+    BENCH_Report("update", "cwlap", "bytes", done, &t);
+}
+
+int main(int argc, char** argv) {
+    uint64_t total = BENCH_Quick(argc, argv) ? (1 << 16) : (1 << 28);
+    
+    BenchIPD(1460, total);
+    BenchIPD(64, total / 4);
+    BenchCWLAP(total / 16);
+    return 0;
+}
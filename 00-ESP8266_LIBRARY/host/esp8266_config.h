@@ -0,0 +1,152 @@
+/**
+ * \author  Tilen Majerle
+ * \email   tilen@majerle.eu
+ * \website http://esp8266at.com
+ * \license MIT
+ * \brief   Configuration of ESP8266 library for host build
+ *
+\verbatim
+   ----------------------------------------------------------------------
+    Copyright (c) 2016 Tilen Majerle
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without restriction,
+    including without limitation the rights to use, copy, modify, merge,
+    publish, distribute, sublicense, and/or sell copies of the Software,
+    and to permit persons to whom the Software is furnished to do so,
+    subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+    AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+    OTHER DEALINGS IN THE SOFTWARE.
+   ----------------------------------------------------------------------
+\endverbatim
+ */
+#ifndef ESP_CONFIG_H
+#define ESP_CONFIG_H
+
+/**
+ * Host build uses this file instead of esp8266_config.h from application.
+ * Description of each value is in esp8266_config_template.h.
+ *
+ * Every value can be changed from build system with compiler definition,
+ * CMake builds library in more configurations this way.
+ */
+
+#ifndef ESP_BUFFER_SIZE
+#define ESP_BUFFER_SIZE                     4096
+#endif
+
+#ifndef ESP_TX_BUFFER_SIZE
+#define ESP_TX_BUFFER_SIZE                  128
+#endif
+
+#ifndef ESP_CMD_QUEUE_SIZE
+#define ESP_CMD_QUEUE_SIZE                  4
+#endif
+
+#ifndef ESP_REQUEST_COUNT
+#define ESP_REQUEST_COUNT                   4
+#endif
+
+#ifndef ESP_EVENT_QUEUE_SIZE
+#define ESP_EVENT_QUEUE_SIZE                16
+#endif
+
+#ifndef ESP_SENDBUF_SEGMENTS
+#define ESP_SENDBUF_SEGMENTS                4
+#endif
+
+#ifndef ESP_SINGLE_CONN
+#define ESP_SINGLE_CONN                     0
+#endif
+
+#ifndef ESP_CONNBUFFER_SIZE
+#define ESP_CONNBUFFER_SIZE                 1460
+#endif
+
+#ifndef ESP_TRANSFER_TX_SIZE
+#define ESP_TRANSFER_TX_SIZE                0
+#endif
+
+#ifndef ESP_CONN_SINGLEBUFFER
+#define ESP_CONN_SINGLEBUFFER               0
+#endif
+
+#ifndef ESP_CONN_RX_SIZE
+#define ESP_CONN_RX_SIZE                    0
+#endif
+
+#ifndef ESP_IPD_POOL_BLOCKS
+#define ESP_IPD_POOL_BLOCKS                 0
+#endif
+
+#ifndef ESP_IPD_POOL_BLOCK_SIZE
+#define ESP_IPD_POOL_BLOCK_SIZE             256
+#endif
+
+#ifndef ESP_ECHO
+#define ESP_ECHO                            0
+#endif
+
+/* Host build runs stack in single thread, update is done while waiting */
+#ifndef ESP_RTOS
+#define ESP_RTOS                            0
+#endif
+
+#ifndef ESP_RTOS_TIMEOUT
+#define ESP_RTOS_TIMEOUT                    180000
+#endif
+
+#ifndef ESP_ASYNC
+#define ESP_ASYNC                           1
+#endif
+
+/* Simulated module runs while stack waits, see esp8266_host.h */
+#ifndef ESP_HOST_SIM
+#define ESP_HOST_SIM                        0
+#endif
+
+#if ESP_HOST_SIM
+void ESP_HOST_Yield(void);
+#define ESP_RTOS_YIELD()                    ESP_HOST_Yield()
+#endif
+
+#ifndef ESP_USE_CTS
+#define ESP_USE_CTS                         0
+#endif
+
+#ifndef ESP_AUTOBAUD
+#define ESP_AUTOBAUD                        0
+#endif
+
+#ifndef ESP_AUTOBAUD_LIST
+#define ESP_AUTOBAUD_LIST                   230400, 460800, 921600
+#endif
+
+#ifndef ESP_AUTOBAUD_CHECKS
+#define ESP_AUTOBAUD_CHECKS                 10
+#endif
+
+#ifndef ESP_AUTOBAUD_GARBAGE
+#define ESP_AUTOBAUD_GARBAGE                0
+#endif
+
+#ifndef ESP_STATS
+#define ESP_STATS                           0
+#endif
+
+#ifndef ESP_STATS_CMDS
+#define ESP_STATS_CMDS                      16
+#endif
+
+#endif
@@ -0,0 +1,61 @@
+/**
+ * \brief   Host low-level layer connecting library to simulated module
+ *
+ * Each ESP instance is attached to its own simulator before \ref ESP_Init is called.
+ * Library and simulators run in the same thread on virtual time: every time stack waits
+ * for command to finish, \ref ESP_HOST_Yield moves time of all attached instances for 1 millisecond,
+ * passes bytes module sent to stack and updates stack.
+ *
+ * Library must be built with ESP_HOST_SIM set to 1, CMake target esp8266_host does it.
+ *
+\verbatim
+ESP_t ESP;
+ATSIM_t sim;
+
+ATSIM_Init(&sim, NULL);
+ESP_HOST_Attach(&ESP, &sim);
+ESP_Init(&ESP, 115200, callback);   //Module boots and stack initializes it in virtual time
+\endverbatim
+ */
+#ifndef ESP8266_HOST_H
+#define ESP8266_HOST_H
+
+#include "esp8266_ll.h"
+#include "at_sim.h"
+
+#define ESP_HOST_MAX_INSTANCES      8       /*!< Maximal number of attached instances */
+
+/**
+ * \brief   Attaches ESP instance to simulated module
+ * \param[in]   *ESP: Pointer to ESP instance, stack does not need to be initialized yet
+ * \param[in]   *sim: Pointer to initialized simulator
+ * \retval      0 on success, -1 when there is no free entry
+ */
+int ESP_HOST_Attach(evol ESP_t* ESP, ATSIM_t* sim);
+
+/**
+ * \brief   Detaches ESP instance from simulated module
+ * \param[in]   *ESP: Pointer to ESP instance
+ */
+void ESP_HOST_Detach(evol ESP_t* ESP);
+
+/**
+ * \brief   Gets simulator instance is attached to
+ * \param[in]   *ESP: Pointer to ESP instance
+ * \retval      Pointer to simulator or NULL when instance is not attached
+ */
+ATSIM_t* ESP_HOST_GetSim(evol ESP_t* ESP);
+
+/**
+ * \brief   Moves virtual time for 1 millisecond and updates all attached instances
+ * \note    Library calls it with ESP_RTOS_YIELD while waiting. Nested calls from callbacks do nothing
+ */
+void ESP_HOST_Yield(void);
+
+/**
+ * \brief   Runs all attached instances for given virtual time and processes their callbacks
+ * \param[in]   ms: Number of milliseconds
+ */
+void ESP_HOST_Run(uint32_t ms);
+
+#endif
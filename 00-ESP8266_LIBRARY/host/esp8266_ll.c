@@ -0,0 +1,150 @@
+/**
+ * \brief   Low-level layer of host build, module is simulated in the same process
+ *
+ * UART between stack and module behaves as with hardware flow control:
+ * bytes which do not fit into stack buffer stay in simulator until stack reads data.
+ */
+#include "esp8266_host.h"
+#include "string.h"
+
+typedef struct {
+    evol ESP_t* ESP;                                        /* Attached instance */
+    ATSIM_t* Sim;                                           /* Module of instance */
+} Host_t;
+
+static Host_t Hosts[ESP_HOST_MAX_INSTANCES];
+static uint8_t InYield;
+
+static Host_t* FindLL(const ESP_LL_t* LL) {
+    uint8_t i;
+    for (i = 0; i < ESP_HOST_MAX_INSTANCES; i++) {
+        if (Hosts[i].ESP && (const ESP_LL_t *)&Hosts[i].ESP->LL == LL) {
+            return &Hosts[i];
+        }
+    }
+    return NULL;
+}
+
+/* Passes bytes module sent to stack, returns number of passed bytes */
+static uint32_t Pump(Host_t* h) {
+    const uint8_t* data;
+    uint32_t len, total = 0;
+    uint16_t count;
+
+    while ((len = ATSIM_Peek(h->Sim, &data)) > 0) {
+        count = ESP_DataReceivedEx(h->ESP, (uint8_t *)data, len > 0xFFFF ? 0xFFFF : (uint16_t)len);
+        ATSIM_Consume(h->Sim, count);
+        total += count;
+        if (count < len) {                                  /* Stack buffer is full */
+            break;
+        }
+    }
+    return total;
+}
+
+int ESP_HOST_Attach(evol ESP_t* ESP, ATSIM_t* sim) {
+    uint8_t i;
+    for (i = 0; i < ESP_HOST_MAX_INSTANCES; i++) {
+        if (!Hosts[i].ESP || Hosts[i].ESP == ESP) {
+            Hosts[i].ESP = ESP;
+            Hosts[i].Sim = sim;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+void ESP_HOST_Detach(evol ESP_t* ESP) {
+    uint8_t i;
+    for (i = 0; i < ESP_HOST_MAX_INSTANCES; i++) {
+        if (Hosts[i].ESP == ESP) {
+            memset(&Hosts[i], 0x00, sizeof(Hosts[i]));
+        }
+    }
+}
+
+ATSIM_t* ESP_HOST_GetSim(evol ESP_t* ESP) {
+    Host_t* h = FindLL((const ESP_LL_t *)&ESP->LL);
+    return h ? h->Sim : NULL;
+}
+
+void ESP_HOST_Yield(void) {
+    uint8_t i, loops;
+    Host_t* h;
+
+    if (InYield) {                                          /* Called again from stack update */
+        return;
+    }
+    InYield = 1;
+    for (i = 0; i < ESP_HOST_MAX_INSTANCES; i++) {
+        h = &Hosts[i];
+        if (!h->ESP) {
+            continue;
+        }
+        ESP_UpdateTime(h->ESP, 1);
+        ATSIM_Step(h->Sim, 1);
+        loops = 16;                                         /* Stack reads buffer in parts */
+        do {
+            ESP_Update(h->ESP);
+        } while (Pump(h) && --loops);
+    }
+    InYield = 0;
+}
+
+void ESP_HOST_Run(uint32_t ms) {
+    uint8_t i;
+
+    while (ms--) {
+        ESP_HOST_Yield();
+        for (i = 0; i < ESP_HOST_MAX_INSTANCES; i++) {
+            if (Hosts[i].ESP) {
+                ESP_ProcessCallbacks(Hosts[i].ESP);
+            }
+        }
+    }
+}
+
+uint8_t ESP_LL_Callback(ESP_LL_Control_t ctrl, void* param, void* result) {
+    Host_t* h;
+
+    switch (ctrl) {
+        case ESP_LL_Control_Init: {                         /* Initialize low-level part of communication */
+            ESP_LL_t* LL = (ESP_LL_t *)param;
+            if ((h = FindLL(LL)) == NULL) {
+                *(uint8_t *)result = 1;                     /* Instance was not attached */
+                return 1;
+            }
+            ATSIM_SetHostBaudrate(h->Sim, LL->Baudrate);
+            *(uint8_t *)result = 0;
+            return 1;
+        }
+        case ESP_LL_Control_Send: {
+            ESP_LL_Send_t* send = (ESP_LL_Send_t *)param;
+            if ((h = FindLL(send->LL)) == NULL) {
+                *(uint8_t *)result = 1;
+                return 1;
+            }
+            ATSIM_Write(h->Sim, send->Data, send->Count);
+            *(uint8_t *)result = 0;
+            return 1;
+        }
+        case ESP_LL_Control_SetReset: {
+            ESP_LL_Pin_t* pin = (ESP_LL_Pin_t *)param;
+            if ((h = FindLL(pin->LL)) != NULL) {
+                ATSIM_SetReset(h->Sim, pin->State == ESP_RESET_SET);
+            }
+            if (result) {
+                *(uint8_t *)result = h == NULL;
+            }
+            return 1;
+        }
+        case ESP_LL_Control_SetRTS: {                       /* Flow control is implicit */
+            if (result) {
+                *(uint8_t *)result = 0;
+            }
+            return 1;
+        }
+        default:
+            return 0;
+    }
+}
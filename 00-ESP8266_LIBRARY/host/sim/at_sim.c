@@ -0,0 +1,1176 @@
+/**
+ * \brief   Simulated ESP8266 module with AT commands firmware
+ */
+#include "at_sim.h"
+#include "stdarg.h"
+#include "stdio.h"
+#include "stdlib.h"
+#include "string.h"
+#include "time.h"
+
+/* Scheduled actions */
+#define ACT_OUTPUT              0
+#define ACT_BOOT                1           /* Module finished boot */
+#define ACT_RESTART             2           /* Software reset after OK was sent */
+#define ACT_BAUD                3           /* Change module baudrate after OK was sent */
+#define ACT_IDLE                4           /* Long command finished */
+#define ACT_SCAN                5           /* CWLAP finished */
+#define ACT_JOIN                6           /* CWJAP finished */
+#define ACT_CONNECT             7           /* CIPSTART finished */
+#define ACT_SEND                8           /* CIPSEND finished, data are acknowledged */
+#define ACT_SEGMENT             9           /* Segment from send buffer acknowledged */
+#define ACT_REMOTE              10          /* Data from remote side arrived */
+
+#define DATA_NONE               0
+#define DATA_SEND               1           /* CIPSEND */
+#define DATA_SENDEX             2           /* CIPSENDEX */
+#define DATA_SENDBUF            3           /* CIPSENDBUF */
+
+#define GARBAGE                 0xFF        /* Character host can not receive */
+#define DEFAULT_BAUDRATE        115200
+#define PLUS_GUARD_TIME         20          /* Milliseconds without data around +++ */
+#define SNTP_BASE_TIME          1470320885  /* Thu Aug 04 14:28:05 2016 */
+
+#define RESULT_OK               "\r\nOK\r\n"
+#define RESULT_ERROR            "\r\nERROR\r\n"
+
+static const ATSIM_AP_t DefaultAPs[] = {
+    {"Home",            "password",     3, -45, 6,  {0x60, 0x31, 0x97, 0x11, 0x22, 0x33}},
+    {"Office",          "office-pass",  4, -62, 1,  {0x60, 0x31, 0x97, 0x44, 0x55, 0x66}},
+    {"Guest",           "",             0, -70, 11, {0x60, 0x31, 0x97, 0x77, 0x88, 0x99}},
+    {"Neighbour,\"5G\"", NULL,          3, -84, 13, {0x60, 0x31, 0x97, 0xAA, 0xBB, 0xCC}},
+};
+
+static const uint8_t STAMAC[6] = {0x18, 0xFE, 0x34, 0xA1, 0xB2, 0xC3};
+static const uint8_t APMAC[6] = {0x1A, 0xFE, 0x34, 0xA1, 0xB2, 0xC3};
+static const uint8_t RemoteIP[4] = {93, 184, 216, 34};
+
+/******************************************************************************/
+/***                               Helpers                                   **/
+/******************************************************************************/
+static uint32_t Random(ATSIM_t* sim) {
+    uint32_t x = sim->Random;                               /* Xorshift generator */
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    sim->Random = x;
+    return x;
+}
+
+/* Returns 1 with probability of permille / 1000 */
+static int Chance(ATSIM_t* sim, uint16_t permille) {
+    return permille && Random(sim) % 1000 < permille;
+}
+
+static uint32_t Bandwidth(ATSIM_t* sim) {
+    return sim->Config.Bandwidth ? sim->Config.Bandwidth : sim->Baudrate / 10;
+}
+
+static void QueuePut(ATSIM_Queue_t* q, const uint8_t* data, uint32_t len) {
+    if (q->Out && q->Out == q->In) {                        /* Empty queue, start from beginning */
+        q->In = q->Out = 0;
+    }
+    if (q->In + len > q->Size) {
+        if (q->Out) {                                       /* Move data to beginning first */
+            memmove(q->Data, &q->Data[q->Out], q->In - q->Out);
+            q->In -= q->Out;
+            q->Out = 0;
+        }
+        if (q->In + len > q->Size) {
+            uint32_t size = q->Size ? q->Size : 4096;
+            while (size < q->In + len) {
+                size *= 2;
+            }
+            q->Data = realloc(q->Data, size);
+            if (!q->Data) {
+                abort();
+            }
+            q->Size = size;
+        }
+    }
+    memcpy(&q->Data[q->In], data, len);
+    q->In += len;
+}
+
+static void QueueReset(ATSIM_Queue_t* q) {
+    q->In = q->Out = 0;
+}
+
+/* Schedules event, ordered events never overtake previous ordered ones */
+static ATSIM_Event_t* Schedule(ATSIM_t* sim, uint32_t delay, uint8_t action, uint32_t arg, const void* data, uint32_t len, uint8_t ordered) {
+    ATSIM_Event_t* e = malloc(sizeof(ATSIM_Event_t) + len);
+    ATSIM_Event_t** p = &sim->Events;
+
+    if (!e) {
+        abort();
+    }
+    e->Due = sim->Time + delay;
+    if (ordered) {
+        if (e->Due < sim->LastOutput) {
+            e->Due = sim->LastOutput;
+        }
+        sim->LastOutput = e->Due;
+    }
+    e->Action = action;
+    e->Raw = 0;
+    e->Arg = arg;
+    e->Length = len;
+    if (len) {
+        memcpy(e->Data, data, len);
+    }
+    while (*p && (*p)->Due <= e->Due) {                     /* Events with the same time keep order */
+        p = &(*p)->Next;
+    }
+    e->Next = *p;
+    *p = e;
+    return e;
+}
+
+/* Schedules response to command after command time */
+static void Reply(ATSIM_t* sim, const char* fmt, ...) {
+    char str[1024];
+    va_list args;
+    int len;
+
+    va_start(args, fmt);
+    len = vsnprintf(str, sizeof(str), fmt, args);
+    va_end(args);
+    Schedule(sim, sim->Config.CommandTime, ACT_OUTPUT, 0, str, len, 1);
+}
+
+/* Schedules action after responses which are already waiting */
+static void After(ATSIM_t* sim, uint32_t delay, uint8_t action, uint32_t arg) {
+    Schedule(sim, sim->Config.CommandTime + delay, action, arg, NULL, 0, 1);
+}
+
+/* Sends data to host now */
+static void Emit(ATSIM_t* sim, const uint8_t* data, uint32_t len, uint8_t raw) {
+    uint32_t i;
+
+    if (sim->InReset || !len) {
+        return;
+    }
+    QueuePut(&sim->Output, data, len);
+    if (sim->HostBaudrate && sim->HostBaudrate != sim->Baudrate) {  /* Host receives only garbage at wrong baudrate */
+        memset(&sim->Output.Data[sim->Output.In - len], GARBAGE, len);
+        return;
+    }
+    if (!raw && sim->Config.GarbageRate) {
+        for (i = sim->Output.In - len; i < sim->Output.In; i++) {
+            if (Chance(sim, sim->Config.GarbageRate)) {
+                sim->Output.Data[i] = GARBAGE;
+                sim->Garbage++;
+            }
+        }
+    }
+}
+
+static void EmitStr(ATSIM_t* sim, const char* fmt, ...) {
+    char str[1024];
+    va_list args;
+    int len;
+
+    va_start(args, fmt);
+    len = vsnprintf(str, sizeof(str), fmt, args);
+    va_end(args);
+    Emit(sim, (const uint8_t *)str, len, 0);
+}
+
+/* Writes connection prefix "n," in multiple connections mode */
+static const char* ConnPrefix(ATSIM_t* sim, uint8_t conn, char* str) {
+    if (sim->Mux) {
+        sprintf(str, "%u,", (unsigned)conn);
+    } else {
+        str[0] = 0;
+    }
+    return str;
+}
+
+static const ATSIM_AP_t* AP(ATSIM_t* sim, int index) {
+    return &sim->Config.APs[index];
+}
+
+static void FormatMAC(char* str, const uint8_t* mac) {
+    sprintf(str, "%02x:%02x:%02x:%02x:%02x:%02x", mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+}
+
+/******************************************************************************/
+/***                         Command line arguments                          **/
+/******************************************************************************/
+typedef struct {
+    char* Arg[8];                                           /* Arguments, quotes and escapes removed */
+    uint8_t Quoted[8];                                      /* Argument was string */
+    uint8_t Count;                                          /* Number of arguments */
+    char Buffer[ATSIM_MAX_LINE];
+} Args_t;
+
+/* Splits arguments after = sign, returns number of arguments */
+static int SplitArgs(const char* str, Args_t* a) {
+    char* out = a->Buffer;
+    uint8_t quote = 0;
+
+    memset(a, 0x00, sizeof(*a));
+    if (!*str) {
+        return 0;
+    }
+    a->Arg[a->Count++] = out;
+    while (*str) {
+        if (quote) {
+            if (*str == '\\' && str[1]) {                   /* Escaped character */
+                *out++ = *++str;
+            } else if (*str == '"') {
+                quote = 0;
+            } else {
+                *out++ = *str;
+            }
+        } else if (*str == '"') {
+            quote = 1;
+            a->Quoted[a->Count - 1] = 1;
+        } else if (*str == ',') {
+            *out++ = 0;
+            if (a->Count == sizeof(a->Arg) / sizeof(a->Arg[0])) {
+                break;
+            }
+            a->Arg[a->Count++] = out;
+        } else {
+            *out++ = *str;
+        }
+        str++;
+    }
+    *out = 0;
+    return a->Count;
+}
+
+static int IsNumber(const char* str) {
+    if (*str == '-') {
+        str++;
+    }
+    if (!*str) {
+        return 0;
+    }
+    while (*str) {
+        if (*str < '0' || *str > '9') {
+            return 0;
+        }
+        str++;
+    }
+    return 1;
+}
+
+/* Resolves host name, returns 0 when name does not exist */
+static int Resolve(const char* host, uint8_t* ip) {
+    unsigned a, b, c, d;
+    size_t len = strlen(host);
+
+    if (sscanf(host, "%u.%u.%u.%u", &a, &b, &c, &d) == 4) {
+        ip[0] = a; ip[1] = b; ip[2] = c; ip[3] = d;
+        return 1;
+    }
+    if (!len || (len >= 8 && strcmp(&host[len - 8], ".invalid") == 0)) {   /* Reserved name which never resolves */
+        return 0;
+    }
+    memcpy(ip, RemoteIP, 4);
+    return 1;
+}
+
+/******************************************************************************/
+/***                             Connections                                 **/
+/******************************************************************************/
+static void ConnReset(ATSIM_Conn_t* c) {
+    uint64_t sent = c->BytesSent, received = c->BytesReceived;
+
+    memset(c, 0x00, sizeof(*c));
+    c->BytesSent = sent;                                    /* Statistics stay for test checks */
+    c->BytesReceived = received;
+}
+
+/* Removes scheduled events of closed connection */
+static void ConnDropEvents(ATSIM_t* sim, uint8_t conn) {
+    ATSIM_Event_t** p = &sim->Events;
+
+    while (*p) {
+        ATSIM_Event_t* e = *p;
+        if ((e->Action == ACT_SEGMENT || e->Action == ACT_REMOTE) && (e->Arg & 0xFF) == conn) {
+            *p = e->Next;
+            free(e);
+        } else {
+            p = &e->Next;
+        }
+    }
+}
+
+static void ConnClosed(ATSIM_t* sim, uint8_t conn) {
+    char pre[4];
+
+    ConnReset(&sim->Conn[conn]);
+    ConnDropEvents(sim, conn);
+    if (sim->Transparent && conn == 0) {                    /* Transparent mode ends with connection */
+        sim->Transparent = 0;
+        sim->DataReceived = 0;
+    }
+    EmitStr(sim, "%sCLOSED\r\n", ConnPrefix(sim, conn, pre));
+}
+
+/* Data arrived to remote side */
+static void RemoteReceived(ATSIM_t* sim, uint8_t conn, const uint8_t* data, uint32_t len) {
+    sim->Conn[conn].BytesSent += len;
+    if (sim->Config.RemoteCallback) {
+        sim->Config.RemoteCallback(sim, conn, data, len);
+    }
+    if (sim->Config.Remote == ATSIM_Remote_Echo) {
+        Schedule(sim, sim->Config.Latency, ACT_REMOTE, conn, data, len, 0);
+    }
+}
+
+/* Sends data from remote side to host as +IPD statements */
+static void EmitIPD(ATSIM_t* sim, uint8_t conn, const uint8_t* data, uint32_t len) {
+    ATSIM_Conn_t* c = &sim->Conn[conn];
+    uint32_t count;
+    char hdr[64];
+    int n;
+
+    c->BytesReceived += len;
+    if (sim->Transparent && conn == 0) {                    /* Data without header in transparent mode */
+        Emit(sim, data, len, 1);
+        return;
+    }
+    while (len) {
+        count = len > sim->Config.IpdSize ? sim->Config.IpdSize : len;
+        n = sprintf(hdr, "\r\n+IPD,");
+        if (sim->Mux) {
+            n += sprintf(&hdr[n], "%u,", (unsigned)conn);
+        }
+        n += sprintf(&hdr[n], "%u", (unsigned)count);
+        if (sim->DInfo) {
+            n += sprintf(&hdr[n], ",%u.%u.%u.%u,%u", c->IP[0], c->IP[1], c->IP[2], c->IP[3], (unsigned)c->RemotePort);
+        }
+        hdr[n++] = ':';
+        Emit(sim, (const uint8_t *)hdr, n, 0);
+        Emit(sim, data, count, 1);
+        data += count;
+        len -= count;
+    }
+}
+
+/* Gets connection number from arguments, returns -1 on invalid input */
+static int ArgConn(ATSIM_t* sim, Args_t* a, int* index) {
+    int conn = 0;
+
+    if (sim->Mux) {
+        if (*index >= a->Count || !IsNumber(a->Arg[*index])) {
+            return -1;
+        }
+        conn = atoi(a->Arg[(*index)++]);
+        if (conn < 0 || conn >= ATSIM_MAX_CONNECTIONS) {
+            return -1;
+        }
+    }
+    return conn;
+}
+
+/******************************************************************************/
+/***                               Commands                                  **/
+/******************************************************************************/
+static void CmdCIPSTART(ATSIM_t* sim, Args_t* a) {
+    int i = 0, conn = ArgConn(sim, a, &i);
+    ATSIM_Conn_t* c;
+
+    if (conn < 0 || a->Count - i < 3 || !IsNumber(a->Arg[i + 2])) {
+        Reply(sim, RESULT_ERROR);
+        return;
+    }
+    c = &sim->Conn[conn];
+    if (c->Active || c->Connecting) {
+        Reply(sim, "ALREADY CONNECTED\r\n" RESULT_ERROR);
+        return;
+    }
+    if (sim->Joined < 0) {
+        Reply(sim, "no ip\r\n" RESULT_ERROR);
+        return;
+    }
+    if (strcmp(a->Arg[i], "TCP") && strcmp(a->Arg[i], "UDP") && strcmp(a->Arg[i], "SSL")) {
+        Reply(sim, "Link type ERROR\r\n" RESULT_ERROR);
+        return;
+    }
+    if (!Resolve(a->Arg[i + 1], c->IP)) {
+        Reply(sim, "DNS Fail\r\n" RESULT_ERROR);
+        return;
+    }
+    strcpy(c->Type, a->Arg[i]);
+    c->RemotePort = atoi(a->Arg[i + 2]);
+    c->LocalPort = sim->NextLocalPort++;
+    c->Connecting = 1;
+    sim->Busy = 1;
+    After(sim, sim->Config.Latency, ACT_CONNECT, conn);     /* Connection takes one round trip */
+}
+
+static void CmdCIPCLOSE(ATSIM_t* sim, Args_t* a) {
+    int i = 0, conn = ArgConn(sim, a, &i);
+    char pre[4];
+
+    if (sim->Mux && a->Count && atoi(a->Arg[0]) == ATSIM_MAX_CONNECTIONS) {  /* Close all connections */
+        for (i = 0; i < ATSIM_MAX_CONNECTIONS; i++) {
+            if (sim->Conn[i].Active) {
+                ConnReset(&sim->Conn[i]);
+                ConnDropEvents(sim, i);
+                Reply(sim, "%u,CLOSED\r\n", (unsigned)i);
+            }
+        }
+        Reply(sim, RESULT_OK);
+        return;
+    }
+    if (conn < 0 || !sim->Conn[conn].Active) {
+        Reply(sim, "UNLINK\r\n" RESULT_ERROR);
+        return;
+    }
+    ConnReset(&sim->Conn[conn]);
+    ConnDropEvents(sim, conn);
+    Reply(sim, "%sCLOSED\r\n" RESULT_OK, ConnPrefix(sim, conn, pre));
+}
+
+static void CmdCIPSTATUS(ATSIM_t* sim) {
+    uint8_t i, active = 0;
+    ATSIM_Conn_t* c;
+
+    for (i = 0; i < ATSIM_MAX_CONNECTIONS; i++) {
+        active |= sim->Conn[i].Active;
+    }
+    Reply(sim, "STATUS:%u\r\n", sim->Joined < 0 ? 5 : (active ? 3 : 2));
+    for (i = 0; i < ATSIM_MAX_CONNECTIONS; i++) {
+        c = &sim->Conn[i];
+        if (c->Active) {
+            Reply(sim, "+CIPSTATUS:%u,\"%s\",\"%u.%u.%u.%u\",%u,%u,%u\r\n", (unsigned)i, c->Type,
+                c->IP[0], c->IP[1], c->IP[2], c->IP[3], (unsigned)c->RemotePort, (unsigned)c->LocalPort, (unsigned)c->Server);
+        }
+    }
+    Reply(sim, RESULT_OK);
+}
+
+/* Starts data receive after > prompt */
+static void CmdSend(ATSIM_t* sim, Args_t* a, uint8_t mode) {
+    int i = 0, conn = ArgConn(sim, a, &i);
+    ATSIM_Conn_t* c;
+    uint32_t len;
+
+    if (conn < 0 || a->Count - i != 1 || !IsNumber(a->Arg[i])) {
+        Reply(sim, RESULT_ERROR);
+        return;
+    }
+    c = &sim->Conn[conn];
+    len = atoi(a->Arg[i]);
+    if (!c->Active) {
+        Reply(sim, "link is not valid\r\n" RESULT_ERROR);
+        return;
+    }
+    if (!len || len > 2048) {
+        Reply(sim, RESULT_ERROR);
+        return;
+    }
+    if (mode == DATA_SENDBUF) {
+        if (c->BufferUsed + len > sim->Config.SendBufSize) {    /* No memory in module send buffer */
+            Reply(sim, RESULT_ERROR);
+            return;
+        }
+        Reply(sim, "%u,%u\r\n", (unsigned)(c->Segment + 1), (unsigned)c->SegmentAcked);
+    }
+    Reply(sim, "\r\nOK\r\n> ");
+    sim->DataMode = mode;
+    sim->DataConn = conn;
+    sim->DataLength = len;
+    sim->DataReceived = 0;
+}
+
+/* All data after > prompt were received */
+static void SendDone(ATSIM_t* sim) {
+    ATSIM_Conn_t* c = &sim->Conn[sim->DataConn];
+    uint32_t len = sim->DataReceived;
+    uint8_t fail;
+
+    if (sim->DataMode == DATA_SENDEX && len >= 2 && sim->DataBuffer[len - 2] == '\\' && sim->DataBuffer[len - 1] == '0') {
+        len -= 2;                                           /* Remove end marker */
+    }
+    Reply(sim, "\r\nRecv %u bytes\r\n", (unsigned)len);
+    if (sim->DataMode == DATA_SENDBUF) {
+        uint64_t due = sim->LastOutput + sim->Config.Latency;   /* Segment is acknowledged after round trip */
+        ATSIM_Event_t* e;
+
+        if (due < c->LinkFree) {                            /* Segments are sent in order */
+            due = c->LinkFree;
+        }
+        c->LinkFree = due;
+        c->Segment++;
+        c->BufferUsed += len;
+        e = Schedule(sim, (uint32_t)(due - sim->Time), ACT_SEGMENT, sim->DataConn | (c->Segment << 8), sim->DataBuffer, len, 0);
+        e->Raw = 1;
+    } else {
+        fail = Chance(sim, sim->Config.SendFailRate);
+        if (fail) {
+            sim->SendFails++;
+        } else {
+            RemoteReceived(sim, sim->DataConn, sim->DataBuffer, len);
+        }
+        sim->Busy = 1;                                      /* Module waits for acknowledge */
+        After(sim, sim->Config.Latency, ACT_SEND, fail);
+    }
+    sim->DataMode = DATA_NONE;
+}
+
+static void CmdCIPBUFSTATUS(ATSIM_t* sim, Args_t* a) {
+    int i = 0, conn = ArgConn(sim, a, &i);
+    ATSIM_Conn_t* c;
+
+    if (conn < 0 || !sim->Conn[conn].Active) {
+        Reply(sim, "link is not valid\r\n" RESULT_ERROR);
+        return;
+    }
+    c = &sim->Conn[conn];
+    Reply(sim, "%u,%u,%u,%u,%u\r\n" RESULT_OK, (unsigned)(c->Segment + 1), (unsigned)c->SegmentSent,
+        (unsigned)c->SegmentAcked, (unsigned)(sim->Config.SendBufSize - c->BufferUsed), (unsigned)(c->Segment - c->SegmentAcked));
+}
+
+static void CmdCIPCHECKSEQ(ATSIM_t* sim, Args_t* a) {
+    int i = 0, conn = ArgConn(sim, a, &i);
+    char pre[4];
+    uint32_t seg;
+
+    if (conn < 0 || a->Count - i != 1 || !sim->Conn[conn].Active) {
+        Reply(sim, RESULT_ERROR);
+        return;
+    }
+    seg = atoi(a->Arg[i]);
+    Reply(sim, "%s%u,%u\r\n" RESULT_OK, ConnPrefix(sim, conn, pre), (unsigned)seg, seg && seg <= sim->Conn[conn].SegmentAcked);
+}
+
+static void CmdCWJAP(ATSIM_t* sim, Args_t* a) {
+    int i;
+
+    if (a->Count < 2) {
+        Reply(sim, RESULT_ERROR);
+        return;
+    }
+    for (i = 0; i < sim->Config.APsCount; i++) {
+        if (strcmp(AP(sim, i)->SSID, a->Arg[0]) == 0) {
+            break;
+        }
+    }
+    sim->Busy = 1;
+    if (i == sim->Config.APsCount) {
+        After(sim, sim->Config.JoinTime, ACT_JOIN, 0x300);  /* AP not found */
+    } else if (!AP(sim, i)->Password || strcmp(AP(sim, i)->Password, a->Arg[1])) {
+        After(sim, sim->Config.JoinTime, ACT_JOIN, 0x200);  /* Wrong password */
+    } else {
+        After(sim, sim->Config.JoinTime, ACT_JOIN, i);
+    }
+}
+
+static void CmdQuery(ATSIM_t* sim, const char* cmd) {
+    char mac[18];
+
+    if (strcmp(cmd, "GMR") == 0) {
+        Reply(sim, "AT version:1.6.2.0(Apr 13 2018 11:10:59)\r\nSDK version:2.2.1(6ab97e9)\r\ncompile time:Jun  7 2018 19:34:26\r\n" RESULT_OK);
+    } else if (strcmp(cmd, "CIPSTAMAC_CUR?") == 0 || strcmp(cmd, "CIPSTAMAC_DEF?") == 0) {
+        FormatMAC(mac, STAMAC);
+        Reply(sim, "+%.13s:\"%s\"\r\n" RESULT_OK, cmd, mac);
+    } else if (strcmp(cmd, "CIPAPMAC_CUR?") == 0 || strcmp(cmd, "CIPAPMAC_DEF?") == 0) {
+        FormatMAC(mac, APMAC);
+        Reply(sim, "+%.12s:\"%s\"\r\n" RESULT_OK, cmd, mac);
+    } else if (strcmp(cmd, "CIPSTA_CUR?") == 0 || strcmp(cmd, "CIPSTA_DEF?") == 0) {
+        if (sim->Joined < 0) {
+            Reply(sim, "+%.10s:ip:\"0.0.0.0\"\r\n+%.10s:gateway:\"0.0.0.0\"\r\n+%.10s:netmask:\"0.0.0.0\"\r\n" RESULT_OK, cmd, cmd, cmd);
+        } else {
+            Reply(sim, "+%.10s:ip:\"192.168.1.57\"\r\n+%.10s:gateway:\"192.168.1.1\"\r\n+%.10s:netmask:\"255.255.255.0\"\r\n" RESULT_OK, cmd, cmd, cmd);
+        }
+    } else if (strcmp(cmd, "CIPAP_CUR?") == 0 || strcmp(cmd, "CIPAP_DEF?") == 0) {
+        Reply(sim, "+%.9s:ip:\"192.168.4.1\"\r\n+%.9s:gateway:\"192.168.4.1\"\r\n+%.9s:netmask:\"255.255.255.0\"\r\n" RESULT_OK, cmd, cmd, cmd);
+    } else if (strcmp(cmd, "CWSAP_CUR?") == 0 || strcmp(cmd, "CWSAP_DEF?") == 0) {
+        Reply(sim, "+%.9s:\"ESP_A1B2C3\",\"\",1,0,4,0\r\n" RESULT_OK, cmd);
+    } else if (strcmp(cmd, "CWMODE_CUR?") == 0 || strcmp(cmd, "CWMODE_DEF?") == 0) {
+        Reply(sim, "+%.10s:%u\r\n" RESULT_OK, cmd, (unsigned)sim->Mode);
+    } else if (strcmp(cmd, "CWJAP_CUR?") == 0 || strcmp(cmd, "CWJAP_DEF?") == 0) {
+        if (sim->Joined < 0) {
+            Reply(sim, "No AP\r\n" RESULT_OK);
+        } else {
+            FormatMAC(mac, AP(sim, sim->Joined)->MAC);
+            Reply(sim, "+%.9s:\"%s\",\"%s\",%u,%d\r\n" RESULT_OK, cmd, AP(sim, sim->Joined)->SSID, mac,
+                (unsigned)AP(sim, sim->Joined)->Channel, (int)AP(sim, sim->Joined)->RSSI);
+        }
+    } else if (strcmp(cmd, "CWHOSTNAME?") == 0) {
+        Reply(sim, "+CWHOSTNAME:ESP_A1B2C3\r\n" RESULT_OK);
+    } else if (strcmp(cmd, "UART_CUR?") == 0 || strcmp(cmd, "UART_DEF?") == 0) {
+        Reply(sim, "+%.8s:%u,8,1,0,0\r\n" RESULT_OK, cmd, (unsigned)(cmd[5] == 'C' ? sim->Baudrate : DEFAULT_BAUDRATE));
+    } else if (strcmp(cmd, "SYSRAM?") == 0) {
+        Reply(sim, "+SYSRAM:%u\r\n" RESULT_OK, 48000 - 1000 * (unsigned)(sim->Conn[0].Active + sim->Conn[1].Active));
+    } else if (strcmp(cmd, "SYSADC?") == 0) {
+        Reply(sim, "+SYSADC:%u\r\n" RESULT_OK, (unsigned)(Random(sim) % 1024));
+    } else if (strcmp(cmd, "CIPDNS_CUR?") == 0 || strcmp(cmd, "CIPDNS_DEF?") == 0) {
+        Reply(sim, "+%.10s:208.67.222.222\r\n+%.10s:8.8.8.8\r\n" RESULT_OK, cmd, cmd);
+    } else if (strcmp(cmd, "CIPSNTPCFG?") == 0) {
+        if (sim->SNTP) {
+            Reply(sim, "+CIPSNTPCFG:1,%d,\"cn.ntp.org.cn\",\"ntp.sjtu.edu.cn\"\r\n" RESULT_OK, (int)sim->Timezone);
+        } else {
+            Reply(sim, "+CIPSNTPCFG:0\r\n" RESULT_OK);
+        }
+    } else if (strcmp(cmd, "CIPSNTPTIME?") == 0) {
+        time_t t = 0;
+        struct tm tm;
+        char str[32];
+
+        if (sim->SNTP && sim->Joined >= 0) {
+            t = SNTP_BASE_TIME + (time_t)(sim->Time / 1000) + (time_t)sim->Timezone * 3600;
+        }
+        gmtime_r(&t, &tm);
+        strftime(str, sizeof(str), "%a %b %d %H:%M:%S %Y", &tm);
+        Reply(sim, "+CIPSNTPTIME:%s\r\n" RESULT_OK, str);
+    } else if (strcmp(cmd, "CIPSTATUS") == 0) {
+        CmdCIPSTATUS(sim);
+    } else if (strcmp(cmd, "CIPCLOSE") == 0 || strcmp(cmd, "CIPBUFSTATUS") == 0) { /* Single connection forms */
+        Args_t a;
+        SplitArgs("", &a);
+        if (cmd[3] == 'C') {
+            CmdCIPCLOSE(sim, &a);
+        } else {
+            CmdCIPBUFSTATUS(sim, &a);
+        }
+    } else if (strcmp(cmd, "CWLIF") == 0) {
+        Reply(sim, RESULT_OK);
+    } else if (strcmp(cmd, "CWLAP") == 0) {
+        if (sim->Mode == 2) {                               /* Station is not enabled */
+            Reply(sim, RESULT_ERROR);
+        } else {
+            sim->Busy = 1;
+            After(sim, sim->Config.ScanTime, ACT_SCAN, 0);
+        }
+    } else if (strcmp(cmd, "CWQAP") == 0) {
+        Reply(sim, RESULT_OK);
+        if (sim->Joined >= 0) {
+            ATSIM_WifiDisconnect(sim);
+        }
+    } else if (strcmp(cmd, "RST") == 0) {
+        Reply(sim, RESULT_OK);
+        After(sim, 0, ACT_RESTART, 0);
+    } else if (strcmp(cmd, "RESTORE") == 0) {
+        Reply(sim, RESULT_OK);
+        After(sim, 0, ACT_RESTART, 0);
+    } else if (strcmp(cmd, "CIUPDATE") == 0) {
+        sim->Busy = 1;
+        Reply(sim, "+CIPUPDATE:1\r\n");
+        After(sim, 1000, ACT_IDLE, 0);
+        Schedule(sim, sim->Config.CommandTime + 1000, ACT_OUTPUT, 0, "+CIPUPDATE:4\r\n" RESULT_OK, 20, 1);
+    } else if (strcmp(cmd, "CIPSEND") == 0) {               /* Transparent transfer */
+        if (sim->TransferMode != 1 || sim->Mux || !sim->Conn[0].Active) {
+            Reply(sim, RESULT_ERROR);
+        } else {
+            Reply(sim, RESULT_OK "\r\n>");
+            sim->Transparent = 1;
+            sim->DataReceived = 0;
+            sim->PlusCount = 0;
+        }
+    } else {
+        Reply(sim, RESULT_ERROR);
+    }
+}
+
+static void CmdSet(ATSIM_t* sim, const char* cmd, Args_t* a) {
+    if (strcmp(cmd, "CIPSTART") == 0) {
+        CmdCIPSTART(sim, a);
+    } else if (strcmp(cmd, "CIPSEND") == 0) {
+        CmdSend(sim, a, DATA_SEND);
+    } else if (strcmp(cmd, "CIPSENDEX") == 0) {
+        CmdSend(sim, a, DATA_SENDEX);
+    } else if (strcmp(cmd, "CIPSENDBUF") == 0) {
+        CmdSend(sim, a, DATA_SENDBUF);
+    } else if (strcmp(cmd, "CIPCLOSE") == 0) {
+        CmdCIPCLOSE(sim, a);
+    } else if (strcmp(cmd, "CIPBUFSTATUS") == 0) {
+        CmdCIPBUFSTATUS(sim, a);
+    } else if (strcmp(cmd, "CIPCHECKSEQ") == 0) {
+        CmdCIPCHECKSEQ(sim, a);
+    } else if (strcmp(cmd, "CWJAP_CUR") == 0 || strcmp(cmd, "CWJAP_DEF") == 0 || strcmp(cmd, "CWJAP") == 0) {
+        CmdCWJAP(sim, a);
+    } else if (strcmp(cmd, "CIPMUX") == 0) {
+        uint8_t i, active = 0;
+        for (i = 0; i < ATSIM_MAX_CONNECTIONS; i++) {
+            active |= sim->Conn[i].Active;
+        }
+        if (active) {
+            Reply(sim, "link is builded\r\n" RESULT_ERROR);
+        } else if (sim->TransferMode && atoi(a->Arg[0])) {
+            Reply(sim, RESULT_ERROR);
+        } else {
+            sim->Mux = atoi(a->Arg[0]) != 0;
+            Reply(sim, RESULT_OK);
+        }
+    } else if (strcmp(cmd, "CIPMODE") == 0) {
+        if (sim->Mux && atoi(a->Arg[0])) {                  /* Transparent mode needs single connection */
+            Reply(sim, RESULT_ERROR);
+        } else {
+            sim->TransferMode = atoi(a->Arg[0]);
+            Reply(sim, RESULT_OK);
+        }
+    } else if (strcmp(cmd, "CIPDINFO") == 0) {
+        sim->DInfo = atoi(a->Arg[0]) != 0;
+        Reply(sim, RESULT_OK);
+    } else if (strcmp(cmd, "CIPSERVER") == 0) {
+        if (atoi(a->Arg[0]) && !sim->Mux) {                 /* Server needs multiple connections */
+            Reply(sim, RESULT_ERROR);
+        } else {
+            sim->Server = atoi(a->Arg[0]) != 0;
+            sim->ServerPort = a->Count > 1 ? atoi(a->Arg[1]) : 333;
+            Reply(sim, RESULT_OK);
+        }
+    } else if (strcmp(cmd, "CWMODE_CUR") == 0 || strcmp(cmd, "CWMODE_DEF") == 0) {
+        int mode = atoi(a->Arg[0]);
+        if (mode < 1 || mode > 3) {
+            Reply(sim, RESULT_ERROR);
+        } else {
+            sim->Mode = mode;
+            Reply(sim, RESULT_OK);
+        }
+    } else if (strcmp(cmd, "UART_CUR") == 0 || strcmp(cmd, "UART_DEF") == 0) {
+        uint32_t baudrate = strtoul(a->Arg[0], NULL, 10);
+        if (baudrate < 110 || baudrate > 4608000) {
+            Reply(sim, RESULT_ERROR);
+        } else {
+            Reply(sim, RESULT_OK);
+            After(sim, 0, ACT_BAUD, baudrate);              /* New baudrate is used after response */
+        }
+    } else if (strcmp(cmd, "CIPDOMAIN") == 0 || strcmp(cmd, "PING") == 0) {
+        uint8_t ip[4];
+        if (sim->Joined < 0) {
+            Reply(sim, cmd[0] == 'P' ? "+timeout\r\n" RESULT_ERROR : "DNS Fail\r\n" RESULT_ERROR);
+        } else if (!Resolve(a->Arg[0], ip)) {
+            Reply(sim, cmd[0] == 'P' ? "+timeout\r\n" RESULT_ERROR : "DNS Fail\r\n" RESULT_ERROR);
+        } else {
+            sim->Busy = 1;
+            if (cmd[0] == 'P') {
+                Schedule(sim, sim->Config.CommandTime + sim->Config.Latency, ACT_OUTPUT, 0, NULL, 0, 1);
+                Reply(sim, "+%u\r\n" RESULT_OK, (unsigned)(sim->Config.Latency ? sim->Config.Latency : 1));
+            } else {
+                Schedule(sim, sim->Config.CommandTime + sim->Config.Latency, ACT_OUTPUT, 0, NULL, 0, 1);
+                Reply(sim, "+CIPDOMAIN:%u.%u.%u.%u\r\n" RESULT_OK, ip[0], ip[1], ip[2], ip[3]);
+            }
+            After(sim, 0, ACT_IDLE, 0);
+        }
+    } else if (strcmp(cmd, "CIPSNTPCFG") == 0) {
+        sim->SNTP = atoi(a->Arg[0]) != 0;
+        sim->Timezone = a->Count > 1 ? atoi(a->Arg[1]) : 0;
+        Reply(sim, RESULT_OK);
+    } else if (strcmp(cmd, "SYSIOGETCFG") == 0) {
+        Reply(sim, "+SYSIOGETCFG:%u,0,0\r\n" RESULT_OK, (unsigned)atoi(a->Arg[0]));
+    } else if (strcmp(cmd, "SYSGPIOREAD") == 0) {
+        Reply(sim, "+SYSGPIOREAD:%u,0,1\r\n" RESULT_OK, (unsigned)atoi(a->Arg[0]));
+    } else if (strcmp(cmd, "CWSAP_CUR") == 0 || strcmp(cmd, "CWSAP_DEF") == 0 || strcmp(cmd, "CIPSTA_CUR") == 0 ||
+                strcmp(cmd, "CIPSTA_DEF") == 0 || strcmp(cmd, "CIPAP_CUR") == 0 || strcmp(cmd, "CIPAP_DEF") == 0 ||
+                strcmp(cmd, "CIPSTAMAC_CUR") == 0 || strcmp(cmd, "CIPSTAMAC_DEF") == 0 || strcmp(cmd, "CIPAPMAC_CUR") == 0 ||
+                strcmp(cmd, "CIPAPMAC_DEF") == 0 || strcmp(cmd, "CWLAPOPT") == 0 || strcmp(cmd, "CWAUTOCONN") == 0 ||
+                strcmp(cmd, "CWHOSTNAME") == 0 || strcmp(cmd, "CIPSTO") == 0 || strcmp(cmd, "CIPSSLSIZE") == 0 ||
+                strcmp(cmd, "CIPDNS_CUR") == 0 || strcmp(cmd, "CIPDNS_DEF") == 0 || strcmp(cmd, "RFPOWER") == 0 ||
+                strcmp(cmd, "SYSIOSETCFG") == 0 || strcmp(cmd, "SYSGPIODIR") == 0 || strcmp(cmd, "SYSGPIOWRITE") == 0 ||
+                strcmp(cmd, "WPS") == 0 || strcmp(cmd, "CWDHCP_CUR") == 0) {
+        Reply(sim, RESULT_OK);                              /* Settings which only need to be accepted */
+    } else {
+        Reply(sim, RESULT_ERROR);
+    }
+}
+
+/* Executes received command line */
+static void Execute(ATSIM_t* sim) {
+    char* line = sim->Line;
+    char* eq;
+    Args_t a;
+
+    if (sim->Echo) {                                        /* Echo command as module received it */
+        Schedule(sim, 0, ACT_OUTPUT, 0, line, sim->LineLength, 1);
+        Schedule(sim, 0, ACT_OUTPUT, 0, "\r\r\n", 3, 1);
+    }
+    line[sim->LineLength] = 0;
+    sim->LineLength = 0;
+    if (!*line) {
+        return;
+    }
+    sim->Commands++;
+    if (sim->Busy) {
+        Schedule(sim, 0, ACT_OUTPUT, 0, "busy p...\r\n", 11, 0);
+        return;
+    }
+    if (line[0] != 'A' || line[1] != 'T') {
+        Reply(sim, RESULT_ERROR);
+        return;
+    }
+    if (Chance(sim, sim->Config.ErrorRate)) {               /* Inject error */
+        sim->Errors++;
+        Reply(sim, RESULT_ERROR);
+        return;
+    }
+    line += 2;
+    if (!*line) {
+        Reply(sim, RESULT_OK);
+    } else if (line[0] == 'E' && (line[1] == '0' || line[1] == '1') && !line[2]) {
+        sim->Echo = line[1] == '1';
+        Reply(sim, RESULT_OK);
+    } else if (line[0] != '+') {
+        Reply(sim, RESULT_ERROR);
+    } else if ((eq = strchr(line, '=')) != NULL) {
+        *eq = 0;
+        SplitArgs(eq + 1, &a);
+        if (!a.Count) {
+            Reply(sim, RESULT_ERROR);
+        } else {
+            CmdSet(sim, line + 1, &a);
+        }
+    } else {
+        CmdQuery(sim, line + 1);
+    }
+}
+
+/* Adds byte to transparent transfer packet */
+static void TransparentPut(ATSIM_t* sim, uint8_t ch) {
+    sim->DataBuffer[sim->DataReceived++] = ch;
+    if (sim->DataReceived == 2048) {                        /* Send full packet */
+        RemoteReceived(sim, 0, sim->DataBuffer, sim->DataReceived);
+        sim->DataReceived = 0;
+    }
+}
+
+/* Processes character received from host */
+static void Received(ATSIM_t* sim, uint8_t ch) {
+    if (sim->Transparent) {
+        if (ch == '+' && sim->PlusCount < 3 && (sim->PlusCount || sim->Time - sim->LastInput >= PLUS_GUARD_TIME)) {
+            sim->PlusCount++;                               /* Maybe end of transparent transfer */
+        } else {
+            for (; sim->PlusCount; sim->PlusCount--) {      /* It was data */
+                TransparentPut(sim, '+');
+            }
+            TransparentPut(sim, ch);
+        }
+    } else if (sim->DataMode) {
+        sim->DataBuffer[sim->DataReceived++] = ch;
+        if (sim->DataReceived == sim->DataLength ||         /* CIPSENDEX data also end with \0 sequence */
+            (sim->DataMode == DATA_SENDEX && sim->DataReceived >= 2 && ch == '0' && sim->DataBuffer[sim->DataReceived - 2] == '\\')) {
+            SendDone(sim);
+        }
+    } else if (ch == '\n') {
+        if (sim->LineLength && sim->Line[sim->LineLength - 1] == '\r') {
+            sim->LineLength--;
+        }
+        Execute(sim);
+    } else if (sim->LineLength < sizeof(sim->Line) - 1) {
+        sim->Line[sim->LineLength++] = ch;
+    }
+    sim->LastInput = sim->Time;
+}
+
+/* Does scheduled action */
+static void Action(ATSIM_t* sim, ATSIM_Event_t* e) {
+    uint8_t conn = e->Arg & 0xFF, i;
+    char pre[4], mac[18];
+    ATSIM_Conn_t* c = &sim->Conn[conn];
+
+    switch (e->Action) {
+        case ACT_OUTPUT:
+            Emit(sim, e->Data, e->Length, e->Raw);
+            break;
+        case ACT_BOOT:
+            sim->Booted = 1;
+            EmitStr(sim, "\r\nready\r\n");
+            break;
+        case ACT_RESTART:
+            ATSIM_SetReset(sim, 1);
+            ATSIM_SetReset(sim, 0);
+            break;
+        case ACT_BAUD:
+            sim->Baudrate = e->Arg;
+            break;
+        case ACT_IDLE:
+            sim->Busy = 0;
+            break;
+        case ACT_SCAN:
+            for (i = 0; i < sim->Config.APsCount; i++) {
+                char ssid[64], *s = ssid;
+                const char* p = AP(sim, i)->SSID;
+                while (*p && s < &ssid[sizeof(ssid) - 3]) { /* Firmware escapes special characters */
+                    if (*p == '"' || *p == ',' || *p == '\\') {
+                        *s++ = '\\';
+                    }
+                    *s++ = *p++;
+                }
+                *s = 0;
+                FormatMAC(mac, AP(sim, i)->MAC);
+                EmitStr(sim, "+CWLAP:(%u,\"%s\",%d,\"%s\",%u,%d,0)\r\n", (unsigned)AP(sim, i)->Ecn, ssid,
+                    (int)AP(sim, i)->RSSI, mac, (unsigned)AP(sim, i)->Channel, -(int)(Random(sim) % 40));
+            }
+            EmitStr(sim, RESULT_OK);
+            sim->Busy = 0;
+            break;
+        case ACT_JOIN:
+            if (sim->Joined >= 0) {
+                ATSIM_WifiDisconnect(sim);
+            }
+            if (e->Arg < 0x100) {
+                sim->Joined = e->Arg;
+                EmitStr(sim, "WIFI CONNECTED\r\nWIFI GOT IP\r\n" RESULT_OK);
+            } else {
+                EmitStr(sim, "+CWJAP:%u\r\n\r\nFAIL\r\n", (unsigned)(e->Arg >> 8));
+            }
+            sim->Busy = 0;
+            break;
+        case ACT_CONNECT:
+            c->Connecting = 0;
+            if (sim->Joined < 0) {                          /* Wi-Fi was lost meanwhile */
+                EmitStr(sim, "%sCLOSED\r\n" RESULT_ERROR, ConnPrefix(sim, conn, pre));
+                ConnReset(c);
+            } else {
+                c->Active = 1;
+                EmitStr(sim, "%sCONNECT\r\n" RESULT_OK, ConnPrefix(sim, conn, pre));
+            }
+            sim->Busy = 0;
+            break;
+        case ACT_SEND:
+            EmitStr(sim, e->Arg ? "\r\nSEND FAIL\r\n" : "\r\nSEND OK\r\n");
+            sim->Busy = 0;
+            break;
+        case ACT_SEGMENT: {
+            uint32_t seg = e->Arg >> 8;
+            uint8_t fail = Chance(sim, sim->Config.SendFailRate);
+
+            c->SegmentSent = seg;
+            c->BufferUsed -= e->Length;
+            if (fail) {
+                sim->SendFails++;
+            } else {
+                c->SegmentAcked = seg;
+                RemoteReceived(sim, conn, e->Data, e->Length);
+            }
+            EmitStr(sim, "%s%u,%s\r\n", ConnPrefix(sim, conn, pre), (unsigned)seg, fail ? "SEND FAIL" : "SEND OK");
+            break;
+        }
+        case ACT_REMOTE:
+            if (c->Active) {
+                EmitIPD(sim, conn, e->Data, e->Length);
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+/******************************************************************************/
+/***                              Public API                                 **/
+/******************************************************************************/
+void ATSIM_Init(ATSIM_t* sim, const ATSIM_Config_t* config) {
+    memset(sim, 0x00, sizeof(*sim));
+    if (config) {
+        sim->Config = *config;
+    }
+    if (!sim->Config.CommandTime) {
+        sim->Config.CommandTime = 1;
+    }
+    if (!sim->Config.BootTime) {
+        sim->Config.BootTime = 300;
+    }
+    if (!sim->Config.ScanTime) {
+        sim->Config.ScanTime = 1500;
+    }
+    if (!sim->Config.JoinTime) {
+        sim->Config.JoinTime = 2000;
+    }
+    if (!sim->Config.IpdSize) {
+        sim->Config.IpdSize = 1460;
+    }
+    if (!sim->Config.SendBufSize) {
+        sim->Config.SendBufSize = 2920;
+    }
+    if (!sim->Config.APs) {
+        sim->Config.APs = DefaultAPs;
+        sim->Config.APsCount = sizeof(DefaultAPs) / sizeof(DefaultAPs[0]);
+    }
+    sim->Random = sim->Config.Seed ? sim->Config.Seed : 0x12345678;
+    sim->InReset = 1;                                       /* Powered off until reset is released */
+    sim->Joined = -1;
+    sim->Baudrate = DEFAULT_BAUDRATE;
+}
+
+void ATSIM_DeInit(ATSIM_t* sim) {
+    while (sim->Events) {
+        ATSIM_Event_t* e = sim->Events;
+        sim->Events = e->Next;
+        free(e);
+    }
+    free(sim->Input.Data);
+    free(sim->Output.Data);
+    memset(sim, 0x00, sizeof(*sim));
+}
+
+void ATSIM_SetReset(ATSIM_t* sim, uint8_t active) {
+    uint8_t i;
+
+    if (active) {
+        while (sim->Events) {                               /* Everything in progress is lost */
+            ATSIM_Event_t* e = sim->Events;
+            sim->Events = e->Next;
+            free(e);
+        }
+        QueueReset(&sim->Input);
+        QueueReset(&sim->Output);
+        for (i = 0; i < ATSIM_MAX_CONNECTIONS; i++) {
+            ConnReset(&sim->Conn[i]);
+        }
+        sim->InReset = 1;
+        sim->Booted = 0;
+        sim->Busy = 0;
+        sim->Echo = 1;
+        sim->Mux = 0;
+        sim->DInfo = 0;
+        sim->TransferMode = 0;
+        sim->Transparent = 0;
+        sim->Server = 0;
+        sim->Mode = 3;
+        sim->Joined = -1;
+        sim->SNTP = 0;
+        sim->LineLength = 0;
+        sim->DataMode = DATA_NONE;
+        sim->Baudrate = DEFAULT_BAUDRATE;
+        sim->LastOutput = sim->Time;
+        sim->NextLocalPort = 50000;
+    } else if (sim->InReset) {
+        sim->InReset = 0;
+        Schedule(sim, sim->Config.BootTime, ACT_BOOT, 0, NULL, 0, 1);
+    }
+}
+
+void ATSIM_SetHostBaudrate(ATSIM_t* sim, uint32_t baudrate) {
+    sim->HostBaudrate = baudrate;
+}
+
+void ATSIM_Write(ATSIM_t* sim, const void* data, uint32_t len) {
+    if (!sim->Booted || (sim->HostBaudrate && sim->HostBaudrate != sim->Baudrate)) {
+        return;                                             /* Module does not understand anything */
+    }
+    QueuePut(&sim->Input, data, len);
+}
+
+uint32_t ATSIM_Peek(ATSIM_t* sim, const uint8_t** data) {
+    uint32_t len = sim->Output.In - sim->Output.Out;
+
+    if (Bandwidth(sim) && len > sim->TxCredit / 1000) {     /* Only bytes UART already transferred */
+        len = sim->TxCredit / 1000;
+    }
+    *data = &sim->Output.Data[sim->Output.Out];
+    return len;
+}
+
+void ATSIM_Consume(ATSIM_t* sim, uint32_t len) {
+    sim->Output.Out += len;
+    if (Bandwidth(sim)) {
+        sim->TxCredit -= (uint64_t)len * 1000;
+    }
+}
+
+void ATSIM_Step(ATSIM_t* sim, uint32_t ms) {
+    uint32_t bw, n, i;
+    uint64_t cap;
+
+    while (ms--) {
+        sim->Time++;
+        bw = Bandwidth(sim);
+        cap = (uint64_t)bw * 2 + 1000;                      /* UART does not save unused time */
+
+        /* Process received characters */
+        n = sim->Input.In - sim->Input.Out;
+        if (bw) {
+            sim->RxCredit += bw;
+            if (sim->RxCredit > cap) {
+                sim->RxCredit = cap;
+            }
+            if (n > sim->RxCredit / 1000) {
+                n = sim->RxCredit / 1000;
+            }
+            sim->RxCredit -= (uint64_t)n * 1000;
+        }
+        for (i = 0; i < n; i++) {
+            Received(sim, sim->Input.Data[sim->Input.Out++]);
+        }
+
+        /* Transparent transfer */
+        if (sim->Transparent) {
+            if (sim->PlusCount == 3 && sim->Time - sim->LastInput >= PLUS_GUARD_TIME) {
+                sim->Transparent = 0;                       /* +++ ends transparent transfer */
+                sim->PlusCount = 0;
+            }
+            if (sim->DataReceived && sim->Time - sim->LastInput >= PLUS_GUARD_TIME) {
+                RemoteReceived(sim, 0, sim->DataBuffer, sim->DataReceived); /* Send packet after pause */
+                sim->DataReceived = 0;
+            }
+        }
+
+        /* Scheduled events */
+        while (sim->Events && sim->Events->Due <= sim->Time) {
+            ATSIM_Event_t* e = sim->Events;
+            sim->Events = e->Next;
+            Action(sim, e);
+            free(e);
+        }
+
+        if (bw) {
+            sim->TxCredit += bw;
+            if (sim->TxCredit > cap) {
+                sim->TxCredit = cap;
+            }
+        }
+    }
+}
+
+int ATSIM_RemoteSend(ATSIM_t* sim, uint8_t conn, const void* data, uint32_t len) {
+    if (conn >= ATSIM_MAX_CONNECTIONS || !sim->Conn[conn].Active) {
+        return -1;
+    }
+    Schedule(sim, sim->Config.Latency / 2, ACT_REMOTE, conn, data, len, 0);
+    return 0;
+}
+
+int ATSIM_RemoteConnect(ATSIM_t* sim) {
+    uint8_t i;
+    ATSIM_Conn_t* c;
+
+    if (!sim->Server || sim->Joined < 0) {
+        return -1;
+    }
+    for (i = 0; i < ATSIM_MAX_CONNECTIONS; i++) {
+        c = &sim->Conn[i];
+        if (!c->Active && !c->Connecting) {
+            ConnReset(c);
+            c->Active = 1;
+            c->Server = 1;
+            strcpy(c->Type, "TCP");
+            memcpy(c->IP, "\xC0\xA8\x01\x0A", 4);           /* 192.168.1.10 */
+            c->RemotePort = 40000 + i;
+            c->LocalPort = sim->ServerPort;
+            EmitStr(sim, "%u,CONNECT\r\n", (unsigned)i);
+            return i;
+        }
+    }
+    return -1;
+}
+
+int ATSIM_RemoteClose(ATSIM_t* sim, uint8_t conn) {
+    if (conn >= ATSIM_MAX_CONNECTIONS || !sim->Conn[conn].Active) {
+        return -1;
+    }
+    ConnClosed(sim, conn);
+    return 0;
+}
+
+void ATSIM_WifiDisconnect(ATSIM_t* sim) {
+    uint8_t i;
+
+    if (sim->Joined < 0) {
+        return;
+    }
+    for (i = 0; i < ATSIM_MAX_CONNECTIONS; i++) {
+        if (sim->Conn[i].Active) {
+            ConnClosed(sim, i);
+        }
+    }
+    sim->Joined = -1;
+    EmitStr(sim, "WIFI DISCONNECT\r\n");
+}
@@ -0,0 +1,264 @@
+/**
+ * \brief   Simulated ESP8266 module with AT commands firmware
+ *
+ * Simulator speaks AT commands used by the library, in format of AT firmware 1.6:
+ * basic and system commands, Wi-Fi commands (CWLAP, CWJAP, CWQAP, CWSAP, CWLIF, ...),
+ * TCP/IP commands (CIPSTART, CIPSEND with > prompt, CIPSENDEX, CIPSENDBUF, CIPCLOSE, CIPSTATUS,
+ * +IPD with CIPDINFO, transparent mode, CIPDOMAIN, PING, SNTP, DNS).
+ *
+ * Simulator runs on virtual time in milliseconds, advanced with \ref ATSIM_Step.
+ * Bytes written to module with \ref ATSIM_Write and bytes module sends with \ref ATSIM_Peek
+ * are limited by UART bandwidth, network operations take configured latency.
+ * Errors can be injected with ERROR responses, SEND FAIL responses and invalid characters.
+ *
+ * Simulator is single threaded, all functions must be called from the same thread.
+ */
+#ifndef AT_SIM_H
+#define AT_SIM_H
+
+#include "stdint.h"
+
+#define ATSIM_MAX_CONNECTIONS       5       /*!< Number of connections module supports */
+#define ATSIM_MAX_LINE              512     /*!< Maximal length of command line */
+
+struct _ATSIM_t;
+
+/**
+ * \brief   What remote side does with data module sends
+ */
+typedef enum _ATSIM_Remote_t {
+    ATSIM_Remote_Sink = 0,                  /*!< Data are dropped */
+    ATSIM_Remote_Echo                       /*!< Data are sent back to module after latency */
+} ATSIM_Remote_t;
+
+/**
+ * \brief   Access point visible to module
+ */
+typedef struct _ATSIM_AP_t {
+    const char* SSID;                       /*!< Network name */
+    const char* Password;                   /*!< Password needed to join, NULL when network can not be joined */
+    uint8_t Ecn;                            /*!< Security as in +CWLAP response */
+    int8_t RSSI;                            /*!< Signal strength */
+    uint8_t Channel;                        /*!< Wi-Fi channel */
+    uint8_t MAC[6];                         /*!< Access point MAC */
+} ATSIM_AP_t;
+
+/**
+ * \brief   Callback with data module sent to remote side
+ * \param[in]   *sim: Pointer to simulator
+ * \param[in]   conn: Connection number
+ * \param[in]   *data: Data sent on connection
+ * \param[in]   len: Number of bytes
+ */
+typedef void (*ATSIM_RemoteCallback_t)(struct _ATSIM_t* sim, uint8_t conn, const uint8_t* data, uint32_t len);
+
+/**
+ * \brief   Simulator configuration, zero value means default for most fields
+ */
+typedef struct _ATSIM_Config_t {
+    uint32_t Bandwidth;                     /*!< UART bytes per second in each direction, 0 = derive from baudrate, baudrate 0 = unlimited */
+    uint32_t Latency;                       /*!< Network round trip time in milliseconds, time from data send to SEND OK and echo */
+    uint32_t CommandTime;                   /*!< Milliseconds module needs to answer local command */
+    uint32_t BootTime;                      /*!< Milliseconds from reset to "ready", default 300 */
+    uint32_t ScanTime;                      /*!< Milliseconds of CWLAP scan, default 1500 */
+    uint32_t JoinTime;                      /*!< Milliseconds to join access point, default 2000 */
+    uint16_t ErrorRate;                     /*!< Per mille of commands answered with ERROR */
+    uint16_t SendFailRate;                  /*!< Per mille of CIPSEND answered with SEND FAIL */
+    uint16_t GarbageRate;                   /*!< Per mille of response characters replaced with invalid character, network data excluded */
+    uint32_t Seed;                          /*!< Seed for error injection, the same seed gives the same errors */
+    uint16_t IpdSize;                       /*!< Maximal payload of single +IPD, default 1460 */
+    uint32_t SendBufSize;                   /*!< Module send buffer size for CIPSENDBUF, default 2920 */
+    const ATSIM_AP_t* APs;                  /*!< Visible access points, default list is used when NULL */
+    uint8_t APsCount;                       /*!< Number of visible access points */
+    ATSIM_Remote_t Remote;                  /*!< Behaviour of remote side */
+    ATSIM_RemoteCallback_t RemoteCallback;  /*!< Called with data module sent, may be NULL */
+    void* Arg;                              /*!< User argument */
+} ATSIM_Config_t;
+
+/**
+ * \brief   Scheduled output or action of simulator
+ * \note    For internal use only
+ */
+typedef struct _ATSIM_Event_t {
+    struct _ATSIM_Event_t* Next;            /*!< Next event in time order */
+    uint64_t Due;                           /*!< Time when event happens */
+    uint8_t Action;                         /*!< Action to do, 0 for output */
+    uint8_t Raw;                            /*!< Output is network data, no garbage is injected */
+    uint32_t Arg;                           /*!< Action argument */
+    uint32_t Length;                        /*!< Number of output bytes */
+    uint8_t Data[];                         /*!< Output bytes */
+} ATSIM_Event_t;
+
+/**
+ * \brief   Simulated connection
+ * \note    For internal use only
+ */
+typedef struct _ATSIM_Conn_t {
+    uint8_t Active;                         /*!< Connection is established */
+    uint8_t Connecting;                     /*!< CIPSTART is in progress */
+    char Type[4];                           /*!< TCP, UDP or SSL */
+    uint8_t IP[4];                          /*!< Remote IP */
+    uint16_t RemotePort;                    /*!< Remote port */
+    uint16_t LocalPort;                     /*!< Local port */
+    uint8_t Server;                         /*!< Connection was accepted by server */
+    uint32_t Segment;                       /*!< Last segment added with CIPSENDBUF */
+    uint32_t SegmentSent;                   /*!< Last segment sent to network */
+    uint32_t SegmentAcked;                  /*!< Last segment acknowledged by remote side */
+    uint32_t BufferUsed;                    /*!< Bytes waiting in module send buffer */
+    uint64_t LinkFree;                      /*!< Time when network link is free for next segment */
+    uint64_t BytesSent;                     /*!< Bytes sent to remote side */
+    uint64_t BytesReceived;                 /*!< Bytes received from remote side */
+} ATSIM_Conn_t;
+
+/**
+ * \brief   Growing byte queue
+ * \note    For internal use only
+ */
+typedef struct _ATSIM_Queue_t {
+    uint8_t* Data;                          /*!< Memory */
+    uint32_t Size;                          /*!< Allocated size */
+    uint32_t In;                            /*!< Write position */
+    uint32_t Out;                           /*!< Read position */
+} ATSIM_Queue_t;
+
+/**
+ * \brief   Simulator state
+ */
+typedef struct _ATSIM_t {
+    ATSIM_Config_t Config;                  /*!< Configuration */
+    uint64_t Time;                          /*!< Virtual time in milliseconds */
+    uint32_t Random;                        /*!< Random generator state */
+
+    uint32_t Baudrate;                      /*!< Baudrate of module UART */
+    uint32_t HostBaudrate;                  /*!< Baudrate of host UART, bytes are garbage when different */
+    uint64_t TxCredit;                      /*!< Module to host credit in bytes * 1000 */
+    uint64_t RxCredit;                      /*!< Host to module credit in bytes * 1000 */
+    ATSIM_Queue_t Input;                    /*!< Bytes written to module, not processed yet */
+    ATSIM_Queue_t Output;                   /*!< Bytes module sent, not read by host yet */
+    ATSIM_Event_t* Events;                  /*!< Scheduled events */
+    uint64_t LastOutput;                    /*!< Due time of last scheduled output, keeps responses in order */
+
+    uint8_t Booted;                         /*!< Module finished boot and accepts commands */
+    uint8_t InReset;                        /*!< Reset pin is active */
+    uint8_t Busy;                           /*!< Command is in progress, new commands get busy response */
+    uint8_t Echo;                           /*!< Echo is enabled */
+    uint8_t Mux;                            /*!< Multiple connections mode */
+    uint8_t DInfo;                          /*!< +IPD contains remote IP and port */
+    uint8_t TransferMode;                   /*!< CIPMODE value */
+    uint8_t Transparent;                    /*!< Module is in transparent transfer */
+    uint8_t Server;                         /*!< Server is enabled */
+    uint16_t ServerPort;                    /*!< Server port */
+    uint8_t Mode;                           /*!< Wi-Fi mode */
+    int16_t Joined;                         /*!< Index of joined access point, -1 when not joined */
+    uint8_t SNTP;                           /*!< SNTP is enabled */
+    int8_t Timezone;                        /*!< SNTP timezone */
+
+    char Line[ATSIM_MAX_LINE];              /*!< Received command line */
+    uint32_t LineLength;                    /*!< Number of characters in line */
+    uint8_t DataMode;                       /*!< Data after > prompt are received */
+    uint8_t DataConn;                       /*!< Connection of data */
+    uint32_t DataLength;                    /*!< Expected data length */
+    uint32_t DataReceived;                  /*!< Received data length */
+    uint8_t DataBuffer[2048 + 2];           /*!< Received data */
+    uint8_t PlusCount;                      /*!< Number of + received in transparent mode */
+    uint64_t LastInput;                     /*!< Time of last received byte */
+    uint16_t NextLocalPort;                 /*!< Local port for next connection */
+
+    ATSIM_Conn_t Conn[ATSIM_MAX_CONNECTIONS];   /*!< Connections */
+
+    uint32_t Commands;                      /*!< Number of received commands */
+    uint32_t Errors;                        /*!< Number of injected errors */
+    uint32_t SendFails;                     /*!< Number of injected send fails */
+    uint32_t Garbage;                       /*!< Number of injected invalid characters */
+} ATSIM_t;
+
+/**
+ * \brief   Initializes simulator, module is powered off until reset
+ * \param[out]  *sim: Pointer to simulator
+ * \param[in]   *config: Configuration, NULL for defaults
+ */
+void ATSIM_Init(ATSIM_t* sim, const ATSIM_Config_t* config);
+
+/**
+ * \brief   Frees memory of simulator
+ * \param[in,out]   *sim: Pointer to simulator
+ */
+void ATSIM_DeInit(ATSIM_t* sim);
+
+/**
+ * \brief   Sets reset pin of module, module boots when pin is released
+ * \param[in,out]   *sim: Pointer to simulator
+ * \param[in]   active: 1 when reset is active, 0 to release it
+ */
+void ATSIM_SetReset(ATSIM_t* sim, uint8_t active);
+
+/**
+ * \brief   Sets baudrate of host UART
+ * \param[in,out]   *sim: Pointer to simulator
+ * \param[in]   baudrate: Host baudrate, when different from module one all characters are received as garbage
+ */
+void ATSIM_SetHostBaudrate(ATSIM_t* sim, uint32_t baudrate);
+
+/**
+ * \brief   Writes data from host to module
+ * \param[in,out]   *sim: Pointer to simulator
+ * \param[in]   *data: Data to write
+ * \param[in]   len: Number of bytes
+ */
+void ATSIM_Write(ATSIM_t* sim, const void* data, uint32_t len);
+
+/**
+ * \brief   Gets data module sent and host can read now
+ * \param[in]   *sim: Pointer to simulator
+ * \param[out]  **data: Pointer to save address of data
+ * \retval      Number of bytes available at address
+ */
+uint32_t ATSIM_Peek(ATSIM_t* sim, const uint8_t** data);
+
+/**
+ * \brief   Removes bytes host read from module output
+ * \param[in,out]   *sim: Pointer to simulator
+ * \param[in]   len: Number of bytes host read, must not be more than \ref ATSIM_Peek returned
+ */
+void ATSIM_Consume(ATSIM_t* sim, uint32_t len);
+
+/**
+ * \brief   Advances virtual time and processes everything that happened meanwhile
+ * \param[in,out]   *sim: Pointer to simulator
+ * \param[in]   ms: Number of milliseconds
+ */
+void ATSIM_Step(ATSIM_t* sim, uint32_t ms);
+
+/**
+ * \brief   Sends data from remote side to module on active connection
+ * \param[in,out]   *sim: Pointer to simulator
+ * \param[in]   conn: Connection number
+ * \param[in]   *data: Data to send
+ * \param[in]   len: Number of bytes
+ * \retval      0: Data will be received by module after latency
+ * \retval      -1: Connection is not active
+ */
+int ATSIM_RemoteSend(ATSIM_t* sim, uint8_t conn, const void* data, uint32_t len);
+
+/**
+ * \brief   Connects remote client to module server
+ * \param[in,out]   *sim: Pointer to simulator
+ * \retval      Connection number or -1 when server is not enabled or no connection is free
+ */
+int ATSIM_RemoteConnect(ATSIM_t* sim);
+
+/**
+ * \brief   Closes connection from remote side
+ * \param[in,out]   *sim: Pointer to simulator
+ * \param[in]   conn: Connection number
+ * \retval      0 on success, -1 when connection is not active
+ */
+int ATSIM_RemoteClose(ATSIM_t* sim, uint8_t conn);
+
+/**
+ * \brief   Disconnects module from access point, all connections are closed
+ * \param[in,out]   *sim: Pointer to simulator
+ */
+void ATSIM_WifiDisconnect(ATSIM_t* sim);
+
+#endif
@@ -0,0 +1,27 @@
+/**
+ * \brief   Checks for host tests
+ *
+ * Test stops at first failed check and returns non-zero exit code, so ctest reports it.
+ */
+#ifndef TEST_H
+#define TEST_H
+
+#include "stdio.h"
+#include "stdlib.h"
+
+/**
+ * \brief   Checks condition, prints location and exits when it is false
+ */
+#define TEST_ASSERT(c)          do { if (!(c)) { printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #c); exit(1); } } while (0)
+
+/**
+ * \brief   Checks two integer values are equal
+ */
+#define TEST_EQUAL(a, b)        do { long long _a = (long long)(a), _b = (long long)(b); if (_a != _b) { printf("%s:%d: %s == %s failed: %lld != %lld\n", __FILE__, __LINE__, #a, #b, _a, _b); exit(1); } } while (0)
+
+/**
+ * \brief   Runs test function and prints its name
+ */
+#define TEST_RUN(f)             do { printf("%s\n", #f); fflush(stdout); f(); } while (0)
+
+#endif
@@ -0,0 +1,159 @@
+/**
+ * \brief   Lock-free buffer mode with producer and consumer in separate threads
+ *
+ * Producer writes stream where each byte depends on its position, consumer checks every byte it reads.
+ * Both sides use copy and linear block functions with changing sizes, consumer also searches
+ * data which producer is still writing. Built with BUFFER_SPSC=1.
+ */
+#include "test.h"
+#include "buffer.h"
+#include "pthread.h"
+#include "sched.h"
+
+#if !BUFFER_SPSC
+#error "Test must be built with BUFFER_SPSC=1"
+#endif
+
+#define STREAM_BYTE(pos)        ((uint8_t)((pos) % 251))    /* Period is not power of 2, wrap point moves in stream */
+
+typedef struct {
+    BUFFER_t Buffer;
+    uint64_t Total;                                         /* Bytes to transfer */
+    uint8_t Linear;                                         /* Use linear block functions instead of copies */
+} Stress_t;
+
+/* Pseudo random chunk size, each thread has its own state */
+static uint32_t Chunk(uint32_t* seed, uint32_t max) {
+    *seed = *seed * 1103515245 + 12345;
+    return 1 + (*seed >> 16) % max;
+}
+
+static void* Producer(void* arg) {
+    Stress_t* s = (Stress_t *)arg;
+    uint8_t chunk[512];
+    uint64_t pos = 0;
+    uint32_t seed = 1, len, i;
+    uint8_t* p;
+
+    while (pos < s->Total) {
+        len = Chunk(&seed, sizeof(chunk));
+        if (len > s->Total - pos) {
+            len = (uint32_t)(s->Total - pos);
+        }
+        if (s->Linear) {                                    /* Fill memory directly, as DMA does */
+            p = BUFFER_GetLinearBlockWriteAddress(&s->Buffer);
+            if (len > BUFFER_GetLinearBlockWriteLength(&s->Buffer)) {
+                len = BUFFER_GetLinearBlockWriteLength(&s->Buffer);
+            }
+            for (i = 0; i < len; i++) {
+                p[i] = STREAM_BYTE(pos + i);
+            }
+            len = BUFFER_Advance(&s->Buffer, len);
+        } else {
+            for (i = 0; i < len; i++) {
+                chunk[i] = STREAM_BYTE(pos + i);
+            }
+            len = BUFFER_Write(&s->Buffer, chunk, len);
+        }
+        if (!len) {
+            sched_yield();                                  /* Let consumer run when CPUs are shared */
+        }
+        pos += len;
+    }
+    return NULL;
+}
+
+/* Checks search results against stream while producer keeps adding data */
+static void CheckFind(BUFFER_t* b, uint64_t pos) {
+    static const uint8_t pattern[] = {5, 6, 7, 8};
+    uint32_t full = BUFFER_GetFull(b);
+    uint32_t k = (250 + 251 - pos % 251) % 251;             /* Offset of first byte with value 250 */
+    int32_t found;
+    uint8_t el;
+
+    found = BUFFER_FindElement(b, 250);
+    TEST_ASSERT(found < 0 || found == (int32_t)k);
+    TEST_ASSERT(full <= k || found == (int32_t)k);          /* Data only grow while consumer waits */
+
+    k = (5 + 251 - pos % 251) % 251;
+    found = BUFFER_Find(b, pattern, sizeof(pattern));
+    TEST_ASSERT(found < 0 || found == (int32_t)k);
+    TEST_ASSERT(full < k + sizeof(pattern) || found == (int32_t)k);
+
+    if (full) {
+        TEST_ASSERT(BUFFER_CheckElement(b, full - 1, &el));
+        TEST_EQUAL(el, STREAM_BYTE(pos + full - 1));
+    }
+}
+
+static void Consume(Stress_t* s) {
+    uint8_t chunk[512];
+    uint64_t pos = 0;
+    uint32_t seed = 2, len, i, n = 0;
+    uint8_t* p;
+
+    while (pos < s->Total) {
+        if ((++n & 0x3F) == 0) {
+            CheckFind(&s->Buffer, pos);
+        }
+        if (s->Linear) {
+            p = BUFFER_GetLinearBlockReadAddress(&s->Buffer);
+            len = BUFFER_GetLinearBlockReadLength(&s->Buffer);
+            for (i = 0; i < len; i++) {
+                TEST_EQUAL(p[i], STREAM_BYTE(pos + i));
+            }
+            len = BUFFER_Skip(&s->Buffer, len);
+        } else {
+            len = BUFFER_Read(&s->Buffer, chunk, Chunk(&seed, sizeof(chunk)));
+            for (i = 0; i < len; i++) {
+                TEST_EQUAL(chunk[i], STREAM_BYTE(pos + i));
+            }
+        }
+        if (!len) {
+            sched_yield();
+        }
+        pos += len;
+    }
+    TEST_EQUAL(BUFFER_GetFull(&s->Buffer), 0);
+}
+
+static void Stress(uint32_t size, uint8_t linear) {
+    Stress_t s;
+    pthread_t producer;
+
+    TEST_EQUAL(BUFFER_Init(&s.Buffer, size, NULL), 0);
+    s.Total = 1 << 22;
+    s.Linear = linear;
+    TEST_EQUAL(pthread_create(&producer, NULL, Producer, &s), 0);
+    Consume(&s);
+    TEST_EQUAL(pthread_join(producer, NULL), 0);
+    BUFFER_Free(&s.Buffer);
+}
+
+static void TestSmallBuffer(void) {
+    Stress(64, 0);                                          /* Chunks are larger than buffer, writes are partial */
+}
+
+static void TestLargeBuffer(void) {
+    Stress(4096, 0);
+}
+
+static void TestLinearBlocks(void) {
+    Stress(1024, 1);
+}
+
+static void TestSizeCheck(void) {
+    BUFFER_t b;
+    TEST_ASSERT(BUFFER_Init(&b, 1000, NULL) != 0);
+    TEST_EQUAL(BUFFER_Init(&b, 1024, NULL), 0);
+    TEST_EQUAL(BUFFER_GetFree(&b), 1024);                   /* All elements can be used */
+    BUFFER_Free(&b);
+}
+
+int main(void) {
+    TEST_RUN(TestSizeCheck);
+    TEST_RUN(TestSmallBuffer);
+    TEST_RUN(TestLargeBuffer);
+    TEST_RUN(TestLinearBlocks);
+    return 0;
+}
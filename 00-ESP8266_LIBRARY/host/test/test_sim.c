@@ -0,0 +1,254 @@
+/**
+ * \brief   Library against simulated module: init, Wi-Fi, connections, SNTP, ping, DNS and injected errors
+ */
+#include "test.h"
+#include "esp8266_host.h"
+#include "string.h"
+
+static ESP_t ESP;
+static ATSIM_t sim;
+static uint8_t rx[65536];
+static uint32_t rxLen, activeEvents, closedEvents;
+
+static int Callback(ESP_Event_t evt, ESP_EventParams_t* params) {
+    switch (evt) {
+        case espEventDataReceived:
+            TEST_ASSERT(rxLen + params->UI <= sizeof(rx));
+            memcpy(&rx[rxLen], params->CP2, params->UI);
+            rxLen += params->UI;
+            break;
+#if ESP_SINGLE_CONN
+        case espEventTransparentReceived:
+            TEST_ASSERT(rxLen + params->UI <= sizeof(rx));
+            memcpy(&rx[rxLen], params->CP2, params->UI);
+            rxLen += params->UI;
+            break;
+#endif
+        case espEventConnActive:
+            activeEvents++;
+            break;
+        case espEventConnClosed:
+            closedEvents++;
+            break;
+        default:
+            break;
+    }
+    return 0;
+}
+
+static void Start(const ATSIM_Config_t* config) {
+    ATSIM_Init(&sim, config);
+    TEST_EQUAL(ESP_HOST_Attach(&ESP, &sim), 0);
+    rxLen = activeEvents = closedEvents = 0;
+    TEST_EQUAL(ESP_Init(&ESP, 115200, Callback), espOK);
+}
+
+static void Stop(void) {
+    ESP_DeInit(&ESP);
+    ESP_HOST_Detach(&ESP);
+    ATSIM_DeInit(&sim);
+}
+
+static void Join(void) {
+    TEST_EQUAL(ESP_STA_Connect(&ESP, "Home", "password", NULL, 0, 1), espOK);
+}
+
+/* Waits until count bytes are received */
+static void WaitReceived(uint32_t count, uint32_t timeout) {
+    while (rxLen < count && timeout--) {
+        ESP_HOST_Run(1);
+    }
+    TEST_EQUAL(rxLen, count);
+}
+
+static void TestInit(void) {
+    Start(NULL);
+    TEST_ASSERT(sim.Booted);
+    TEST_EQUAL(sim.Echo, 0);
+    TEST_EQUAL(sim.Mux, !ESP_SINGLE_CONN);
+    TEST_EQUAL(sim.DInfo, 1);
+    TEST_EQUAL(sim.Mode, 3);
+    Stop();
+}
+
+static void TestScanAndJoin(void) {
+    ESP_AP_t aps[10];
+    ESP_ConnectedAP_t ap;
+    uint16_t count = 0;
+    uint8_t ip[4];
+
+    Start(NULL);
+    TEST_EQUAL(ESP_STA_ListAccessPoints(&ESP, aps, 10, &count, 1), espOK);
+    TEST_EQUAL(count, 4);
+    TEST_ASSERT(strcmp(aps[0].SSID, "Home") == 0);
+    TEST_EQUAL(aps[0].RSSI, -45);
+    TEST_EQUAL(aps[2].Channel, 11);
+    TEST_EQUAL(aps[1].MAC[5], 0x66);
+
+    TEST_ASSERT(ESP_STA_Connect(&ESP, "Home", "wrong", NULL, 0, 1) != espOK);
+    TEST_ASSERT(ESP_STA_Connect(&ESP, "Nobody", "password", NULL, 0, 1) != espOK);
+    TEST_EQUAL(sim.Joined, -1);
+    Join();
+    TEST_EQUAL(sim.Joined, 0);
+    TEST_EQUAL(ESP_STA_GetConnected(&ESP, &ap, 1), espOK);
+    TEST_ASSERT(strcmp(ap.SSID, "Home") == 0);
+    TEST_EQUAL(ap.Channel, 6);
+    TEST_EQUAL(ESP_STA_GetIP(&ESP, ip, 1), espOK);
+    TEST_EQUAL(ip[0], 192);
+    TEST_EQUAL(ip[3], 57);
+    TEST_EQUAL(ESP_STA_Disconnect(&ESP, 1), espOK);
+    TEST_EQUAL(sim.Joined, -1);
+    Stop();
+}
+
+static void TestConnection(void) {
+    ATSIM_Config_t config = {0};
+    ESP_CONN_t* conn;
+    uint8_t data[3000];
+    uint32_t bw, i;
+
+    config.Latency = 30;
+    config.Remote = ATSIM_Remote_Echo;
+    Start(&config);
+    TEST_ASSERT(ESP_CONN_Start(&ESP, &conn, ESP_CONN_Type_TCP, "example.com", 80, 1) != espOK);  /* Wi-Fi not joined yet */
+    Join();
+    TEST_ASSERT(ESP_CONN_Start(&ESP, &conn, ESP_CONN_Type_TCP, "host.invalid", 80, 1) != espOK);
+    TEST_EQUAL(ESP_CONN_Start(&ESP, &conn, ESP_CONN_Type_TCP, "example.com", 80, 1), espOK);
+    TEST_ASSERT(sim.Conn[conn->Number].Active);
+    TEST_EQUAL(sim.Conn[conn->Number].RemotePort, 80);
+
+    for (i = 0; i < sizeof(data); i++) {
+        data[i] = (uint8_t)(i * 7);
+    }
+    TEST_EQUAL(ESP_CONN_Send(&ESP, conn, data, sizeof(data), &bw, 1), espOK);   /* More than one CIPSEND */
+    TEST_EQUAL(bw, sizeof(data));
+    TEST_EQUAL(sim.Conn[conn->Number].BytesSent, sizeof(data));
+    WaitReceived(sizeof(data), 1000);                       /* Echo comes back as +IPD */
+    TEST_ASSERT(memcmp(rx, data, sizeof(data)) == 0);
+
+    rxLen = 0;
+    TEST_EQUAL(ATSIM_RemoteSend(&sim, conn->Number, "Hello", 5), 0);
+    WaitReceived(5, 1000);
+    TEST_ASSERT(memcmp(rx, "Hello", 5) == 0);
+
+    TEST_EQUAL(ESP_CONN_Close(&ESP, conn, 1), espOK);
+    TEST_EQUAL(sim.Conn[conn->Number].Active, 0);
+    ESP_HOST_Run(10);
+    TEST_EQUAL(closedEvents, 1);
+
+    TEST_EQUAL(ESP_CONN_Start(&ESP, &conn, ESP_CONN_Type_TCP, "10.0.0.1", 8080, 1), espOK);
+    TEST_EQUAL(ATSIM_RemoteClose(&sim, conn->Number), 0);
+    ESP_HOST_Run(10);
+    TEST_EQUAL(closedEvents, 2);
+    TEST_EQUAL(activeEvents, 2);
+    Stop();
+}
+
+static void TestServices(void) {
+    ESP_SNTP_t sntp = {0};
+    ESP_DateTime_t dt;
+    uint32_t time = 0;
+    uint8_t ip[4];
+
+    Start(NULL);
+    Join();
+    sntp.Enable = 1;
+    sntp.Timezone = 2;
+    TEST_EQUAL(ESP_SNTP_SetConfig(&ESP, &sntp, 1), espOK);
+    TEST_EQUAL(ESP_SNTP_GetDateTime(&ESP, &dt, 1), espOK);
+    TEST_EQUAL(dt.Year, 2016);
+    TEST_EQUAL(dt.Month, 8);
+    TEST_EQUAL(dt.Date, 4);
+    TEST_EQUAL(dt.Hours, 16);
+
+    sim.Config.Latency = 25;
+    TEST_EQUAL(ESP_Ping(&ESP, "example.com", &time, 1), espOK);
+    TEST_EQUAL(time, 25);
+    TEST_EQUAL(ESP_DNS_GetIp(&ESP, "example.com", ip, 1), espOK);
+    TEST_EQUAL(ip[0], 93);
+    TEST_EQUAL(ip[3], 34);
+    TEST_ASSERT(ESP_DNS_GetIp(&ESP, "name.invalid", ip, 1) != espOK);
+    Stop();
+}
+
+#if ESP_SINGLE_CONN
+static void TestTransparent(void) {
+    ATSIM_Config_t config = {0};
+    ESP_CONN_t* conn;
+    static const char msg[] = "GET / HTTP/1.1\r\n+++\r\n\r\n";
+
+    config.Latency = 20;
+    config.Remote = ATSIM_Remote_Echo;
+    Start(&config);
+    Join();
+    TEST_EQUAL(ESP_CONN_Start(&ESP, &conn, ESP_CONN_Type_TCP, "example.com", 80, 1), espOK);
+    TEST_EQUAL(ESP_TRANSFER_SetMode(&ESP, ESP_TransferMode_Transparent, 1), espOK);
+    TEST_EQUAL(ESP_TRANSFER_Start(&ESP, 1), espOK);
+    TEST_ASSERT(sim.Transparent);
+    TEST_EQUAL(ESP_TRANSFER_Send(&ESP, msg, sizeof(msg) - 1, 1), espOK);
+    WaitReceived(sizeof(msg) - 1, 1000);                    /* Data with + characters are not escape sequence */
+    TEST_ASSERT(memcmp(rx, msg, sizeof(msg) - 1) == 0);
+    TEST_EQUAL(ESP_TRANSFER_Stop(&ESP, 1), espOK);
+    TEST_EQUAL(sim.Transparent, 0);
+    TEST_EQUAL(sim.Conn[0].Active, 1);
+    Stop();
+}
+#endif
+
+/* Stack must survive ERROR responses, failed sends and corrupted characters */
+static void TestErrors(void) {
+    ATSIM_Config_t config = {0};
+    ESP_CONN_t* conn = NULL;
+    uint32_t ram, i, ok = 0, bw;
+    uint8_t data[200];
+
+    config.ErrorRate = 100;
+    config.SendFailRate = 200;
+    config.GarbageRate = 2;
+    config.Remote = ATSIM_Remote_Echo;
+    config.Seed = 42;
+    Start(&config);
+    for (i = 0; i < 20 && ESP_STA_Connect(&ESP, "Home", "password", NULL, 0, 1) != espOK; i++);
+    TEST_EQUAL(sim.Joined, 0);
+    for (i = 0; i < 100; i++) {
+        if (ESP_SYS_GetAvailableRAM(&ESP, &ram, 1) == espOK) {
+            ok++;
+        }
+    }
+    TEST_ASSERT(sim.Errors > 0);
+    TEST_ASSERT(ok > 50 && ok < 100);
+
+    for (i = 0; i < 20 && ESP_CONN_Start(&ESP, &conn, ESP_CONN_Type_TCP, "example.com", 80, 1) != espOK; i++);
+    TEST_ASSERT(conn != NULL && sim.Conn[conn->Number].Active);
+    memset(data, 'x', sizeof(data));
+    for (ok = 0, i = 0; i < 50; i++) {
+        if (ESP_CONN_Send(&ESP, conn, data, sizeof(data), &bw, 1) == espOK) {
+            ok++;
+        }
+    }
+    TEST_ASSERT(sim.SendFails > 0);
+    TEST_ASSERT(ok > 25);
+    TEST_ASSERT(sim.Garbage > 0);
+    Stop();
+}
+
+/* Module answers at different baudrate than host expects */
+static void TestBaudrateMismatch(void) {
+    ATSIM_Init(&sim, NULL);
+    ESP_HOST_Attach(&ESP, &sim);
+    TEST_ASSERT(ESP_Init(&ESP, 921600, Callback) != espOK);
+    Stop();
+}
+
+int main(void) {
+    TEST_RUN(TestInit);
+    TEST_RUN(TestScanAndJoin);
+    TEST_RUN(TestConnection);
+    TEST_RUN(TestServices);
+#if ESP_SINGLE_CONN
+    TEST_RUN(TestTransparent);
+#endif
+    TEST_RUN(TestErrors);
+    TEST_RUN(TestBaudrateMismatch);
+    return 0;
+}
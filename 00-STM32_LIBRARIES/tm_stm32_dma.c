@@ -161,6 +161,14 @@ void TM_DMA_DisableInterrupts(DMA_Stream_TypeDef* DMA_Stream) {
 	DMA_Stream->FCR &= DMA_SxFCR_FEIE;
 }
 
+IRQn_Type TM_DMA_GetIRQn(DMA_Stream_TypeDef* DMA_Stream) {
+	/* Check stream value */
+	if (DMA_Stream < DMA2_Stream0) {
+		return DMA_IRQs[0][GET_STREAM_NUMBER_DMA1(DMA_Stream)];
+	}
+	return DMA_IRQs[1][GET_STREAM_NUMBER_DMA2(DMA_Stream)];
+}
+
 void TM_DMA_Init(DMA_Stream_TypeDef* Stream, DMA_HandleTypeDef* HDMA) {	
 	/* Init DMA stream */
 	if (HDMA) {
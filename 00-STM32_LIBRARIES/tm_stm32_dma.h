@@ -212,6 +212,13 @@ void TM_DMA_EnableInterrupts(DMA_Stream_TypeDef* DMA_Stream);
  */
 void TM_DMA_DisableInterrupts(DMA_Stream_TypeDef* DMA_Stream);
 
+/**
+ * @brief  Gets NVIC interrupt number of DMA stream
+ * @param  *DMA_Stream: Pointer to DMA stream
+ * @retval Interrupt number for @ref HAL_NVIC_SetPriority and similar functions
+ */
+IRQn_Type TM_DMA_GetIRQn(DMA_Stream_TypeDef* DMA_Stream);
+
 /**
  * @brief  Transfer complete callback
  * @note   This function is called when interrupt for specific stream happens for transfer complete
@@ -25,6 +25,9 @@
  */
 #include "tm_stm32_usart.h"
 
+/* Check if character received and receive interrupt is used (disabled when DMA receives data) */
+#define USART_INT_RX_PENDING(USARTx)    (((USARTx)->USART_STATUS_REG & USART_ISR_RXNE) && ((USARTx)->CR1 & USART_CR1_RXNEIE))
+
 /* Set alternate function mappings */
 #if defined(STM32F4xx) || defined(STM32F7xx)
 
@@ -449,6 +452,12 @@ __weak void TM_USART_InitCustomPinsCallback(USART_TypeDef* USARTx, uint16_t Alte
 	*/
 }
 
+__weak void TM_USART_IdleLineHandler(USART_TypeDef* USARTx) {
+	/* NOTE: This function Should not be modified, when the callback is needed,
+           the TM_USART_IdleLineHandler could be implemented in the user file
+	*/
+}
+
 __weak void TM_USART1_ReceiveHandler(uint8_t c) { }
 __weak void TM_USART2_ReceiveHandler(uint8_t c) { }
 __weak void TM_USART3_ReceiveHandler(uint8_t c) { }
@@ -868,7 +877,7 @@ void TM_USART8_InitPins(TM_USART_PinsPack_t pinspack) {
 #ifdef USART1
 void USART1_IRQHandler(void) {
 	/* Check if interrupt was because data is received */
-	if (USART1->USART_STATUS_REG & USART_ISR_RXNE) {
+	if (USART_INT_RX_PENDING(USART1)) {
 #ifdef TM_USART1_USE_CUSTOM_IRQ
 		/* Call user function */
 		TM_USART1_ReceiveHandler(USART_READ_DATA(USART1));
@@ -886,7 +895,7 @@ void USART1_IRQHandler(void) {
 #ifdef USART2
 void USART2_IRQHandler(void) {
 	/* Check if interrupt was because data is received */
-	if (USART2->USART_STATUS_REG & USART_ISR_RXNE) {
+	if (USART_INT_RX_PENDING(USART2)) {
 #ifdef TM_USART2_USE_CUSTOM_IRQ
 		/* Call user function */
 		TM_USART2_ReceiveHandler(USART_READ_DATA(USART2));
@@ -904,7 +913,7 @@ void USART2_IRQHandler(void) {
 #ifdef USART3
 void USART3_IRQHandler(void) {
 	/* Check if interrupt was because data is received */
-	if (USART3->USART_STATUS_REG & USART_ISR_RXNE) {
+	if (USART_INT_RX_PENDING(USART3)) {
 #ifdef TM_USART3_USE_CUSTOM_IRQ
 		/* Call user function */
 		TM_USART3_ReceiveHandler(USART_READ_DATA(USART3));
@@ -922,7 +931,7 @@ void USART3_IRQHandler(void) {
 #ifdef UART4
 void UART4_IRQHandler(void) {
 	/* Check if interrupt was because data is received */
-	if (UART4->USART_STATUS_REG & USART_ISR_RXNE) {
+	if (USART_INT_RX_PENDING(UART4)) {
 #ifdef TM_UART4_USE_CUSTOM_IRQ
 		/* Call user function */
 		TM_UART4_ReceiveHandler(USART_READ_DATA(UART4));
@@ -940,7 +949,7 @@ void UART4_IRQHandler(void) {
 #ifdef UART5
 void UART5_IRQHandler(void) {
 	/* Check if interrupt was because data is received */
-	if (UART5->USART_STATUS_REG & USART_ISR_RXNE) {
+	if (USART_INT_RX_PENDING(UART5)) {
 #ifdef TM_UART5_USE_CUSTOM_IRQ
 		/* Call user function */
 		TM_UART5_ReceiveHandler(USART_READ_DATA(UART5));
@@ -958,7 +967,7 @@ void UART5_IRQHandler(void) {
 #ifdef USART6
 void USART6_IRQHandler(void) {
 	/* Check if interrupt was because data is received */
-	if (USART6->USART_STATUS_REG & USART_ISR_RXNE) {
+	if (USART_INT_RX_PENDING(USART6)) {
 #ifdef TM_USART6_USE_CUSTOM_IRQ
 		/* Call user function */
 		TM_USART6_ReceiveHandler(USART_READ_DATA(USART6));
@@ -976,7 +985,7 @@ void USART6_IRQHandler(void) {
 #ifdef UART7
 void UART7_IRQHandler(void) {
 	/* Check if interrupt was because data is received */
-	if (UART7->USART_STATUS_REG & USART_ISR_RXNE) {
+	if (USART_INT_RX_PENDING(UART7)) {
 #ifdef TM_UART7_USE_CUSTOM_IRQ
 		/* Call user function */
 		TM_UART7_ReceiveHandler(USART_READ_DATA(UART7));
@@ -994,7 +1003,7 @@ void UART7_IRQHandler(void) {
 #ifdef UART8
 void UART8_IRQHandler(void) {
 	/* Check if interrupt was because data is received */
-	if (UART8->USART_STATUS_REG & USART_ISR_RXNE) {
+	if (USART_INT_RX_PENDING(UART8)) {
 #ifdef TM_UART8_USE_CUSTOM_IRQ
 		/* Call user function */
 		TM_UART8_ReceiveHandler(USART_READ_DATA(UART8));
@@ -1013,7 +1022,7 @@ void UART8_IRQHandler(void) {
 #ifdef USART8
 void USART3_8_IRQHandler(void) {
 	/* Check if interrupt was because data is received */
-	if (USART3->USART_STATUS_REG & USART_ISR_RXNE) {
+	if (USART_INT_RX_PENDING(USART3)) {
 #ifdef TM_USART3_USE_CUSTOM_IRQ
 		/* Call user function */
 		TM_UART8_ReceiveHandler(USART_READ_DATA(USART3));
@@ -1024,7 +1033,7 @@ void USART3_8_IRQHandler(void) {
 	}
 
 	/* Check if interrupt was because data is received */
-	if (USART4->USART_STATUS_REG & USART_ISR_RXNE) {
+	if (USART_INT_RX_PENDING(USART4)) {
 #ifdef TM_USART4_USE_CUSTOM_IRQ
 		/* Call user function */
 		TM_UART8_ReceiveHandler(USART_READ_DATA(USART4));
@@ -1035,7 +1044,7 @@ void USART3_8_IRQHandler(void) {
 	}
 
 	/* Check if interrupt was because data is received */
-	if (USART5->USART_STATUS_REG & USART_ISR_RXNE) {
+	if (USART_INT_RX_PENDING(USART5)) {
 #ifdef TM_USART5_USE_CUSTOM_IRQ
 		/* Call user function */
 		TM_UART8_ReceiveHandler(USART_READ_DATA(USART5));
@@ -1046,7 +1055,7 @@ void USART3_8_IRQHandler(void) {
 	}
 
 	/* Check if interrupt was because data is received */
-	if (USART6->USART_STATUS_REG & USART_ISR_RXNE) {
+	if (USART_INT_RX_PENDING(USART6)) {
 #ifdef TM_USART6_USE_CUSTOM_IRQ
 		/* Call user function */
 		TM_UART8_ReceiveHandler(USART_READ_DATA(USART6));
@@ -1057,7 +1066,7 @@ void USART3_8_IRQHandler(void) {
 	}
 
 	/* Check if interrupt was because data is received */
-	if (USART7->USART_STATUS_REG & USART_ISR_RXNE) {
+	if (USART_INT_RX_PENDING(USART7)) {
 #ifdef TM_USART7_USE_CUSTOM_IRQ
 		/* Call user function */
 		TM_UART8_ReceiveHandler(USART_READ_DATA(USART7));
@@ -1068,7 +1077,7 @@ void USART3_8_IRQHandler(void) {
 	}
 
 	/* Check if interrupt was because data is received */
-	if (USART8->USART_STATUS_REG & USART_ISR_RXNE) {
+	if (USART_INT_RX_PENDING(USART8)) {
 #ifdef TM_USART8_USE_CUSTOM_IRQ
 		/* Call user function */
 		TM_UART8_ReceiveHandler(USART_READ_DATA(USART8));
@@ -1089,7 +1098,7 @@ void USART3_8_IRQHandler(void) {
 #elif defined(USART6)
 void USART3_6_IRQHandler(void) {
 	/* Check if interrupt was because data is received */
-	if (USART3->USART_STATUS_REG & USART_ISR_RXNE) {
+	if (USART_INT_RX_PENDING(USART3)) {
 #ifdef TM_USART3_USE_CUSTOM_IRQ
 		/* Call user function */
 		TM_UART8_ReceiveHandler(USART_READ_DATA(USART3));
@@ -1100,7 +1109,7 @@ void USART3_6_IRQHandler(void) {
 	}
 
 	/* Check if interrupt was because data is received */
-	if (USART4->USART_STATUS_REG & USART_ISR_RXNE) {
+	if (USART_INT_RX_PENDING(USART4)) {
 #ifdef TM_USART4_USE_CUSTOM_IRQ
 		/* Call user function */
 		TM_UART8_ReceiveHandler(USART_READ_DATA(USART4));
@@ -1111,7 +1120,7 @@ void USART3_6_IRQHandler(void) {
 	}
 
 	/* Check if interrupt was because data is received */
-	if (USART5->USART_STATUS_REG & USART_ISR_RXNE) {
+	if (USART_INT_RX_PENDING(USART5)) {
 #ifdef TM_USART5_USE_CUSTOM_IRQ
 		/* Call user function */
 		TM_UART8_ReceiveHandler(USART_READ_DATA(USART5));
@@ -1122,7 +1131,7 @@ void USART3_6_IRQHandler(void) {
 	}
 
 	/* Check if interrupt was because data is received */
-	if (USART6->USART_STATUS_REG & USART_ISR_RXNE) {
+	if (USART_INT_RX_PENDING(USART6)) {
 #ifdef TM_USART6_USE_CUSTOM_IRQ
 		/* Call user function */
 		TM_UART8_ReceiveHandler(USART_READ_DATA(USART6));
@@ -1141,7 +1150,7 @@ void USART3_6_IRQHandler(void) {
 #elif defined(USART4)
 void USART3_6_IRQHandler(void) {
 	/* Check if interrupt was because data is received */
-	if (USART3->USART_STATUS_REG & USART_ISR_RXNE) {
+	if (USART_INT_RX_PENDING(USART3)) {
 #ifdef TM_USART3_USE_CUSTOM_IRQ
 		/* Call user function */
 		TM_UART8_ReceiveHandler(USART_READ_DATA(USART3));
@@ -1152,7 +1161,7 @@ void USART3_6_IRQHandler(void) {
 	}
 
 	/* Check if interrupt was because data is received */
-	if (USART4->USART_STATUS_REG & USART_ISR_RXNE) {
+	if (USART_INT_RX_PENDING(USART4)) {
 #ifdef TM_USART4_USE_CUSTOM_IRQ
 		/* Call user function */
 		TM_UART8_ReceiveHandler(USART_READ_DATA(USART4));
@@ -1397,6 +1406,11 @@ static UART_HandleTypeDef UART_Handle;
 static void TM_USART_INT_ClearAllFlags(USART_TypeDef* USARTx, IRQn_Type irq) {
 	UART_Handle.Instance = USARTx;
 	
+	/* Check idle line detection before flag is cleared */
+	if ((USARTx->CR1 & USART_CR1_IDLEIE) && (USARTx->USART_STATUS_REG & USART_ISR_IDLE)) {
+		TM_USART_IdleLineHandler(USARTx);
+	}
+	
 #ifdef __HAL_UART_CLEAR_PEFLAG
 	__HAL_UART_CLEAR_PEFLAG(&UART_Handle);
 #endif
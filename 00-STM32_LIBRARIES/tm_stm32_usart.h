@@ -3,7 +3,7 @@
  * @email   tilen@majerle.eu
  * @website http://stm32f4-discovery.net
  * @link    http://stm32f4-discovery.net/2015/07/hal-library-07-usart-for-stm32fxxx
- * @version v1.2.1
+ * @version v1.3
  * @ide     Keil uVision
  * @license MIT
  * @brief   USART Library for STM32Fxxx with receive interrupt
@@ -35,7 +35,7 @@
 \endverbatim
  */
 #ifndef TM_USART_H
-#define TM_USART_H 121
+#define TM_USART_H 130
 
 /* C++ detection */
 #ifdef __cplusplus
@@ -188,6 +188,10 @@ USART8       |PC2    PC3     |PC8    PC9     |PD13   PD14
   - December 26, 2015
   - On reinitialization USART with other baudrate, USART didn't work properly and needs some time to start.
   - With forcing register reset this has been fixed
+   
+ Version 1.3
+  - Added idle line callback, used by DMA receive in TM USART DMA library
+  - Receive interrupt ignores data when RXNE interrupt is disabled (DMA receive mode)
 \endverbatim
  *
  * \b Dependencies
@@ -509,6 +513,9 @@ typedef enum {
 #if !defined(USART_ISR_RXNE)
 #define USART_ISR_RXNE                      USART_SR_RXNE
 #endif
+#if !defined(USART_ISR_IDLE)
+#define USART_ISR_IDLE                      USART_SR_IDLE
+#endif
 
 /**
  * @brief  Default string delimiter for USART
@@ -700,6 +707,15 @@ int16_t TM_USART_FindString(USART_TypeDef* USARTx, char* str);
  */
 void TM_USART_InitCustomPinsCallback(USART_TypeDef* USARTx, uint16_t AlternateFunction);
 
+/**
+ * @brief  Callback function for idle line detection on USART
+ * @note   Called from USART interrupt when idle line interrupt (USART_CR1_IDLEIE) is enabled, for example by @ref TM_USART_DMA_InitRX
+ * @note   With __weak parameter to prevent link errors if not defined by user
+ * @param  *USARTx: Pointer to USARTx where idle line was detected
+ * @retval None
+ */
+void TM_USART_IdleLineHandler(USART_TypeDef* USARTx);
+
 /**
  * @brief  Callback function for receive interrupt on USART1 in case you have enabled custom USART handler mode 
  * @note   With __weak parameter to prevent link errors if not defined by user
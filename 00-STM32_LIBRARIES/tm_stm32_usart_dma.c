@@ -29,32 +29,37 @@
 typedef struct {
 	uint32_t DMA_Channel;
 	DMA_Stream_TypeDef* DMA_Stream;
+	uint32_t DMA_RX_Channel;
+	DMA_Stream_TypeDef* DMA_RX_Stream;
+	uint8_t* RX_Buffer;
+	uint16_t RX_Size;
+	uint16_t RX_Pos;
 } TM_USART_DMA_INT_t;
 
 /* Create variables if necessary */
 #ifdef USART1
-static TM_USART_DMA_INT_t USART1_DMA_INT = {USART1_DMA_TX_CHANNEL, USART1_DMA_TX_STREAM};
+static TM_USART_DMA_INT_t USART1_DMA_INT = {USART1_DMA_TX_CHANNEL, USART1_DMA_TX_STREAM, USART1_DMA_RX_CHANNEL, USART1_DMA_RX_STREAM};
 #endif
 #ifdef USART2
-static TM_USART_DMA_INT_t USART2_DMA_INT = {USART2_DMA_TX_CHANNEL, USART2_DMA_TX_STREAM};
+static TM_USART_DMA_INT_t USART2_DMA_INT = {USART2_DMA_TX_CHANNEL, USART2_DMA_TX_STREAM, USART2_DMA_RX_CHANNEL, USART2_DMA_RX_STREAM};
 #endif
 #ifdef USART3
-static TM_USART_DMA_INT_t USART3_DMA_INT = {USART3_DMA_TX_CHANNEL, USART3_DMA_TX_STREAM};
+static TM_USART_DMA_INT_t USART3_DMA_INT = {USART3_DMA_TX_CHANNEL, USART3_DMA_TX_STREAM, USART3_DMA_RX_CHANNEL, USART3_DMA_RX_STREAM};
 #endif
 #ifdef UART4
-static TM_USART_DMA_INT_t UART4_DMA_INT = {UART4_DMA_TX_CHANNEL, UART4_DMA_TX_STREAM};
+static TM_USART_DMA_INT_t UART4_DMA_INT = {UART4_DMA_TX_CHANNEL, UART4_DMA_TX_STREAM, UART4_DMA_RX_CHANNEL, UART4_DMA_RX_STREAM};
 #endif
 #ifdef UART5
-static TM_USART_DMA_INT_t UART5_DMA_INT = {UART5_DMA_TX_CHANNEL, UART5_DMA_TX_STREAM};
+static TM_USART_DMA_INT_t UART5_DMA_INT = {UART5_DMA_TX_CHANNEL, UART5_DMA_TX_STREAM, UART5_DMA_RX_CHANNEL, UART5_DMA_RX_STREAM};
 #endif
 #ifdef USART6
-static TM_USART_DMA_INT_t USART6_DMA_INT = {USART6_DMA_TX_CHANNEL, USART6_DMA_TX_STREAM};
+static TM_USART_DMA_INT_t USART6_DMA_INT = {USART6_DMA_TX_CHANNEL, USART6_DMA_TX_STREAM, USART6_DMA_RX_CHANNEL, USART6_DMA_RX_STREAM};
 #endif
 #ifdef UART7
-static TM_USART_DMA_INT_t UART7_DMA_INT = {UART7_DMA_TX_CHANNEL, UART7_DMA_TX_STREAM};
+static TM_USART_DMA_INT_t UART7_DMA_INT = {UART7_DMA_TX_CHANNEL, UART7_DMA_TX_STREAM, UART7_DMA_RX_CHANNEL, UART7_DMA_RX_STREAM};
 #endif
 #ifdef UART8
-static TM_USART_DMA_INT_t UART8_DMA_INT = {UART8_DMA_TX_CHANNEL, UART8_DMA_TX_STREAM};
+static TM_USART_DMA_INT_t UART8_DMA_INT = {UART8_DMA_TX_CHANNEL, UART8_DMA_TX_STREAM, UART8_DMA_RX_CHANNEL, UART8_DMA_RX_STREAM};
 #endif
 
 /* Private functions */
@@ -168,6 +173,144 @@ uint16_t TM_USART_DMA_Transmitting(USART_TypeDef* USARTx) {
 	return !USART_TXEMPTY(USARTx);
 }
 
+void TM_USART_DMA_InitRX(USART_TypeDef* USARTx, uint8_t* Buffer, uint16_t Size) {
+	DMA_HandleTypeDef DMA_InitStruct;
+	
+	/* Get USART settings */
+	TM_USART_DMA_INT_t* Settings = TM_USART_DMA_INT_GetSettings(USARTx);
+	
+	/* Save buffer */
+	Settings->RX_Buffer = Buffer;
+	Settings->RX_Size = Size;
+	Settings->RX_Pos = 0;
+	
+	/* Enable DMA clock and disable stream */
+	TM_DMA_Init(Settings->DMA_RX_Stream, NULL);
+	Settings->DMA_RX_Stream->CR &= ~DMA_SxCR_EN;
+	
+	/* Set DMA options */
+	DMA_InitStruct.Instance = Settings->DMA_RX_Stream;
+	DMA_InitStruct.Init.Channel = Settings->DMA_RX_Channel;
+	DMA_InitStruct.Init.Direction = DMA_PERIPH_TO_MEMORY;
+	DMA_InitStruct.Init.PeriphInc = DMA_PINC_DISABLE;
+	DMA_InitStruct.Init.MemInc = DMA_MINC_ENABLE;
+	DMA_InitStruct.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+	DMA_InitStruct.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+	DMA_InitStruct.Init.Mode = DMA_CIRCULAR;
+	DMA_InitStruct.Init.Priority = DMA_PRIORITY_HIGH;
+	DMA_InitStruct.Init.FIFOMode = DMA_FIFOMODE_DISABLE;
+	DMA_InitStruct.Init.FIFOThreshold = DMA_FIFO_THRESHOLD_FULL;
+	DMA_InitStruct.Init.MemBurst = DMA_MBURST_SINGLE;
+	DMA_InitStruct.Init.PeriphBurst = DMA_PBURST_SINGLE;
+	
+	/* Clear all flags */
+	TM_DMA_ClearFlags(Settings->DMA_RX_Stream);
+	
+	/* Init HAL */
+	TM_DMA_Init(Settings->DMA_RX_Stream, &DMA_InitStruct);
+	
+	/* Enable interrupts, only half transfer and transfer complete are needed */
+	TM_DMA_EnableInterrupts(Settings->DMA_RX_Stream);
+	Settings->DMA_RX_Stream->CR &= ~(DMA_SxCR_TEIE | DMA_SxCR_DMEIE);
+	Settings->DMA_RX_Stream->FCR &= ~DMA_SxFCR_FEIE;
+	
+	/* DMA and idle line interrupts both call TM_USART_DMA_ProcessRX, give them the same priority so they can not preempt each other */
+	HAL_NVIC_SetPriority(TM_DMA_GetIRQn(Settings->DMA_RX_Stream), USART_NVIC_PRIORITY, 0);
+	
+	/* Start circular transfer */
+	TM_DMA_Start(&DMA_InitStruct, (uint32_t) &USART_READ_DATA(USARTx), (uint32_t) &Buffer[0], Size);
+	
+	/* Disable RXNE interrupt and enable idle line interrupt */
+	USARTx->CR1 &= ~USART_CR1_RXNEIE;
+	USARTx->CR1 |= USART_CR1_IDLEIE;
+	
+	/* Enable USART RX DMA */
+	USARTx->CR3 |= USART_CR3_DMAR;
+}
+
+void TM_USART_DMA_InitRXWithStreamAndChannel(USART_TypeDef* USARTx, DMA_Stream_TypeDef* DMA_Stream, uint32_t DMA_Channel, uint8_t* Buffer, uint16_t Size) {
+	/* Get USART settings */
+	TM_USART_DMA_INT_t* Settings = TM_USART_DMA_INT_GetSettings(USARTx);
+	
+	/* Set DMA stream and channel */
+	Settings->DMA_RX_Stream = DMA_Stream;
+	Settings->DMA_RX_Channel = DMA_Channel;
+	
+	/* Init DMA RX */
+	TM_USART_DMA_InitRX(USARTx, Buffer, Size);
+}
+
+void TM_USART_DMA_DeinitRX(USART_TypeDef* USARTx) {
+	/* Get USART settings */
+	TM_USART_DMA_INT_t* Settings = TM_USART_DMA_INT_GetSettings(USARTx);
+	
+	/* Disable USART RX DMA and idle line interrupt */
+	USARTx->CR3 &= ~USART_CR3_DMAR;
+	USARTx->CR1 &= ~USART_CR1_IDLEIE;
+	
+	/* Deinit DMA Stream */
+	TM_DMA_DisableInterrupts(Settings->DMA_RX_Stream);
+	TM_DMA_DeInit(Settings->DMA_RX_Stream);
+	Settings->RX_Buffer = NULL;
+	
+	/* Enable RXNE interrupt back */
+	USARTx->CR1 |= USART_CR1_RXNEIE;
+}
+
+DMA_Stream_TypeDef* TM_USART_DMA_GetStreamRX(USART_TypeDef* USARTx) {
+	/* Get USART settings */
+	return TM_USART_DMA_INT_GetSettings(USARTx)->DMA_RX_Stream;
+}
+
+uint16_t TM_USART_DMA_ProcessRX(USART_TypeDef* USARTx) {
+	uint16_t pos, count = 0;
+	
+	/* Get USART settings */
+	TM_USART_DMA_INT_t* Settings = TM_USART_DMA_INT_GetSettings(USARTx);
+	
+	/* Check if DMA RX is active */
+	if (Settings->RX_Buffer == NULL) {
+		return 0;
+	}
+	
+	/* Get current DMA write position in buffer */
+	pos = Settings->RX_Size - Settings->DMA_RX_Stream->NDTR;
+	if (pos >= Settings->RX_Size) {
+		pos = 0;
+	}
+	
+	/* Check for new data */
+	if (pos != Settings->RX_Pos) {
+		if (pos > Settings->RX_Pos) {
+			/* New data are in one linear block */
+			count = pos - Settings->RX_Pos;
+			TM_USART_DMA_ReceiveHandler(USARTx, &Settings->RX_Buffer[Settings->RX_Pos], count);
+		} else {
+			/* DMA wrapped, report data to the end of buffer first */
+			count = Settings->RX_Size - Settings->RX_Pos;
+			TM_USART_DMA_ReceiveHandler(USARTx, &Settings->RX_Buffer[Settings->RX_Pos], count);
+			
+			/* Then data from the beginning of buffer */
+			if (pos) {
+				TM_USART_DMA_ReceiveHandler(USARTx, &Settings->RX_Buffer[0], pos);
+				count += pos;
+			}
+		}
+		
+		/* Save new position */
+		Settings->RX_Pos = pos;
+	}
+	
+	/* Return number of new bytes */
+	return count;
+}
+
+__weak void TM_USART_DMA_ReceiveHandler(USART_TypeDef* USARTx, uint8_t* Data, uint16_t count) {
+	/* NOTE: This function should not be modified, when the callback is needed,
+            the TM_USART_DMA_ReceiveHandler should be implemented in the user file
+	*/
+}
+
 void TM_USART_DMA_EnableInterrupts(USART_TypeDef* USARTx) {
 	/* Get USART settings */
 	TM_USART_DMA_INT_t* Settings = TM_USART_DMA_INT_GetSettings(USARTx);
@@ -3,10 +3,10 @@
  * @email   tilen@majerle.eu
  * @website http://stm32f4-discovery.net
  * @link    http://stm32f4-discovery.net/2016/04/hal-library-32-dma-extension-for-usart-on-stm32fxxx
- * @version v1.0
+ * @version v1.1
  * @ide     Keil uVision
  * @license MIT
- * @brief   DMA TX functionality for USART for STM32F4xx or STM32F7xx devices
+ * @brief   DMA TX and circular DMA RX functionality for USART for STM32F4xx or STM32F7xx devices
  *	
 @verbatim
    ----------------------------------------------------------------------
@@ -35,7 +35,7 @@
 @endverbatim
  */
 #ifndef TM_USART_DMA_H
-#define TM_USART_DMA_H 100
+#define TM_USART_DMA_H 110
 
 /* C++ detection */
 #ifdef __cplusplus
@@ -56,8 +56,40 @@ extern "C" {
  *
  * It is great feature because you can do other stuff while DMA sends data to USART.
  *
- * It is designed only for TX data from MCU to other world. For RX, @ref TM_USART library already
- * uses RXNE (RX Not Empty) interrupts when data is available and there is no need for RX DMA too right now.
+ * By default, @ref TM_USART library receives data with RXNE (RX Not Empty) interrupt for each character.
+ * On high baudrates, this may take too much CPU time, so receive can be done with circular DMA instead.
+ *
+ * \par Circular DMA receive
+ *
+ * After @ref TM_USART_DMA_InitRX is called, DMA writes received data to user buffer in circular mode.
+ * Data are reported to user in blocks with @ref TM_USART_DMA_ReceiveHandler callback, when:
+ *
+@verbatim
+- Half of buffer is filled (DMA half transfer interrupt)
+- Buffer is completely filled (DMA transfer complete interrupt)
+- USART line is idle after data were received (USART idle line interrupt)
+@endverbatim
+ *
+ * Library does not define interrupt callbacks itself, user must call @ref TM_USART_DMA_ProcessRX from them:
+ *
+\code
+void TM_USART_IdleLineHandler(USART_TypeDef* USARTx) {
+	TM_USART_DMA_ProcessRX(USARTx);
+}
+void TM_DMA_HalfTransferCompleteHandler(DMA_Stream_TypeDef* DMA_Stream) {
+	if (DMA_Stream == TM_USART_DMA_GetStreamRX(USART1)) {
+		TM_USART_DMA_ProcessRX(USART1);
+	}
+}
+void TM_DMA_TransferCompleteHandler(DMA_Stream_TypeDef* DMA_Stream) {
+	if (DMA_Stream == TM_USART_DMA_GetStreamRX(USART1)) {
+		TM_USART_DMA_ProcessRX(USART1);
+	}
+}
+\endcode
+ *
+ * @note   USART and DMA RX stream interrupts must have the same preemption priority as they both process the same buffer.
+ *         @ref TM_USART_DMA_InitRX sets DMA RX stream interrupt to @ref USART_NVIC_PRIORITY for this reason.
  *
  * @warning This library works for STM32F4xx and STM32F7xx series only.
  *
@@ -72,7 +104,7 @@ extern "C" {
  * Default DMA streams and channels:
  *
 @verbatim
-USARTx     | DMA  | DMA Stream   | DMA Channel
+USARTx TX  | DMA  | DMA Stream   | DMA Channel
 
 USART1     | DMA2 | DMA Stream 7 | DMA Channel 4
 USART2     | DMA1 | DMA Stream 6 | DMA Channel 4
@@ -82,6 +114,17 @@ UART5      | DMA1 | DMA Stream 7 | DMA Channel 4
 USART6     | DMA2 | DMA Stream 6 | DMA Channel 5
 UART7      | DMA1 | DMA Stream 1 | DMA Channel 5
 UART8      | DMA1 | DMA Stream 0 | DMA Channel 5
+
+USARTx RX  | DMA  | DMA Stream   | DMA Channel
+
+USART1     | DMA2 | DMA Stream 2 | DMA Channel 4
+USART2     | DMA1 | DMA Stream 5 | DMA Channel 4
+USART3     | DMA1 | DMA Stream 1 | DMA Channel 4
+UART4      | DMA1 | DMA Stream 2 | DMA Channel 4
+UART5      | DMA1 | DMA Stream 0 | DMA Channel 4
+USART6     | DMA2 | DMA Stream 1 | DMA Channel 5
+UART7      | DMA1 | DMA Stream 3 | DMA Channel 5
+UART8      | DMA1 | DMA Stream 6 | DMA Channel 5
 @endverbatim
  *
  * \par Changelog
@@ -89,6 +132,9 @@ UART8      | DMA1 | DMA Stream 0 | DMA Channel 5
 @verbatim
  Version 1.0
   - First release
+  
+ Version 1.1
+  - Added circular DMA RX with half transfer, transfer complete and idle line detection
 @endverbatim
  *
  * \par Dependencies
@@ -109,8 +155,8 @@ UART8      | DMA1 | DMA Stream 0 | DMA Channel 5
 #include "string.h"
 
 /* Check USART library version */
-#if TM_USART_H < 121
-#error "TM USART library version must be greater or equal to 2.5.0. Please redownload TM USART library!"
+#if TM_USART_H < 130
+#error "TM USART library version must be greater or equal to 1.3. Please redownload TM USART library!"
 #endif
 
 /**
@@ -167,6 +213,54 @@ UART8      | DMA1 | DMA Stream 0 | DMA Channel 5
 #define UART8_DMA_TX_CHANNEL      DMA_CHANNEL_5
 #endif
 
+/* Default DMA RX Stream and Channel for USART1 */
+#ifndef USART1_DMA_RX_STREAM
+#define USART1_DMA_RX_STREAM      DMA2_Stream2
+#define USART1_DMA_RX_CHANNEL     DMA_CHANNEL_4
+#endif
+
+/* Default DMA RX Stream and Channel for USART2 */
+#ifndef USART2_DMA_RX_STREAM
+#define USART2_DMA_RX_STREAM      DMA1_Stream5
+#define USART2_DMA_RX_CHANNEL     DMA_CHANNEL_4
+#endif
+
+/* Default DMA RX Stream and Channel for USART3 */
+#ifndef USART3_DMA_RX_STREAM
+#define USART3_DMA_RX_STREAM      DMA1_Stream1
+#define USART3_DMA_RX_CHANNEL     DMA_CHANNEL_4
+#endif
+
+/* Default DMA RX Stream and Channel for UART4 */
+#ifndef UART4_DMA_RX_STREAM
+#define UART4_DMA_RX_STREAM       DMA1_Stream2
+#define UART4_DMA_RX_CHANNEL      DMA_CHANNEL_4
+#endif
+
+/* Default DMA RX Stream and Channel for UART5 */
+#ifndef UART5_DMA_RX_STREAM
+#define UART5_DMA_RX_STREAM       DMA1_Stream0
+#define UART5_DMA_RX_CHANNEL      DMA_CHANNEL_4
+#endif
+
+/* Default DMA RX Stream and Channel for USART6 */
+#ifndef USART6_DMA_RX_STREAM
+#define USART6_DMA_RX_STREAM      DMA2_Stream1
+#define USART6_DMA_RX_CHANNEL     DMA_CHANNEL_5
+#endif
+
+/* Default DMA RX Stream and Channel for UART7 */
+#ifndef UART7_DMA_RX_STREAM
+#define UART7_DMA_RX_STREAM       DMA1_Stream3
+#define UART7_DMA_RX_CHANNEL      DMA_CHANNEL_5
+#endif
+
+/* Default DMA RX Stream and Channel for UART8 */
+#ifndef UART8_DMA_RX_STREAM
+#define UART8_DMA_RX_STREAM       DMA1_Stream6
+#define UART8_DMA_RX_CHANNEL      DMA_CHANNEL_5
+#endif
+
 /**
  * @}
  */
@@ -268,6 +362,62 @@ uint8_t TM_USART_DMA_Send(USART_TypeDef* USARTx, uint8_t* DataArray, uint16_t co
  */
 uint16_t TM_USART_DMA_Transmitting(USART_TypeDef* USARTx);
 
+/**
+ * @brief  Initializes USART circular DMA RX functionality
+ * @note   USART HAVE TO be previously initialized using @ref TM_USART library.
+ *            RXNE interrupt is disabled and idle line interrupt is enabled instead
+ * @param  *USARTx: Pointer to USARTx where you want to enable DMA RX mode
+ * @param  *Buffer: Pointer to buffer where DMA will write received data. Must stay valid while DMA RX is active
+ * @param  Size: Size of buffer in units of bytes
+ * @retval None
+ */
+void TM_USART_DMA_InitRX(USART_TypeDef* USARTx, uint8_t* Buffer, uint16_t Size);
+
+/**
+ * @brief  Initializes USART circular DMA RX functionality with custom DMA stream and Channel options
+ * @note   Use this function only in case default Stream and Channel settings are not good for you
+ * @param  *USARTx: Pointer to USARTx where you want to enable DMA RX mode
+ * @param  *DMA_Stream: Pointer to DMAy_Streamx, where y is DMA (1 or 2) and x is Stream (0 to 7)
+ * @param  DMA_Channel: Select DMA channel for your USART in specific DMA Stream
+ * @param  *Buffer: Pointer to buffer where DMA will write received data. Must stay valid while DMA RX is active
+ * @param  Size: Size of buffer in units of bytes
+ * @retval None
+ */
+void TM_USART_DMA_InitRXWithStreamAndChannel(USART_TypeDef* USARTx, DMA_Stream_TypeDef* DMA_Stream, uint32_t DMA_Channel, uint8_t* Buffer, uint16_t Size);
+
+/**
+ * @brief  Deinitializes USART DMA RX functionality and enables RXNE interrupt back
+ * @param  *USARTx: Pointer to USARTx where you want to disable DMA RX mode
+ * @retval None
+ */
+void TM_USART_DMA_DeinitRX(USART_TypeDef* USARTx);
+
+/**
+ * @brief  Gets poitner to DMA RX stream for desired USART 
+ * @param  *USARTx: Pointer to USART where you wanna get its stream pointer
+ * @retval Pointer to DMA stream for desired USART
+ */
+DMA_Stream_TypeDef* TM_USART_DMA_GetStreamRX(USART_TypeDef* USARTx);
+
+/**
+ * @brief  Processes data written by DMA since last call and reports them with @ref TM_USART_DMA_ReceiveHandler
+ * @note   Must be called from idle line, DMA half transfer and DMA transfer complete interrupts
+ * @param  *USARTx: Pointer to USARTx with DMA RX enabled
+ * @retval Number of new bytes reported to user
+ */
+uint16_t TM_USART_DMA_ProcessRX(USART_TypeDef* USARTx);
+
+/**
+ * @brief  Callback function for received block of data with DMA RX
+ * @note   Called from @ref TM_USART_DMA_ProcessRX, up to 2 times per call when data wraps around end of buffer
+ * @note   With __weak parameter to prevent link errors if not defined by user
+ * @param  *USARTx: Pointer to USARTx where data were received
+ * @param  *Data: Pointer to received data inside DMA buffer
+ * @param  count: Number of received bytes
+ * @retval None
+ */
+void TM_USART_DMA_ReceiveHandler(USART_TypeDef* USARTx, uint8_t* Data, uint16_t count);
+
 /**
  * @}
  */
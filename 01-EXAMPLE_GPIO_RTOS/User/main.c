@@ -117,8 +117,8 @@ void TM_DELAY_1msHandler() {
  */
 void ESP_Update_Thread(void const* params) {
     while (1) {
-        /* Process ESP update */
-        ESP_Update(&ESP);
+        /* Process ESP update, sleep until new data or command */
+        ESP_UpdateWait(&ESP, 10);
     }
 }
 
@@ -120,8 +120,8 @@ void TM_DELAY_1msHandler() {
  */
 void ESP_Update_Thread(void const* params) {
     while (1) {
-        /* Process ESP update */
-        ESP_Update(&ESP);
+        /* Process ESP update, sleep until new data or command */
+        ESP_UpdateWait(&ESP, 10);
     }
 }
 
@@ -148,6 +148,7 @@ void ESP_Main_Thread(void const* params) {
     for (i = 0; i < 3; i++) {
         sntp.Addr[i] = sntp_server[i];
     }
+    sntp.AddrSize = sizeof(sntp_server[0]);                 /* Size of memory for each server */
     if ((espRes = ESP_SNTP_GetConfig(&ESP, &sntp, 1)) == espOK) {
         printf("SNTP config received\r\n");
         printf("SNTP enabled: %d\r\n", sntp.Enable);
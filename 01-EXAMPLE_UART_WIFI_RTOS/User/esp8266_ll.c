@@ -35,6 +35,9 @@
 
 #if ESP_RTOS
 osMutexId id;
+osSemaphoreDef(ESP_Update_Sem);
+osSemaphoreDef(ESP_Ready_Sem);
+osSemaphoreId sem[2];                               /* Binary semaphores for update and ready events */
 #endif /* ESP_RTOS */
 
 /*****************************************/
@@ -86,6 +89,20 @@ osMutexId id;
 #define ESP_RESET_PIN           GPIO_PIN_1
 #endif /* defined(STM32F429_DISCOVERY) */
 
+/* Receive data with circular DMA and idle line detection instead of interrupt for each character */
+#ifndef ESP_USART_DMA_RX
+#define ESP_USART_DMA_RX        1
+#endif
+
+#if ESP_USART_DMA_RX
+static uint8_t DMA_RX_Buffer[256];                  /* Circular DMA receive buffer */
+#endif /* ESP_USART_DMA_RX */
+
+/* ESP_DataReceived signals RTOS semaphore from USART and DMA RX interrupts, both run at USART_NVIC_PRIORITY */
+#if ESP_RTOS && defined(configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY) && USART_NVIC_PRIORITY < configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY
+#error "USART_NVIC_PRIORITY must not be higher than configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY"
+#endif
+
 uint8_t ESP_LL_Callback(ESP_LL_Control_t ctrl, void* param, void* result) {
     switch (ctrl) {
         case ESP_LL_Control_Init: {                 /* Initialize low-level part of communication */
@@ -95,6 +112,9 @@ uint8_t ESP_LL_Callback(ESP_LL_Control_t ctrl, void* param, void* result) {
             /*  Device specific initialization  */
             /************************************/
             TM_USART_Init(ESP_USART, TM_USART_PinsPack_Custom, LL->Baudrate);
+#if ESP_USART_DMA_RX
+            TM_USART_DMA_InitRX(ESP_USART, DMA_RX_Buffer, sizeof(DMA_RX_Buffer));  /* Receive with circular DMA */
+#endif /* ESP_USART_DMA_RX */
 #if defined(ESP_RESET_PORT) && defined(ESP_RESET_PIN)
             TM_GPIO_Init(ESP_RESET_PORT, ESP_RESET_PIN, TM_GPIO_Mode_OUT, TM_GPIO_OType_PP, TM_GPIO_PuPd_UP, TM_GPIO_Speed_Low);
             TM_GPIO_SetPinHigh(ESP_RESET_PORT, ESP_RESET_PIN);
@@ -146,6 +166,8 @@ uint8_t ESP_LL_Callback(ESP_LL_Control_t ctrl, void* param, void* result) {
         case ESP_LL_Control_SYS_Create: {           /* Create system synchronization object */
             ESP_RTOS_SYNC_t* Sync = (ESP_RTOS_SYNC_t *)param;   /* Get pointer to sync object */
             id = osMutexCreate(Sync);               /* Create mutex */
+            sem[ESP_SYS_EVENT_UPDATE] = osSemaphoreCreate(osSemaphore(ESP_Update_Sem), 1);
+            sem[ESP_SYS_EVENT_READY] = osSemaphoreCreate(osSemaphore(ESP_Ready_Sem), 1);
             
             if (result) {
                 *(uint8_t *)result = id == NULL;    /*!< Set result value */
@@ -175,12 +197,59 @@ uint8_t ESP_LL_Callback(ESP_LL_Control_t ctrl, void* param, void* result) {
             *(uint8_t *)result = osMutexRelease(id) == osOK ? 0 : 1;    /* Set result according to response */
             return 1;                               /* Command processed */
         }
+        case ESP_LL_Control_SYS_Wait: {             /* Wait for stack event */
+            ESP_LL_SysEvent_t* evt = (ESP_LL_SysEvent_t *)param;
+            
+            if (evt->Event == ESP_SYS_EVENT_DELAY) {
+                osDelay(evt->Timeout);              /* Sleep only */
+                *(uint8_t *)result = 1;
+            } else {
+                *(uint8_t *)result = osSemaphoreWait(sem[evt->Event], evt->Timeout) == osOK ? 0 : 1;   /* Wrapper returns osOK when semaphore was taken */
+            }
+            return 1;                               /* Command processed */
+        }
+        case ESP_LL_Control_SYS_Signal: {           /* Signal stack event, may be called from interrupt */
+            ESP_LL_SysEvent_t* evt = (ESP_LL_SysEvent_t *)param;
+            
+            *(uint8_t *)result = sem[evt->Event] != NULL && osSemaphoreRelease(sem[evt->Event]) == osOK ? 0 : 1;  /* Semaphore may not be created yet */
+            return 1;                               /* Command processed */
+        }
 #endif /* ESP_RTOS */
         default: 
             return 0;
     }
 }
 
+#if ESP_USART_DMA_RX
+/* USART idle line interrupt handler */
+void TM_USART_IdleLineHandler(USART_TypeDef* USARTx) {
+    if (USARTx == ESP_USART) {
+        TM_USART_DMA_ProcessRX(USARTx);             /* Process data received before line went idle */
+    }
+}
+
+/* DMA half transfer interrupt handler */
+void TM_DMA_HalfTransferCompleteHandler(DMA_Stream_TypeDef* DMA_Stream) {
+    if (DMA_Stream == TM_USART_DMA_GetStreamRX(ESP_USART)) {
+        TM_USART_DMA_ProcessRX(ESP_USART);          /* Process first half of buffer */
+    }
+}
+
+/* DMA transfer complete interrupt handler */
+void TM_DMA_TransferCompleteHandler(DMA_Stream_TypeDef* DMA_Stream) {
+    if (DMA_Stream == TM_USART_DMA_GetStreamRX(ESP_USART)) {
+        TM_USART_DMA_ProcessRX(ESP_USART);          /* Process second half of buffer */
+    }
+}
+
+/* DMA receive handler, called with blocks of received data */
+void TM_USART_DMA_ReceiveHandler(USART_TypeDef* USARTx, uint8_t* Data, uint16_t count) {
+    if (USARTx == ESP_USART) {
+        ESP_DataReceived(Data, count);              /* Send received block to ESP stack */
+    }
+}
+#endif /* ESP_USART_DMA_RX */
+
 #if defined(STM32F769_DISCOVERY)
 /* USART receive interrupt handler */
 void TM_UART5_ReceiveHandler(uint8_t ch) {